@@ -0,0 +1,553 @@
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "ast/ast_arena.h"
+#include "cache/query_cache.h"
+#include "lexer/interner.h"
+#include "lexer/keyword_classifier.h"
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "schema/schema.h"
+#include "validation/validator.h"
+
+// Google Benchmark suite: the cost of each front-end stage (tokenize,
+// classify_keyword, parse fused and materialized, schema load, validation,
+// cache put/get) on every document of the checked-in corpus/ (see
+// corpus/README.md). Besides time, each case reports bytes/s, tokens/s and
+// heap allocations per operation, counted by the global operator new
+// below. Two more families use generated input: overlapping_fields/ fits
+// the validator's growth on adversarial documents (it should stay O(N)),
+// and cache_get_shared/ measures hits from 1 to hardware_concurrency()
+// threads on one cache.
+//
+// The other benchmark_* programs stay standalone: execution, parallel
+// execution and batch loading need the C++20 runtime with their own schema,
+// resolvers and simulated backend latency, and cache replay reports hit
+// rates per eviction policy over a trace rather than a time per operation.
+//
+// Usage: graphql_benchmark [--corpus=DIR] [--benchmark_filter=parse/ ...]
+
+#ifndef GRAPHQL_CORPUS_DIR
+#define GRAPHQL_CORPUS_DIR "corpus"
+#endif
+
+namespace {
+
+std::atomic<size_t> allocations{0};
+
+struct CorpusDocument {
+    std::string name;  // Directory/file stem, e.g. queries/product_page
+    std::string text;
+    size_t tokens;
+};
+
+struct Corpus {
+    std::vector<CorpusDocument> queries;
+    std::vector<CorpusDocument> schemas;
+    std::vector<CorpusDocument> adversarial;
+};
+
+// Generated documents validated by overlapping_fields/
+const char* OVERLAP_SDL = R"(
+type T { t: T f(x: Int): T name: String id: ID }
+type Query { t: T }
+)";
+
+struct OverlapCase {
+    const char* name;
+    std::string (*generate)(size_t n);
+};
+
+const OverlapCase OVERLAP_CASES[] = {
+    // One response name selected n times
+    {"repeated_field", [](size_t n) {
+        std::string q = "{ t { ";
+        for (size_t i = 0; i < n; i++) q += "name ";
+        return q + "} }";
+    }},
+    // n aliases of the same field, each with a sub-selection to merge
+    {"aliased_subselections", [](size_t n) {
+        std::string q = "{ t { ";
+        for (size_t i = 0; i < n; i++) q += "a: f(x: 1) { id name } ";
+        return q + "} }";
+    }},
+    // n fragments all selecting the same field, all spread together
+    {"fragment_pairs", [](size_t n) {
+        std::string q = "{ t { ";
+        for (size_t i = 0; i < n; i++) q += "...F" + std::to_string(i) + " ";
+        q += "} }";
+        for (size_t i = 0; i < n; i++) q += " fragment F" + std::to_string(i) + " on T { t { id } name }";
+        return q;
+    }},
+    // Each fragment spreads the previous one under two same-named fields:
+    // comparing pairwise through the spreads takes 2^n steps
+    {"doubling_spreads", [](size_t n) {
+        std::string q = "fragment F0 on T { name }";
+        for (size_t i = 1; i <= n; i++) {
+            std::string previous = "...F" + std::to_string(i - 1);
+            q += " fragment F" + std::to_string(i) + " on T { t { " + previous + " } t { " + previous + " } }";
+        }
+        return q + " { t { ...F" + std::to_string(n) + " } }";
+    }},
+    // n distinct response names, each selected twice through sub-selections
+    {"wide_groups", [](size_t n) {
+        std::string q = "{ t { t { ";
+        for (size_t i = 0; i < n; i++) q += "n" + std::to_string(i) + ": name ";
+        q += "} t { ";
+        for (size_t i = 0; i < n; i++) q += "n" + std::to_string(i) + ": name ";
+        return q + "} } }";
+    }},
+};
+
+// A corpus query and the schema it's validated against
+struct ValidationCase {
+    const CorpusDocument* document;
+    const Schema* schema;
+};
+
+// One cache read by every thread of cache_get_shared/
+struct SharedCache {
+    QueryCache cache{1000};
+    std::vector<uint64_t> keys;
+};
+
+// Limits a server exposed to untrusted documents would parse under
+ParserOptions hardened_options() {
+    ParserOptions options;
+    options.max_tokens = 50'000;
+    options.max_depth = 64;
+    options.max_aliases = 500;
+    options.max_directives_per_field = 16;
+    options.max_list_size = 10'000;
+    return options;
+}
+
+size_t count_tokens(const std::string& text) {
+    Tokenizer tokenizer;
+    TokenArena arena;
+    return tokenizer.tokenize(text.data(), text.size(), arena).size();
+}
+
+std::vector<CorpusDocument> load_directory(const std::filesystem::path& corpus, const char* directory) {
+    std::vector<CorpusDocument> documents;
+    std::error_code error;
+    for (const auto& file : std::filesystem::directory_iterator(corpus / directory, error)) {
+        if (file.path().extension() != ".graphql") continue;
+        std::ifstream in(file.path(), std::ios::binary);
+        std::stringstream text;
+        text << in.rdbuf();
+        documents.push_back(CorpusDocument{std::string(directory) + "/" + file.path().stem().string(), text.str(), 0});
+    }
+    std::sort(documents.begin(), documents.end(),
+              [](const CorpusDocument& a, const CorpusDocument& b) { return a.name < b.name; });
+    for (CorpusDocument& document : documents) document.tokens = count_tokens(document.text);
+    return documents;
+}
+
+void report(benchmark::State& state, size_t bytes, size_t tokens, size_t allocated) {
+    auto iterations = static_cast<double>(state.iterations());
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * bytes));
+    state.counters["tokens/s"] = benchmark::Counter(iterations * tokens, benchmark::Counter::kIsRate);
+    state.counters["allocs/op"] = benchmark::Counter(static_cast<double>(allocated),
+                                                     benchmark::Counter::kAvgIterations);
+}
+
+void tokenize(benchmark::State& state, const CorpusDocument* document) {
+    Tokenizer tokenizer;
+    TokenArena arena;
+    size_t before = allocations.load(std::memory_order_relaxed);
+    for (auto _ : state) {
+        auto& tokens = tokenizer.tokenize(document->text.data(), document->text.size(), arena);
+        benchmark::DoNotOptimize(tokens.data());
+    }
+    report(state, document->text.size(), document->tokens, allocations.load(std::memory_order_relaxed) - before);
+}
+
+// Every name token of the queries, as the lexer would classify them
+void classify_names(benchmark::State& state, const std::vector<std::string_view>* names) {
+    size_t bytes = 0;
+    for (std::string_view name : *names) bytes += name.size();
+    size_t before = allocations.load(std::memory_order_relaxed);
+    for (auto _ : state) {
+        for (std::string_view name : *names) benchmark::DoNotOptimize(classify_keyword(name));
+    }
+    report(state, bytes, names->size(), allocations.load(std::memory_order_relaxed) - before);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * names->size()));
+}
+
+// Fused LexerCursor -> Parser, under the hardened limits: adversarial
+// documents mostly measure how fast they are rejected
+void parse(benchmark::State& state, const CorpusDocument* document) {
+    ParserOptions options = hardened_options();
+    ASTArena arena;
+    size_t tokens = 0;
+    bool parsed = false;
+    size_t before = allocations.load(std::memory_order_relaxed);
+    for (auto _ : state) {
+        arena.reset();
+        LexerCursor cursor(document->text.data(), document->text.size());
+        Parser parser(cursor, arena, options);
+        auto ast = parser.parse_document();
+        benchmark::DoNotOptimize(ast.get());
+        parsed = ast && !parser.has_errors();
+        tokens = cursor.tokens_produced();
+    }
+    report(state, document->text.size(), tokens, allocations.load(std::memory_order_relaxed) - before);
+    state.SetLabel(parsed ? "parsed" : "rejected");
+}
+
+// Tokenizer -> token vector -> Parser: the pipeline parse/ fuses
+void parse_materialized(benchmark::State& state, const CorpusDocument* document) {
+    ParserOptions options = hardened_options();
+    Tokenizer tokenizer;
+    TokenArena token_arena;
+    ASTArena arena;
+    size_t tokens = 0;
+    bool parsed = false;
+    size_t before = allocations.load(std::memory_order_relaxed);
+    for (auto _ : state) {
+        arena.reset();
+        auto& stream = tokenizer.tokenize(document->text.data(), document->text.size(), token_arena);
+        Parser parser(stream, arena, options);
+        auto ast = parser.parse_document();
+        benchmark::DoNotOptimize(ast.get());
+        parsed = ast && !parser.has_errors();
+        tokens = stream.size();
+    }
+    report(state, document->text.size(), tokens, allocations.load(std::memory_order_relaxed) - before);
+    state.SetLabel(parsed ? "parsed" : "rejected");
+}
+
+void schema(benchmark::State& state, const CorpusDocument* document) {
+    size_t before = allocations.load(std::memory_order_relaxed);
+    for (auto _ : state) {
+        auto loaded = Schema::from_sdl(document->text);
+        benchmark::DoNotOptimize(loaded.get());
+    }
+    report(state, document->text.size(), document->tokens, allocations.load(std::memory_order_relaxed) - before);
+}
+
+bool valid_against(const CorpusDocument& document, const Schema& schema) {
+    Interner symbols(&schema.names());
+    LexerCursor cursor(document.text.data(), document.text.size(), &symbols);
+    ASTArena arena;
+    Parser parser(cursor, arena);
+    auto ast = parser.parse_document();
+    Validator validator(schema);
+    return ast && !parser.has_errors() && validator.validate(*ast);
+}
+
+// Validation alone, of one parsed document
+void validate(benchmark::State& state, const ValidationCase* validation) {
+    const CorpusDocument& document = *validation->document;
+    Interner symbols(&validation->schema->names());
+    LexerCursor cursor(document.text.data(), document.text.size(), &symbols);
+    ASTArena arena;
+    Parser parser(cursor, arena);
+    auto ast = parser.parse_document();
+    Validator validator(*validation->schema);
+    if (!ast || parser.has_errors() || !validator.validate(*ast)) {
+        state.SkipWithError("Document is not valid against the schema");
+        return;
+    }
+    size_t before = allocations.load(std::memory_order_relaxed);
+    for (auto _ : state) benchmark::DoNotOptimize(validator.validate(*ast));
+    report(state, document.text.size(), document.tokens, allocations.load(std::memory_order_relaxed) - before);
+}
+
+// Parse + validate, as for a request that misses the cache
+void parse_validate(benchmark::State& state, const ValidationCase* validation) {
+    const CorpusDocument& document = *validation->document;
+    Validator validator(*validation->schema);
+    ASTArena arena;
+    bool valid = false;
+    size_t before = allocations.load(std::memory_order_relaxed);
+    for (auto _ : state) {
+        arena.reset();
+        Interner symbols(&validation->schema->names());
+        LexerCursor cursor(document.text.data(), document.text.size(), &symbols);
+        Parser parser(cursor, arena);
+        auto ast = parser.parse_document();
+        valid = ast && !parser.has_errors() && validator.validate(*ast);
+    }
+    report(state, document.text.size(), document.tokens, allocations.load(std::memory_order_relaxed) - before);
+    if (!valid) state.SkipWithError("Document is not valid against the schema");
+}
+
+// A cached query, whose entry already records its pass for this schema
+void validate_cached(benchmark::State& state, const ValidationCase* validation) {
+    const CorpusDocument& document = *validation->document;
+    QueryCache cache;
+    Validator validator(*validation->schema);
+    QueryCache::Handle entry = cache.put(document.text);
+    if (!entry || !validator.validate(*entry) || !entry->validated_for(validation->schema->generation())) {
+        state.SkipWithError("Document is not valid against the schema");
+        return;
+    }
+    uint64_t key = QueryCache::key_for(document.text);
+    size_t before = allocations.load(std::memory_order_relaxed);
+    for (auto _ : state) benchmark::DoNotOptimize(validator.validate(*cache.get(key)));
+    report(state, document.text.size(), document.tokens, allocations.load(std::memory_order_relaxed) - before);
+}
+
+// Validation of a generated document of size state.range(0); the fitted
+// complexity should be O(N): pairwise comparison would show O(N^2) or worse
+void overlapping_fields(benchmark::State& state, const OverlapCase* overlap) {
+    static const auto schema = Schema::from_sdl(OVERLAP_SDL);
+    std::string text = overlap->generate(static_cast<size_t>(state.range(0)));
+    Interner symbols(&schema->names());
+    LexerCursor cursor(text.data(), text.size(), &symbols);
+    ASTArena arena;
+    Parser parser(cursor, arena);
+    auto ast = parser.parse_document();
+    if (!ast || parser.has_errors()) {
+        state.SkipWithError("Generated document failed to parse");
+        return;
+    }
+    Validator validator(*schema);
+    for (auto _ : state) benchmark::DoNotOptimize(validator.validate(*ast));
+    state.SetComplexityN(state.range(0));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * text.size()));
+}
+
+// A miss: parse and insert into an emptied cache (the clear is included)
+void cache_put(benchmark::State& state, const CorpusDocument* document) {
+    QueryCache cache;
+    size_t before = allocations.load(std::memory_order_relaxed);
+    for (auto _ : state) {
+        cache.clear();
+        benchmark::DoNotOptimize(cache.put(document->text).get());
+    }
+    report(state, document->text.size(), document->tokens, allocations.load(std::memory_order_relaxed) - before);
+}
+
+// A hit by text: canonical hash of the document, then the lookup
+void cache_get(benchmark::State& state, const CorpusDocument* document) {
+    QueryCache cache;
+    if (!cache.put(document->text)) {
+        state.SkipWithError("Document failed to parse");
+        return;
+    }
+    size_t before = allocations.load(std::memory_order_relaxed);
+    for (auto _ : state) benchmark::DoNotOptimize(cache.get(document->text).get());
+    report(state, document->text.size(), document->tokens, allocations.load(std::memory_order_relaxed) - before);
+}
+
+// A hit by precomputed key, cycling through every query
+void cache_get_key(benchmark::State& state, const std::vector<CorpusDocument>* documents) {
+    QueryCache cache;
+    std::vector<uint64_t> keys;
+    for (const CorpusDocument& document : *documents) {
+        if (cache.put(document.text)) keys.push_back(QueryCache::key_for(document.text));
+    }
+    if (keys.empty()) {
+        state.SkipWithError("No query could be cached");
+        return;
+    }
+    size_t next = 0;
+    size_t before = allocations.load(std::memory_order_relaxed);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(cache.get(keys[next]).get());
+        if (++next == keys.size()) next = 0;
+    }
+    state.counters["allocs/op"] = benchmark::Counter(
+        static_cast<double>(allocations.load(std::memory_order_relaxed) - before), benchmark::Counter::kAvgIterations);
+}
+
+// Hits on one cache from every thread of the run, each cycling through the
+// keys from its own offset; with the lock-free read path, items/s should
+// grow with the thread count up to the number of cores
+void cache_get_shared(benchmark::State& state, SharedCache* shared) {
+    size_t next = static_cast<size_t>(state.thread_index()) * 7919;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(shared->cache.get(shared->keys[next % shared->keys.size()]).get());
+        next++;
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+
+void register_benchmarks(const Corpus& corpus, std::vector<std::unique_ptr<Schema>>& schemas,
+                         std::vector<ValidationCase>& validations, SharedCache& shared,
+                         std::vector<std::string_view>& names) {
+    for (const auto* documents : {&corpus.queries, &corpus.adversarial}) {
+        for (const CorpusDocument& document : *documents) {
+            benchmark::RegisterBenchmark(("tokenize/" + document.name).c_str(), tokenize, &document);
+        }
+    }
+
+    Tokenizer tokenizer;
+    TokenArena arena;
+    for (const CorpusDocument& document : corpus.queries) {
+        for (const Token& token : tokenizer.tokenize(document.text.data(), document.text.size(), arena)) {
+            if (token.type <= IDENTIFIER) names.push_back(token.value);
+        }
+    }
+    benchmark::RegisterBenchmark("classify_keyword/queries", classify_names, &names);
+
+    for (const auto* documents : {&corpus.queries, &corpus.adversarial}) {
+        for (const CorpusDocument& document : *documents) {
+            benchmark::RegisterBenchmark(("parse/" + document.name).c_str(), parse, &document);
+        }
+    }
+    for (const auto* documents : {&corpus.queries, &corpus.adversarial}) {
+        for (const CorpusDocument& document : *documents) {
+            benchmark::RegisterBenchmark(("parse_materialized/" + document.name).c_str(), parse_materialized,
+                                         &document);
+        }
+    }
+    for (const CorpusDocument& document : corpus.schemas) {
+        benchmark::RegisterBenchmark(("schema/" + document.name).c_str(), schema, &document);
+    }
+
+    // Queries are validated against the first schema of the corpus, those it
+    // accepts (introspection isn't: the schema has no __Type and friends)
+    if (!corpus.schemas.empty()) schemas.push_back(Schema::from_sdl(corpus.schemas[0].text));
+    if (!schemas.empty() && schemas[0]) {
+        validations.reserve(corpus.queries.size());
+        for (const CorpusDocument& document : corpus.queries) {
+            if (valid_against(document, *schemas[0])) validations.push_back({&document, schemas[0].get()});
+        }
+        for (const auto& [prefix, run] : {std::pair{"validate/", validate}, std::pair{"parse_validate/", parse_validate},
+                                          std::pair{"validate_cached/", validate_cached}}) {
+            for (const ValidationCase& validation : validations) {
+                benchmark::RegisterBenchmark((prefix + validation.document->name).c_str(), run, &validation);
+            }
+        }
+    }
+    for (const OverlapCase& overlap : OVERLAP_CASES) {
+        benchmark::RegisterBenchmark((std::string("overlapping_fields/") + overlap.name).c_str(), overlapping_fields,
+                                     &overlap)
+            ->Arg(1000)
+            ->Arg(2000)
+            ->Arg(4000)
+            ->Arg(8000)
+            ->Complexity(benchmark::oN);
+    }
+    for (const CorpusDocument& document : corpus.queries) {
+        benchmark::RegisterBenchmark(("cache_put/" + document.name).c_str(), cache_put, &document);
+    }
+    for (const CorpusDocument& document : corpus.queries) {
+        benchmark::RegisterBenchmark(("cache_get/" + document.name).c_str(), cache_get, &document);
+    }
+    benchmark::RegisterBenchmark("cache_get_key/queries", cache_get_key, &corpus.queries);
+
+    for (size_t i = 0; i < 1000; i++) {
+        QueryCache::Handle entry = shared.cache.put("query Q" + std::to_string(i) + " { user(id: " +
+                                                    std::to_string(i) + ") { id name } }");
+        if (entry) shared.keys.push_back(entry->key);
+    }
+    int threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    benchmark::RegisterBenchmark("cache_get_shared/synthetic", cache_get_shared, &shared)
+        ->ThreadRange(1, threads)
+        ->UseRealTime();
+}
+
+}  // namespace
+
+// Every replaceable single-object form is replaced, so each allocation is
+// counted and every delete frees what the matching new returned (the array
+// forms forward to these). The pair is kept out of line: inlined into a
+// caller, GCC would see operator new's result reach free() and warn
+// (-Wmismatched-new-delete).
+
+namespace {
+
+[[gnu::noinline]] void counted_free(void* memory) {
+    std::free(memory);
+}
+
+[[gnu::noinline]] void* counted_allocate(std::size_t size, std::size_t alignment) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (size == 0) size = 1;
+    if (alignment <= alignof(std::max_align_t)) return std::malloc(size);
+    return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+}
+
+}  // namespace
+
+void* operator new(std::size_t size) {
+    if (void* memory = counted_allocate(size, 0)) return memory;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    if (void* memory = counted_allocate(size, static_cast<std::size_t>(alignment))) return memory;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return counted_allocate(size, 0);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return counted_allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* memory) noexcept {
+    counted_free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    counted_free(memory);
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept {
+    counted_free(memory);
+}
+
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept {
+    counted_free(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept {
+    counted_free(memory);
+}
+
+void operator delete(void* memory, std::align_val_t, const std::nothrow_t&) noexcept {
+    counted_free(memory);
+}
+
+int main(int argc, char** argv) {
+    // --corpus is ours; everything else goes to Google Benchmark
+    std::string directory = GRAPHQL_CORPUS_DIR;
+    int kept = 1;
+    for (int i = 1; i < argc; i++) {
+        std::string_view arg(argv[i]);
+        if (arg.rfind("--corpus=", 0) == 0) {
+            directory = std::string(arg.substr(9));
+        } else {
+            argv[kept++] = argv[i];
+        }
+    }
+    argc = kept;
+
+    Corpus corpus;
+    corpus.queries = load_directory(directory, "queries");
+    corpus.schemas = load_directory(directory, "schemas");
+    corpus.adversarial = load_directory(directory, "adversarial");
+    if (corpus.queries.empty()) {
+        std::cerr << "No queries found in " << directory << "/queries; pass --corpus=DIR" << std::endl;
+        return 1;
+    }
+
+    std::vector<std::unique_ptr<Schema>> schemas;
+    std::vector<ValidationCase> validations;
+    SharedCache shared;
+    std::vector<std::string_view> names;
+    register_benchmarks(corpus, schemas, validations, shared, names);
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,170 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "ast/ast_arena.h"
+#include "lexer/interner.h"
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "runtime/executor.h"
+#include "runtime/query_plan.h"
+#include "schema/schema.h"
+
+// Measures the N+1 pattern: every post of a feed resolves its author, and
+// every author their best friend, against a backend whose calls cost a
+// fixed round trip. Compares one backend call per object with a batch
+// loader, interpreted (dispatches as keys are reached) and from a plan
+// (one dispatch per level).
+//
+// Usage: benchmark_batch_loading [iterations] [round_trip_us]
+
+namespace {
+
+const char* SCHEMA_SDL = R"(
+type User { id: ID! name: String friend: User }
+type Post { id: ID! title: String author: User }
+type Query { feed: [Post!]! }
+)";
+
+const char* QUERY = "{ feed { id title author { id name friend { id name } } } }";
+
+struct User {
+    int64_t id;
+    std::string name;
+    int64_t friend_id;
+};
+
+struct Post {
+    int64_t id;
+    std::string title;
+    int64_t author_id;
+};
+
+struct Backend {
+    std::vector<User> users;
+    std::vector<Post> posts;
+    std::chrono::microseconds round_trip;
+    size_t calls = 0;
+
+    void call() {
+        calls++;
+        auto until = std::chrono::steady_clock::now() + round_trip;
+        while (std::chrono::steady_clock::now() < until) {
+        }
+    }
+    const User* user(int64_t id) const { return id >= 0 && id < static_cast<int64_t>(users.size()) ? &users[id] : nullptr; }
+};
+
+void add_common(ResolverRegistry& r, Backend& b) {
+    r.add("Query", "feed", [&b](const FieldContext& ctx) {
+        Resolved* items = ctx.allocate<Resolved>(b.posts.size());
+        for (size_t i = 0; i < b.posts.size(); i++) items[i] = Resolved::object(&b.posts[i]);
+        return Resolved::list(items, static_cast<uint32_t>(b.posts.size()));
+    });
+    r.add("Post", "id", [](const FieldContext& ctx) {
+        return Resolved::scalar(ResponseValue::of_int(static_cast<const Post*>(ctx.source)->id));
+    });
+    r.add("Post", "title", [](const FieldContext& ctx) {
+        return Resolved::scalar(ResponseValue::of_string(static_cast<const Post*>(ctx.source)->title));
+    });
+    r.add("User", "id", [](const FieldContext& ctx) {
+        return Resolved::scalar(ResponseValue::of_int(static_cast<const User*>(ctx.source)->id));
+    });
+    r.add("User", "name", [](const FieldContext& ctx) {
+        return Resolved::scalar(ResponseValue::of_string(static_cast<const User*>(ctx.source)->name));
+    });
+}
+
+// One backend call per author and per friend
+void add_per_object(ResolverRegistry& r, Backend& b) {
+    add_common(r, b);
+    r.add("Post", "author", [&b](const FieldContext& ctx) {
+        b.call();
+        return Resolved::object(b.user(static_cast<const Post*>(ctx.source)->author_id));
+    });
+    r.add("User", "friend", [&b](const FieldContext& ctx) {
+        b.call();
+        return Resolved::object(b.user(static_cast<const User*>(ctx.source)->friend_id));
+    });
+}
+
+// One backend call per batch of user ids
+void add_batched(ResolverRegistry& r, Backend& b) {
+    add_common(r, b);
+    uint32_t users = r.add_loader([&b](const BatchCall& call) {
+        b.call();
+        for (uint32_t i = 0; i < call.count; i++) call.results[i] = Resolved::object(b.user(call.keys[i].integer));
+    });
+    r.add("Post", "author", [users](const FieldContext& ctx) {
+        return ctx.load(users, ResponseValue::of_int(static_cast<const Post*>(ctx.source)->author_id));
+    });
+    r.add("User", "friend", [users](const FieldContext& ctx) {
+        return ctx.load(users, ResponseValue::of_int(static_cast<const User*>(ctx.source)->friend_id));
+    });
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    size_t iterations = argc > 1 ? std::stoul(argv[1]) : 200;
+    Backend backend;
+    backend.round_trip = std::chrono::microseconds(argc > 2 ? std::stoul(argv[2]) : 20);
+
+    auto schema = Schema::from_sdl(SCHEMA_SDL);
+    if (!schema) {
+        std::cerr << "Schema failed to load" << std::endl;
+        return 1;
+    }
+    // 100 posts by 40 authors, whose friends are 40 further users
+    for (int64_t i = 0; i < 80; i++) backend.users.push_back(User{i, "user" + std::to_string(i), (i + 40) % 80});
+    for (int64_t i = 0; i < 100; i++) backend.posts.push_back(Post{1000 + i, "post" + std::to_string(i), i % 40});
+
+    Interner symbols(&schema->names());
+    LexerCursor cursor(QUERY, std::strlen(QUERY), &symbols);
+    ASTArena document_arena;
+    Parser parser(cursor, document_arena);
+    auto document = parser.parse_document();
+    if (parser.has_errors()) {
+        std::cerr << "Query failed to parse" << std::endl;
+        return 1;
+    }
+
+    ResolverRegistry per_object(*schema);
+    add_per_object(per_object, backend);
+    ResolverRegistry batched(*schema);
+    add_batched(batched, backend);
+    Executor per_object_executor(*schema, per_object);
+    Executor batched_executor(*schema, batched);
+    auto per_object_plan = QueryPlan::compile(per_object, per_object_executor.coercer(), *document);
+    auto batched_plan = QueryPlan::compile(batched, batched_executor.coercer(), *document);
+    if (!per_object_plan || !batched_plan) {
+        std::cerr << "Query failed to compile" << std::endl;
+        return 1;
+    }
+
+    ASTArena arena;
+    size_t errors = 0;
+    auto measure = [&](const char* label, auto&& execute) {
+        backend.calls = 0;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < iterations; i++) {
+            arena.reset();
+            errors += execute().errors.size();
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        double seconds = std::chrono::duration<double>(end - start).count();
+        std::cout << label << std::setw(10) << iterations / seconds << " req/s  " << std::setw(6)
+                  << backend.calls / iterations << " backend calls/req\n";
+    };
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << backend.posts.size() << " posts, " << backend.round_trip.count() << " us per backend call, "
+              << iterations << " iterations\n";
+    measure("Per object, plan:        ", [&] { return per_object_executor.execute(*per_object_plan, arena); });
+    measure("Batched, interpreted:    ", [&] { return batched_executor.execute(*document, arena); });
+    measure("Batched, plan:           ", [&] { return batched_executor.execute(*batched_plan, arena); });
+    if (errors) std::cerr << errors << " execution errors" << std::endl;
+    return errors ? 1 : 0;
+}
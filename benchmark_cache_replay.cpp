@@ -0,0 +1,94 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+#include "cache/query_cache.h"
+
+// Replays a query trace through QueryCache under each eviction policy and
+// reports hit rate and throughput.
+//
+// Usage: benchmark_cache_replay [trace-file] [cache-entries]
+//   trace-file: one query per line (as recorded by the gateway); when
+//               omitted, a synthetic trace is generated: Zipf-distributed
+//               persisted operations mixed with a long tail of one-off
+//               ad-hoc queries.
+
+namespace {
+
+std::vector<std::string> synthetic_trace(size_t length) {
+    const size_t operations = 5000;
+    std::mt19937_64 rng(12345);
+
+    // Zipf(0.9) over the persisted operations, via the inverse CDF table
+    std::vector<double> cdf(operations);
+    double total = 0;
+    for (size_t i = 0; i < operations; i++) {
+        total += 1.0 / std::pow(static_cast<double>(i + 1), 0.9);
+        cdf[i] = total;
+    }
+
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::vector<std::string> trace;
+    trace.reserve(length);
+    size_t adhoc = 0;
+    for (size_t n = 0; n < length; n++) {
+        if (uniform(rng) < 0.4) {
+            trace.push_back("query AdHoc { search(term: \"" + std::to_string(adhoc++) + "\") { id title } }");
+            continue;
+        }
+        size_t op = std::lower_bound(cdf.begin(), cdf.end(), uniform(rng) * total) - cdf.begin();
+        std::string id = std::to_string(op);
+        trace.push_back("query Op" + id + "($id: ID!) { node(id: $id) { id ... on User { name email } "
+                        "posts(first: " + id + ") { title } } }");
+    }
+    return trace;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::vector<std::string> trace;
+    if (argc > 1) {
+        std::ifstream file(argv[1]);
+        if (!file) {
+            std::cerr << "Cannot open trace " << argv[1] << std::endl;
+            return 1;
+        }
+        for (std::string line; std::getline(file, line);) {
+            if (!line.empty()) trace.push_back(line);
+        }
+    } else {
+        trace = synthetic_trace(500000);
+    }
+    size_t entries = argc > 2 ? std::stoul(argv[2]) : 1000;
+
+    std::cout << "=== QueryCache replay: " << trace.size() << " requests, "
+              << entries << " entries ===" << std::endl;
+    std::cout << std::left << std::setw(12) << "Policy"
+              << std::setw(12) << "Hit rate"
+              << std::setw(14) << "Evictions"
+              << "Throughput (req/s)" << std::endl;
+
+    for (EvictionPolicy policy : {EvictionPolicy::LRU, EvictionPolicy::W_TINYLFU}) {
+        QueryCache cache(entries, 1024, ParserOptions(), policy);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        for (const std::string& query : trace) {
+            cache.get_or_put(query);
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        double seconds = std::chrono::duration<double>(end - start).count();
+
+        QueryCache::Stats stats = cache.get_stats();
+        std::cout << std::left << std::setw(12) << (policy == EvictionPolicy::LRU ? "LRU" : "W-TinyLFU")
+                  << std::setw(12) << std::fixed << std::setprecision(4) << stats.hit_rate
+                  << std::setw(14) << stats.evictions
+                  << std::setprecision(0) << trace.size() / seconds << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,236 @@
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "ast/ast_arena.h"
+#include "cache/query_cache.h"
+#include "lexer/interner.h"
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "runtime/executor.h"
+#include "runtime/query_plan.h"
+#include "runtime/response_writer.h"
+#include "schema/schema.h"
+
+// Measures Executor throughput on a persisted-style operation over
+// in-memory data: interpreted from the document, from a compiled
+// QueryPlan, and through a QueryCache entry that keeps its plan; then
+// the cost of serializing one response with ResponseWriter.
+// Resolvers are trivial, so the numbers are dominated by the executor.
+//
+// Usage: benchmark_execution [iterations]
+
+namespace {
+
+const char* SCHEMA_SDL = R"(
+interface Node { id: ID! }
+type User implements Node {
+  id: ID!
+  name: String
+  email: String
+  friends(first: Int = 10): [User!]!
+  posts(first: Int): [Post!]!
+}
+type Post implements Node { id: ID! title: String author: User }
+union SearchResult = User | Post
+type Query {
+  user(id: ID!): User
+  search(term: String!, limit: Int = 20): [SearchResult]
+}
+)";
+
+const char* QUERY = R"(
+query Dashboard($id: ID!, $first: Int = 5, $withPosts: Boolean!) {
+  user(id: $id) {
+    ...UserSummary
+    friends(first: $first) { ...UserSummary friends(first: 3) { id name } }
+    posts(first: $first) @include(if: $withPosts) { id title author { ...UserSummary } }
+  }
+  search(term: "a") {
+    __typename
+    ... on User { id name }
+    ... on Post { id title }
+  }
+}
+fragment UserSummary on User { id name email }
+)";
+
+struct User {
+    int64_t id;
+    std::string name;
+    std::string email;
+    std::vector<const User*> friends;
+};
+
+struct Post {
+    int64_t id;
+    std::string title;
+    const User* author;
+};
+
+struct Data {
+    std::vector<User> users;
+    std::vector<Post> posts;
+};
+
+template <typename T>
+Resolved list_of(const FieldContext& ctx, const std::vector<const T*>& items, int64_t first) {
+    uint32_t count = static_cast<uint32_t>(std::min<int64_t>(first, static_cast<int64_t>(items.size())));
+    Resolved* resolved = ctx.allocate<Resolved>(count);
+    for (uint32_t i = 0; i < count; i++) resolved[i] = Resolved::object(items[i]);
+    return Resolved::list(resolved, count);
+}
+
+void add_resolvers(ResolverRegistry& r, const Data& data, std::vector<const Post*>& post_refs) {
+    for (const Post& post : data.posts) post_refs.push_back(&post);
+    const Schema& schema = r.schema();
+    uint32_t user_type = schema.type_index("User");
+    uint32_t post_type = schema.type_index("Post");
+
+    r.add("Query", "user", [&data](const FieldContext& ctx) {
+        return Resolved::object(&data.users[std::stoul(std::string(ctx.argument(0).text())) % data.users.size()]);
+    });
+    r.add("Query", "search", [&data, user_type, post_type](const FieldContext& ctx) {
+        Resolved* items = ctx.allocate<Resolved>(4);
+        for (uint32_t i = 0; i < 4; i++) {
+            items[i] = i % 2 ? Resolved::object(&data.posts[i], post_type) : Resolved::object(&data.users[i], user_type);
+        }
+        return Resolved::list(items, 4);
+    });
+    r.add("User", "id", [](const FieldContext& ctx) {
+        return Resolved::scalar(ResponseValue::of_int(static_cast<const User*>(ctx.source)->id));
+    });
+    r.add("User", "name", [](const FieldContext& ctx) {
+        return Resolved::scalar(ResponseValue::of_string(static_cast<const User*>(ctx.source)->name));
+    });
+    r.add("User", "email", [](const FieldContext& ctx) {
+        return Resolved::scalar(ResponseValue::of_string(static_cast<const User*>(ctx.source)->email));
+    });
+    r.add("User", "friends", [](const FieldContext& ctx) {
+        return list_of(ctx, static_cast<const User*>(ctx.source)->friends, ctx.argument(0).integer);
+    });
+    r.add("User", "posts", [&post_refs](const FieldContext& ctx) {
+        const ResponseValue& first = ctx.argument(0);
+        return list_of(ctx, post_refs, first.is_null() ? 100 : first.integer);
+    });
+    r.add("Post", "id", [](const FieldContext& ctx) {
+        return Resolved::scalar(ResponseValue::of_int(static_cast<const Post*>(ctx.source)->id));
+    });
+    r.add("Post", "title", [](const FieldContext& ctx) {
+        return Resolved::scalar(ResponseValue::of_string(static_cast<const Post*>(ctx.source)->title));
+    });
+    r.add("Post", "author", [](const FieldContext& ctx) {
+        return Resolved::object(static_cast<const Post*>(ctx.source)->author);
+    });
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    size_t iterations = argc > 1 ? std::stoul(argv[1]) : 100000;
+
+    auto schema = Schema::from_sdl(SCHEMA_SDL);
+    if (!schema) {
+        std::cerr << "Schema failed to load" << std::endl;
+        return 1;
+    }
+
+    Data data;
+    for (int64_t i = 0; i < 16; i++) {
+        data.users.push_back(User{i, "user" + std::to_string(i), "user" + std::to_string(i) + "@example.com", {}});
+    }
+    for (size_t i = 0; i < data.users.size(); i++) {
+        for (size_t j = 1; j <= 8; j++) data.users[i].friends.push_back(&data.users[(i + j) % data.users.size()]);
+    }
+    for (int64_t i = 0; i < 16; i++) data.posts.push_back(Post{100 + i, "post" + std::to_string(i), &data.users[i]});
+    std::vector<const Post*> post_refs;
+    ResolverRegistry resolvers(*schema);
+    add_resolvers(resolvers, data, post_refs);
+
+    ResponseField fields[2] = {{"id", ResponseValue::of_int(3)}, {"withPosts", ResponseValue::of_bool(true)}};
+    ResponseValue variables = ResponseValue::of_object(fields, 2);
+    ExecutionRequest request;
+    request.variables = &variables;
+
+    Interner symbols(&schema->names());
+    LexerCursor cursor(QUERY, std::strlen(QUERY), &symbols);
+    ASTArena document_arena;
+    Parser parser(cursor, document_arena);
+    auto document = parser.parse_document();
+    if (parser.has_errors()) {
+        std::cerr << parser.get_errors()[0] << std::endl;
+        return 1;
+    }
+
+    Executor executor(*schema, resolvers);
+    ASTArena arena;
+    size_t errors = 0;
+
+    // Interpreted: fields collected and arguments coerced per object
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+        arena.reset();
+        errors += executor.execute(*document, arena, request).errors.size();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    double interpreted_seconds = std::chrono::duration<double>(end - start).count();
+
+    // Compiled once, then executed from the plan
+    std::string error;
+    auto plan = QueryPlan::compile(resolvers, executor.coercer(), *document, &error);
+    if (!plan) {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+    start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+        arena.reset();
+        errors += executor.execute(*plan, arena, request).errors.size();
+    }
+    end = std::chrono::high_resolution_clock::now();
+    double plan_seconds = std::chrono::duration<double>(end - start).count();
+
+    // Cached: look up the entry, reuse the plan it keeps
+    QueryCache cache;
+    cache.put(QUERY);
+    uint64_t key = QueryCache::key_for(QUERY);
+    start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+        arena.reset();
+        errors += executor.execute(*cache.get(key), arena, request).errors.size();
+    }
+    end = std::chrono::high_resolution_clock::now();
+    double cached_seconds = std::chrono::duration<double>(end - start).count();
+
+    // Serialized into a reused buffer, keys from the plan
+    arena.reset();
+    ExecutionResult result = executor.execute(*plan, arena, request);
+    std::vector<char> buffer(64 * 1024);
+    size_t bytes = 0;
+    start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+        ResponseWriter writer({buffer.data(), buffer.size()}, [&](const char*, size_t) {
+            return JsonBuffer{buffer.data(), buffer.size()};
+        }, plan.get());
+        writer.write(result);
+        bytes += writer.bytes_written();
+    }
+    end = std::chrono::high_resolution_clock::now();
+    double write_seconds = std::chrono::duration<double>(end - start).count();
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Plan: " << plan->field_count() << " fields, " << plan->memory_bytes() << " bytes; " << iterations
+              << " iterations (" << errors << " errors)\n";
+    std::cout << "Interpreted:   " << std::setw(10) << iterations / interpreted_seconds << " ops/s  "
+              << interpreted_seconds * 1e9 / iterations << " ns/op\n";
+    std::cout << "Compiled plan: " << std::setw(10) << iterations / plan_seconds << " ops/s  "
+              << plan_seconds * 1e9 / iterations << " ns/op\n";
+    std::cout << "Cached entry:  " << std::setw(10) << iterations / cached_seconds << " ops/s  "
+              << cached_seconds * 1e9 / iterations << " ns/op\n";
+    std::cout << "Serialize:     " << std::setw(10) << iterations / write_seconds << " ops/s  "
+              << write_seconds * 1e9 / iterations << " ns/op  " << bytes / write_seconds / (1 << 20) << " MB/s\n";
+    return 0;
+}
@@ -0,0 +1,164 @@
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ast/ast_arena.h"
+#include "lexer/interner.h"
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "runtime/executor.h"
+#include "runtime/query_plan.h"
+#include "runtime/scheduler.h"
+#include "schema/schema.h"
+
+// Measures how parallel plan execution scales with Scheduler threads, from
+// 1 to 64, against sequential execution of the same plan. Expensive
+// resolvers either burn CPU (compute-bound) or sleep (I/O-bound latency);
+// the cheap ones run inline either way.
+//
+// Usage: benchmark_parallel_execution [iterations] [work_us] [max_threads] [--sleep]
+
+namespace {
+
+const char* SCHEMA_SDL = R"(
+type User { id: ID! name: String score: Int posts: [Post!]! }
+type Post { id: ID! title: String }
+type Query { users: [User!]! top: [Post!]! }
+)";
+
+const char* QUERY = "{ users { id name score posts { id title } } top { id title } }";
+
+struct User {
+    int64_t id;
+    std::string name;
+};
+
+struct Post {
+    int64_t id;
+    std::string title;
+};
+
+struct Workload {
+    std::vector<User> users;
+    std::vector<Post> posts;
+    std::chrono::microseconds work;
+    bool sleep;
+
+    void expensive_call() const {
+        if (sleep) {
+            std::this_thread::sleep_for(work);
+            return;
+        }
+        auto until = std::chrono::steady_clock::now() + work;
+        while (std::chrono::steady_clock::now() < until) {
+        }
+    }
+};
+
+void add_resolvers(ResolverRegistry& r, const Workload& w) {
+    r.add("Query", "users", [&w](const FieldContext& ctx) {
+        Resolved* items = ctx.allocate<Resolved>(w.users.size());
+        for (size_t i = 0; i < w.users.size(); i++) items[i] = Resolved::object(&w.users[i]);
+        return Resolved::list(items, static_cast<uint32_t>(w.users.size()));
+    });
+    r.add("Query", "top", [&w](const FieldContext& ctx) {
+        w.expensive_call();
+        Resolved* items = ctx.allocate<Resolved>(4);
+        for (size_t i = 0; i < 4; i++) items[i] = Resolved::object(&w.posts[i]);
+        return Resolved::list(items, 4);
+    }, ResolverCost::EXPENSIVE);
+    r.add("User", "id", [](const FieldContext& ctx) {
+        return Resolved::scalar(ResponseValue::of_int(static_cast<const User*>(ctx.source)->id));
+    });
+    r.add("User", "name", [](const FieldContext& ctx) {
+        return Resolved::scalar(ResponseValue::of_string(static_cast<const User*>(ctx.source)->name));
+    });
+    // Two expensive siblings per user: a score and their posts
+    r.add("User", "score", [&w](const FieldContext& ctx) {
+        w.expensive_call();
+        return Resolved::scalar(ResponseValue::of_int(static_cast<const User*>(ctx.source)->id * 7 % 100));
+    }, ResolverCost::EXPENSIVE);
+    r.add("User", "posts", [&w](const FieldContext& ctx) {
+        w.expensive_call();
+        const User* user = static_cast<const User*>(ctx.source);
+        Resolved* items = ctx.allocate<Resolved>(3);
+        for (size_t i = 0; i < 3; i++) items[i] = Resolved::object(&w.posts[(user->id + i) % w.posts.size()]);
+        return Resolved::list(items, 3);
+    }, ResolverCost::EXPENSIVE);
+    r.add("Post", "id", [](const FieldContext& ctx) {
+        return Resolved::scalar(ResponseValue::of_int(static_cast<const Post*>(ctx.source)->id));
+    });
+    r.add("Post", "title", [](const FieldContext& ctx) {
+        return Resolved::scalar(ResponseValue::of_string(static_cast<const Post*>(ctx.source)->title));
+    });
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    size_t iterations = argc > 1 ? std::stoul(argv[1]) : 200;
+    Workload workload;
+    workload.work = std::chrono::microseconds(argc > 2 ? std::stoul(argv[2]) : 20);
+    size_t max_threads = argc > 3 ? std::stoul(argv[3]) : 64;
+    workload.sleep = argc > 4 && std::strcmp(argv[4], "--sleep") == 0;
+
+    auto schema = Schema::from_sdl(SCHEMA_SDL);
+    if (!schema) {
+        std::cerr << "Schema failed to load" << std::endl;
+        return 1;
+    }
+    for (int64_t i = 0; i < 64; i++) workload.users.push_back(User{i, "user" + std::to_string(i)});
+    for (int64_t i = 0; i < 32; i++) workload.posts.push_back(Post{1000 + i, "post" + std::to_string(i)});
+    ResolverRegistry resolvers(*schema);
+    add_resolvers(resolvers, workload);
+
+    Interner symbols(&schema->names());
+    LexerCursor cursor(QUERY, std::strlen(QUERY), &symbols);
+    ASTArena document_arena;
+    Parser parser(cursor, document_arena);
+    auto document = parser.parse_document();
+    Executor executor(*schema, resolvers);
+    std::string error;
+    auto plan = QueryPlan::compile(resolvers, executor.coercer(), *document, &error);
+    if (parser.has_errors() || !plan) {
+        std::cerr << "Query failed to compile: " << error << std::endl;
+        return 1;
+    }
+    size_t calls = workload.users.size() * 2 + 1;
+
+    ASTArena arena;
+    auto start = std::chrono::high_resolution_clock::now();
+    size_t errors = 0;
+    for (size_t i = 0; i < iterations; i++) {
+        arena.reset();
+        errors += executor.execute(*plan, arena).errors.size();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    double sequential_seconds = std::chrono::duration<double>(end - start).count();
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << calls << " expensive calls of " << workload.work.count() << " us ("
+              << (workload.sleep ? "sleep" : "spin") << ") per request, " << iterations << " iterations, "
+              << std::thread::hardware_concurrency() << " hardware threads\n";
+    std::cout << "Sequential:   " << std::setw(10) << iterations / sequential_seconds << " req/s\n";
+
+    for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+        Scheduler scheduler(threads);
+        WorkerArenas arenas(scheduler);
+        start = std::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < iterations; i++) {
+            arenas.reset();
+            errors += executor.execute(*plan, arenas, scheduler).errors.size();
+        }
+        end = std::chrono::high_resolution_clock::now();
+        double seconds = std::chrono::duration<double>(end - start).count();
+        std::cout << std::setw(2) << threads << " threads:   " << std::setw(10) << iterations / seconds
+                  << " req/s  speedup " << sequential_seconds / seconds << "x\n";
+    }
+    if (errors) std::cerr << errors << " execution errors" << std::endl;
+    return errors ? 1 : 0;
+}
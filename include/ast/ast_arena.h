@@ -39,7 +39,8 @@ public:
     // Start with 1MB buffer (adjustable based on typical query size)
     explicit ASTArena(size_t initial_size = 1024 * 1024)
         : buffer_(initial_size)
-        , allocator_(&buffer_) {
+        , allocator_(&buffer_)
+        , bytes_allocated_(0) {
     }
     
     // Disable copy (arena owns memory)
@@ -64,6 +65,7 @@ public:
         // Use allocate() with typed allocator (C++17 compatible)
         std::pmr::polymorphic_allocator<T> typed_allocator{&buffer_};
         T* mem = typed_allocator.allocate(1);
+        bytes_allocated_ += sizeof(T);
         
         // Construct object in-place
         return new(mem) T(std::forward<Args>(args)...);
@@ -79,6 +81,7 @@ public:
     T* allocate_array(size_t count) {
         // Use allocate() with typed allocator (C++17 compatible)
         std::pmr::polymorphic_allocator<T> typed_allocator{&buffer_};
+        bytes_allocated_ += sizeof(T) * count;
         return typed_allocator.allocate(count);
     }
     
@@ -90,20 +93,23 @@ public:
      */
     void reset() {
         buffer_.release();
+        bytes_allocated_ = 0;
     }
     
     /**
      * Get the total bytes allocated so far
+     * 
+     * monotonic_buffer_resource doesn't expose this, so create() and
+     * allocate_array() track it themselves (alignment padding not included).
      */
     size_t bytes_allocated() const {
-        // Note: monotonic_buffer_resource doesn't expose this, 
-        // so we'd need to track it manually if needed
-        return 0; // Placeholder
+        return bytes_allocated_;
     }
     
 private:
     std::pmr::monotonic_buffer_resource buffer_;
     std::pmr::polymorphic_allocator<std::byte> allocator_;
+    size_t bytes_allocated_;
 };
 
 /**
@@ -156,6 +162,37 @@ private:
     T* ptr_;
 };
 
+/**
+ * Fixed-size, arena-allocated contiguous array
+ * 
+ * Built once with its final size (see ASTArena::allocate_array) and never
+ * grown, so it is just a pointer and a length. Like every arena object it is
+ * never destroyed individually.
+ */
+template<typename T>
+class ArenaSpan {
+public:
+    ArenaSpan() : data_(nullptr), size_(0) {}
+    ArenaSpan(T* data, size_t size) : data_(data), size_(size) {}
+    
+    T* begin() { return data_; }
+    T* end() { return data_ + size_; }
+    const T* begin() const { return data_; }
+    const T* end() const { return data_ + size_; }
+    
+    T& operator[](size_t i) { return data_[i]; }
+    const T& operator[](size_t i) const { return data_[i]; }
+    
+    T* data() { return data_; }
+    const T* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    
+private:
+    T* data_;
+    size_t size_;
+};
+
 /**
  * Helper to create ArenaPtr
  */
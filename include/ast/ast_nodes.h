@@ -1,11 +1,13 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <string_view>
 #include <vector>
 #include <memory>
 #include <variant>
 #include "ast/ast_arena.h"  // For arena_ptr
+#include "lexer/token/token.h"  // For NO_SYMBOL
 
 // Forward declarations
 struct ASTNode;
@@ -23,8 +25,8 @@ struct NamedType;
 struct ListType;
 struct NonNullType;
 
-// Base node type
-enum class ASTNodeType {
+// Base node type (also the node kind of the flat representation in flat_ast.h)
+enum class ASTNodeType : uint8_t {
     DOCUMENT,
     OPERATION_DEFINITION,
     FRAGMENT_DEFINITION,
@@ -45,7 +47,9 @@ enum class ASTNodeType {
     NULL_VALUE,
     ENUM_VALUE,
     LIST_VALUE,
-    OBJECT_VALUE
+    OBJECT_VALUE,
+    VARIABLE_DEFINITION,
+    OBJECT_FIELD
 };
 
 // Value types
@@ -93,25 +97,75 @@ using Value = std::variant<
     arena_ptr<Variable>
 >;
 
+// Item of a homogeneous scalar list: 8-byte span relative to ListValue::source
+struct PackedScalar {
+    uint32_t offset;
+    uint32_t length;
+};
+
+/**
+ * List literal
+ * 
+ * Items live in a single exact-size arena array. Lists whose items are all
+ * ints, floats, strings or enums ([1, 2, 3], ["a", "b"], [RED, GREEN]) are
+ * stored packed instead: 8 bytes per item and no Value at all. Use size()
+ * and for_each() to handle both layouts.
+ */
 struct ListValue {
-    std::vector<Value> values;
+    ArenaSpan<Value> values;                            // Mixed lists
+    ArenaSpan<PackedScalar> packed;                     // Homogeneous scalar lists
+    ASTNodeType packed_kind = ASTNodeType::LIST_VALUE;  // INT/FLOAT/STRING/ENUM_VALUE when packed
+    const char* source = nullptr;                       // Text of the '[' (packed offsets are relative to it)
     size_t position;
+    
+    bool is_packed() const { return packed_kind != ASTNodeType::LIST_VALUE; }
+    size_t size() const { return is_packed() ? packed.size() : values.size(); }
+    
+    // Packed item accessors
+    std::string_view packed_text(size_t i) const {
+        return std::string_view(source + packed[i].offset, packed[i].length);
+    }
+    size_t packed_position(size_t i) const { return position + packed[i].offset; }
+    
+    // Call fn(const Value&) for every item; packed items are materialized on the fly
+    template<typename Fn>
+    void for_each(Fn&& fn) const;
 };
 
 struct ObjectField {
     std::string_view name;
+    uint32_t name_id = NO_SYMBOL;  // Token::symbol of the name
     Value value;
     size_t position;
 };
 
 struct ObjectValue {
-    std::vector<ObjectField> fields;
+    ArenaSpan<ObjectField> fields;
     size_t position;
 };
 
+template<typename Fn>
+void ListValue::for_each(Fn&& fn) const {
+    if (!is_packed()) {
+        for (const Value& v : values) fn(v);
+        return;
+    }
+    for (size_t i = 0; i < packed.size(); i++) {
+        std::string_view text = packed_text(i);
+        size_t pos = packed_position(i);
+        switch (packed_kind) {
+            case ASTNodeType::INT_VALUE:    fn(Value(IntValue{text, pos})); break;
+            case ASTNodeType::FLOAT_VALUE:  fn(Value(FloatValue{text, pos})); break;
+            case ASTNodeType::STRING_VALUE: fn(Value(StringValue{text, pos})); break;
+            default:                        fn(Value(EnumValue{text, pos})); break;
+        }
+    }
+}
+
 // Variable definition
 struct Variable {
     std::string_view name;  // Without the $
+    uint32_t name_id = NO_SYMBOL;
     size_t position;
 };
 
@@ -126,6 +180,7 @@ struct VariableDefinition {
 // Type system
 struct NamedType {
     std::string_view name;
+    uint32_t name_id = NO_SYMBOL;
     size_t position;
 };
 
@@ -142,6 +197,7 @@ struct NonNullType {
 // Directive
 struct Directive {
     std::string_view name;  // Without the @
+    uint32_t name_id = NO_SYMBOL;
     std::vector<arena_ptr<Argument>> arguments;
     size_t position;
 };
@@ -149,6 +205,7 @@ struct Directive {
 // Argument
 struct Argument {
     std::string_view name;
+    uint32_t name_id = NO_SYMBOL;
     Value value;
     size_t position;
 };
@@ -157,6 +214,8 @@ struct Argument {
 struct Field {
     std::string_view alias;  // Optional, empty if no alias
     std::string_view name;
+    uint32_t alias_id = NO_SYMBOL;
+    uint32_t name_id = NO_SYMBOL;
     std::vector<arena_ptr<Argument>> arguments;
     std::vector<arena_ptr<Directive>> directives;
     arena_ptr<SelectionSet> selection_set;  // Optional
@@ -165,12 +224,14 @@ struct Field {
 
 struct FragmentSpread {
     std::string_view name;
+    uint32_t name_id = NO_SYMBOL;
     std::vector<arena_ptr<Directive>> directives;
     size_t position;
 };
 
 struct InlineFragment {
     std::string_view type_condition;  // Optional, empty if no type condition
+    uint32_t type_condition_id = NO_SYMBOL;
     std::vector<arena_ptr<Directive>> directives;
     arena_ptr<SelectionSet> selection_set;
     size_t position;
@@ -207,6 +268,8 @@ struct OperationDefinition {
 struct FragmentDefinition {
     std::string_view name;
     std::string_view type_condition;
+    uint32_t name_id = NO_SYMBOL;
+    uint32_t type_condition_id = NO_SYMBOL;
     std::vector<arena_ptr<Directive>> directives;
     arena_ptr<SelectionSet> selection_set;
     size_t position;
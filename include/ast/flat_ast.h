@@ -0,0 +1,222 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "ast/ast_nodes.h"  // For ASTNodeType, OperationType
+
+/**
+ * Flat AST - struct-of-arrays document representation
+ *
+ * Every node is an index into a set of parallel arrays instead of a separately
+ * allocated struct. Children are linked through first_child/next_sibling
+ * indices, and all text (names, aliases, literals) is stored as offset/length
+ * spans into the original query source, so the node arrays contain no
+ * pointers at all.
+ *
+ * Benefits:
+ * - Traversal touches a handful of dense arrays (cache-friendly)
+ * - The whole document can be memcpy'd or written out as one blob
+ * - A blob can be used in place (e.g. from an mmap'd file) through a
+ *   FlatDocumentView without rebuilding anything
+ *
+ * Every node also records the source offset Parser gives the tree node as
+ * its position, so a document can be expanded back into a tree without
+ * tokens (see FlatExpander).
+ *
+ * Node layout by kind (text = primary span, aux = secondary span):
+ *   DOCUMENT              children: definitions (always node 0)
+ *   OPERATION_DEFINITION  text: name (may be empty), aux_offset: OperationType
+ *                         children: VARIABLE_DEFINITION*, DIRECTIVE*, SELECTION_SET
+ *   FRAGMENT_DEFINITION   text: name, aux: type condition
+ *                         children: DIRECTIVE*, SELECTION_SET
+ *   VARIABLE_DEFINITION   text: variable name (without $)
+ *                         children: type, default value?, DIRECTIVE*
+ *   SELECTION_SET         children: FIELD | FRAGMENT_SPREAD | INLINE_FRAGMENT
+ *   FIELD                 text: name, aux: alias (may be empty)
+ *                         children: ARGUMENT*, DIRECTIVE*, SELECTION_SET?
+ *   ARGUMENT              text: name, children: value
+ *   FRAGMENT_SPREAD       text: fragment name, children: DIRECTIVE*
+ *   INLINE_FRAGMENT       aux: type condition (may be empty)
+ *                         children: DIRECTIVE*, SELECTION_SET
+ *   DIRECTIVE             text: name (without @), children: ARGUMENT*
+ *   VARIABLE              text: name (without $)
+ *   NAMED_TYPE            text: type name
+ *   LIST_TYPE             children: item type
+ *   NON_NULL_TYPE         children: NAMED_TYPE | LIST_TYPE
+ *   *_VALUE (scalars)     text: literal as written (BOOLEAN_VALUE: aux_offset 0/1)
+ *   LIST_VALUE            children: values
+ *   OBJECT_VALUE          children: OBJECT_FIELD*
+ *   OBJECT_FIELD          text: name, children: value
+ */
+
+constexpr uint32_t FLAT_NONE = UINT32_MAX;
+
+/**
+ * Non-owning view over flat node arrays plus the source they refer to.
+ *
+ * Cheap to copy. Valid as long as the FlatDocument (or blob) and the source
+ * text it was created from are alive.
+ */
+struct FlatDocumentView {
+    const ASTNodeType* kind = nullptr;
+    const uint32_t* first_child = nullptr;
+    const uint32_t* next_sibling = nullptr;
+    const uint32_t* token = nullptr;        // Index of the node's first token
+    const uint32_t* position = nullptr;     // Source offset of the tree node (Parser's position)
+    const uint32_t* text_offset = nullptr;
+    const uint32_t* text_length = nullptr;
+    const uint32_t* aux_offset = nullptr;
+    const uint32_t* aux_length = nullptr;
+    uint32_t node_count = 0;
+    std::string_view source;
+
+    bool empty() const { return node_count == 0; }
+
+    std::string_view text(uint32_t node) const {
+        return source.substr(text_offset[node], text_length[node]);
+    }
+
+    std::string_view aux_text(uint32_t node) const {
+        return source.substr(aux_offset[node], aux_length[node]);
+    }
+
+    /**
+     * Bind a view to a blob produced by FlatDocument::serialize()
+     *
+     * The blob is used in place (no copy); it must be 4-byte aligned and stay
+     * alive as long as the view. Returns false if the blob is malformed or
+     * refers outside of source.
+     */
+    static bool from_blob(const void* data, size_t size, std::string_view source,
+                          FlatDocumentView& out);
+};
+
+/**
+ * Cursor over a single node of a flat document
+ */
+class FlatNode {
+public:
+    FlatNode() : doc_(nullptr), index_(FLAT_NONE) {}
+    FlatNode(const FlatDocumentView* doc, uint32_t index) : doc_(doc), index_(index) {}
+
+    bool valid() const { return index_ != FLAT_NONE; }
+    explicit operator bool() const { return valid(); }
+    uint32_t index() const { return index_; }
+
+    ASTNodeType kind() const { return doc_->kind[index_]; }
+    std::string_view text() const { return doc_->text(index_); }
+    std::string_view aux_text() const { return doc_->aux_text(index_); }
+    uint32_t token() const { return doc_->token[index_]; }
+    uint32_t position() const { return doc_->position[index_]; }
+
+    // Kind-specific accessors
+    std::string_view name() const { return text(); }
+    std::string_view alias() const { return aux_text(); }
+    std::string_view type_condition() const { return aux_text(); }
+    OperationType operation_type() const { return static_cast<OperationType>(doc_->aux_offset[index_]); }
+    bool boolean_value() const { return doc_->aux_offset[index_] != 0; }
+
+    FlatNode first_child() const { return FlatNode(doc_, doc_->first_child[index_]); }
+    FlatNode next_sibling() const { return FlatNode(doc_, doc_->next_sibling[index_]); }
+
+    // First child of the given kind, or an invalid node
+    FlatNode child(ASTNodeType kind) const {
+        for (FlatNode c = first_child(); c; c = c.next_sibling()) {
+            if (c.kind() == kind) return c;
+        }
+        return FlatNode(doc_, FLAT_NONE);
+    }
+
+    template<typename Fn>
+    void for_each_child(Fn&& fn) const {
+        for (FlatNode c = first_child(); c; c = c.next_sibling()) fn(c);
+    }
+
+    bool operator==(const FlatNode& other) const { return index_ == other.index_ && doc_ == other.doc_; }
+    bool operator!=(const FlatNode& other) const { return !(*this == other); }
+
+private:
+    const FlatDocumentView* doc_;
+    uint32_t index_;
+};
+
+/**
+ * Depth-first traversal of a flat document
+ *
+ * The visitor provides:
+ *   bool enter(FlatNode node);  // return false to skip the node's children
+ *   void leave(FlatNode node);
+ *
+ * Uses an explicit stack, so arbitrarily deep documents can't overflow the
+ * call stack.
+ */
+template<typename Visitor>
+void walk_flat(const FlatDocumentView& doc, Visitor& visitor, uint32_t root = 0) {
+    if (root >= doc.node_count) return;
+    std::vector<uint32_t> stack;
+    stack.reserve(64);
+
+    uint32_t node = root;
+    while (true) {
+        if (visitor.enter(FlatNode(&doc, node)) && doc.first_child[node] != FLAT_NONE) {
+            stack.push_back(node);
+            node = doc.first_child[node];
+            continue;
+        }
+        visitor.leave(FlatNode(&doc, node));
+
+        // Climb until a node with an unvisited sibling is found
+        while (node != root && doc.next_sibling[node] == FLAT_NONE) {
+            node = stack.back();
+            stack.pop_back();
+            visitor.leave(FlatNode(&doc, node));
+        }
+        if (node == root) return;
+        node = doc.next_sibling[node];
+    }
+}
+
+/**
+ * Owning flat document, built by FlatParser
+ */
+class FlatDocument {
+public:
+    std::vector<ASTNodeType> kind;
+    std::vector<uint32_t> first_child;
+    std::vector<uint32_t> next_sibling;
+    std::vector<uint32_t> token;
+    std::vector<uint32_t> position;
+    std::vector<uint32_t> text_offset;
+    std::vector<uint32_t> text_length;
+    std::vector<uint32_t> aux_offset;
+    std::vector<uint32_t> aux_length;
+    std::string_view source;
+
+    // Bytes per node across all arrays
+    static constexpr size_t NODE_BYTES = sizeof(ASTNodeType) + 8 * sizeof(uint32_t);
+
+    void clear();
+    void reserve(size_t nodes);
+
+    uint32_t size() const { return static_cast<uint32_t>(kind.size()); }
+    size_t memory_size() const { return kind.capacity() * NODE_BYTES; }
+
+    // Append a node (unlinked) and return its index
+    uint32_t add_node(ASTNodeType k, uint32_t tok, uint32_t pos, uint32_t text_off, uint32_t text_len,
+                      uint32_t aux_off = 0, uint32_t aux_len = 0);
+
+    // The cursor API (FlatNode, walk_flat) works on views, not on the document itself
+    FlatDocumentView view() const;
+
+    /**
+     * Serialize the node arrays into a relocatable blob (source not included)
+     *
+     * Layout: 16-byte header ("TGFA", version, node count, source length)
+     * followed by each array, padded to 4 bytes.
+     */
+    void serialize(std::string& out) const;
+    static size_t blob_size(uint32_t node_count);
+};
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * Epoch-based reclamation for lock-free readers
+ *
+ * Readers bracket every access to shared objects with enter()/exit(). A
+ * writer that unlinks an object hands it to retire() instead of freeing it;
+ * reclaim() frees retired objects once no reader that could still see them
+ * is active.
+ *
+ * Each active reader occupies one cache-line-sized slot holding the global
+ * epoch it observed on entry; an object retired at epoch r is freed when
+ * every occupied slot holds an epoch > r. Threads prefer their own slot, so
+ * uncontended readers touch only their own cache line.
+ *
+ * When all MAX_READERS slots are taken (more concurrent readers than
+ * slots, or a thread holding many), enter() stops probing after one pass
+ * and joins SHARED_SLOT instead: a reference-counted slot, entered under a
+ * mutex, whose epoch is that of its oldest reader. It is slower but never
+ * spins, and holds back reclamation only as long as it has readers.
+ *
+ * enter()/exit() are lock-free outside that fallback and may be called
+ * from any thread;
+ * retire()/reclaim() must be serialized by the caller (writer lock).
+ */
+class EpochManager {
+public:
+    static constexpr size_t MAX_READERS = 128;
+    static constexpr size_t SHARED_SLOT = MAX_READERS;  // Overflow slot, shared by reference count
+
+    EpochManager() : epoch_(1), shared_readers_(0) {
+        for (auto& slot : slots_) slot.epoch.store(0, std::memory_order_relaxed);
+    }
+
+    EpochManager(const EpochManager&) = delete;
+    EpochManager& operator=(const EpochManager&) = delete;
+
+    // Returns the reader slot to pass to exit()
+    size_t enter() {
+        size_t slot = preferred_slot();
+        for (size_t probe = 0; probe < MAX_READERS; probe++) {
+            uint64_t expected = 0;
+            uint64_t epoch = epoch_.load(std::memory_order_seq_cst);
+            if (slots_[slot].epoch.compare_exchange_strong(expected, epoch, std::memory_order_seq_cst)) {
+                return slot;
+            }
+            slot = (slot + 1) % MAX_READERS;  // Slot busy (nested or colliding reader)
+        }
+        return enter_shared();
+    }
+
+    void exit(size_t slot) {
+        if (slot == SHARED_SLOT) {
+            exit_shared();
+            return;
+        }
+        slots_[slot].epoch.store(0, std::memory_order_release);
+    }
+
+    void retire(std::shared_ptr<void> object);
+    void reclaim();
+
+    size_t pending() const { return retired_.size(); }
+
+private:
+    struct alignas(64) ReaderSlot {
+        std::atomic<uint64_t> epoch;  // 0 = free
+    };
+
+    struct Retired {
+        uint64_t epoch;
+        std::shared_ptr<void> object;
+    };
+
+    std::atomic<uint64_t> epoch_;
+    ReaderSlot slots_[MAX_READERS + 1];  // The last one is SHARED_SLOT
+    std::mutex shared_mutex_;
+    size_t shared_readers_;              // Guarded by shared_mutex_
+    std::vector<Retired> retired_;
+
+    size_t enter_shared();
+    void exit_shared();
+
+    static size_t preferred_slot() {
+        static std::atomic<size_t> next_thread{0};
+        thread_local size_t slot = next_thread.fetch_add(1, std::memory_order_relaxed) % MAX_READERS;
+        return slot;
+    }
+};
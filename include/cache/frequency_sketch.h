@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Count-min sketch of access frequencies, for TinyLFU admission
+ *
+ * Counters are 4 bits, packed 16 to a 64-bit word; each key maps to one
+ * counter in each of 4 words, and its frequency estimate is the minimum of
+ * the 4. Once the number of recorded accesses reaches 10x the table width,
+ * every counter is halved, so old popularity decays and the sketch adapts
+ * to shifting traffic.
+ *
+ * Keys are expected to be well-mixed 64-bit hashes (e.g. canonical query
+ * hashes).
+ */
+class FrequencySketch {
+public:
+    static constexpr uint32_t MAX_FREQUENCY = 15;
+
+    explicit FrequencySketch(size_t expected_entries = 1024) {
+        size_t width = 64;
+        while (width < expected_entries) width <<= 1;
+        table_.assign(width, 0);
+        mask_ = width - 1;
+        sample_limit_ = width * 10;
+        samples_ = 0;
+    }
+
+    void increment(uint64_t key) {
+        bool added = false;
+        for (int i = 0; i < 4; i++) {
+            uint64_t& word = table_[index(key, i)];
+            int shift = offset(key, i);
+            if (((word >> shift) & 0xF) < MAX_FREQUENCY) {
+                word += uint64_t(1) << shift;
+                added = true;
+            }
+        }
+        if (added && ++samples_ >= sample_limit_) age();
+    }
+
+    uint32_t frequency(uint64_t key) const {
+        uint32_t freq = MAX_FREQUENCY;
+        for (int i = 0; i < 4; i++) {
+            uint32_t count = static_cast<uint32_t>((table_[index(key, i)] >> offset(key, i)) & 0xF);
+            if (count < freq) freq = count;
+        }
+        return freq;
+    }
+
+    void clear() {
+        std::fill(table_.begin(), table_.end(), 0);
+        samples_ = 0;
+    }
+
+private:
+    std::vector<uint64_t> table_;
+    size_t mask_;
+    size_t sample_limit_;
+    size_t samples_;
+
+    // Row i uses its own multiplier, then picks a word and a nibble in it
+    static uint64_t rehash(uint64_t key, int i) {
+        static constexpr uint64_t SEEDS[4] = {0xC3A5C85C97CB3127ull, 0xB492B66FBE98F273ull,
+                                              0x9AE16A3B2F90404Full, 0xCBF29CE484222325ull};
+        uint64_t h = (key + SEEDS[i]) * 0x9E3779B97F4A7C15ull;
+        return h ^ (h >> 29);
+    }
+
+    size_t index(uint64_t key, int i) const {
+        return static_cast<size_t>(rehash(key, i)) & mask_;
+    }
+
+    static int offset(uint64_t key, int i) {
+        return static_cast<int>((rehash(key, i) >> 58) & 0xF) << 2;
+    }
+
+    // Halve every counter (a 4-bit shift-right within each nibble)
+    void age() {
+        for (uint64_t& word : table_) {
+            word = (word >> 1) & 0x7777777777777777ull;
+        }
+        samples_ /= 2;
+    }
+};
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "cache/query_cache.h"
+#include "cache/sha256.h"
+
+/**
+ * Automatic Persisted Queries (APQ) store
+ *
+ * Maps the SHA-256 of a query (the APQ `sha256Hash` extension) to its text,
+ * and resolves hits to parsed documents through a QueryCache. Registrations
+ * are verified by hashing the submitted text; the store is bounded by entry
+ * count and memory and evicts least recently used hashes.
+ *
+ * The 64-bit cache key is only a hint: a document found under it is
+ * returned only if its canonical form matches the registered text's, and
+ * otherwise the stored text is parsed again. The store's lock is never held
+ * while calling into the cache.
+ *
+ * Usage:
+ *   QueryCache cache;
+ *   PersistedQueryStore apq(cache);
+ *   apq.load_manifest("persisted-queries.json");   // At startup
+ *
+ *   auto result = apq.lookup(hash);
+ *   if (result.status == PersistedQueryStore::Status::NOT_FOUND) {
+ *       // Client retries with the full query
+ *       result = apq.register_query(hash, query);
+ *   }
+ */
+class PersistedQueryStore {
+public:
+    enum class Status {
+        OK,
+        NOT_FOUND,       // Unknown hash: the client must send the query text
+        HASH_MISMATCH,   // The text does not hash to the given sha256Hash
+        INVALID_HASH,    // Not 64 hex digits
+        PARSE_ERROR
+    };
+
+    struct Result {
+        Status status;
+        QueryCache::Handle entry;  // Set when status == OK; pins the document while held
+    };
+
+    explicit PersistedQueryStore(QueryCache& cache, size_t max_entries = 10000,
+                                 size_t max_memory_mb = 64);
+
+    Result lookup(std::string_view sha256_hex);
+    Result lookup(const Sha256Digest& digest);
+
+    // Verify and store a query, parsing it into the cache
+    Result register_query(std::string_view sha256_hex, const std::string& query);
+
+    /**
+     * Preload operations from a persisted-query manifest
+     *
+     * Accepts Apollo's manifest format
+     *   {"format": "apollo-persisted-query-manifest", "version": 1,
+     *    "operations": [{"id": "<sha256>", "body": "<query>", ...}]}
+     * or a flat {"<sha256>": "<query>"} map. Every operation is verified and
+     * parsed up front. Returns the number of operations loaded; entries that
+     * fail verification or parsing are skipped and reported by errors().
+     */
+    size_t load_manifest(const std::string& path);
+    size_t load_manifest_json(std::string_view json);
+
+    const std::vector<std::string>& errors() const { return errors_; }
+    size_t size() const;
+    size_t memory_bytes() const;
+
+private:
+    struct DigestHash {
+        size_t operator()(const Sha256Digest& d) const {
+            uint64_t h;
+            std::memcpy(&h, d.data(), sizeof(h));  // Already uniformly distributed
+            return static_cast<size_t>(h);
+        }
+    };
+
+    // Immutable once stored, so lookups can use it after dropping mutex_
+    struct Registered {
+        std::string source;     // Verified against the digest
+        std::string canonical;  // Its canonical form (CacheEntry::canonical)
+        uint64_t cache_key;     // Canonical hash in the QueryCache
+    };
+
+    struct Entry {
+        std::shared_ptr<const Registered> query;
+        std::list<Sha256Digest>::iterator lru;
+    };
+
+    QueryCache& cache_;
+    size_t max_entries_;
+    size_t max_memory_bytes_;
+    size_t memory_bytes_;
+
+    std::unordered_map<Sha256Digest, Entry, DigestHash> entries_;
+    std::list<Sha256Digest> lru_;  // Most recently used first
+    std::vector<std::string> errors_;
+    mutable std::mutex mutex_;
+
+    Result store(const Sha256Digest& digest, const std::string& query);
+    void evict_if_needed();  // Requires mutex_
+    static size_t entry_bytes(const Registered& query);
+};
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+#include <list>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -7,68 +9,287 @@
 #include <mutex>
 #include <chrono>
 #include "ast/ast_nodes.h"
+#include "ast/ast_arena.h"
+#include "ast/flat_ast.h"
+#include "cache/epoch.h"
+#include "cache/frequency_sketch.h"
 #include "lexer/token/token.h"
+#include "parser/parser_options.h"
+
+class QueryPlan;
 
 // Cache entry for a parsed query
+// Immutable once published, except access_count/last_access, which are only
+// written under the cache's writer lock (see QueryCache).
+// Owns the query text, the tokens and the arena the AST lives in, since the
+// AST and tokens point into the text and the nodes are arena-allocated.
+//
+// Entries restored from a snapshot are "warm": they have no tokens or tree
+// AST, only a flat view whose arrays and source live in the mapped snapshot
+// file (ast == nullptr, flat is set).
+//
+// validated_generation is the exception to immutability: the
+// Schema::generation() the query last passed validation against (0 if
+// none), stored by whichever thread validated it. A document stays valid
+// until the schema changes, so a matching generation lets repeated
+// operations skip validation (see Validator::validate(const CacheEntry&)).
+// Hot-swapping the schema changes the generation, which invalidates every
+// stamp at once without touching the entries.
+//
+// plan is likewise filled in lazily: the QueryPlan compiled from the
+// document by Executor::execute(const CacheEntry&), read and replaced with
+// the atomic shared_ptr functions. Its own generation says which schema it
+// was compiled for, so a schema swap makes it stale the same way; its
+// resolver version does the same for the ResolverRegistry.
 struct CacheEntry {
-    std::unique_ptr<Document> ast;
+    uint64_t key;                     // Canonical hash of the query
+    std::string source;
+    std::string canonical;            // Canonical form the key hashes (CanonicalHasher::form)
     std::vector<Token> tokens;
+    std::unique_ptr<ASTArena> arena;
+    Document* ast;                    // Allocated in arena
+    FlatDocumentView flat;            // Warm entries only
+    std::string_view flat_blob;       // Serialized flat, in the snapshot mapping
     size_t access_count;
     std::chrono::steady_clock::time_point last_access;
     size_t memory_size;  // Approximate memory usage
-    
-    CacheEntry(std::unique_ptr<Document> ast_ptr, std::vector<Token> tok)
-        : ast(std::move(ast_ptr))
-        , tokens(std::move(tok))
+    mutable std::atomic<uint64_t> validated_generation{0};
+    mutable std::shared_ptr<const QueryPlan> plan;
+
+    CacheEntry(uint64_t k, std::string src)
+        : key(k)
+        , source(std::move(src))
+        , arena(std::make_unique<ASTArena>(source.size() * 16 + 1024))  // Sized to the query, not the 1MB default
+        , ast(nullptr)
+        , access_count(1)
+        , last_access(std::chrono::steady_clock::now())
+        , memory_size(0) {}
+
+    CacheEntry(uint64_t k, const FlatDocumentView& view, std::string_view blob)
+        : key(k)
+        , ast(nullptr)
+        , flat(view)
+        , flat_blob(blob)
         , access_count(1)
         , last_access(std::chrono::steady_clock::now())
-        , memory_size(tokens.size() * sizeof(Token)) {}
+        , memory_size(0) {}
+
+    bool is_warm() const { return ast == nullptr; }
+    bool validated_for(uint64_t generation) const {
+        return validated_generation.load(std::memory_order_acquire) == generation;
+    }
+    std::string_view text() const { return is_warm() ? flat.source : std::string_view(source); }
+};
+
+enum class EvictionPolicy {
+    LRU,
+    W_TINYLFU  // Window TinyLFU: small LRU window plus a frequency-admitted main region
 };
 
-// LRU cache for parsed GraphQL queries
+// Cache for parsed GraphQL queries
+//
+// Entries are keyed by the query's canonical hash (Tokenizer::canonical_hash),
+// so the same operation sent with different whitespace, comments, commas or
+// argument order shares one entry. The hash is keyed per process, and a
+// lookup or insert by text only matches an entry whose canonical form equals
+// the query's, so a key collision is a miss, never the wrong document.
+// get(uint64_t) trusts its key: it is for keys computed in this process.
+//
+// The default W-TinyLFU policy keeps one-off queries from flushing hot ones:
+// new entries enter a window LRU holding ~1% of the budget, and an entry
+// leaving the window only gets into the main region (a segmented LRU,
+// probation + protected) if the frequency sketch says it is requested more
+// often than the main-region entry it would displace. Budgets are weighted
+// by CacheEntry::memory_size, so a large entry has to beat as many victims
+// as it takes to make room for it.
+//
+// Reads are lock-free: get() probes an open-addressing table of
+// atomics under epoch protection (EpochManager) and never take mutex_.
+// Recency and frequency updates are recorded in small per-reader buffers
+// and applied by whichever thread next holds the writer lock; when a buffer
+// is full, updates are dropped (the policy only needs a sample). Writers
+// (put, eviction, clear, snapshots) serialize on mutex_, and evicted entries
+// are freed only once no reader can still hold them.
 class QueryCache {
 public:
-    explicit QueryCache(size_t max_size = 100, size_t max_memory_mb = 50);
-    
-    // Add a query to the cache
-    void put(const std::string& query, 
-             std::unique_ptr<Document> ast,
-             const std::vector<Token>& tokens);
-    
-    // Get a cached query (returns nullptr if not found)
-    const CacheEntry* get(const std::string& query);
-    
+    explicit QueryCache(size_t max_size = 100, size_t max_memory_mb = 50,
+                        const ParserOptions& options = ParserOptions(),
+                        EvictionPolicy policy = EvictionPolicy::W_TINYLFU);
+
+    // Canonical cache key of a query (stable within this process only)
+    static uint64_t key_for(const std::string& query);
+
+    // Entries are handed out pinned: one can't be freed while a Handle to it
+    // is alive, even once it is evicted. Handles occupy a reader slot, so
+    // keep them short-lived.
+    class Handle {
+    public:
+        Handle() : cache_(nullptr), slot_(0), entry_(nullptr) {}
+        Handle(Handle&& other) noexcept
+            : cache_(other.cache_), slot_(other.slot_), entry_(other.entry_), owned_(std::move(other.owned_)) {
+            other.cache_ = nullptr;
+        }
+        Handle& operator=(Handle&& other) noexcept {
+            if (this != &other) {
+                release();
+                cache_ = other.cache_;
+                slot_ = other.slot_;
+                entry_ = other.entry_;
+                owned_ = std::move(other.owned_);
+                other.cache_ = nullptr;
+            }
+            return *this;
+        }
+        ~Handle() { release(); }
+
+        const CacheEntry* get() const { return entry_; }
+        const CacheEntry* operator->() const { return entry_; }
+        const CacheEntry& operator*() const { return *entry_; }
+        explicit operator bool() const { return entry_ != nullptr; }
+
+    private:
+        friend class QueryCache;
+        Handle(QueryCache* cache, size_t slot, const CacheEntry* entry)
+            : cache_(cache), slot_(slot), entry_(entry) {}
+        // An entry that is not in the cache (its key collided with another)
+        explicit Handle(std::unique_ptr<const CacheEntry> owned)
+            : cache_(nullptr), slot_(0), entry_(owned.get()), owned_(std::move(owned)) {}
+        void release() {
+            if (cache_) cache_->epoch_.exit(slot_);
+            cache_ = nullptr;
+        }
+
+        QueryCache* cache_;
+        size_t slot_;
+        const CacheEntry* entry_;
+        std::unique_ptr<const CacheEntry> owned_;
+    };
+
+    // Parse a query and add it to the cache. Returns the entry, or an empty
+    // handle only if the query failed to parse (failures are not cached).
+    // The entry is returned even when it isn't kept: the cache is disabled,
+    // a different document already holds the key, admission turned it away
+    // or it alone exceeds the memory budget.
+    Handle put(const std::string& query);
+
+    // Get a cached query (an empty handle if not found)
+    Handle get(const std::string& query);
+    Handle get(uint64_t key);
+
+    // get(), falling back to put() on a miss
+    Handle get_or_put(const std::string& query);
+
     // Clear the cache
     void clear();
-    
+
+    /**
+     * Snapshot / warm restore
+     *
+     * save_snapshot() writes every entry (query text plus the relocatable
+     * flat AST blob, most recently used first) to path. load_snapshot() maps
+     * the file and adds each entry as a warm entry that points straight into
+     * the mapping: nothing is parsed or allocated per node, and the text is
+     * only lexed to recompute its key, since keys are per process. Entries
+     * already in the cache win; corrupt records are skipped. Returns the
+     * number of entries written / restored; save_snapshot() writes every
+     * entry or, on any failure, nothing and returns 0.
+     */
+    size_t save_snapshot(const std::string& path);
+    size_t load_snapshot(const std::string& path);
+
     // Get cache statistics
     struct Stats {
         size_t hits;
         size_t misses;
         size_t total_entries;
         size_t total_memory_bytes;
+        size_t evictions;
         double hit_rate;
     };
     Stats get_stats() const;
-    
+
     // Enable/disable caching
-    void set_enabled(bool enabled) { enabled_ = enabled; }
-    bool is_enabled() const { return enabled_; }
+    void set_enabled(bool enabled) { enabled_.store(enabled, std::memory_order_relaxed); }
+    bool is_enabled() const { return enabled_.load(std::memory_order_relaxed); }
 
 private:
     size_t max_size_;
     size_t max_memory_bytes_;
-    bool enabled_;
-    
-    std::unordered_map<std::string, std::unique_ptr<CacheEntry>> cache_;
+    std::atomic<bool> enabled_;
+    ParserOptions options_;
+
+    // Reader-side index: open addressing over atomic keys and entry pointers.
+    // Key 0 marks an empty bucket; an erased entry leaves its key with a null
+    // pointer (tombstone) until the table is rebuilt.
+    struct ReadTable {
+        size_t mask;
+        size_t used;  // Buckets with a key, including tombstones
+        std::unique_ptr<std::atomic<uint64_t>[]> keys;
+        std::unique_ptr<std::atomic<const CacheEntry*>[]> entries;
+
+        explicit ReadTable(size_t capacity);
+    };
+    std::atomic<ReadTable*> table_;
+    std::unique_ptr<ReadTable> table_owner_;
+    EpochManager epoch_;
+
+    // Lossy single-producer buffer of looked-up keys, one per reader slot
+    struct alignas(64) ReadBuffer {
+        static constexpr uint32_t SIZE = 16;
+        std::atomic<uint32_t> head{0};  // Written by the slot's reader
+        std::atomic<uint32_t> tail{0};  // Written by the drainer (under mutex_)
+        std::atomic<uint64_t> keys[SIZE];
+        std::atomic<size_t> hits{0};
+        std::atomic<size_t> misses{0};
+    };
+    std::unique_ptr<ReadBuffer[]> read_buffers_;  // One per EpochManager slot, SHARED_SLOT included
+
+    enum class Segment : uint8_t { WINDOW, PROBATION, PROTECTED };
+
+    struct Slot {
+        std::unique_ptr<CacheEntry> entry;
+        Segment segment;
+        std::list<uint64_t>::iterator position;  // In the segment's list
+    };
+
+    std::unordered_map<uint64_t, Slot> cache_;
+    size_t memory_bytes_;
+
+    // Recency lists, most recently used first. With LRU only window_ is used.
+    EvictionPolicy policy_;
+    std::list<uint64_t> window_;
+    std::list<uint64_t> probation_;
+    std::list<uint64_t> protected_;
+    size_t window_bytes_;
+    size_t protected_bytes_;
+    FrequencySketch sketch_;
+
+    // Snapshot files backing warm entries, unmapped on clear()/destruction
+    struct MappedFile;
+    std::vector<std::shared_ptr<MappedFile>> snapshots_;
     mutable std::mutex mutex_;
-    
-    // Statistics
-    mutable size_t hits_;
-    mutable size_t misses_;
-    
-    // Eviction policy: remove least recently used
+
+    // Statistics (hits and misses are counted per reader buffer)
+    size_t evictions_;
+
+    // Lock-free read path
+    static uint64_t table_key(uint64_t key) { return key ? key : 1; }  // 0 is reserved for empty
+    const CacheEntry* find(uint64_t key) const;
+    Handle lookup(uint64_t key, const std::string* canonical);  // Verifies the form if given
+    Handle pin(const CacheEntry* entry);  // Requires mutex_
+    void record_read(size_t slot, uint64_t key, bool hit);
+
+    // Writer side; all require mutex_
+    void drain_read_buffers();
+    void table_insert(const CacheEntry* entry);
+    void table_erase(uint64_t key);
+    void rebuild_table(size_t capacity);
+    void insert(std::unique_ptr<CacheEntry> entry, Segment segment, bool most_recent = true);
+    void on_hit(Slot& slot);
+    void move_to(Slot& slot, Segment segment);
+    void remove(uint64_t key);
+    std::list<uint64_t>& list_for(Segment segment);
+    bool over_budget() const;
     void evict_if_needed();
-    std::string find_lru_key() const;
+    void admit(uint64_t candidate);
 };
-
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+using Sha256Digest = std::array<uint8_t, 32>;
+
+/**
+ * SHA-256 of a buffer
+ *
+ * Uses the x86 SHA extensions (SHA-NI) when the CPU has them, otherwise a
+ * portable scalar implementation. The choice is made once, on first use.
+ */
+Sha256Digest sha256(const void* data, size_t len);
+
+inline Sha256Digest sha256(std::string_view text) {
+    return sha256(text.data(), text.size());
+}
+
+// Lowercase hex, as used by the APQ protocol's sha256Hash
+std::string sha256_to_hex(const Sha256Digest& digest);
+
+// Parses 64 hex digits (either case); returns false on malformed input
+bool sha256_from_hex(std::string_view hex, Sha256Digest& out);
+
+// Block compression functions, exposed for testing. Each processes `blocks`
+// 64-byte blocks into state.
+namespace sha256_detail {
+void compress_scalar(uint32_t state[8], const uint8_t* data, size_t blocks);
+void compress_shani(uint32_t state[8], const uint8_t* data, size_t blocks);
+bool shani_supported();  // Compiled in and supported by this CPU
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include "ast/ast_arena.h"
+
+/**
+ * Minimal pull-style JSON reader
+ *
+ * Walks a JSON text in place without building a DOM. Callers drive it by
+ * the shape they expect and skip anything else:
+ *
+ *   JsonReader reader(text);
+ *   std::string key;
+ *   if (reader.begin_object()) {
+ *       while (reader.next_key(key)) {
+ *           if (key == "id") reader.read_string(id);
+ *           else reader.skip_value();
+ *       }
+ *   }
+ *   if (!reader.ok()) ... reader.error() ...
+ *
+ * Any failed call puts the reader into an error state, after which every
+ * call returns false.
+ *
+ * The arena overloads of next_key() and read_string() don't copy strings
+ * without escapes: they return views into the text, so the text must
+ * outlive what is read from it. Strings are scanned 16 bytes at a time
+ * and whitespace runs are skipped with the lexer's SIMD kernels.
+ */
+class JsonReader {
+public:
+    enum class Type { OBJECT, ARRAY, STRING, NUMBER, BOOLEAN, NULL_VALUE, END, INVALID };
+
+    explicit JsonReader(std::string_view text);
+
+    // Type of the next value (without consuming it)
+    Type peek();
+
+    // Objects: begin_object() consumes '{', then next_key() returns each key
+    // and false once '}' is consumed. The value must be read or skipped
+    // before the next call.
+    bool begin_object();
+    bool next_key(std::string& key);
+    bool next_key(std::string_view& key, ASTArena& arena);
+
+    // Arrays: begin_array() consumes '[', then next_element() returns true
+    // while another element follows and false once ']' is consumed.
+    bool begin_array();
+    bool next_element();
+
+    bool read_string(std::string& out);  // Unescaped, UTF-8
+    bool read_string(std::string_view& out, ASTArena& arena);
+    bool read_number(double& out);
+    // The number's text, checked against the JSON grammar; integer is set
+    // when it has neither fraction nor exponent
+    bool read_number(std::string_view& token, bool& integer);
+    bool read_bool(bool& out);
+    bool read_null();
+    bool skip_value();
+
+    bool ok() const { return error_.empty(); }
+    const std::string& error() const { return error_; }
+    size_t position() const { return pos_; }
+
+private:
+    std::string_view text_;
+    size_t pos_;
+    std::string error_;
+    bool after_value_;  // A comma is required before the next element/key
+
+    void skip_whitespace();
+    bool fail(const char* message);
+    bool expect_literal(std::string_view literal);
+    bool next_item(char close);
+    bool scan_string(std::string_view& body, bool& escaped);
+    bool unescape(std::string_view body, std::string& out);
+};
@@ -0,0 +1,197 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "lexer/token/token.h"
+
+/**
+ * Streaming canonical form and keyed hash of a GraphQL token stream
+ *
+ * Fed one token at a time (from the tokenize loop), it builds the
+ * document's canonical form, a byte string that only depends on its
+ * meaning-bearing tokens:
+ * - Whitespace and comments never become tokens, and commas are skipped
+ * - Arguments, variable definitions and input object fields are put in a
+ *   fixed order, so `f(a: 1, b: 2)` and `f(b: 2, a: 1)` have the same form
+ * - Everything else (selections, list items) keeps its order
+ *
+ * Items inside `( ... )` (and object values nested in them) are split where
+ * a `:` follows a name, so each `name: value` pair is one item; when the
+ * group closes its items are sorted bytewise.
+ *
+ * finish() hashes the form with SipHash-2-4 under a key drawn at random once
+ * per process, so cache keys can't be predicted (or collided on purpose)
+ * from outside and are only comparable within one process. Two documents
+ * with the same key are the same operation only if their forms match, which
+ * is what QueryCache checks.
+ *
+ * Usage:
+ *   CanonicalHasher hasher;
+ *   for (const Token& t : tokens) hasher.add(t);
+ *   uint64_t key = hasher.finish();
+ *   const std::string& form = hasher.form();
+ */
+class CanonicalHasher {
+public:
+    struct Key {
+        uint64_t k0;
+        uint64_t k1;
+    };
+
+    // Random key shared by every hasher in this process
+    static const Key& process_key() {
+        static const Key key = [] {
+            std::random_device random;
+            auto word = [&random] { return (static_cast<uint64_t>(random()) << 32) ^ random(); };
+            uint64_t k0 = word();
+            return Key{k0, word()};
+        }();
+        return key;
+    }
+
+    explicit CanonicalHasher(const Key& key = process_key()) : key_(key) {
+        frames_.reserve(16);
+        frames_.push_back(Frame{0, NONE, false, false});
+    }
+
+    void add(const Token& token) {
+        switch (token.type) {
+            case COMMA:
+                return;
+            case LEFT_PAREN:
+            case LEFT_BRACE:
+            case LEFT_BRACKET: {
+                begin_unit(frames_.back());
+                append_token(token);
+                bool in_args = frames_.back().in_args || token.type == LEFT_PAREN;
+                bool commutative = in_args && token.type != LEFT_BRACKET;
+                frames_.push_back(Frame{items_.size(), NONE, commutative, in_args});
+                return;
+            }
+            case RIGHT_PAREN:
+            case RIGHT_BRACE:
+            case RIGHT_BRACKET:
+                if (frames_.size() > 1) {
+                    close_frame();
+                    append_token(token);
+                    return;
+                }
+                break;  // Unbalanced: kept like any other token
+            case COLON: {
+                Frame& frame = frames_.back();
+                if (frame.commutative && frame.last_unit != NONE) {
+                    // The last unit (the name) starts a new item
+                    items_.push_back(frame.last_unit);
+                }
+                break;
+            }
+            default:
+                break;
+        }
+        begin_unit(frames_.back());
+        append_token(token);
+    }
+
+    // Hash of everything added so far; unclosed groups are closed first, so
+    // no tokens may be added afterwards
+    uint64_t finish() {
+        while (frames_.size() > 1) close_frame();
+        return siphash(key_, form_.data(), form_.size());
+    }
+
+    // Canonical form of everything added, complete once finish() returned
+    const std::string& form() const { return form_; }
+
+    // SipHash-2-4 of raw bytes (little-endian word loads)
+    static uint64_t siphash(const Key& key, const char* data, size_t size) {
+        uint64_t v0 = key.k0 ^ 0x736F6D6570736575ull;
+        uint64_t v1 = key.k1 ^ 0x646F72616E646F6Dull;
+        uint64_t v2 = key.k0 ^ 0x6C7967656E657261ull;
+        uint64_t v3 = key.k1 ^ 0x7465646279746573ull;
+
+        const char* p = data;
+        size_t n = size;
+        for (; n >= 8; p += 8, n -= 8) {
+            uint64_t m;
+            std::memcpy(&m, p, 8);
+            v3 ^= m;
+            sip_round(v0, v1, v2, v3);
+            sip_round(v0, v1, v2, v3);
+            v0 ^= m;
+        }
+        uint64_t last = static_cast<uint64_t>(size) << 56;
+        for (size_t i = 0; i < n; i++) last |= static_cast<uint64_t>(static_cast<unsigned char>(p[i])) << (8 * i);
+        v3 ^= last;
+        sip_round(v0, v1, v2, v3);
+        sip_round(v0, v1, v2, v3);
+        v0 ^= last;
+
+        v2 ^= 0xFF;
+        for (int i = 0; i < 4; i++) sip_round(v0, v1, v2, v3);
+        return v0 ^ v1 ^ v2 ^ v3;
+    }
+
+private:
+    static constexpr size_t NONE = SIZE_MAX;
+
+    struct Frame {
+        size_t first_item;   // Index of its first item start in items_
+        size_t last_unit;    // Offset of its last token or nested group, NONE if empty
+        bool commutative;
+        bool in_args;        // Inside an argument or variable definition list
+    };
+
+    Key key_;
+    std::string form_;
+    std::vector<Frame> frames_;
+    std::vector<size_t> items_;  // Item start offsets of the open commutative groups
+
+    void begin_unit(Frame& frame) { frame.last_unit = form_.size(); }
+
+    // Type, value length, value: unambiguous however values are spelled
+    void append_token(const Token& token) {
+        uint32_t length = static_cast<uint32_t>(token.value.size());
+        form_.push_back(static_cast<char>(token.type));
+        form_.append(reinterpret_cast<const char*>(&length), sizeof(length));
+        form_.append(token.value.data(), token.value.size());
+    }
+
+    // Sorts the innermost group's items in place and pops it
+    void close_frame() {
+        Frame frame = frames_.back();
+        frames_.pop_back();
+        if (!frame.commutative || items_.size() - frame.first_item < 2) {
+            items_.resize(frame.first_item);
+            return;
+        }
+
+        std::vector<std::string_view> items;
+        items.reserve(items_.size() - frame.first_item);
+        for (size_t i = frame.first_item; i < items_.size(); i++) {
+            size_t end = i + 1 < items_.size() ? items_[i + 1] : form_.size();
+            items.emplace_back(form_.data() + items_[i], end - items_[i]);
+        }
+        std::sort(items.begin(), items.end());
+
+        size_t begin = items_[frame.first_item];
+        std::string sorted;
+        sorted.reserve(form_.size() - begin);
+        for (std::string_view item : items) sorted.append(item);
+        form_.replace(begin, sorted.size(), sorted);
+        items_.resize(frame.first_item);
+    }
+
+    static uint64_t rotl(uint64_t x, int b) { return (x << b) | (x >> (64 - b)); }
+
+    static void sip_round(uint64_t& v0, uint64_t& v1, uint64_t& v2, uint64_t& v3) {
+        v0 += v1; v1 = rotl(v1, 13); v1 ^= v0; v0 = rotl(v0, 32);
+        v2 += v3; v3 = rotl(v3, 16); v3 ^= v2;
+        v0 += v3; v3 = rotl(v3, 21); v3 ^= v0;
+        v2 += v1; v1 = rotl(v1, 17); v1 ^= v2; v2 = rotl(v2, 32);
+    }
+};
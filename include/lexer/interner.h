@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+/**
+ * Name interner (symbol table)
+ *
+ * Maps each distinct name to a dense 32-bit symbol ID (in order of first
+ * appearance), so later stages compare and index by integer instead of
+ * rehashing strings.
+ *
+ * The table is a SIMD-probed open-addressing ("Swiss") table: one control
+ * byte per slot holds 7 bits of the name's hash, and a lookup compares a
+ * whole group of 16 control bytes against the tag in one SSE2 instruction,
+ * so a probe touches the name bytes only on a likely match.
+ *
+ * An interner may be layered over a base, typically a Schema's names():
+ * names already in the base keep the base's IDs (which are the schema's
+ * name IDs), and new names are numbered after them in the layer. The base
+ * must not change while layers over it exist; a layer is cheap to create,
+ * e.g. one per request over a shared, immutable schema.
+ *
+ * Usage:
+ *   Interner symbols(&schema->names());
+ *   Tokenizer tokenizer(&symbols);        // Tokens now carry Token::symbol
+ *   const FieldDef* f = schema->field(type, token.symbol);
+ */
+class Interner {
+public:
+    static constexpr uint32_t INVALID = UINT32_MAX;  // Same as NO_SYMBOL
+
+    explicit Interner(const Interner* base = nullptr);
+
+    Interner(const Interner&) = delete;
+    Interner& operator=(const Interner&) = delete;
+    Interner(Interner&&) = default;
+    Interner& operator=(Interner&&) = default;
+
+    // ID of name, adding it if new
+    uint32_t intern(std::string_view name);
+
+    // ID of name, or INVALID if it was never interned
+    uint32_t find(std::string_view name) const;
+
+    std::string_view name(uint32_t id) const {
+        return id < base_size_ ? base_->name(id) : names_[id - base_size_];
+    }
+    size_t size() const { return base_size_ + names_.size(); }
+
+    static uint64_t hash(std::string_view name);
+
+private:
+    static constexpr size_t GROUP_SIZE = 16;
+    static constexpr uint8_t EMPTY = 0x80;       // Full slots hold a 7-bit tag
+    static constexpr size_t CHUNK_SIZE = 16 * 1024;
+
+    const Interner* base_;
+    uint32_t base_size_;
+    std::vector<uint8_t> control_;  // One byte per slot
+    std::vector<uint32_t> slots_;   // Local name index per slot
+    size_t group_mask_;             // Group count - 1
+    std::vector<std::string_view> names_;
+    std::vector<std::unique_ptr<char[]>> chunks_;  // Name bytes; never move
+    char* chunk_;                                  // Chunk being filled
+    size_t chunk_used_;
+
+    uint32_t find_local(std::string_view name, uint64_t h) const;
+    void insert_slot(uint32_t local, uint64_t h);
+    void grow();
+    std::string_view store(std::string_view name);
+};
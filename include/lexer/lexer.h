@@ -1,16 +1,89 @@
 #pragma once
 
+#include <cstdint>
+#include <string>
 #include <string_view>
 #include <vector>
 #include <memory_resource>
 
+#include "lexer/interner.h"
 #include "lexer/token/token.h"
 #include "lexer/token/token_arena.h"
 
+class CanonicalHasher;
+
 class Tokenizer {
 public:
+    // With an interner, every name, $variable and @directive token gets its
+    // name's symbol ID in Token::symbol (variables and directives without
+    // the sigil); otherwise Token::symbol stays NO_SYMBOL.
+    explicit Tokenizer(Interner* interner = nullptr) : interner_(interner) {}
+    
     // Main tokenize function
+    // Lexing stops once more than max_tokens tokens have been produced, so a
+    // hostile document costs at most max_tokens + 1 tokens before the Parser
+    // rejects it (see ParserOptions::max_tokens).
+    std::pmr::vector<Token>& tokenize(const char* text, 
+                                      size_t text_len, 
+                                      TokenArena& arena,
+                                      size_t max_tokens = SIZE_MAX);
+    
+    // Same as above, also feeding every token to hasher in the same pass
+    // (call hasher.finish() for the canonical hash, see CanonicalHasher)
     std::pmr::vector<Token>& tokenize(const char* text, 
                                       size_t text_len, 
-                                      TokenArena& arena);
+                                      TokenArena& arena,
+                                      size_t max_tokens,
+                                      CanonicalHasher& hasher);
+    
+    // Canonical hash only; lexes without storing any tokens. The hash is
+    // keyed per process; form, if given, receives the canonical form.
+    static uint64_t canonical_hash(const char* text, size_t text_len, std::string* form = nullptr);
+
+private:
+    Interner* interner_;
+};
+
+/**
+ * Pull-mode lexer: produces tokens on demand instead of materializing them
+ * 
+ * Tokens are scanned with the same kernels as Tokenizer::tokenize into a
+ * small ring buffer, so at most RING_SIZE consecutive tokens are available at
+ * any time. The Parser uses this in fused mode (see Parser(LexerCursor&, ...)),
+ * which needs one token of lookbehind and one of lookahead.
+ * 
+ * Usage:
+ *   LexerCursor cursor(text, text_len);
+ *   for (size_t i = 0; cursor.has(i); i++) {
+ *       const Token& tok = cursor.at(i);
+ *   }
+ */
+class LexerCursor {
+public:
+    static constexpr size_t RING_SIZE = 8;  // Power of two
+    
+    LexerCursor(const char* text, size_t text_len, Interner* interner = nullptr);
+    
+    // True if token `index` exists, lexing ahead as needed
+    bool has(size_t index) {
+        return index < produced_ || fill(index);
+    }
+    
+    // Token `index`; requires has(index) and index + RING_SIZE > tokens_produced()
+    const Token& at(size_t index) const { return ring_[index & RING_MASK]; }
+    
+    size_t tokens_produced() const { return produced_; }
+
+private:
+    static constexpr size_t RING_MASK = RING_SIZE - 1;
+    
+    const char* text_;
+    size_t text_len_;
+    size_t pos_;
+    size_t produced_;
+    bool done_;
+    Interner* interner_;
+    Token ring_[RING_SIZE];
+    
+    bool fill(size_t index);
 };
@@ -1,8 +1,12 @@
 #pragma once
 
+#include <cstdint>
 #include <string_view>
 #include "token_type.h"
 
+// Token::symbol when no Interner was attached to the lexer
+constexpr uint32_t NO_SYMBOL = UINT32_MAX;
+
 /**
  * Token structure representing a lexical unit in GraphQL
  */
@@ -10,6 +14,7 @@ struct Token {
     std::string_view value; // 16 bytes
     size_t position;        // 8 bytes
     TokenType type;         // 4 bytes
+    uint32_t symbol = NO_SYMBOL;  // Interned name (names, $variables, @directives); fills padding
 
     Token(TokenType t, std::string_view v, size_t p)
         : type(t), value(v), position(p) {}
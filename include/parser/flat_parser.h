@@ -0,0 +1,115 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "ast/ast_nodes.h"
+#include "ast/flat_ast.h"
+#include "lexer/interner.h"
+#include "lexer/token/token.h"
+#include "parser/parser_options.h"
+
+/**
+ * Builds the flat (struct-of-arrays) AST of a document
+ *
+ * There is one grammar: the tokens are parsed by Parser, under the same
+ * ParserOptions and with the same errors and limits, and the resulting tree
+ * is then written out as a FlatDocument in pre-order. Whatever Parser
+ * accepts FlatParser accepts, with the same structure.
+ *
+ * Usage:
+ *   FlatDocument doc;
+ *   FlatParser parser(tokens, source);
+ *   if (parser.parse_document(doc)) {
+ *       FlatDocumentView view = doc.view();
+ *       walk_flat(view, visitor);
+ *   }
+ */
+class FlatParser {
+public:
+    // tokens must have been lexed from source (token values point into it)
+    FlatParser(const std::vector<Token>& tokens, std::string_view source,
+               const ParserOptions& options = ParserOptions());
+
+    // Parse into out (cleared first). Returns false if any error was
+    // recorded, in which case out is left empty.
+    bool parse_document(FlatDocument& out);
+
+    // Flatten a tree Parser built from this parser's tokens into out
+    void flatten(const Document& document, FlatDocument& out);
+
+    const std::vector<std::string>& get_errors() const { return errors_; }
+    bool has_errors() const { return !errors_.empty(); }
+    const std::optional<ParserLimit>& limit_exceeded() const { return limit_exceeded_; }
+
+private:
+    const std::vector<Token>& tokens_;
+    std::string_view source_;
+    ParserOptions options_;
+    FlatDocument* doc_;
+    std::vector<uint32_t> last_child_;  // Tail of each node's child list while building
+    std::vector<std::string> errors_;
+    std::optional<ParserLimit> limit_exceeded_;
+
+    // Node construction
+    uint32_t token_at(size_t position) const;
+    uint32_t offset_of(std::string_view text) const;
+    uint32_t add_child(uint32_t parent, ASTNodeType kind, size_t position,
+                       std::string_view text = std::string_view(),
+                       uint32_t aux_offset = 0, uint32_t aux_length = 0);
+    uint32_t add_child(uint32_t parent, ASTNodeType kind, size_t position, std::string_view text,
+                       std::string_view aux);
+
+    // Each flatten_* appends the node(s) it builds to parent
+    void flatten_operation(uint32_t parent, const OperationDefinition& op);
+    void flatten_fragment(uint32_t parent, const FragmentDefinition& fragment);
+    void flatten_selection_set(uint32_t parent, const SelectionSet& selection_set);
+    void flatten_arguments(uint32_t parent, const std::vector<arena_ptr<Argument>>& arguments);
+    void flatten_directives(uint32_t parent, const std::vector<arena_ptr<Directive>>& directives);
+    void flatten_type(uint32_t parent, const ASTNode& type);
+    void flatten_value(uint32_t parent, const Value& value);
+};
+
+/**
+ * Rebuilds the tree AST of a flat document, the inverse of FlatParser
+ *
+ * Nothing is lexed or parsed: nodes, names, literals and positions all come
+ * from the view, and names point into its source, so the tree is the one
+ * Parser built (scalar lists packed the same way). With an interner, names
+ * get symbol IDs as if the tokens had been interned by the Tokenizer.
+ *
+ * Used for warm cache entries, which only have a flat view, by the
+ * consumers that walk the tree (Validator, QueryPlan).
+ *
+ * Usage:
+ *   ASTArena arena;
+ *   FlatExpander expander(view, arena, &symbols);
+ *   arena_ptr<Document> document = expander.expand();
+ */
+class FlatExpander {
+public:
+    // view must be a valid document (as FlatParser builds and from_blob checks)
+    FlatExpander(const FlatDocumentView& view, ASTArena& arena, Interner* interner = nullptr);
+
+    arena_ptr<Document> expand();
+
+private:
+    const FlatDocumentView& view_;
+    ASTArena& arena_;
+    Interner* interner_;
+
+    uint32_t symbol(std::string_view name) const;
+
+    arena_ptr<OperationDefinition> expand_operation(FlatNode node);
+    arena_ptr<FragmentDefinition> expand_fragment(FlatNode node);
+    arena_ptr<SelectionSet> expand_selection_set(FlatNode node);
+    arena_ptr<Argument> expand_argument(FlatNode node);
+    arena_ptr<Directive> expand_directive(FlatNode node);
+    arena_ptr<ASTNode> expand_type(FlatNode node);
+    Value expand_value(FlatNode node);
+
+    // Copy items into an exact-size arena array, as Parser does
+    template<typename T>
+    ArenaSpan<T> to_arena(std::vector<T>& items);
+};
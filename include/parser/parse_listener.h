@@ -0,0 +1,34 @@
+#pragma once
+
+#include "ast/ast_nodes.h"
+
+/**
+ * Observes the document while Parser builds it
+ *
+ * Set as ParserOptions::listener. Callbacks arrive in source order as each
+ * construct is recognized, before its selection set is parsed, so a
+ * listener can act on a prefix of the document (e.g. reject it) without
+ * waiting for the full AST. Nodes passed to begin_* have everything up to
+ * their selection set filled in: names, arguments and directives.
+ *
+ * A callback may throw ParseLimitExceeded to abort the parse; Parser
+ * reports it like its own limits, through limit_exceeded(). After a syntax
+ * error the matching end_* callbacks may be missing, so listeners should
+ * treat begin_operation / begin_fragment as closing any open definition.
+ *
+ * Only Parser (the tree parser) calls listeners.
+ */
+class ParseListener {
+public:
+    virtual ~ParseListener() = default;
+
+    virtual void begin_operation(const OperationDefinition&) {}
+    virtual void begin_fragment(const FragmentDefinition&) {}
+    virtual void end_definition() {}
+
+    virtual void begin_field(const Field&) {}
+    virtual void end_field(const Field&) {}
+    virtual void begin_inline_fragment(const InlineFragment&) {}
+    virtual void end_inline_fragment(const InlineFragment&) {}
+    virtual void fragment_spread(const FragmentSpread&) {}
+};
@@ -1,16 +1,29 @@
 #pragma once
 
 #include <memory>
+#include <memory_resource>
 #include <vector>
 #include <string>
 #include <optional>
 #include "ast/ast_nodes.h"
 #include "ast/ast_arena.h"
 #include "lexer/token/token.h"
+#include "lexer/lexer.h"
+#include "parser/parser_options.h"
 
 class Parser {
 public:
-    explicit Parser(const std::vector<Token>& tokens, ASTArena& arena);
+    explicit Parser(const std::vector<Token>& tokens, ASTArena& arena,
+                    const ParserOptions& options = ParserOptions());
+    // Straight over Tokenizer::tokenize's output, without copying it out
+    explicit Parser(const std::pmr::vector<Token>& tokens, ASTArena& arena,
+                    const ParserOptions& options = ParserOptions());
+    
+    // Fused mode: pull tokens on demand from the cursor instead of walking a
+    // materialized token vector. Produces the same Document; 
+    // exact_preallocation is ignored (there is no token stream to pre-scan).
+    explicit Parser(LexerCursor& cursor, ASTArena& arena,
+                    const ParserOptions& options = ParserOptions());
     
     // Main parsing entry point
     arena_ptr<Document> parse_document();
@@ -18,18 +31,38 @@ public:
     // Get parsing errors
     const std::vector<std::string>& get_errors() const { return errors_; }
     bool has_errors() const { return !errors_.empty(); }
+    
+    // Set when parsing was aborted by a ParserOptions limit
+    const std::optional<ParserLimit>& limit_exceeded() const { return limit_exceeded_; }
 
 private:
-    const std::vector<Token>& tokens_;
+    const Token* tokens_;
+    size_t token_count_;
+    LexerCursor* cursor_;  // Set in fused mode, tokens_ is then empty
     size_t current_;
     ASTArena& arena_;
     std::vector<std::string> errors_;
     
+    // Resource limits
+    ParserOptions options_;
+    size_t depth_;
+    size_t alias_count_;
+    std::optional<ParserLimit> limit_exceeded_;
+    
+    // Child counts per opening token index (exact_preallocation mode only)
+    std::vector<uint32_t> child_counts_;
+    
+    // Scratch stacks for list/object items, reused across the whole parse
+    std::vector<Value> value_scratch_;
+    std::vector<ObjectField> field_scratch_;
+    std::vector<PackedScalar> packed_scratch_;
+    
     // Token navigation
     const Token& current_token() const;
     const Token& peek(size_t offset = 1) const;
     bool is_at_end() const;
     const Token& advance();
+    const Token& previous_token() const;
     bool check(TokenType type) const;
     bool match(TokenType type);
     bool expect(TokenType type, const char* message);
@@ -39,6 +72,22 @@ private:
     void error_at_current(const std::string& message);
     void synchronize();  // Error recovery
     
+    // Resource limits (throw ParseLimitExceeded)
+    [[noreturn]] void limit_error(ParserLimit limit, const char* message);
+    void enter_nesting();
+    void leave_nesting() { depth_--; }
+    void check_ast_bytes();
+    void check_list_size(size_t size);
+    
+    // Two-pass preallocation
+    void take_census();
+    template<typename Vec>
+    void reserve_children(Vec& children, size_t open_token) const {
+        if (open_token < child_counts_.size() && child_counts_[open_token] != 0) {
+            children.reserve(child_counts_[open_token]);
+        }
+    }
+    
     // Parsing methods
     arena_ptr<Document> parse_document_impl();
     Definition parse_definition();
@@ -76,6 +125,21 @@ private:
     Value parse_enum_value();
     Value parse_list_value();
     Value parse_object_value();
+    static ASTNodeType scalar_kind(const Token& token);
+    
+    // Move scratch[mark..] into an exact-size arena array and pop it off the stack
+    template<typename T>
+    ArenaSpan<T> move_to_arena(std::vector<T>& scratch, size_t mark) {
+        size_t count = scratch.size() - mark;
+        if (count == 0) return ArenaSpan<T>();
+        T* items = arena_.allocate_array<T>(count);
+        for (size_t i = 0; i < count; i++) {
+            new (&items[i]) T(std::move(scratch[mark + i]));
+        }
+        scratch.resize(mark);
+        check_ast_bytes();
+        return ArenaSpan<T>(items, count);
+    }
     
     // Helpers
     OperationType parse_operation_type();
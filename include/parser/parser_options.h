@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+class ParseListener;
+
+/**
+ * Resource limits enforced by the Parser while it runs.
+ *
+ * Every limit defaults to "unlimited" (SIZE_MAX), so the checks on the hot
+ * parse paths are a single well-predicted compare when nothing is configured.
+ * When a limit is hit the parser aborts immediately: no error recovery is
+ * attempted and parse_document() returns nullptr.
+ *
+ * Usage:
+ *   ParserOptions opts;
+ *   opts.max_depth = 32;
+ *   opts.max_tokens = 10'000;
+ *   Parser parser(tokens, arena, opts);
+ */
+struct ParserOptions {
+    static constexpr size_t UNLIMITED = SIZE_MAX;
+
+    size_t max_tokens = UNLIMITED;                // Tokens in the whole document
+    size_t max_depth = UNLIMITED;                 // Nesting of selection sets, list/object values and list types
+    size_t max_aliases = UNLIMITED;               // Aliased fields in the whole document
+    size_t max_directives_per_field = UNLIMITED;  // Directives on a single field (or any other directive location)
+    size_t max_list_size = UNLIMITED;             // Elements in a single list value or fields in an object value
+    size_t max_arena_bytes = UNLIMITED;           // Bytes handed out by the ASTArena for this document (see below)
+
+    // max_arena_bytes counts arena allocations only: nodes and list/object
+    // value arrays. The std::vector child arrays of selection sets,
+    // arguments, directives and definitions live on the global heap and are
+    // not included; they hold one pointer per child token, so max_tokens is
+    // what bounds them.
+
+    // Two-pass mode: count the children of every selection set and argument
+    // or variable definition group in a cheap pre-pass over the tokens, then
+    // reserve their child arrays at the exact size so they never reallocate
+    // while the AST is built. (List and object values always get exact-size
+    // arena arrays, so the pre-pass skips over them.)
+    bool exact_preallocation = false;
+
+    // Notified of operations, fragments and fields as they are parsed (Parser
+    // only, see ParseListener); it may abort the parse by throwing
+    // ParseLimitExceeded. Not owned.
+    ParseListener* listener = nullptr;
+};
+
+// Which limit aborted the parse
+enum class ParserLimit {
+    TOKENS,
+    DEPTH,
+    ALIASES,
+    DIRECTIVES,
+    LIST_SIZE,
+    ARENA_BYTES,
+    COST  // Raised by a listener, e.g. CostAnalyzer
+};
+
+/**
+ * Thrown internally when a ParserOptions limit is exceeded.
+ *
+ * Parser::parse_document() catches it, records an error and returns nullptr,
+ * so callers only see it through Parser::limit_exceeded().
+ */
+class ParseLimitExceeded : public std::runtime_error {
+public:
+    ParseLimitExceeded(ParserLimit limit, const std::string& message)
+        : std::runtime_error(message), limit_(limit) {}
+
+    ParserLimit limit() const { return limit_; }
+
+private:
+    ParserLimit limit_;
+};
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include "ast/ast_arena.h"
+#include "runtime/resolver.h"
+
+/**
+ * Suspended async resolvers of one Executor, waiting to be resumed
+ *
+ * Whatever a resolver awaits may complete anywhere (an I/O thread, a
+ * storage engine's callback); it only posts the coroutine here. The
+ * executor resumes it on its own thread, so resolver bodies never run
+ * concurrently with the rest of their request and keep allocating from
+ * the request arena without locks.
+ */
+class ResumeQueue {
+public:
+    ResumeQueue() = default;
+    ResumeQueue(const ResumeQueue&) = delete;
+    ResumeQueue& operator=(const ResumeQueue&) = delete;
+
+    // Any thread
+    void post(std::coroutine_handle<> handle);
+
+    // Executor thread: resumes what was posted so far; false if nothing was
+    bool run_ready();
+    // Blocks until something is posted, then runs it
+    void wait_and_run();
+    // Runs until every coroutine started against this queue has finished
+    void drain();
+
+    // Started and not finished; executor thread only
+    size_t outstanding() const { return outstanding_; }
+
+private:
+    friend class AsyncResolved;
+
+    std::mutex mutex_;
+    std::condition_variable posted_;
+    std::vector<std::coroutine_handle<>> ready_;
+    std::vector<std::coroutine_handle<>> running_;
+    size_t outstanding_ = 0;
+};
+
+// Resumes a suspended async resolver; call exactly once, from any thread
+class Wakeup {
+public:
+    Wakeup(ResumeQueue* queue, std::coroutine_handle<> handle) : queue_(queue), handle_(handle) {}
+    void operator()() const { queue_->post(handle_); }
+
+private:
+    ResumeQueue* queue_;
+    std::coroutine_handle<> handle_;
+};
+
+/**
+ * Return type of coroutine resolvers (see ResolverRegistry::add_async)
+ *
+ * The coroutine starts running inside the resolver call, as a plain
+ * resolver would; if it finishes without suspending, its field completes
+ * right away. Otherwise the field is deferred like a batch loader key:
+ * plan execution goes on with the rest of the response and completes it
+ * once the coroutine co_returns, so every resolver awaiting I/O has it in
+ * flight at the same time, on one thread. The interpreter and parallel
+ * runs wait for it where the field is completed.
+ *
+ * The coroutine must take the FieldContext as a parameter: its frame and
+ * result are allocated from ctx.arena, never the global heap, and go with
+ * the request arena. Registered through add_async, ctx stays valid across
+ * suspensions. An exception escaping the body becomes a field error.
+ *
+ * Usage:
+ *   resolvers.add_async("User", "bio", [&store](const FieldContext& ctx) -> AsyncResolved {
+ *       const char* bio = nullptr;
+ *       co_await suspend([&](Wakeup wakeup) { store.fetch(user_id(ctx), &bio, wakeup); });
+ *       co_return Resolved::scalar(ResponseValue::of_string(ctx.copy(bio)));
+ *   });
+ */
+class AsyncResolved {
+public:
+    class promise_type {
+    public:
+        // Coroutine parameters: the closure (for lambdas), then the FieldContext
+        template <typename... Args>
+        explicit promise_type(const Args&... args) : promise_type(context_of(args...)) {}
+        explicit promise_type(const FieldContext& ctx)
+            : arena_(ctx.arena), queue_(ctx.resume), result_(ctx.arena->create<DeferredValue>()) {
+            queue_->outstanding_++;
+        }
+
+        template <typename... Args>
+        static void* operator new(size_t size, const Args&... args) {
+            size_t units = (size + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t);
+            return context_of(args...).arena->template allocate_array<std::max_align_t>(units);
+        }
+        static void operator delete(void*, size_t) {}  // The request arena frees frames
+
+        AsyncResolved get_return_object() { return AsyncResolved(result_); }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_value(Resolved value) { finish(value); }
+        void unhandled_exception();
+
+        ResumeQueue* queue() const { return queue_; }
+
+    private:
+        ASTArena* arena_;
+        ResumeQueue* queue_;
+        DeferredValue* result_;
+
+        template <typename... Rest>
+        static const FieldContext& context_of(const FieldContext& ctx, const Rest&...) {
+            return ctx;
+        }
+        template <typename First, typename... Rest>
+        static const FieldContext& context_of(const First&, const Rest&... rest) {
+            return context_of(rest...);
+        }
+
+        void finish(Resolved value) {
+            result_->value = value;
+            result_->done = true;
+            queue_->outstanding_--;
+        }
+    };
+
+    // The value if the coroutine finished, else deferred until it does
+    Resolved result() const { return result_->done ? result_->value : Resolved::deferred(result_); }
+
+private:
+    explicit AsyncResolved(const DeferredValue* result) : result_(result) {}
+
+    const DeferredValue* result_;
+};
+
+// co_await suspend(start): suspends, then calls start(wakeup); the
+// coroutine resumes on its executor's thread once wakeup() is called
+template <typename Start>
+class Suspend {
+public:
+    explicit Suspend(Start start) : start_(std::move(start)) {}
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<AsyncResolved::promise_type> handle) {
+        // Called after suspending, so a wakeup racing in from another thread is safe
+        start_(Wakeup(handle.promise().queue(), handle));
+    }
+    void await_resume() const noexcept {}
+
+private:
+    Start start_;
+};
+
+template <typename Start>
+Suspend<Start> suspend(Start start) {
+    return Suspend<Start>(std::move(start));
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "ast/ast_arena.h"
+#include "runtime/resolver.h"
+#include "runtime/response.h"
+
+// One key of one loader in a request: queued until dispatched, then cached
+struct LoadEntry : DeferredValue {
+    ResponseValue key;
+    uint64_t hash;
+    LoadEntry* next;  // Hash chain
+};
+
+/**
+ * Per-request state of a ResolverRegistry's batch loaders
+ *
+ * FieldContext::load() looks the key up in the loader's dedup cache and,
+ * on a miss, queues it; dispatch() then calls each loader once with every
+ * key queued since the last dispatch (split into batches of max_batch).
+ * Keys are compared by kind and value, so Int 1 and String "1" differ.
+ *
+ * Everything, including the caches, lives in the request arena: nothing
+ * is freed individually and the whole state goes with the arena. Not
+ * thread-safe; parallel execution gives each worker its own.
+ *
+ * The executor creates one per request when the registry has loaders.
+ * Plan execution defers loaded fields and completes them in ticks: the
+ * whole response is walked, every loader dispatched once, the loaded
+ * values completed (queueing the next level's keys), and so on. So a
+ * field loaded under every item of a list, or on sibling paths, costs one
+ * call per level instead of one per object. Parallel runs do the same
+ * per task, on their worker's state. The interpreter, which completes
+ * fields in document order, dispatches a pending key as soon as it
+ * reaches it (flushing every key queued so far) and otherwise only shares
+ * the cache: cached documents should be run through their plan.
+ */
+class BatchLoads {
+public:
+    BatchLoads(const ResolverRegistry& resolvers, ASTArena& arena, void* context);
+
+    BatchLoads(const BatchLoads&) = delete;
+    BatchLoads& operator=(const BatchLoads&) = delete;
+
+    // Cached entry for key, queued for the next dispatch if new
+    LoadEntry* load(uint32_t loader, const ResponseValue& key);
+    // Calls every loader with queued keys; false if none were queued
+    bool dispatch();
+    bool has_queued() const { return queued_ > 0; }
+
+    size_t loader_count() const { return resolvers_.loader_count(); }
+    size_t batch_count() const { return batches_; }  // Loader calls made
+    size_t key_count() const { return keys_; }       // Distinct keys loaded
+
+private:
+    struct LoaderState {
+        LoadEntry** buckets;
+        uint32_t bucket_count;  // Power of two
+        uint32_t size;
+        LoadEntry** queue;
+        uint32_t queued;
+        uint32_t queue_capacity;
+    };
+
+    const ResolverRegistry& resolvers_;
+    ASTArena& arena_;
+    void* context_;
+    LoaderState* loaders_;
+    size_t queued_;
+    size_t batches_;
+    size_t keys_;
+
+    void grow(LoaderState& state);
+    void call(uint32_t loader, LoadEntry* const* entries, uint32_t count);
+};
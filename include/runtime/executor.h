@@ -0,0 +1,224 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "ast/ast_arena.h"
+#include "ast/ast_nodes.h"
+#include "runtime/async.h"
+#include "runtime/batch_loader.h"
+#include "runtime/input_values.h"
+#include "runtime/query_plan.h"
+#include "runtime/resolver.h"
+#include "runtime/response.h"
+#include "runtime/scheduler.h"
+#include "schema/schema.h"
+
+struct ExecutionRequest {
+    std::string_view operation_name;           // Required when the document has several operations
+    const ResponseValue* variables = nullptr;  // OBJECT of raw variable values, or nullptr
+    std::string_view variables_json;           // Else the request's variables JSON, coerced as it's read
+    const void* root_value = nullptr;          // Source of the root fields
+    void* context = nullptr;                   // Passed to every resolver
+};
+
+// Element of a response path: a response key, or a list index when key is empty
+struct PathSegment {
+    std::string_view key;
+    size_t index = 0;
+};
+
+struct ExecutionError {
+    std::string message;
+    size_t position = 0;            // Source offset of the field; 0 for request errors
+    std::vector<PathSegment> path;  // Empty for request errors
+};
+
+struct ExecutionResult {
+    ResponseValue data;  // OBJECT, or null when a non-null root field failed
+    bool has_data = false;  // False when the request failed before execution began
+    std::vector<ExecutionError> errors;
+};
+
+/**
+ * Executes validated operations against resolvers
+ *
+ * Implements the spec's Execution section: operation selection, variable
+ * coercion, CollectFields with @skip/@include, fragment type conditions,
+ * argument coercion, value completion (lists, non-null, leaf
+ * serialization, abstract type resolution) and null propagation to the
+ * nearest nullable parent. Fields are resolved through the
+ * ResolverRegistry by the FieldDef found from the field's interned name,
+ * so no string maps are consulted per field when the document was lexed
+ * with an Interner layered over schema.names().
+ *
+ * The response tree, coerced arguments and anything resolvers allocate
+ * live in the caller's arena; response keys and error paths point into
+ * the document's source. Documents must pass the Validator first; the
+ * executor doesn't repeat its checks. Subscriptions execute once, like a
+ * query, on the subscription root.
+ *
+ * Hot operations can instead be compiled once into a QueryPlan, which
+ * settles field collection, resolver lookup and constant arguments ahead
+ * of time; both paths produce the same response. When the registry has
+ * batch loaders, plan execution completes loaded fields a level at a time
+ * so each loader is called once per level (see BatchLoads); fields of
+ * suspended async resolvers are likewise completed as they finish, with
+ * the rest of the response going on meanwhile (see AsyncResolved).
+ *
+ * An Executor reuses scratch storage across calls, so keep one per
+ * thread; the Schema and ResolverRegistry may be shared. For parallel
+ * execution it keeps one more Executor per Scheduler worker, which runs
+ * that worker's tasks with its own arena and scratch.
+ *
+ * Usage:
+ *   Executor executor(*schema, resolvers);
+ *   ASTArena arena;
+ *   ExecutionResult result = executor.execute(*document, arena, request);
+ */
+class Executor {
+public:
+    Executor(const Schema& schema, const ResolverRegistry& resolvers);
+
+    Executor(const Executor&) = delete;
+    Executor& operator=(const Executor&) = delete;
+
+    ExecutionResult execute(const Document& document, ASTArena& arena,
+                            const ExecutionRequest& request = ExecutionRequest());
+    // Runs a plan compiled against the same Schema and ResolverRegistry
+    ExecutionResult execute(const QueryPlan& plan, ASTArena& arena,
+                            const ExecutionRequest& request = ExecutionRequest());
+    // Runs the entry's plan, compiling it first if missing or stale; falls
+    // back to interpreting the entry's document if the plan can't be built
+    ExecutionResult execute(const CacheEntry& entry, ASTArena& arena,
+                            const ExecutionRequest& request = ExecutionRequest());
+    // Runs a plan on scheduler's workers: sibling fields that lead to
+    // EXPENSIVE resolvers, and shares of the items of lists of them, become
+    // tasks. Loaded fields are batched per task. Mutation root fields still
+    // run one at a time, in order.
+    // The response lives in arenas; errors are in no particular order.
+    ExecutionResult execute(const QueryPlan& plan, WorkerArenas& arenas, Scheduler& scheduler,
+                            const ExecutionRequest& request = ExecutionRequest());
+
+    const InputCoercer& coercer() const { return coercer_; }
+
+private:
+    // Field of a selection set, grouped by response key
+    struct CollectedField {
+        const Field* field;
+        uint32_t group;
+    };
+
+    struct FieldGroup {
+        std::string_view key;
+        const Field* first;
+    };
+
+    // Where a value being completed came from; plan_field is set when running a plan
+    struct Completion {
+        const Field* field;
+        uint32_t parent_type;
+        size_t group_index;
+        size_t collected_begin;
+        const PlanField* plan_field;
+    };
+
+    // Deferred value completed once done, with where its null propagates to
+    struct Pending {
+        TypeRef type;
+        const DeferredValue* value;
+        Completion completion;
+        ResponseValue* out;
+        ResponseValue* boundary;
+        const PathSegment* path;
+        uint32_t path_size;
+    };
+
+    const Schema& schema_;
+    const ResolverRegistry& resolvers_;
+    InputCoercer coercer_;
+    uint32_t schema_names_;
+    uint32_t typename_id_;
+    uint32_t skip_id_;
+    uint32_t include_id_;
+
+    struct ParallelRun;
+    struct BlockTask;
+    struct FieldTask;
+    struct ItemTask;
+    class TaskScope;
+
+    // Current request
+    ASTArena* arena_;
+    const ExecutionRequest* request_;
+    ExecutionResult* result_;
+    const QueryPlan* plan_;
+    ParallelRun* parallel_;   // Set while running tasks of a parallel execution
+    size_t path_base_;        // Start of the current task's path in path_
+    std::vector<std::unique_ptr<Executor>> workers_;  // Per scheduler worker
+    ResponseValue variables_;
+    BatchLoads* loads_;            // Request's loader state, nullptr without loaders
+    bool defer_pending_;           // Queue deferred fields in pending_ instead of waiting
+    ResponseValue* null_boundary_;  // Where a non-null failure here propagates to
+    std::unordered_map<std::string_view, const FragmentDefinition*> fragments_;
+
+    // Scratch stacks; each selection set uses a range and truncates on return
+    std::vector<CollectedField> collected_;
+    std::vector<FieldGroup> groups_;
+    std::vector<const SelectionSet*> sets_;
+    std::vector<const FragmentDefinition*> visited_;
+    std::vector<PathSegment> path_;
+    std::vector<Pending> pending_;
+    std::vector<Pending> completing_;
+    ResumeQueue resume_;
+    std::string error_;
+
+    void error(size_t position, std::string message);
+    bool coerce_variables(const OperationDefinition& operation, const ExecutionRequest& request, ASTArena& arena);
+    uint32_t schema_name(uint32_t symbol, std::string_view name) const;
+    const FragmentDefinition* fragment_named(std::string_view name) const;
+
+    bool included(const std::vector<arena_ptr<Directive>>& directives);
+    bool type_applies(std::string_view condition, uint32_t condition_id, uint32_t object_type) const;
+    void collect_fields(uint32_t object_type, const SelectionSet& set, size_t group_begin, size_t visited_begin);
+
+    // False when a non-null field of the set failed, nulling the object
+    bool execute_selection_sets(uint32_t object_type, size_t set_begin, const void* source, ResponseValue& out);
+    bool execute_field(uint32_t object_type, const void* source, size_t group, size_t collected_begin,
+                       ResponseField& out);
+    bool resolve_field(const FieldDef& def, const Resolver* resolver, const ResponseValue* arguments,
+                       const void* source, const Completion& completion, ResponseValue& out);
+    bool complete_value(TypeRef type, const Resolved& resolved, const Completion& completion, ResponseValue& out);
+    bool complete_leaf(uint32_t type, const ResponseValue& value, ResponseValue& out);
+    // Reports message at the field and nulls it; false if the null must propagate
+    bool field_error(const Field& field, TypeRef type, std::string message, ResponseValue& out);
+    std::string field_label(const Field& field, uint32_t parent_type) const;
+
+    // Plan execution
+    bool execute_block(uint32_t block, const void* source, ResponseValue& out);
+    // The operation's root block; a mutation's fields serially
+    bool execute_root(const PlanOperation& operation, const void* source, ResponseValue& out);
+    bool execute_plan_field(const PlanField& field, uint32_t object_type, const void* source, ResponseField& out);
+    bool guards_hold(const PlanField& field) const;
+    void complete_pending();
+    void wait_for(const DeferredValue& value);
+    void settle(const Resolved& resolved);
+    const PlanOperation* begin_plan(const QueryPlan& plan, ASTArena& arena, const ExecutionRequest& request,
+                                    ExecutionResult& result);
+
+    // Parallel execution
+    bool execute_block_parallel(const PlanBlock& block, const void* source, ResponseValue& out);
+    bool complete_list_parallel(TypeRef type, const Resolved& resolved, const Completion& completion,
+                                ResponseValue& out);
+    bool complete_items(TypeRef type, const Resolved* resolved, const Completion& completion, ResponseValue* out,
+                        uint32_t first, uint32_t end);
+    const PathSegment* copy_path();
+    Executor& worker_executor(size_t index);
+    static void run_block_task(Task* task);
+    static void run_field_task(Task* task);
+    static void run_item_task(Task* task);
+};
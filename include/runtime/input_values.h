@@ -0,0 +1,104 @@
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "ast/ast_arena.h"
+#include "ast/ast_nodes.h"
+#include "json/json_reader.h"
+#include "runtime/response.h"
+#include "schema/schema.h"
+
+/**
+ * Input coercion: literals, variables and defaults to typed values
+ *
+ * Turns GraphQL input into ResponseValues of a declared input type,
+ * following the spec's Input Coercion rules: Int is 32-bit, Int literals
+ * are accepted for Float and ID, a single value is accepted for a list
+ * type, enum values must exist, and input objects come out with their
+ * fields in schema order, defaults applied and required fields checked.
+ * String literals are unescaped (block strings dedented); a literal with
+ * no escapes is not copied.
+ *
+ * Schema default values (stored as source text) are parsed and coerced
+ * once, when the coercer is built, and then shared by every request.
+ *
+ * Coerced variables are an OBJECT with one field per variable that has a
+ * value; a variable that is absent (not provided, no default) has no
+ * field, so arguments that reference it fall back to their own default.
+ *
+ * Variables can also be coerced straight from the request's JSON text:
+ * each value is read with a JsonReader and checked against its type as it
+ * goes, with no raw value tree in between. Strings without escapes are
+ * views into the text, which must then outlive the coerced values.
+ */
+class InputCoercer {
+public:
+    explicit InputCoercer(const Schema& schema);
+    ~InputCoercer();
+
+    InputCoercer(const InputCoercer&) = delete;
+    InputCoercer& operator=(const InputCoercer&) = delete;
+
+    // Variable values of operation from the raw request values (OBJECT or nullptr)
+    bool coerce_variables(const OperationDefinition& operation, const ResponseValue* raw, ASTArena& arena,
+                          ResponseValue& out, std::string& error) const;
+    // Same, from the variables JSON (an object, null, or empty for none)
+    bool coerce_variables(const OperationDefinition& operation, std::string_view json, ASTArena& arena,
+                          ResponseValue& out, std::string& error) const;
+
+    // One slot per definition in defs (schema order), from AST arguments
+    bool coerce_arguments(const std::vector<arena_ptr<Argument>>& arguments, SchemaSpan<InputValueDef> defs,
+                          const ResponseValue& variables, ASTArena& arena, ResponseValue* slots,
+                          std::string& error) const;
+
+    // One slot: literal is the argument's value, or nullptr when it's not given
+    bool coerce_argument(const Value* literal, const InputValueDef& def, const ResponseValue& variables,
+                         ASTArena& arena, ResponseValue& slot, std::string& error) const;
+
+    // AST literal, which may reference variables, to a value of type
+    bool coerce_literal(const Value& literal, TypeRef type, const ResponseValue& variables, ASTArena& arena,
+                        ResponseValue& out, std::string& error) const;
+    // Raw request value (e.g. parsed from JSON) to a value of type
+    bool coerce_value(const ResponseValue& raw, TypeRef type, ASTArena& arena, ResponseValue& out,
+                      std::string& error) const;
+    // Next value of reader to a value of type; on a syntax error the
+    // reader has the message
+    bool coerce_json(JsonReader& reader, TypeRef type, ASTArena& arena, ResponseValue& out,
+                     std::string& error) const;
+
+    // Coerced schema default, or nullptr if def has none
+    const ResponseValue* default_value(const InputValueDef& def) const {
+        auto it = defaults_.find(&def);
+        return it != defaults_.end() ? &it->second : nullptr;
+    }
+
+    // Type of a variable definition; false for unknown or non-input types
+    bool resolve_type(const ASTNode& node, TypeRef& out) const;
+
+    const Schema& schema() const { return schema_; }
+
+private:
+    const Schema& schema_;
+    uint32_t schema_names_;
+    std::unordered_map<const InputValueDef*, ResponseValue> defaults_;
+    std::unique_ptr<ASTArena> defaults_arena_;
+    std::deque<std::string> default_sources_;  // Parsed default texts; AST views point into them
+
+    void coerce_defaults(SchemaSpan<InputValueDef> defs, std::vector<bool>& prepared);
+    uint32_t schema_name(uint32_t symbol, std::string_view name) const;
+    bool coerce_scalar_literal(const Value& literal, uint32_t type, ASTArena& arena, ResponseValue& out) const;
+    bool coerce_input_object(const ObjectValue& object, uint32_t type, const ResponseValue& variables,
+                             ASTArena& arena, ResponseValue& out, std::string& error) const;
+    bool coerce_json_object(JsonReader& reader, uint32_t type, ASTArena& arena, ResponseValue& out,
+                            std::string& error) const;
+    bool coerce_json_scalar(JsonReader& reader, uint32_t type, ASTArena& arena, ResponseValue& out) const;
+    bool absent_variable(const VariableDefinition& definition, TypeRef type, const std::string& label,
+                         ASTArena& arena, ResponseField* fields, uint32_t& count, std::string& error) const;
+};
+
+// Value of a string token (quotes included), unescaped into arena when needed
+std::string_view string_literal_value(std::string_view token, ASTArena& arena);
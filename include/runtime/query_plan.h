@@ -0,0 +1,158 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "ast/ast_arena.h"
+#include "ast/ast_nodes.h"
+#include "runtime/input_values.h"
+#include "runtime/resolver.h"
+#include "runtime/response.h"
+#include "schema/schema.h"
+
+struct CacheEntry;
+
+// @include(if: $variable) holds when the variable is true, @skip(if: $variable) when it is false
+struct PlanCondition {
+    std::string_view variable;
+    bool expected;
+};
+
+// Conjunction of conditions: every directive on the path to one occurrence of a field
+struct PlanGuard {
+    uint32_t first_condition;
+    uint32_t condition_count;
+};
+
+// Argument slot whose literal references variables, coerced per request
+struct PlanArgument {
+    uint32_t slot;
+    const Value* literal;
+};
+
+struct PlanField {
+    std::string_view key;        // Response key, inside its fragment in the plan's key block
+    uint32_t key_offset;         // "key": fragment in that block (see key_fragment)
+    uint32_t key_size;
+    const Field* field;          // First occurrence, for errors and FieldContext::selection
+    const FieldDef* def;         // nullptr for __typename (type String!) and unknown fields (type NONE)
+    TypeRef type;
+    uint32_t resolver;           // ResolverRegistry slot
+    const ResponseValue* arguments;  // def->arg_count slots: coerced constants, defaults or null
+    uint32_t first_dynamic;      // PlanArgument range overriding slots per request
+    uint32_t dynamic_count;
+    uint32_t first_guard;        // Included when any guard holds; always when guard_count is 0
+    uint32_t guard_count;
+    uint32_t child;              // Object types: PlanBlock; abstract types: first PlanDispatch
+    uint32_t dispatch_count;     // Abstract types: one PlanDispatch per possible type
+    bool expensive;              // Its resolver, or one below it, is ResolverCost::EXPENSIVE
+    bool expensive_children;     // One below it is
+};
+
+// Fields of one merged selection set on one object type, in response order
+struct PlanBlock {
+    uint32_t type;
+    uint32_t first_field;
+    uint32_t field_count;
+    bool expensive;  // Any field, at any depth
+};
+
+struct PlanDispatch {
+    uint32_t type;   // Possible object type
+    uint32_t block;
+};
+
+struct PlanOperation {
+    std::string_view name;
+    const OperationDefinition* definition;  // For variable definitions
+    uint32_t root_type;
+    uint32_t block;
+};
+
+/**
+ * An executable document compiled against a Schema
+ *
+ * Everything the interpreter (Executor::execute on a Document) works out
+ * per request and per object is settled once at compile time:
+ *
+ *   - fragments are inlined and fields merged by response key, per
+ *     concrete object type, into flat PlanBlocks of PlanFields; a field of
+ *     interface or union type dispatches to one block per possible type
+ *   - each field's FieldDef and resolver slot are resolved
+ *   - argument slots are laid out in schema order and literals coerced,
+ *     with defaults applied; only slots whose literal references a
+ *     variable are coerced per request
+ *   - @skip/@include with literal conditions are applied; conditions on
+ *     variables become guards, evaluated per request
+ *   - fields and blocks leading to EXPENSIVE resolvers are marked, so
+ *     parallel execution spawns tasks only where they pay off
+ *
+ * Executor::execute(plan) then runs blocks in a tight loop. A plan points
+ * into the Document it was compiled from (keys, literals, error
+ * positions), which must outlive it; plans compiled from a CacheEntry keep
+ * what they need alive themselves or rely on the entry. Plans are
+ * immutable and shared across threads.
+ *
+ * Executor::execute(const CacheEntry&) compiles a plan on first use and
+ * keeps it in the entry, next to the parsed document, until the schema
+ * generation or the ResolverRegistry version changes: slots depend only on
+ * the schema, but the expensive marks come from the compiling registry's
+ * costs, so an executor with another registry (or one re-registered since)
+ * recompiles rather than reuse another registry's task layout.
+ */
+class QueryPlan {
+public:
+    // Fails (nullptr, with a message in error) when the plan would exceed
+    // max_fields PlanFields, e.g. for exponentially nested fragments
+    static std::shared_ptr<const QueryPlan> compile(const ResolverRegistry& resolvers, const InputCoercer& coercer,
+                                                    const Document& document, std::string* error = nullptr,
+                                                    size_t max_fields = 1 << 20);
+    // Warm entries, which have no tree AST, are expanded (FlatExpander) into the plan's own arena
+    static std::shared_ptr<const QueryPlan> compile(const ResolverRegistry& resolvers, const InputCoercer& coercer,
+                                                    const CacheEntry& entry, std::string* error = nullptr,
+                                                    size_t max_fields = 1 << 20);
+
+    uint64_t generation() const { return generation_; }
+    uint64_t resolver_version() const { return resolver_version_; }  // ResolverRegistry::version()
+
+    // The named operation, or the only one when name is empty; nullptr otherwise
+    const PlanOperation* operation(std::string_view name) const;
+    size_t operation_count() const { return operations_.size(); }
+
+    const PlanBlock& block(uint32_t index) const { return blocks_[index]; }
+    const PlanField& field(uint32_t index) const { return fields_[index]; }
+    const PlanDispatch* dispatch(uint32_t first) const { return dispatch_.data() + first; }
+    const PlanGuard& guard(uint32_t index) const { return guards_[index]; }
+    const PlanCondition& condition(uint32_t index) const { return conditions_[index]; }
+    const PlanArgument& dynamic_argument(uint32_t index) const { return dynamic_arguments_[index]; }
+
+    // JSON member prefix "key": of one of this plan's fields
+    std::string_view key_fragment(const PlanField& field) const {
+        return std::string_view(keys_.get() + field.key_offset, field.key_size);
+    }
+
+    size_t field_count() const { return fields_.size(); }
+    size_t memory_bytes() const;
+
+private:
+    friend class PlanCompiler;
+
+    uint64_t generation_ = 0;
+    uint64_t resolver_version_ = 0;
+    std::vector<PlanOperation> operations_;
+    std::vector<PlanBlock> blocks_;
+    std::vector<PlanField> fields_;
+    std::vector<PlanDispatch> dispatch_;
+    std::vector<PlanGuard> guards_;
+    std::vector<PlanCondition> conditions_;
+    std::vector<PlanArgument> dynamic_arguments_;
+    std::unique_ptr<ASTArena> arena_;           // Constant argument values
+    std::unique_ptr<ASTArena> document_arena_;  // Expanded document of a warm entry
+    std::unique_ptr<char[]> keys_;              // "key": per distinct response key
+    size_t keys_size_ = 0;
+
+    QueryPlan() = default;
+    void quote_keys();
+};
@@ -0,0 +1,259 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string_view>
+#include <vector>
+#include "ast/ast_arena.h"
+#include "ast/ast_nodes.h"
+#include "runtime/response.h"
+#include "schema/schema.h"
+
+struct DeferredValue;
+class BatchLoads;
+class ResumeQueue;
+class AsyncResolved;
+
+/**
+ * What a resolver returns for one field
+ *
+ *   - a leaf (scalar or enum), checked and serialized against the field type
+ *   - an object: an opaque source pointer handed to the resolvers of the
+ *     field's sub-selections; for interface and union fields, type names
+ *     the concrete object type unless a TypeResolver is registered
+ *   - a list of Resolved items (allocate them with FieldContext::allocate)
+ *   - null, or an error (the field becomes null and the message is reported)
+ *   - deferred: a key queued on a batch loader (see FieldContext::load),
+ *     completed once the loader's batch is dispatched, or the result of a
+ *     suspended async resolver (see async.h)
+ */
+struct Resolved {
+    enum class Kind : uint8_t { LEAF, OBJECT, LIST, ERROR, DEFERRED };
+
+    Kind kind = Kind::LEAF;
+    uint32_t type = Schema::NONE;  // OBJECT: concrete object type, or NONE
+    uint32_t size = 0;             // LIST: item count
+    ResponseValue leaf;            // LEAF (null by default)
+    union {
+        const void* source;     // OBJECT
+        const Resolved* items;  // LIST
+        const char* message;    // ERROR, size bytes
+        const DeferredValue* later;  // DEFERRED
+    };
+
+    Resolved() : source(nullptr) {}
+
+    static Resolved null() { return Resolved(); }
+    static Resolved scalar(ResponseValue value) {
+        Resolved r;
+        r.leaf = value;
+        return r;
+    }
+    static Resolved object(const void* source, uint32_t type = Schema::NONE) {
+        Resolved r;
+        r.kind = Kind::OBJECT;
+        r.type = type;
+        r.source = source;
+        return r;
+    }
+    static Resolved list(const Resolved* items, uint32_t size) {
+        Resolved r;
+        r.kind = Kind::LIST;
+        r.size = size;
+        r.items = items;
+        return r;
+    }
+    // Not copied: text must outlive execution (see FieldContext::copy)
+    static Resolved error(std::string_view text) {
+        Resolved r;
+        r.kind = Kind::ERROR;
+        r.size = static_cast<uint32_t>(text.size());
+        r.message = text.data();
+        return r;
+    }
+
+    static Resolved deferred(const DeferredValue* value) {
+        Resolved r;
+        r.kind = Kind::DEFERRED;
+        r.later = value;
+        return r;
+    }
+
+    std::string_view error_message() const { return std::string_view(message, size); }
+};
+
+// Result not known yet; the executor completes the field once done is set
+struct DeferredValue {
+    Resolved value;
+    bool done = false;
+};
+
+/**
+ * Inputs of one resolver call
+ *
+ * Arguments are coerced to the field's argument types and laid out in
+ * slots, one per argument in schema order, with defaults applied; an
+ * argument that is absent and has no default is null. Everything a
+ * resolver allocates for its result should come from the request arena.
+ */
+struct FieldContext {
+    const Schema* schema;
+    const void* source;              // Parent object; ExecutionRequest::root_value for root fields
+    uint32_t parent_type;            // Object type the field is resolved on
+    const FieldDef* field;
+    const Field* selection;          // First AST field of the response key
+    const ResponseValue* arguments;  // field->arg_count slots
+    void* context;                   // ExecutionRequest::context
+    ASTArena* arena;                 // Request arena
+    BatchLoads* loads;               // Per-request loader state; nullptr without loaders
+    ResumeQueue* resume;             // Where suspended async resolvers are resumed from
+
+    const ResponseValue& argument(uint32_t slot) const { return arguments[slot]; }
+    // Slot by name, or nullptr if the field has no such argument
+    const ResponseValue* argument(std::string_view name) const {
+        const InputValueDef* def = schema->argument(*field, schema->name_id(name));
+        return def ? &arguments[def - schema->arguments(*field).begin()] : nullptr;
+    }
+
+    template <typename T>
+    T* allocate(size_t count) const {
+        T* items = arena->allocate_array<T>(count);
+        for (size_t i = 0; i < count; i++) new (items + i) T();
+        return items;
+    }
+    std::string_view copy(std::string_view text) const {
+        char* bytes = arena->allocate_array<char>(text.size());
+        if (!text.empty()) std::memcpy(bytes, text.data(), text.size());
+        return std::string_view(bytes, text.size());
+    }
+
+    // Value for key from loader (see ResolverRegistry::add_loader): cached if
+    // the key was loaded before in this request, otherwise deferred until the
+    // loader's next batch. Return it as the field's result, or as list items.
+    Resolved load(uint32_t loader, const ResponseValue& key) const;
+};
+
+using Resolver = std::function<Resolved(const FieldContext&)>;
+// Coroutine resolver (see async.h)
+using AsyncResolver = std::function<AsyncResolved(const FieldContext&)>;
+
+// One dispatch of a batch loader: fill results[i] for keys[i] (a result may
+// be an error for its key). Allocate what results point to from arena.
+struct BatchCall {
+    const ResponseValue* keys;
+    Resolved* results;
+    uint32_t count;
+    void* context;  // ExecutionRequest::context
+    ASTArena* arena;
+};
+using BatchFunction = std::function<void(const BatchCall&)>;
+// Under a Scheduler, EXPENSIVE resolvers (I/O, heavy computation) run as
+// tasks alongside their siblings; CHEAP ones run inline, where spawning
+// would cost more than the call
+enum class ResolverCost : uint8_t { CHEAP, EXPENSIVE };
+// Concrete object type of a source returned for an interface or union field
+using TypeResolver = std::function<uint32_t(const void* source, const Schema& schema)>;
+
+/**
+ * Resolvers for a Schema's fields
+ *
+ * Resolvers are stored in one flat array with a slot per schema field
+ * (fields are contiguous per type), so lookup is an index computation
+ * from the parent type and the FieldDef the executor already resolved
+ * through interned names; no string maps are consulted while executing.
+ *
+ * Fields without a resolver use the default resolver when one is set,
+ * and otherwise fail with an execution error. Built once, then read-only
+ * and safe to share between threads.
+ *
+ * Usage:
+ *   ResolverRegistry resolvers(*schema);
+ *   resolvers.add("Query", "user", [&](const FieldContext& ctx) {
+ *       return Resolved::object(users.find(ctx.argument(0).integer));
+ *   });
+ *   resolvers.add("User", "name", [](const FieldContext& ctx) {
+ *       return Resolved::scalar(ResponseValue::of_string(static_cast<const User*>(ctx.source)->name));
+ *   });
+ *
+ *   // Post.author for every post in a list is fetched in one call
+ *   uint32_t users_by_id = resolvers.add_loader([&](const BatchCall& call) {
+ *       for (uint32_t i = 0; i < call.count; i++) call.results[i] = Resolved::object(users.find(call.keys[i].integer));
+ *   });
+ *   resolvers.add("Post", "author", [=](const FieldContext& ctx) {
+ *       return ctx.load(users_by_id, ResponseValue::of_int(static_cast<const Post*>(ctx.source)->author_id));
+ *   });
+ */
+class ResolverRegistry {
+public:
+    explicit ResolverRegistry(const Schema& schema);
+
+    // False if the type or field doesn't exist
+    bool add(std::string_view type, std::string_view field, Resolver resolver,
+             ResolverCost cost = ResolverCost::CHEAP);
+    // Coroutine resolver: may co_await, and its field completes once it co_returns
+    bool add_async(std::string_view type, std::string_view field, AsyncResolver resolver,
+                   ResolverCost cost = ResolverCost::CHEAP);
+    // For an interface or union; false if the type isn't abstract
+    bool add_type_resolver(std::string_view type, TypeResolver resolver);
+    void set_default(Resolver resolver, ResolverCost cost = ResolverCost::CHEAP) {
+        default_ = std::move(resolver);
+        default_cost_ = cost;
+        version_ = next_version();
+    }
+    // Batch loader for FieldContext::load; returns its id. Batches hold at
+    // most max_batch keys (0: unlimited).
+    uint32_t add_loader(BatchFunction batch, uint32_t max_batch = 0) {
+        loaders_.push_back(Loader{std::move(batch), max_batch});
+        return static_cast<uint32_t>(loaders_.size() - 1);
+    }
+
+    // Resolver for field of type, or nullptr
+    const Resolver* find(uint32_t type, const FieldDef& field) const { return at(slot(type, field)); }
+    // Same, by slot (see QueryPlan)
+    const Resolver* at(uint32_t slot) const {
+        const Resolver& resolver = resolvers_[slot];
+        if (resolver) return &resolver;
+        return default_ ? &default_ : nullptr;
+    }
+    bool expensive(uint32_t slot) const {
+        return (resolvers_[slot] ? costs_[slot] : default_cost_) == ResolverCost::EXPENSIVE;
+    }
+    const TypeResolver* type_resolver(uint32_t type) const {
+        return type_resolvers_[type] ? &type_resolvers_[type] : nullptr;
+    }
+
+    // Dense index of a schema field, 0 .. field_count() - 1
+    uint32_t slot(uint32_t type, const FieldDef& field) const {
+        return first_slot_[type] + static_cast<uint32_t>(&field - schema_.fields(type).begin());
+    }
+    size_t field_count() const { return resolvers_.size(); }
+
+    size_t loader_count() const { return loaders_.size(); }
+    const BatchFunction& loader(uint32_t id) const { return loaders_[id].batch; }
+    uint32_t max_batch(uint32_t id) const { return loaders_[id].max_batch; }
+
+    const Schema& schema() const { return schema_; }
+
+    // Unique per registry and renewed by add() / set_default() (never 0):
+    // QueryPlans record it, since their expensive marks come from the costs
+    uint64_t version() const { return version_; }
+
+private:
+    struct Loader {
+        BatchFunction batch;
+        uint32_t max_batch;
+    };
+
+    const Schema& schema_;
+    std::vector<uint32_t> first_slot_;  // Per type: slot of its first field
+    std::vector<Resolver> resolvers_;   // Per slot
+    std::vector<ResolverCost> costs_;   // Per slot
+    std::vector<TypeResolver> type_resolvers_;  // Per type
+    Resolver default_;
+    ResolverCost default_cost_ = ResolverCost::CHEAP;
+    std::vector<Loader> loaders_;
+    uint64_t version_;
+
+    static uint64_t next_version();
+};
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include "ast/ast_arena.h"
+
+enum class ResponseKind : uint8_t {
+    NULL_VALUE,
+    BOOLEAN,
+    INT,
+    FLOAT,
+    STRING,
+    ENUM,
+    LIST,
+    OBJECT
+};
+
+struct ResponseField;
+struct PlanField;
+
+/**
+ * Node of an execution result: a JSON-shaped value in 16 bytes
+ *
+ * Strings, list items and object fields are pointer + size into storage
+ * the value does not own, normally the request's ASTArena, so a whole
+ * response tree is freed with the arena. Object fields keep their
+ * response order. The same representation carries coerced argument and
+ * variable values into resolvers.
+ */
+struct ResponseValue {
+    ResponseKind kind = ResponseKind::NULL_VALUE;
+    uint32_t size = 0;  // String bytes, list items or object fields
+    union {
+        bool boolean;
+        int64_t integer;
+        double number;
+        const char* string;  // STRING and ENUM
+        const ResponseValue* items;
+        const ResponseField* fields;
+    };
+
+    ResponseValue() : integer(0) {}
+
+    static ResponseValue null() { return ResponseValue(); }
+    static ResponseValue of_bool(bool value) {
+        ResponseValue v;
+        v.kind = ResponseKind::BOOLEAN;
+        v.boolean = value;
+        return v;
+    }
+    static ResponseValue of_int(int64_t value) {
+        ResponseValue v;
+        v.kind = ResponseKind::INT;
+        v.integer = value;
+        return v;
+    }
+    static ResponseValue of_float(double value) {
+        ResponseValue v;
+        v.kind = ResponseKind::FLOAT;
+        v.number = value;
+        return v;
+    }
+    // Not copied: text must outlive the response (see FieldContext::copy)
+    static ResponseValue of_string(std::string_view text) {
+        return text_value(ResponseKind::STRING, text);
+    }
+    static ResponseValue of_enum(std::string_view name) {
+        return text_value(ResponseKind::ENUM, name);
+    }
+    static ResponseValue of_list(const ResponseValue* items, uint32_t size) {
+        ResponseValue v;
+        v.kind = ResponseKind::LIST;
+        v.size = size;
+        v.items = items;
+        return v;
+    }
+    static ResponseValue of_object(const ResponseField* fields, uint32_t size) {
+        ResponseValue v;
+        v.kind = ResponseKind::OBJECT;
+        v.size = size;
+        v.fields = fields;
+        return v;
+    }
+
+    bool is_null() const { return kind == ResponseKind::NULL_VALUE; }
+    std::string_view text() const { return std::string_view(string, size); }
+
+    // Object member by response key, or nullptr (linear: objects are small)
+    inline const ResponseValue* find(std::string_view key) const;
+
+private:
+    static ResponseValue text_value(ResponseKind kind, std::string_view text) {
+        ResponseValue v;
+        v.kind = kind;
+        v.size = static_cast<uint32_t>(text.size());
+        v.string = text.data();
+        return v;
+    }
+};
+
+struct ResponseField {
+    std::string_view name;
+    ResponseValue value;
+    const PlanField* plan_field = nullptr;  // Set by plan execution, for its quoted key
+};
+
+const ResponseValue* ResponseValue::find(std::string_view key) const {
+    if (kind != ResponseKind::OBJECT) return nullptr;
+    for (uint32_t i = 0; i < size; i++) {
+        if (fields[i].name == key) return &fields[i].value;
+    }
+    return nullptr;
+}
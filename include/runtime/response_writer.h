@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <sys/uio.h>
+#include "runtime/executor.h"
+#include "runtime/query_plan.h"
+#include "runtime/response.h"
+
+// Caller-owned output space
+struct JsonBuffer {
+    char* data;
+    size_t size;
+};
+
+/**
+ * Serializes execution results as JSON straight into caller buffers
+ *
+ * Output goes into the current buffer until it is full, then flush gets
+ * the filled bytes and returns the buffer to continue in: the same one
+ * once its bytes were sent, the next one of an I/O vector, and so on.
+ * Nothing is allocated while writing; each byte is copied once, from the
+ * response tree into the caller's buffer.
+ *
+ * Strings are scanned for bytes that need escaping with find_json_escape
+ * (AVX2 or SSE2), and runs without any are copied whole. Numbers are
+ * formatted with std::to_chars (shortest round-trip form for floats; non-finite
+ * floats, which JSON can't express, become null). Given the QueryPlan a
+ * response was executed from, object keys are written from the plan's
+ * precomputed "key": fragments instead of being quoted per field.
+ *
+ * Results are written as {"errors":[...],"data":...}, each error with its
+ * message and path; errors is left out when there are none, and data when
+ * the request failed before execution.
+ *
+ * Usage:
+ *   char buffer[4096];
+ *   ResponseWriter writer({buffer, sizeof(buffer)}, [&](const char* data, size_t size) {
+ *       send(socket, data, size);
+ *       return JsonBuffer{buffer, sizeof(buffer)};
+ *   }, plan.get());
+ *   writer.write(result);
+ *   writer.finish();
+ */
+class ResponseWriter {
+public:
+    // Takes a full buffer's bytes; returns where to continue, or an empty
+    // buffer to stop writing
+    using Flush = std::function<JsonBuffer(const char* data, size_t size)>;
+
+    // Without flush, output that doesn't fit in buffer fails the writer
+    ResponseWriter(JsonBuffer buffer, Flush flush = nullptr, const QueryPlan* plan = nullptr);
+
+    ResponseWriter(const ResponseWriter&) = delete;
+    ResponseWriter& operator=(const ResponseWriter&) = delete;
+
+    bool write(const ExecutionResult& result);
+    bool write(const ResponseValue& value);
+    // Passes the bytes of the last, partly filled buffer to flush (its
+    // return value is ignored); false if writing failed at any point
+    bool finish();
+
+    bool ok() const { return !failed_; }
+    size_t bytes_written() const { return flushed_ + used_; }
+    // Bytes in the current buffer, not yet passed to flush
+    size_t buffered() const { return used_; }
+
+private:
+    char* buffer_;
+    size_t capacity_;
+    size_t used_;
+    size_t flushed_;
+    Flush flush_;
+    const QueryPlan* plan_;
+    bool failed_;
+
+    bool next_buffer();
+    void put(char c) {
+        if (used_ == capacity_ && !next_buffer()) return;
+        buffer_[used_++] = c;
+    }
+    void put(const char* data, size_t size);
+    void put(std::string_view text) { put(text.data(), text.size()); }
+
+    void write_value(const ResponseValue& value);
+    void write_string(std::string_view text);
+    void write_key(const ResponseField& field);
+    void write_int(int64_t value);
+    void write_float(double value);
+    void write_error(const ExecutionError& error);
+};
+
+// Serializes result into iov[0..count) in order, setting each iov_len to
+// the bytes it holds (iov_len is read as its capacity first). Returns how
+// many were used, or 0 if they were too small.
+size_t write_response(const ExecutionResult& result, struct iovec* iov, size_t count,
+                      const QueryPlan* plan = nullptr);
+
+// Into a string, growing it as needed
+std::string response_to_json(const ExecutionResult& result, const QueryPlan* plan = nullptr);
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "ast/ast_arena.h"
+
+class TaskGroup;
+
+// Unit of work; callers embed it at the start of their own task struct
+struct Task {
+    void (*run)(Task* task);
+    TaskGroup* group;
+};
+
+// Tasks spawned together and waited for together
+class TaskGroup {
+public:
+    TaskGroup() : pending_(0) {}
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    bool done() const { return pending_.load(std::memory_order_acquire) == 0; }
+
+private:
+    friend class Scheduler;
+    std::atomic<size_t> pending_;
+};
+
+/**
+ * Work-stealing thread pool for fork-join execution
+ *
+ * Each worker owns a Chase-Lev deque: it pushes and pops its own tasks at
+ * the bottom (LIFO, cache-warm), while idle workers steal from the top
+ * (FIFO, the oldest and typically largest tasks). Pushing, popping and
+ * stealing are lock-free; the only locks are around idle sleep and the
+ * injection queue that threads outside the pool submit to.
+ *
+ * wait() on a worker thread doesn't block: it runs its own and stolen
+ * tasks until the group is done, so nested fork-join never deadlocks and
+ * never idles a worker. Threads outside the pool block in wait().
+ *
+ * Tasks are caller-allocated (typically in a WorkerArenas arena) and must
+ * stay alive until their group is done. When a worker's deque is full,
+ * spawn() runs the task inline.
+ *
+ * Usage:
+ *   Scheduler scheduler(8);
+ *   TaskGroup group;
+ *   scheduler.spawn(group, &task);
+ *   scheduler.wait(group);
+ */
+class Scheduler {
+public:
+    static constexpr size_t DEQUE_CAPACITY = 4096;
+
+    explicit Scheduler(size_t threads = std::thread::hardware_concurrency());
+    ~Scheduler();
+
+    Scheduler(const Scheduler&) = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+
+    size_t worker_count() const { return workers_.size(); }
+    // Index of the calling thread's worker, or worker_count() outside the pool
+    size_t worker_index() const;
+
+    void spawn(TaskGroup& group, Task* task);
+    void wait(TaskGroup& group);
+
+private:
+    // Chase-Lev deque (Le, Pop, Cohen, Nardelli 2013), fixed capacity
+    class Deque {
+    public:
+        Deque();
+        bool push(Task* task);  // Owner only; false when full
+        Task* pop();            // Owner only
+        Task* steal();          // Any thread; nullptr when empty or lost a race
+
+    private:
+        alignas(64) std::atomic<int64_t> top_;
+        alignas(64) std::atomic<int64_t> bottom_;
+        std::unique_ptr<std::atomic<Task*>[]> buffer_;
+    };
+
+    struct alignas(64) Worker {
+        Deque deque;
+        std::thread thread;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<bool> stopping_;
+
+    // Submissions from threads outside the pool
+    std::mutex injected_mutex_;
+    std::vector<Task*> injected_;
+    std::atomic<size_t> injected_count_;
+
+    // Idle workers sleep until the epoch moves; external waiters until a group finishes
+    std::mutex sleep_mutex_;
+    std::condition_variable work_available_;
+    std::condition_variable group_done_;
+    std::atomic<uint64_t> work_epoch_;
+    std::atomic<size_t> sleepers_;
+
+    void run_worker(size_t index);
+    Task* find_task(size_t index);
+    void execute(Task* task);
+    void notify_work();
+};
+
+/**
+ * One arena per Scheduler worker plus one for threads outside the pool
+ *
+ * Lets tasks allocate response values without locking: each thread
+ * allocates from its own arena. Everything a parallel execution returns
+ * lives in these arenas, so keep them alive while the result is in use and
+ * reset() them between requests.
+ */
+class WorkerArenas {
+public:
+    explicit WorkerArenas(const Scheduler& scheduler, size_t initial_size = 64 * 1024);
+
+    // Arena of the calling thread
+    ASTArena& local() { return *arenas_[scheduler_.worker_index()]; }
+    ASTArena& operator[](size_t index) { return *arenas_[index]; }
+    size_t size() const { return arenas_.size(); }
+
+    void reset();
+    size_t bytes_allocated() const;
+
+private:
+    const Scheduler& scheduler_;
+    std::vector<std::unique_ptr<ASTArena>> arenas_;
+};
@@ -0,0 +1,289 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "lexer/interner.h"
+
+enum class TypeKind : uint8_t {
+    SCALAR,
+    OBJECT,
+    INTERFACE,
+    UNION,
+    ENUM,
+    INPUT_OBJECT
+};
+
+enum class DirectiveLocation : uint8_t {
+    // Executable
+    QUERY,
+    MUTATION,
+    SUBSCRIPTION,
+    FIELD,
+    FRAGMENT_DEFINITION,
+    FRAGMENT_SPREAD,
+    INLINE_FRAGMENT,
+    VARIABLE_DEFINITION,
+    // Type system
+    SCHEMA,
+    SCALAR,
+    OBJECT,
+    FIELD_DEFINITION,
+    ARGUMENT_DEFINITION,
+    INTERFACE,
+    UNION,
+    ENUM,
+    ENUM_VALUE,
+    INPUT_OBJECT,
+    INPUT_FIELD_DEFINITION
+};
+
+// Parses a location name such as "FIELD_DEFINITION"
+bool directive_location_from_name(std::string_view name, DirectiveLocation& out);
+
+/**
+ * Reference to a possibly wrapped type, e.g. [String!]!
+ *
+ * Wrapping level 0 is the outermost type and level list_depth is the named
+ * type; bit k of non_null is set when level k is non-null. So [String!]! is
+ * {String, list_depth 1, non_null 0b11} and [[ID]] is {ID, 2, 0}.
+ */
+struct TypeRef {
+    static constexpr uint8_t MAX_LIST_DEPTH = 15;
+
+    uint32_t type = UINT32_MAX;  // Index into the schema's types
+    uint8_t list_depth = 0;
+    uint16_t non_null = 0;
+
+    bool is_list() const { return list_depth > 0; }
+    bool is_non_null() const { return non_null & 1; }
+
+    // Element type of a list type
+    TypeRef item() const {
+        return TypeRef{type, static_cast<uint8_t>(list_depth - 1), static_cast<uint16_t>(non_null >> 1)};
+    }
+    TypeRef nullable() const {
+        return TypeRef{type, list_depth, static_cast<uint16_t>(non_null & ~1u)};
+    }
+
+    bool operator==(const TypeRef& other) const {
+        return type == other.type && list_depth == other.list_depth && non_null == other.non_null;
+    }
+    bool operator!=(const TypeRef& other) const { return !(*this == other); }
+};
+
+// Arguments and input object fields
+struct InputValueDef {
+    uint32_t name;
+    TypeRef type;
+    std::string_view default_value;  // GraphQL source text; null data() when absent
+
+    bool has_default() const { return default_value.data() != nullptr; }
+};
+
+struct FieldDef {
+    uint32_t name;
+    TypeRef type;
+    uint32_t first_arg;  // Into the schema's input values
+    uint32_t arg_count;
+    bool deprecated;
+};
+
+struct EnumValueDef {
+    uint32_t name;
+    bool deprecated;
+};
+
+struct TypeDef {
+    uint32_t name;
+    TypeKind kind;
+    // Fields (OBJECT, INTERFACE), input fields (INPUT_OBJECT) or values (ENUM)
+    uint32_t first_member;
+    uint32_t member_count;
+    // Implemented interfaces, and for abstract types the possible object
+    // types (sorted by index); both are type indices
+    uint32_t first_interface;
+    uint32_t interface_count;
+    uint32_t first_possible;
+    uint32_t possible_count;
+    // Open-addressing member table: name ID -> member index
+    uint32_t table_offset;
+    uint32_t table_mask;
+
+    bool is_composite() const {
+        return kind == TypeKind::OBJECT || kind == TypeKind::INTERFACE || kind == TypeKind::UNION;
+    }
+    bool is_abstract() const { return kind == TypeKind::INTERFACE || kind == TypeKind::UNION; }
+    bool is_input() const {
+        return kind == TypeKind::SCALAR || kind == TypeKind::ENUM || kind == TypeKind::INPUT_OBJECT;
+    }
+    bool is_leaf() const { return kind == TypeKind::SCALAR || kind == TypeKind::ENUM; }
+};
+
+struct DirectiveDef {
+    uint32_t name;
+    uint32_t first_arg;
+    uint32_t arg_count;
+    uint32_t locations;  // Bit per DirectiveLocation
+    bool repeatable;
+
+    bool allows(DirectiveLocation location) const {
+        return locations & (1u << static_cast<unsigned>(location));
+    }
+};
+
+// Contiguous view over schema storage
+template <typename T>
+class SchemaSpan {
+public:
+    SchemaSpan(const T* data, size_t size) : data_(data), size_(size) {}
+    const T* begin() const { return data_; }
+    const T* end() const { return data_ + size_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    const T& operator[](size_t i) const { return data_[i]; }
+
+private:
+    const T* data_;
+    size_t size_;
+};
+
+/**
+ * In-memory GraphQL schema
+ *
+ * Built once from SDL or an introspection result, then read-only and safe
+ * to share between threads. Every name (types, fields, arguments, enum
+ * values, directives) is interned to a dense ID, and all definitions live
+ * in flat arrays addressed by index:
+ *
+ *   - type_index(name_id) is a direct array lookup
+ *   - each type owns a small open-addressing table mapping member name IDs
+ *     to its fields / input fields / enum values, so field(type, name_id)
+ *     is O(1) regardless of how wide the type is
+ *   - possible types of interfaces and unions are sorted, so
+ *     is_possible_type() is a binary search
+ *
+ * The built-in scalars (Int, Float, String, Boolean, ID) are always present
+ * at fixed indices, as are @skip, @include, @deprecated and @specifiedBy.
+ * Introspection types (__Schema, __Type, ...) are not modeled; callers
+ * treat __typename, __schema and __type specially.
+ *
+ * Usage:
+ *   std::vector<std::string> errors;
+ *   auto schema = Schema::from_sdl(sdl, &errors);
+ *   uint32_t user = schema->type_index("User");
+ *   const FieldDef* field = schema->field(user, schema->name_id("email"));
+ */
+class Schema {
+public:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    // Type indices of the built-in scalars
+    static constexpr uint32_t BUILTIN_INT = 0;
+    static constexpr uint32_t BUILTIN_FLOAT = 1;
+    static constexpr uint32_t BUILTIN_STRING = 2;
+    static constexpr uint32_t BUILTIN_BOOLEAN = 3;
+    static constexpr uint32_t BUILTIN_ID = 4;
+
+    // Return nullptr on failure, describing each problem in errors
+    static std::unique_ptr<Schema> from_sdl(std::string_view sdl,
+                                            std::vector<std::string>* errors = nullptr);
+    // Accepts {"data": {"__schema": ...}} or {"__schema": ...}
+    static std::unique_ptr<Schema> from_introspection(std::string_view json,
+                                                      std::vector<std::string>* errors = nullptr);
+
+    // Names
+    const Interner& names() const { return names_; }
+    uint32_t name_id(std::string_view name) const { return names_.find(name); }
+    std::string_view name(uint32_t id) const { return names_.name(id); }
+
+    // Types
+    size_t type_count() const { return types_.size(); }
+    const TypeDef& type(uint32_t index) const { return types_[index]; }
+    std::string_view type_name(uint32_t index) const { return names_.name(types_[index].name); }
+    uint32_t type_index(uint32_t name_id) const {
+        return name_id < type_by_name_.size() ? type_by_name_[name_id] : NONE;
+    }
+    uint32_t type_index(std::string_view name) const { return type_index(name_id(name)); }
+
+    // Root operation types; NONE when absent
+    uint32_t query_type() const { return query_type_; }
+    uint32_t mutation_type() const { return mutation_type_; }
+    uint32_t subscription_type() const { return subscription_type_; }
+
+    // Member lookup; nullptr when the type has no such member
+    const FieldDef* field(uint32_t type, uint32_t name_id) const;
+    const FieldDef* field(uint32_t type, std::string_view name) const { return field(type, name_id(name)); }
+    const InputValueDef* input_field(uint32_t type, uint32_t name_id) const;
+    const EnumValueDef* enum_value(uint32_t type, uint32_t name_id) const;
+    const InputValueDef* argument(const FieldDef& field, uint32_t name_id) const;
+    const InputValueDef* argument(const DirectiveDef& directive, uint32_t name_id) const;
+
+    SchemaSpan<FieldDef> fields(uint32_t type) const;
+    SchemaSpan<InputValueDef> input_fields(uint32_t type) const;
+    SchemaSpan<EnumValueDef> enum_values(uint32_t type) const;
+    SchemaSpan<InputValueDef> arguments(const FieldDef& field) const {
+        return {input_values_.data() + field.first_arg, field.arg_count};
+    }
+    SchemaSpan<InputValueDef> arguments(const DirectiveDef& directive) const {
+        return {input_values_.data() + directive.first_arg, directive.arg_count};
+    }
+    SchemaSpan<uint32_t> interfaces(uint32_t type) const {
+        return {type_lists_.data() + types_[type].first_interface, types_[type].interface_count};
+    }
+    SchemaSpan<uint32_t> possible_types(uint32_t type) const {
+        return {type_lists_.data() + types_[type].first_possible, types_[type].possible_count};
+    }
+
+    // GraphQL notation, e.g. [String!]!
+    std::string type_string(const TypeRef& type) const;
+
+    // True if object_type is abstract_type itself or one of its possible types
+    bool is_possible_type(uint32_t abstract_type, uint32_t object_type) const;
+
+    // Directives
+    size_t directive_count() const { return directives_.size(); }
+    const DirectiveDef& directive(uint32_t index) const { return directives_[index]; }
+    const DirectiveDef* find_directive(uint32_t name_id) const {
+        uint32_t index = name_id < directive_by_name_.size() ? directive_by_name_[name_id] : NONE;
+        return index != NONE ? &directives_[index] : nullptr;
+    }
+    const DirectiveDef* find_directive(std::string_view name) const { return find_directive(name_id(name)); }
+
+    size_t memory_bytes() const;
+
+    // Unique per built Schema (never 0): results derived from one schema, such
+    // as cached validation verdicts, are keyed by it, so replacing the schema
+    // invalidates all of them at once
+    uint64_t generation() const { return generation_; }
+
+private:
+    friend class SchemaBuilder;
+
+    uint64_t generation_ = 0;
+
+    Interner names_;
+    std::vector<TypeDef> types_;
+    std::vector<FieldDef> fields_;
+    std::vector<InputValueDef> input_values_;
+    std::vector<EnumValueDef> enum_values_;
+    std::vector<DirectiveDef> directives_;
+    std::vector<uint32_t> type_lists_;    // Interfaces and possible types
+    std::vector<uint32_t> member_table_;  // Per-type open-addressing tables
+    std::vector<uint32_t> type_by_name_;  // Name ID -> type index
+    std::vector<uint32_t> directive_by_name_;
+    std::deque<std::string> default_values_;
+    uint32_t query_type_ = NONE;
+    uint32_t mutation_type_ = NONE;
+    uint32_t subscription_type_ = NONE;
+
+    Schema() = default;
+
+    // Member index within the type, or NONE
+    uint32_t find_member(uint32_t type, uint32_t name_id) const;
+    uint32_t member_name(const TypeDef& type, uint32_t member) const;
+};
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "schema/schema.h"
+
+/**
+ * Collects type system definitions by name, then resolves them into a Schema
+ *
+ * Both the SDL and introspection loaders fill one of these; definitions may
+ * reference types declared later, and extensions add to existing types.
+ * build() checks every reference and returns nullptr if anything is wrong.
+ */
+class SchemaBuilder {
+public:
+    struct TypeRefSpec {
+        std::string name;
+        uint8_t list_depth = 0;
+        uint16_t non_null = 0;  // Same layout as TypeRef::non_null
+    };
+
+    struct InputValueSpec {
+        std::string name;
+        TypeRefSpec type;
+        std::string default_value;
+        bool has_default = false;
+    };
+
+    struct FieldSpec {
+        std::string name;
+        TypeRefSpec type;
+        std::vector<InputValueSpec> args;
+        bool deprecated = false;
+    };
+
+    struct EnumValueSpec {
+        std::string name;
+        bool deprecated = false;
+    };
+
+    struct TypeSpec {
+        std::string name;
+        TypeKind kind;
+        std::vector<FieldSpec> fields;
+        std::vector<InputValueSpec> input_fields;
+        std::vector<EnumValueSpec> enum_values;
+        std::vector<std::string> interfaces;
+        std::vector<std::string> union_members;
+    };
+
+    struct DirectiveSpec {
+        std::string name;
+        std::vector<InputValueSpec> args;
+        uint32_t locations = 0;
+        bool repeatable = false;
+    };
+
+    SchemaBuilder();
+
+    // Defines a type, or returns the existing one when extending. Redefining
+    // a type (or extending it as another kind) is reported, and the returned
+    // spec is then a scratch one that build() ignores.
+    TypeSpec& define_type(std::string_view name, TypeKind kind, bool extension = false);
+
+    // Defines a directive, replacing a built-in of the same name
+    DirectiveSpec& define_directive(std::string_view name);
+
+    // Root operation types; when unset, types named Query, Mutation and
+    // Subscription are used
+    std::string query_type;
+    std::string mutation_type;
+    std::string subscription_type;
+
+    void error(std::string message) { errors_.push_back(std::move(message)); }
+    const std::vector<std::string>& errors() const { return errors_; }
+
+    std::unique_ptr<Schema> build();
+
+private:
+    std::vector<TypeSpec> types_;
+    std::vector<DirectiveSpec> directives_;
+    std::vector<bool> user_defined_;  // Per type: defined (not just built in or extended)
+    TypeSpec scratch_;
+    std::vector<std::string> errors_;
+
+    bool resolve(Schema& schema, const TypeRefSpec& spec, bool input, std::string_view context, TypeRef& out);
+    uint32_t add_input_values(Schema& schema, const std::vector<InputValueSpec>& values,
+                              std::string_view context);
+    void build_member_table(Schema& schema, TypeDef& type);
+};
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+
+/**
+ * Finds the bytes a JSON string can't hold as they are: '"', '\\' and
+ * control characters (below 0x20)
+ *
+ * The scan runs 32 bytes at a time with AVX2 where the CPU has it, else 16
+ * with SSE2; the choice is made once per process. JsonReader uses it to
+ * find where a string body stops, ResponseWriter to find the runs it can
+ * copy whole.
+ *
+ * Usage:
+ *   size_t clean = find_json_escape(text, size);  // size if there are none
+ */
+
+// Offset of the first '"', '\\' or control character in text[0, size), or size
+size_t find_json_escape(const char* text, size_t size);
+
+// Each scanner, exposed for testing
+namespace json_escape_detail {
+size_t find_scalar(const char* text, size_t size);
+size_t find_sse2(const char* text, size_t size);
+size_t find_avx2(const char* text, size_t size);
+bool avx2_supported();  // Compiled in and supported by this CPU
+}
@@ -16,4 +16,6 @@ class SIMDDetector {
 public:
     static SIMDType detectBestSIMD();
     static void printBestSIMD();
+    static bool hasSHA();   // x86 SHA extensions (SHA-NI)
+    static bool hasAVX2();  // Including OS support for the YMM registers
 };
\ No newline at end of file
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "ast/ast_nodes.h"
+#include "parser/parse_listener.h"
+#include "schema/schema.h"
+
+struct CostOptions {
+    uint64_t max_cost = UINT64_MAX;  // Budget; analysis stops once an operation exceeds it
+    uint64_t default_field_cost = 1;
+    uint64_t assumed_list_size = 10;  // For a list-size argument given as a variable
+
+    // Arguments whose integer value multiplies the cost of the field's selections
+    std::vector<std::string> list_size_arguments{"first", "last", "limit"};
+
+    // Per-field weights, keyed "Type.field" (needs schema) or "field" (any type)
+    std::unordered_map<std::string, uint64_t> field_costs;
+
+    // Resolves parent types for "Type.field" weights; optional
+    const Schema* schema = nullptr;
+};
+
+/**
+ * Query cost analysis for rate limiting
+ *
+ * The cost of a field is its weight times the product of the list sizes
+ * (first/last/limit arguments) of the fields enclosing it; an operation
+ * costs the sum over its fields. Arithmetic saturates instead of wrapping.
+ *
+ * Fragments are costed once, with multiplier 1, and each spread adds that
+ * cost times the spread's multiplier. A spread that appears before its
+ * fragment is defined waits on it; when a fragment completes, its cost is
+ * pushed to everything waiting on it, so every spread edge is settled
+ * exactly once. Fragments that never resolve (undefined, or in a cycle)
+ * contribute nothing; validation rejects those documents anyway.
+ *
+ * Two ways to run it, sharing the same callbacks:
+ *   - analyze(document) after parsing
+ *   - streaming, as ParserOptions::listener: once an operation's cost
+ *     passes max_cost the parse aborts with ParserLimit::COST, before the
+ *     rest of the AST is built
+ *
+ * Usage:
+ *   CostOptions options;
+ *   options.max_cost = 5000;
+ *   options.field_costs["search"] = 10;
+ *   CostAnalyzer cost(options);
+ *   ParserOptions parser_options;
+ *   parser_options.listener = &cost;
+ *   Parser parser(cursor, arena, parser_options);
+ *   auto document = parser.parse_document();  // nullptr if over budget
+ *   uint64_t spent = cost.cost();
+ */
+class CostAnalyzer : public ParseListener {
+public:
+    explicit CostAnalyzer(CostOptions options = CostOptions());
+
+    CostAnalyzer(const CostAnalyzer&) = delete;
+    CostAnalyzer& operator=(const CostAnalyzer&) = delete;
+
+    // Start over; with a name, only that operation is costed (and budgeted)
+    void reset(std::string_view operation_name = {});
+
+    // Cost of the document's operation (the named one, or the most expensive)
+    uint64_t analyze(const Document& document, std::string_view operation_name = {});
+
+    uint64_t cost() const;
+    bool exceeded() const { return exceeded_; }
+
+    // ParseListener
+    void begin_operation(const OperationDefinition& operation) override;
+    void begin_fragment(const FragmentDefinition& fragment) override;
+    void end_definition() override;
+    void begin_field(const Field& field) override;
+    void end_field(const Field& field) override;
+    void begin_inline_fragment(const InlineFragment& fragment) override;
+    void end_inline_fragment(const InlineFragment& fragment) override;
+    void fragment_spread(const FragmentSpread& spread) override;
+
+private:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    struct DefinitionCost {
+        uint64_t cost = 0;
+        uint32_t unresolved = 0;  // Spreads still waiting on their fragment
+        bool operation = false;
+        bool defined = false;     // Fragments can be referenced before they're defined
+        bool complete = false;
+        bool resolved = false;    // Fragment cost is final
+    };
+
+    CostOptions options_;
+    std::unordered_map<std::string_view, uint64_t> name_costs_;
+    std::unordered_map<uint64_t, uint64_t> typed_costs_;  // (type << 32 | field name ID) -> weight
+
+    std::string operation_name_;
+    std::vector<DefinitionCost> definitions_;
+    std::unordered_map<std::string_view, uint32_t> fragment_index_;
+    std::vector<std::vector<std::pair<uint32_t, uint64_t>>> waiting_;  // Per fragment: (definition, multiplier)
+    bool exceeded_;
+
+    // Open definition
+    uint32_t current_;
+    std::vector<uint64_t> multipliers_;
+    std::vector<uint32_t> types_;  // Schema type of each open selection set, or Schema::NONE
+
+    void begin_definition(uint32_t index, uint32_t type);
+    uint32_t fragment_slot(std::string_view name);
+    void add(uint32_t index, uint64_t amount);
+    void resolve(uint32_t fragment);
+
+    uint64_t field_weight(const Field& field, uint32_t parent_type) const;
+    uint64_t list_size(const Field& field) const;
+    uint32_t type_named(std::string_view name) const;
+
+    void walk(const SelectionSet& set);
+};
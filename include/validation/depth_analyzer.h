@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "ast/ast_nodes.h"
+
+struct DepthReport {
+    static constexpr uint32_t UNBOUNDED_DEPTH = UINT32_MAX;
+    static constexpr uint64_t UNBOUNDED = UINT64_MAX;
+
+    uint32_t max_depth = 0;    // Deepest field nesting, counting through fragments
+    uint64_t field_count = 0;  // Fields in the fully expanded operation (saturating)
+    uint64_t max_breadth = 0;  // Most fields merged into one selection set, through fragments
+    std::vector<std::vector<std::string_view>> cycles;  // Fragment names in each spread cycle
+};
+
+/**
+ * Depth, size and breadth of operations after fragment expansion
+ *
+ * One iterative walk over Document::definitions records, per definition,
+ * its local field count and depth, the field count of each of its
+ * selection sets (inline fragments merge into their enclosing set) and its
+ * spreads with the depth they occur at. An iterative Tarjan SCC pass over
+ * the resulting spread graph finds fragment cycles, and because Tarjan
+ * completes components in reverse topological order, each fragment's
+ * expanded figures are computed from its already finished dependencies as
+ * its component closes. Nothing is expanded: the whole analysis is O(AST
+ * nodes + spreads), even for spread graphs that expand exponentially.
+ *
+ * A definition that can reach a cycle has unbounded depth and size
+ * (UNBOUNDED_DEPTH / UNBOUNDED). Spreads of undefined fragments count as
+ * empty. Scratch storage is reused across calls.
+ *
+ * Usage:
+ *   DepthAnalyzer depth;
+ *   DepthReport report = depth.analyze(*document);
+ *   if (!report.cycles.empty() || report.max_depth > 15) reject();
+ */
+class DepthAnalyzer {
+public:
+    // Figures for the named operation, or the maximum over all operations
+    DepthReport analyze(const Document& document, std::string_view operation_name = {});
+
+private:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    struct Spread {
+        uint32_t target;  // Definition index
+        uint32_t depth;   // Fields enclosing the spread
+        uint32_t set;     // Selection set index the spread merges into
+    };
+
+    struct Node {
+        std::string_view name;
+        bool operation = false;
+        bool defined = false;
+        uint32_t local_depth = 0;
+        uint64_t local_fields = 0;
+        uint32_t first_spread = 0, spread_count = 0;
+        uint32_t first_set = 0, set_count = 0;
+
+        // Tarjan state
+        uint32_t index = NONE;
+        uint32_t low = 0;
+        bool on_stack = false;
+
+        // Expanded figures, final once the node's component closes
+        bool cyclic = false;
+        uint32_t depth = 0;
+        uint64_t fields = 0;
+        uint64_t top_fields = 0;  // Fields merged into the definition's root selection set
+        uint64_t breadth = 0;
+    };
+
+    std::vector<Node> nodes_;
+    std::vector<Spread> spreads_;
+    std::vector<uint64_t> set_fields_;  // Direct field count of each selection set
+    std::unordered_map<std::string_view, uint32_t> fragment_index_;
+
+    // Scratch
+    struct WalkFrame {
+        const SelectionSet* set;
+        uint32_t set_index;
+        uint32_t depth;
+    };
+    std::vector<WalkFrame> walk_stack_;
+    std::vector<uint64_t> set_breadth_;
+    std::vector<uint32_t> tarjan_stack_;
+    std::vector<std::pair<uint32_t, uint32_t>> call_stack_;  // (node, next spread)
+
+    uint32_t fragment_node(std::string_view name);
+    void record(uint32_t node, const SelectionSet& root);
+    void strongconnect(uint32_t root, uint32_t& counter, DepthReport& report);
+    void close_component(uint32_t root, DepthReport& report);
+    void evaluate(Node& node);
+};
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "ast/ast_nodes.h"
+#include "schema/schema.h"
+#include "validation/validator.h"
+
+/**
+ * The "overlapping fields can be merged" rule
+ *
+ * Fields that share a response name within a selection set (directly or
+ * through fragments) must resolve to the same field with the same
+ * arguments, unless their parents are distinct object types, and must
+ * return compatible shapes.
+ *
+ * The spec states the rule pairwise, which is quadratic in the fields per
+ * response name and exponential through repeated fragment spreads. This
+ * follows the merge formulation instead: fields are grouped by response
+ * name with a hash map, and both conditions are equivalence relations, so
+ * each group is compared against one representative (per parent type for
+ * the name/argument check). The sub-selections of a group are merged and
+ * regrouped rather than compared pair by pair, and a fragment spread
+ * several times into a merge is expanded once. The outcome of every group
+ * is memoized for the document, keyed by its field nodes, so a fragment
+ * pair compared under one field is not compared again under another and
+ * the nested checks the Validator requests reuse the work of the outer
+ * ones.
+ */
+class OverlapChecker {
+public:
+    OverlapChecker(const Schema& schema, std::vector<ValidationError>& errors);
+
+    void reset();
+    void add_fragment(const FragmentDefinition* definition, uint32_t type);
+
+    void check(const SelectionSet& set, uint32_t parent_type);
+
+private:
+    struct CollectedField {
+        std::string_view response_name;
+        const Field* field;
+        uint32_t parent;       // Schema::NONE if unknown
+        TypeRef type;          // type == Schema::NONE if unknown
+    };
+
+    using FieldGroup = std::vector<const CollectedField*>;
+
+    struct FragmentEntry {
+        const FragmentDefinition* definition;
+        uint32_t type;
+    };
+
+    // Empty reason if the group merges; otherwise why not, and where
+    struct Conflict {
+        std::string reason;
+        const Field* field = nullptr;
+    };
+
+    const Schema& schema_;
+    std::vector<ValidationError>& errors_;
+    uint32_t schema_names_;
+    std::unordered_map<std::string_view, FragmentEntry> fragments_;
+    std::deque<CollectedField> pool_;  // Stable storage for collected fields, per document
+    std::unordered_map<std::string, Conflict> group_results_;  // Keyed by mode + sorted field nodes
+
+    // Scratch for a single collection or grouping pass
+    std::unordered_set<std::string_view> expanded_;
+    std::unordered_map<std::string_view, size_t> group_index_;
+    FieldGroup check_fields_;
+    std::vector<FieldGroup> check_groups_;
+
+    uint32_t schema_name(uint32_t symbol, std::string_view name) const;
+
+    // Fields of the set with fragments expanded, skipping fragments already in expanded_
+    void collect(const SelectionSet& set, uint32_t parent_type, FieldGroup& out);
+
+    // Groups fields by response name, in order of first appearance, each sorted by position
+    void group_fields(const FieldGroup& fields, std::vector<FieldGroup>& groups);
+    // Sub-selections of every field in the group, merged; each fragment contributes once
+    void merge_children(const FieldGroup& group, FieldGroup& out);
+
+    Conflict shape_conflict(const FieldGroup& group);
+    Conflict parent_conflict(const FieldGroup& group);
+    Conflict parent_partition_conflict(const FieldGroup& partition);
+    Conflict memoized(char mode, const FieldGroup& group);
+    Conflict children_conflict(char mode, const FieldGroup& group);
+
+    bool same_shape(const TypeRef& a, const TypeRef& b) const;
+    bool same_arguments(const Field& a, const Field& b) const;
+};
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "ast/ast_nodes.h"
+#include "schema/schema.h"
+
+struct ValidationError {
+    std::string message;
+    size_t position;  // Source offset of the offending node
+};
+
+class OverlapChecker;
+struct CacheEntry;
+
+/**
+ * Validates executable documents against a Schema
+ *
+ * Implements the rules of the GraphQL spec's Validation section for
+ * operations, fields, arguments, fragments, values, directives and
+ * variables, including overlapping-field merging. All rules run in one
+ * traversal of the Document: each definition is visited once, fragments
+ * record the variables they use and the fragments they spread, and the
+ * per-operation rules (variables defined, used and in allowed positions;
+ * unused fragments) are settled from those records afterwards.
+ *
+ * Names are resolved through their name_id when the document was lexed
+ * with an Interner layered over schema.names() (see Tokenizer), and by
+ * string otherwise. Symbols from any other interner must not be used.
+ *
+ * A Validator is cheap to keep per thread and reuses its scratch storage
+ * across calls; the Schema may be shared.
+ *
+ * For QueryCache entries, validate(entry) records a pass in the entry,
+ * stamped with the schema's generation, and later calls for the same
+ * schema return immediately. Failures are not recorded, so their errors
+ * are always available.
+ *
+ * Usage:
+ *   Validator validator(*schema);
+ *   if (!validator.validate(*document)) {
+ *       for (const auto& e : validator.errors()) ... e.message ...
+ *   }
+ */
+class Validator {
+public:
+    explicit Validator(const Schema& schema);
+    ~Validator();
+
+    Validator(const Validator&) = delete;
+    Validator& operator=(const Validator&) = delete;
+
+    // True if the document is valid; errors() lists every violation
+    bool validate(const Document& document);
+    // Same for a cached query, skipped if it already passed against this schema
+    bool validate(const CacheEntry& entry);
+
+    const std::vector<ValidationError>& errors() const { return errors_; }
+    bool has_errors() const { return !errors_.empty(); }
+
+private:
+    // A variable reference and the input type expected where it appears
+    struct VariableUsage {
+        const Variable* variable;
+        TypeRef type;            // type == Schema::NONE when the position is unknown
+        bool location_default;   // The argument or input field has a default
+    };
+
+    struct FragmentInfo {
+        const FragmentDefinition* definition;
+        uint32_t type;                        // Type condition, or Schema::NONE
+        std::vector<uint32_t> spreads;        // Fragment indices spread directly
+        std::vector<VariableUsage> usages;
+        bool used;
+        uint8_t state;                        // Cycle detection: 0 new, 1 in progress, 2 done
+    };
+
+    const Schema& schema_;
+    uint32_t schema_names_;
+    uint32_t typename_id_;
+    std::vector<ValidationError> errors_;
+
+    std::vector<FragmentInfo> fragments_;
+    std::unordered_map<std::string_view, uint32_t> fragment_index_;
+    std::unordered_map<std::string_view, size_t> names_seen_;  // Scratch for uniqueness checks
+    std::vector<uint32_t> reached_;                              // Scratch: fragments reached by an operation
+
+    // Where the current definition records its spreads and variable usages
+    std::vector<uint32_t>* spreads_;
+    std::vector<VariableUsage>* usages_;
+
+    std::unique_ptr<OverlapChecker> overlap_;
+
+    void error(size_t position, std::string message);
+    uint32_t schema_name(uint32_t symbol, std::string_view name) const;
+    uint32_t fragment_named(const FragmentSpread& spread) const;
+
+    // Definitions
+    void collect_fragments(const Document& document);
+    void check_operation_names(const Document& document);
+    void validate_operation(const OperationDefinition& operation);
+    void validate_fragment(uint32_t index);
+    void check_subscription_root(const OperationDefinition& operation);
+    void check_fragment_cycles();
+    void reach_fragments(const std::vector<uint32_t>& spreads);
+
+    // Selections
+    void visit_selection_set(const SelectionSet& set, uint32_t parent_type);
+    void visit_field(const Field& field, uint32_t parent_type);
+    void visit_fragment_spread(const FragmentSpread& spread, uint32_t parent_type);
+    void visit_inline_fragment(const InlineFragment& fragment, uint32_t parent_type);
+    void check_spread_possible(uint32_t fragment_type, uint32_t parent_type, size_t position,
+                               std::string_view fragment_name);
+
+    // Arguments, directives and values
+    template <typename Args, typename Owner>
+    void check_arguments(const Args& arguments, const Owner& owner, std::string_view owner_name,
+                         size_t position);
+    void check_directives(const std::vector<arena_ptr<Directive>>& directives, DirectiveLocation location);
+    void check_value(const Value& value, TypeRef expected, bool location_default);
+    void check_scalar_literal(const Value& value, uint32_t type);
+    bool resolve_type(const ASTNode& node, TypeRef& out, unsigned level = 0);
+
+    // Variables
+    void check_variable_usages(const OperationDefinition& operation, const std::vector<VariableUsage>& usages);
+    bool allowed_position(TypeRef variable_type, bool variable_default, const VariableUsage& usage) const;
+};
@@ -0,0 +1,143 @@
+#include "ast/flat_ast.h"
+#include <cstring>
+
+namespace {
+
+constexpr char FLAT_MAGIC[4] = {'T', 'G', 'F', 'A'};
+constexpr uint32_t FLAT_VERSION = 2;  // 2: position column
+constexpr size_t FLAT_HEADER_SIZE = 16;
+
+inline size_t pad4(size_t n) {
+    return (n + 3) & ~size_t(3);
+}
+
+// Kinds whose aux fields hold a value instead of a source span
+inline bool aux_is_span(ASTNodeType kind) {
+    return kind != ASTNodeType::OPERATION_DEFINITION && kind != ASTNodeType::BOOLEAN_VALUE;
+}
+
+}  // namespace
+
+void FlatDocument::clear() {
+    kind.clear();
+    first_child.clear();
+    next_sibling.clear();
+    token.clear();
+    position.clear();
+    text_offset.clear();
+    text_length.clear();
+    aux_offset.clear();
+    aux_length.clear();
+    source = std::string_view();
+}
+
+void FlatDocument::reserve(size_t nodes) {
+    kind.reserve(nodes);
+    first_child.reserve(nodes);
+    next_sibling.reserve(nodes);
+    token.reserve(nodes);
+    position.reserve(nodes);
+    text_offset.reserve(nodes);
+    text_length.reserve(nodes);
+    aux_offset.reserve(nodes);
+    aux_length.reserve(nodes);
+}
+
+uint32_t FlatDocument::add_node(ASTNodeType k, uint32_t tok, uint32_t pos, uint32_t text_off, uint32_t text_len,
+                                uint32_t aux_off, uint32_t aux_len) {
+    uint32_t index = size();
+    kind.push_back(k);
+    first_child.push_back(FLAT_NONE);
+    next_sibling.push_back(FLAT_NONE);
+    token.push_back(tok);
+    position.push_back(pos);
+    text_offset.push_back(text_off);
+    text_length.push_back(text_len);
+    aux_offset.push_back(aux_off);
+    aux_length.push_back(aux_len);
+    return index;
+}
+
+FlatDocumentView FlatDocument::view() const {
+    FlatDocumentView v;
+    v.kind = kind.data();
+    v.first_child = first_child.data();
+    v.next_sibling = next_sibling.data();
+    v.token = token.data();
+    v.position = position.data();
+    v.text_offset = text_offset.data();
+    v.text_length = text_length.data();
+    v.aux_offset = aux_offset.data();
+    v.aux_length = aux_length.data();
+    v.node_count = size();
+    v.source = source;
+    return v;
+}
+
+size_t FlatDocument::blob_size(uint32_t node_count) {
+    return FLAT_HEADER_SIZE + pad4(node_count * sizeof(ASTNodeType)) + 8 * node_count * sizeof(uint32_t);
+}
+
+void FlatDocument::serialize(std::string& out) const {
+    uint32_t n = size();
+    size_t base = out.size();
+    out.resize(base + blob_size(n));
+    char* p = &out[base];
+
+    uint32_t header[3] = {FLAT_VERSION, n, static_cast<uint32_t>(source.size())};
+    std::memcpy(p, FLAT_MAGIC, 4);
+    std::memcpy(p + 4, header, sizeof(header));
+    p += FLAT_HEADER_SIZE;
+
+    std::memcpy(p, kind.data(), n * sizeof(ASTNodeType));
+    std::memset(p + n, 0, pad4(n) - n);
+    p += pad4(n * sizeof(ASTNodeType));
+
+    for (const std::vector<uint32_t>* column : {&first_child, &next_sibling, &token, &position,
+                                                &text_offset, &text_length, &aux_offset, &aux_length}) {
+        std::memcpy(p, column->data(), n * sizeof(uint32_t));
+        p += n * sizeof(uint32_t);
+    }
+}
+
+bool FlatDocumentView::from_blob(const void* data, size_t size, std::string_view source,
+                                 FlatDocumentView& out) {
+    const char* p = static_cast<const char*>(data);
+    if (size < FLAT_HEADER_SIZE || (reinterpret_cast<uintptr_t>(p) & 3) != 0) return false;
+    if (std::memcmp(p, FLAT_MAGIC, 4) != 0) return false;
+
+    uint32_t header[3];
+    std::memcpy(header, p + 4, sizeof(header));
+    uint32_t n = header[1];
+    if (header[0] != FLAT_VERSION || header[2] != source.size()) return false;
+    if (size < FlatDocument::blob_size(n)) return false;
+
+    FlatDocumentView v;
+    v.node_count = n;
+    v.source = source;
+    v.kind = reinterpret_cast<const ASTNodeType*>(p + FLAT_HEADER_SIZE);
+    const uint32_t* col = reinterpret_cast<const uint32_t*>(p + FLAT_HEADER_SIZE + pad4(n));
+    v.first_child = col;
+    v.next_sibling = col + n;
+    v.token = col + 2 * n;
+    v.position = col + 3 * n;
+    v.text_offset = col + 4 * n;
+    v.text_length = col + 5 * n;
+    v.aux_offset = col + 6 * n;
+    v.aux_length = col + 7 * n;
+
+    // Validate links and spans so a corrupt blob can't make cursors read out of
+    // bounds. Nodes are emitted in pre-order, so links always point forward,
+    // which also rules out cycles.
+    for (uint32_t i = 0; i < n; i++) {
+        if (static_cast<uint8_t>(v.kind[i]) > static_cast<uint8_t>(ASTNodeType::OBJECT_FIELD)) return false;
+        if (v.first_child[i] != FLAT_NONE && (v.first_child[i] >= n || v.first_child[i] <= i)) return false;
+        if (v.next_sibling[i] != FLAT_NONE && (v.next_sibling[i] >= n || v.next_sibling[i] <= i)) return false;
+        if (v.position[i] > source.size()) return false;
+        if (size_t(v.text_offset[i]) + v.text_length[i] > source.size()) return false;
+        if (aux_is_span(v.kind[i]) && size_t(v.aux_offset[i]) + v.aux_length[i] > source.size()) return false;
+    }
+
+    out = v;
+    return true;
+}
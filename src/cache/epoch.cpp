@@ -0,0 +1,38 @@
+#include "cache/epoch.h"
+#include <algorithm>
+
+size_t EpochManager::enter_shared() {
+    std::lock_guard<std::mutex> lock(shared_mutex_);
+    // Later readers keep the first one's (older) epoch, which only delays reclamation
+    if (shared_readers_++ == 0) {
+        slots_[SHARED_SLOT].epoch.store(epoch_.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+    }
+    return SHARED_SLOT;
+}
+
+void EpochManager::exit_shared() {
+    std::lock_guard<std::mutex> lock(shared_mutex_);
+    if (--shared_readers_ == 0) slots_[SHARED_SLOT].epoch.store(0, std::memory_order_release);
+}
+
+void EpochManager::retire(std::shared_ptr<void> object) {
+    // The object is already unlinked, so any reader entering from now on
+    // observes a later epoch and can't reach it
+    uint64_t epoch = epoch_.fetch_add(1, std::memory_order_seq_cst);
+    retired_.push_back(Retired{epoch, std::move(object)});
+}
+
+void EpochManager::reclaim() {
+    if (retired_.empty()) return;
+
+    uint64_t oldest = UINT64_MAX;
+    for (const auto& slot : slots_) {
+        uint64_t epoch = slot.epoch.load(std::memory_order_seq_cst);
+        if (epoch != 0 && epoch < oldest) oldest = epoch;
+    }
+
+    // Readers that entered at or before an object's retire epoch may hold it
+    auto it = std::remove_if(retired_.begin(), retired_.end(),
+                             [oldest](const Retired& r) { return r.epoch < oldest; });
+    retired_.erase(it, retired_.end());
+}
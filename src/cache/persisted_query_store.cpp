@@ -0,0 +1,151 @@
+#include "cache/persisted_query_store.h"
+#include <fstream>
+#include <sstream>
+#include "json/json_reader.h"
+
+PersistedQueryStore::PersistedQueryStore(QueryCache& cache, size_t max_entries, size_t max_memory_mb)
+    : cache_(cache)
+    , max_entries_(max_entries)
+    , max_memory_bytes_(max_memory_mb * 1024 * 1024)
+    , memory_bytes_(0) {}
+
+size_t PersistedQueryStore::entry_bytes(const Registered& query) {
+    return query.source.capacity() + query.canonical.capacity() + sizeof(Registered) + sizeof(Entry) +
+           sizeof(Sha256Digest) + 64;  // Map and list nodes, shared_ptr control block
+}
+
+PersistedQueryStore::Result PersistedQueryStore::lookup(std::string_view sha256_hex) {
+    Sha256Digest digest;
+    if (!sha256_from_hex(sha256_hex, digest)) return Result{Status::INVALID_HASH, {}};
+    return lookup(digest);
+}
+
+PersistedQueryStore::Result PersistedQueryStore::lookup(const Sha256Digest& digest) {
+    std::shared_ptr<const Registered> query;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = entries_.find(digest);
+        if (it == entries_.end()) return Result{Status::NOT_FOUND, {}};
+        lru_.splice(lru_.begin(), lru_, it->second.lru);
+        query = it->second.query;
+    }
+
+    // Hot path: the parsed document is still cached, no lexing needed. The
+    // key alone doesn't prove it is this query, the canonical form does.
+    QueryCache::Handle entry = cache_.get(query->cache_key);
+    if (entry && entry->canonical == query->canonical) return Result{Status::OK, std::move(entry)};
+
+    // The cache evicted the document; reparse from the stored text
+    entry = cache_.put(query->source);
+    if (!entry) return Result{Status::PARSE_ERROR, {}};
+    return Result{Status::OK, std::move(entry)};
+}
+
+PersistedQueryStore::Result PersistedQueryStore::register_query(std::string_view sha256_hex,
+                                                                const std::string& query) {
+    Sha256Digest digest;
+    if (!sha256_from_hex(sha256_hex, digest)) return Result{Status::INVALID_HASH, {}};
+    if (sha256(query) != digest) return Result{Status::HASH_MISMATCH, {}};
+    return store(digest, query);
+}
+
+PersistedQueryStore::Result PersistedQueryStore::store(const Sha256Digest& digest, const std::string& query) {
+    QueryCache::Handle parsed = cache_.get_or_put(query);
+    if (!parsed) return Result{Status::PARSE_ERROR, {}};
+    auto registered = std::make_shared<const Registered>(Registered{query, parsed->canonical, parsed->key});
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(digest);
+    if (it != entries_.end()) {
+        lru_.splice(lru_.begin(), lru_, it->second.lru);
+        return Result{Status::OK, std::move(parsed)};
+    }
+
+    lru_.push_front(digest);
+    Entry& entry = entries_[digest];
+    entry.query = std::move(registered);
+    entry.lru = lru_.begin();
+    memory_bytes_ += entry_bytes(*entry.query);
+    evict_if_needed();
+    return Result{Status::OK, std::move(parsed)};
+}
+
+void PersistedQueryStore::evict_if_needed() {
+    while (lru_.size() > 1 && (entries_.size() > max_entries_ || memory_bytes_ > max_memory_bytes_)) {
+        auto it = entries_.find(lru_.back());
+        memory_bytes_ -= entry_bytes(*it->second.query);
+        entries_.erase(it);
+        lru_.pop_back();
+    }
+}
+
+size_t PersistedQueryStore::load_manifest(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        errors_.push_back("Cannot open manifest: " + path);
+        return 0;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    return load_manifest_json(buffer.str());
+}
+
+size_t PersistedQueryStore::load_manifest_json(std::string_view json) {
+    size_t loaded = 0;
+    auto add = [&](const std::string& id, const std::string& body) {
+        Sha256Digest digest;
+        Status status = Status::INVALID_HASH;
+        if (sha256_from_hex(id, digest)) {
+            status = sha256(body) == digest ? store(digest, body).status : Status::HASH_MISMATCH;
+        }
+        if (status == Status::OK) {
+            loaded++;
+        } else {
+            const char* reason = status == Status::PARSE_ERROR ? ": parse error"
+                               : status == Status::INVALID_HASH ? ": invalid hash"
+                               : ": hash mismatch";
+            errors_.push_back("Skipped manifest operation " + id + reason);
+        }
+    };
+
+    JsonReader reader(json);
+    std::string key, id, body;
+    if (reader.begin_object()) {
+        while (reader.next_key(key)) {
+            if (key == "operations" && reader.peek() == JsonReader::Type::ARRAY) {
+                // Apollo manifest
+                reader.begin_array();
+                while (reader.next_element()) {
+                    id.clear();
+                    body.clear();
+                    reader.begin_object();
+                    std::string field;
+                    while (reader.next_key(field)) {
+                        if (field == "id") reader.read_string(id);
+                        else if (field == "body") reader.read_string(body);
+                        else reader.skip_value();
+                    }
+                    if (reader.ok()) add(id, body);
+                }
+            } else if (reader.peek() == JsonReader::Type::STRING && key.size() == 64) {
+                // Flat hash -> query map
+                if (reader.read_string(body)) add(key, body);
+            } else {
+                reader.skip_value();  // format, version, ...
+            }
+        }
+    }
+
+    if (!reader.ok()) errors_.push_back("Invalid manifest: " + reader.error());
+    return loaded;
+}
+
+size_t PersistedQueryStore::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+size_t PersistedQueryStore::memory_bytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return memory_bytes_;
+}
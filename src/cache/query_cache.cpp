@@ -0,0 +1,377 @@
+#include "cache/query_cache.h"
+#include <algorithm>
+#include "lexer/canonical_hash.h"
+#include "lexer/lexer.h"
+#include "lexer/token/token_arena.h"
+#include "parser/parser.h"
+
+namespace {
+
+// W-TinyLFU region sizes, as fractions of the budget
+constexpr size_t WINDOW_PERCENT = 1;
+constexpr size_t PROTECTED_PERCENT = 80;  // Of the main region
+
+}  // namespace
+
+QueryCache::QueryCache(size_t max_size, size_t max_memory_mb, const ParserOptions& options,
+                       EvictionPolicy policy)
+    : max_size_(max_size)
+    , max_memory_bytes_(max_memory_mb * 1024 * 1024)
+    , enabled_(true)
+    , options_(options)
+    , memory_bytes_(0)
+    , policy_(policy)
+    , window_bytes_(0)
+    , protected_bytes_(0)
+    , sketch_(max_size)
+    , evictions_(0) {
+    read_buffers_.reset(new ReadBuffer[EpochManager::MAX_READERS + 1]);
+    rebuild_table(max_size * 2);
+}
+
+QueryCache::ReadTable::ReadTable(size_t capacity) : used(0) {
+    size_t size = 16;
+    while (size < capacity) size <<= 1;
+    mask = size - 1;
+    keys.reset(new std::atomic<uint64_t>[size]);
+    entries.reset(new std::atomic<const CacheEntry*>[size]);
+    for (size_t i = 0; i < size; i++) {
+        keys[i].store(0, std::memory_order_relaxed);
+        entries[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+uint64_t QueryCache::key_for(const std::string& query) {
+    return Tokenizer::canonical_hash(query.data(), query.size());
+}
+
+QueryCache::Handle QueryCache::put(const std::string& query) {
+    // Lex and parse outside the lock, from the entry's own copy of the text
+    auto entry = std::make_unique<CacheEntry>(0, query);
+    const std::string& source = entry->source;
+
+    TokenArena token_arena;
+    Tokenizer tokenizer;
+    CanonicalHasher hasher;
+    auto& toks = tokenizer.tokenize(source.data(), source.size(), token_arena,
+                                    options_.max_tokens, hasher);
+    entry->tokens.assign(toks.begin(), toks.end());
+    entry->key = hasher.finish();
+    entry->canonical = hasher.form();
+
+    Parser parser(entry->tokens, *entry->arena, options_);
+    auto doc = parser.parse_document();
+    if (!doc || parser.has_errors()) return Handle();
+
+    entry->ast = doc.release();
+    entry->memory_size = sizeof(CacheEntry) + source.capacity() + entry->canonical.capacity() +
+                         entry->tokens.capacity() * sizeof(Token) +
+                         entry->arena->bytes_allocated();
+    if (!is_enabled()) return Handle(std::unique_ptr<const CacheEntry>(std::move(entry)));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    drain_read_buffers();
+    auto it = cache_.find(entry->key);
+    if (it != cache_.end()) {
+        // Raced with another put of an equivalent query: keep the existing
+        // entry. A different document under the same key is not cached.
+        if (it->second.entry->canonical == entry->canonical) return pin(it->second.entry.get());
+        return Handle(std::unique_ptr<const CacheEntry>(std::move(entry)));
+    }
+
+    // New entries always start in the window; admission to the main region
+    // is decided when they age out of it
+    // Pinned before eviction: if admission turns it away, or it alone
+    // exceeds the memory budget, the caller still gets the parsed entry
+    Handle result = pin(entry.get());
+    insert(std::move(entry), Segment::WINDOW);
+    evict_if_needed();
+    epoch_.reclaim();
+    return result;
+}
+
+QueryCache::Handle QueryCache::get(const std::string& query) {
+    if (!is_enabled()) return Handle();
+    std::string canonical;
+    uint64_t key = Tokenizer::canonical_hash(query.data(), query.size(), &canonical);
+    return lookup(key, &canonical);
+}
+
+QueryCache::Handle QueryCache::get(uint64_t key) {
+    if (!is_enabled()) return Handle();
+    return lookup(key, nullptr);
+}
+
+QueryCache::Handle QueryCache::get_or_put(const std::string& query) {
+    Handle entry = get(query);
+    return entry ? std::move(entry) : put(query);
+}
+
+// Entering the epoch under mutex_ orders it before any later retire(), so
+// the entry stays alive for the handle even if it is evicted right after
+QueryCache::Handle QueryCache::pin(const CacheEntry* entry) {
+    return Handle(this, epoch_.enter(), entry);
+}
+
+QueryCache::Handle QueryCache::lookup(uint64_t key, const std::string* canonical) {
+    size_t slot = epoch_.enter();
+    const CacheEntry* entry = find(key);
+    if (entry && canonical && entry->canonical != *canonical) entry = nullptr;  // Key collision
+    record_read(slot, key, entry != nullptr);
+    return Handle(this, slot, entry);
+}
+
+// Lock-free probe; the caller must be inside an epoch
+const CacheEntry* QueryCache::find(uint64_t key) const {
+    const ReadTable* table = table_.load(std::memory_order_acquire);
+    uint64_t k = table_key(key);
+    for (size_t i = (k ^ (k >> 29)) & table->mask;; i = (i + 1) & table->mask) {
+        uint64_t bucket = table->keys[i].load(std::memory_order_acquire);
+        if (bucket == k) return table->entries[i].load(std::memory_order_acquire);
+        if (bucket == 0) return nullptr;
+    }
+}
+
+// Queue the access for the policy. Only the reader holding the slot writes
+// head, so this is a plain single-producer ring; when it fills up, accesses
+// are dropped until a writer drains it. A reader that finds its buffer half
+// full drains all buffers itself if the writer lock happens to be free.
+void QueryCache::record_read(size_t slot, uint64_t key, bool hit) {
+    ReadBuffer& buffer = read_buffers_[slot];
+    (hit ? buffer.hits : buffer.misses).fetch_add(1, std::memory_order_relaxed);
+    if (slot == EpochManager::SHARED_SLOT) return;  // Many readers at once: not a single producer
+
+    uint32_t head = buffer.head.load(std::memory_order_relaxed);
+    uint32_t tail = buffer.tail.load(std::memory_order_acquire);
+    if (head - tail >= ReadBuffer::SIZE) return;
+    buffer.keys[head % ReadBuffer::SIZE].store(key, std::memory_order_relaxed);
+    buffer.head.store(head + 1, std::memory_order_release);
+
+    if (head + 1 - tail >= ReadBuffer::SIZE / 2 && mutex_.try_lock()) {
+        drain_read_buffers();
+        mutex_.unlock();
+    }
+}
+
+void QueryCache::drain_read_buffers() {
+    auto now = std::chrono::steady_clock::now();
+    for (size_t b = 0; b <= EpochManager::MAX_READERS; b++) {
+        ReadBuffer& buffer = read_buffers_[b];
+        uint32_t tail = buffer.tail.load(std::memory_order_relaxed);
+        uint32_t head = buffer.head.load(std::memory_order_acquire);
+        for (; tail != head; tail++) {
+            uint64_t key = buffer.keys[tail % ReadBuffer::SIZE].load(std::memory_order_relaxed);
+
+            // Frequency is recorded for every lookup, hit or miss, so a query
+            // that keeps missing builds up the history it needs to be admitted
+            if (policy_ == EvictionPolicy::W_TINYLFU) sketch_.increment(key);
+
+            auto it = cache_.find(key);
+            if (it == cache_.end()) continue;
+            CacheEntry* entry = it->second.entry.get();
+            entry->access_count++;
+            entry->last_access = now;
+            on_hit(it->second);
+        }
+        buffer.tail.store(tail, std::memory_order_release);
+    }
+}
+
+void QueryCache::table_insert(const CacheEntry* entry) {
+    ReadTable* table = table_.load(std::memory_order_relaxed);
+    if ((table->used + 1) * 4 > (table->mask + 1) * 3) {
+        rebuild_table(std::max<size_t>(cache_.size() * 2, max_size_ * 2));
+        table = table_.load(std::memory_order_relaxed);
+    }
+
+    uint64_t k = table_key(entry->key);
+    for (size_t i = (k ^ (k >> 29)) & table->mask;; i = (i + 1) & table->mask) {
+        uint64_t bucket = table->keys[i].load(std::memory_order_relaxed);
+        if (bucket == k) {  // Reuse this key's tombstone
+            table->entries[i].store(entry, std::memory_order_release);
+            return;
+        }
+        if (bucket == 0) {
+            // Publish the entry before the key, so a reader that finds the key sees it
+            table->entries[i].store(entry, std::memory_order_release);
+            table->keys[i].store(k, std::memory_order_release);
+            table->used++;
+            return;
+        }
+    }
+}
+
+void QueryCache::table_erase(uint64_t key) {
+    ReadTable* table = table_.load(std::memory_order_relaxed);
+    uint64_t k = table_key(key);
+    for (size_t i = (k ^ (k >> 29)) & table->mask;; i = (i + 1) & table->mask) {
+        uint64_t bucket = table->keys[i].load(std::memory_order_relaxed);
+        if (bucket == k) {
+            table->entries[i].store(nullptr, std::memory_order_release);
+            return;
+        }
+        if (bucket == 0) return;
+    }
+}
+
+// Build a fresh table (dropping tombstones) and swap it in; readers still
+// probing the old one keep it alive through the epoch
+void QueryCache::rebuild_table(size_t capacity) {
+    auto table = std::make_unique<ReadTable>(capacity);
+    ReadTable* old = table_owner_.get();
+    table_owner_.swap(table);
+    table_.store(table_owner_.get(), std::memory_order_release);
+    for (const auto& kv : cache_) table_insert(kv.second.entry.get());
+    if (old) epoch_.retire(std::shared_ptr<void>(std::move(table)));
+}
+
+void QueryCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    drain_read_buffers();
+    for (auto& kv : cache_) {
+        table_erase(kv.first);
+        epoch_.retire(std::shared_ptr<void>(std::move(kv.second.entry)));
+    }
+    for (auto& mapping : snapshots_) epoch_.retire(std::shared_ptr<void>(std::move(mapping)));
+    cache_.clear();
+    window_.clear();
+    probation_.clear();
+    protected_.clear();
+    memory_bytes_ = 0;
+    window_bytes_ = 0;
+    protected_bytes_ = 0;
+    sketch_.clear();
+    snapshots_.clear();
+    rebuild_table(max_size_ * 2);
+    epoch_.reclaim();
+}
+
+QueryCache::Stats QueryCache::get_stats() const {
+    Stats stats;
+    stats.hits = 0;
+    stats.misses = 0;
+    for (size_t b = 0; b <= EpochManager::MAX_READERS; b++) {
+        stats.hits += read_buffers_[b].hits.load(std::memory_order_relaxed);
+        stats.misses += read_buffers_[b].misses.load(std::memory_order_relaxed);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats.total_entries = cache_.size();
+    stats.total_memory_bytes = memory_bytes_;
+    stats.evictions = evictions_;
+    size_t total = stats.hits + stats.misses;
+    stats.hit_rate = total ? static_cast<double>(stats.hits) / total : 0.0;
+    return stats;
+}
+
+std::list<uint64_t>& QueryCache::list_for(Segment segment) {
+    switch (segment) {
+        case Segment::WINDOW: return window_;
+        case Segment::PROBATION: return probation_;
+        default: return protected_;
+    }
+}
+
+void QueryCache::insert(std::unique_ptr<CacheEntry> entry, Segment segment, bool most_recent) {
+    uint64_t key = entry->key;
+    size_t size = entry->memory_size;
+    std::list<uint64_t>& list = list_for(segment);
+    auto position = most_recent ? list.insert(list.begin(), key) : list.insert(list.end(), key);
+
+    table_insert(entry.get());
+    cache_.emplace(key, Slot{std::move(entry), segment, position});
+    memory_bytes_ += size;
+    if (segment == Segment::WINDOW) window_bytes_ += size;
+    if (segment == Segment::PROTECTED) protected_bytes_ += size;
+}
+
+void QueryCache::move_to(Slot& slot, Segment segment) {
+    size_t size = slot.entry->memory_size;
+    if (slot.segment == Segment::WINDOW) window_bytes_ -= size;
+    if (slot.segment == Segment::PROTECTED) protected_bytes_ -= size;
+    if (segment == Segment::WINDOW) window_bytes_ += size;
+    if (segment == Segment::PROTECTED) protected_bytes_ += size;
+
+    std::list<uint64_t>& to = list_for(segment);
+    to.splice(to.begin(), list_for(slot.segment), slot.position);
+    slot.segment = segment;
+}
+
+void QueryCache::remove(uint64_t key) {
+    auto it = cache_.find(key);
+    Slot& slot = it->second;
+    size_t size = slot.entry->memory_size;
+    if (slot.segment == Segment::WINDOW) window_bytes_ -= size;
+    if (slot.segment == Segment::PROTECTED) protected_bytes_ -= size;
+    list_for(slot.segment).erase(slot.position);
+    memory_bytes_ -= size;
+    table_erase(key);
+    epoch_.retire(std::shared_ptr<void>(std::move(slot.entry)));
+    cache_.erase(it);
+    evictions_++;
+}
+
+void QueryCache::on_hit(Slot& slot) {
+    if (slot.segment != Segment::PROBATION) {
+        move_to(slot, slot.segment);  // Just refresh recency
+        return;
+    }
+
+    // A second hit promotes a main-region entry to protected; protected
+    // overflow is demoted back to probation rather than evicted
+    move_to(slot, Segment::PROTECTED);
+    size_t main_bytes = max_memory_bytes_ - max_memory_bytes_ * WINDOW_PERCENT / 100;
+    size_t main_entries = max_size_ - max_size_ * WINDOW_PERCENT / 100;
+    while (protected_.size() > 1 &&
+           (protected_bytes_ > main_bytes * PROTECTED_PERCENT / 100 ||
+            protected_.size() > main_entries * PROTECTED_PERCENT / 100)) {
+        move_to(cache_.find(protected_.back())->second, Segment::PROBATION);
+    }
+}
+
+bool QueryCache::over_budget() const {
+    return cache_.size() > max_size_ || memory_bytes_ > max_memory_bytes_;
+}
+
+void QueryCache::evict_if_needed() {
+    if (policy_ == EvictionPolicy::LRU) {
+        while (over_budget() && !window_.empty()) remove(window_.back());
+        return;
+    }
+
+    // Entries aging out of the window compete for a place in the main region
+    size_t window_bytes = std::max<size_t>(max_memory_bytes_ * WINDOW_PERCENT / 100, 1);
+    size_t window_entries = std::max<size_t>(max_size_ * WINDOW_PERCENT / 100, 1);
+    while (!window_.empty() && (window_bytes_ > window_bytes || window_.size() > window_entries)) {
+        uint64_t candidate = window_.back();
+        move_to(cache_.find(candidate)->second, Segment::PROBATION);
+        admit(candidate);
+    }
+
+    // Only reachable if the window alone exceeds the budget
+    while (over_budget() && !window_.empty()) remove(window_.back());
+}
+
+// TinyLFU admission: evict main-region victims (probation first) while the
+// candidate is more popular than each of them; otherwise drop the candidate
+void QueryCache::admit(uint64_t candidate) {
+    uint32_t candidate_freq = sketch_.frequency(candidate);
+    while (over_budget()) {
+        uint64_t victim;
+        if (!probation_.empty() && probation_.back() != candidate) {
+            victim = probation_.back();
+        } else if (!protected_.empty()) {
+            victim = protected_.back();
+        } else {
+            remove(candidate);  // Too large to fit on its own
+            return;
+        }
+
+        if (candidate_freq > sketch_.frequency(victim)) {
+            remove(victim);
+        } else {
+            remove(candidate);
+            return;
+        }
+    }
+}
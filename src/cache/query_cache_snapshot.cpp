@@ -0,0 +1,197 @@
+#include "cache/query_cache.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "lexer/lexer.h"
+#include "parser/flat_parser.h"
+
+// Snapshot file layout (all fields little-endian, records 8-byte aligned):
+//
+//   header   "TGQC" | u32 version | u64 entry count
+//   record   u64 key | u32 source length | u32 blob length | u32 access count | u32 reserved
+//            source bytes, padded to 8
+//            flat AST blob (FlatDocument::serialize), padded to 8
+//
+// The blob and the source it refers to stay in the mapping, so a restored
+// entry's FlatDocumentView points directly into the file. The saved key is
+// only meaningful to the process that wrote it (canonical hashes are keyed
+// per process), so loading recomputes it from the source.
+
+namespace {
+
+constexpr char SNAPSHOT_MAGIC[4] = {'T', 'G', 'Q', 'C'};
+constexpr uint32_t SNAPSHOT_VERSION = 1;
+
+struct SnapshotHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t count;
+};
+
+struct RecordHeader {
+    uint64_t key;
+    uint32_t source_length;
+    uint32_t blob_length;
+    uint32_t access_count;
+    uint32_t reserved;
+};
+
+inline size_t pad8(size_t n) {
+    return (n + 7) & ~size_t(7);
+}
+
+void append_padded(std::string& out, const void* data, size_t len) {
+    out.append(static_cast<const char*>(data), len);
+    out.append(pad8(len) - len, '\0');
+}
+
+}  // namespace
+
+struct QueryCache::MappedFile {
+    void* data = nullptr;
+    size_t size = 0;
+
+    ~MappedFile() {
+        if (data) munmap(data, size);
+    }
+};
+
+size_t QueryCache::save_snapshot(const std::string& path) {
+    std::string out;
+    size_t written = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        drain_read_buffers();
+
+        // Most recently used first, so a smaller cache restores the hottest entries
+        std::vector<const CacheEntry*> entries;
+        entries.reserve(cache_.size());
+        for (const auto& kv : cache_) entries.push_back(kv.second.entry.get());
+        std::sort(entries.begin(), entries.end(), [](const CacheEntry* a, const CacheEntry* b) {
+            return a->last_access > b->last_access;
+        });
+
+        SnapshotHeader header{};
+        std::memcpy(header.magic, SNAPSHOT_MAGIC, 4);
+        header.version = SNAPSHOT_VERSION;
+        out.append(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        FlatDocument flat;
+        std::string blob;
+        for (const CacheEntry* entry : entries) {
+            std::string_view text = entry->text();
+            blob.clear();
+            if (entry->is_warm()) {
+                blob.assign(entry->flat_blob);
+            } else {
+                // Live entries are flattened from their tree at save time, so
+                // the hot path never pays for the flat form
+                FlatParser(entry->tokens, text, options_).flatten(*entry->ast, flat);
+                flat.serialize(blob);
+            }
+            // Every entry is saved or none is: a record that can't be
+            // represented fails the snapshot instead of silently shrinking it
+            if (text.size() > UINT32_MAX || blob.size() > UINT32_MAX) return 0;
+
+            RecordHeader record{};
+            record.key = entry->key;
+            record.source_length = static_cast<uint32_t>(text.size());
+            record.blob_length = static_cast<uint32_t>(blob.size());
+            record.access_count = static_cast<uint32_t>(std::min<size_t>(entry->access_count, UINT32_MAX));
+            out.append(reinterpret_cast<const char*>(&record), sizeof(record));
+            append_padded(out, text.data(), text.size());
+            append_padded(out, blob.data(), blob.size());
+            written++;
+        }
+        reinterpret_cast<SnapshotHeader*>(&out[0])->count = written;
+    }
+
+    // Write to a temporary file and rename, so a crash never leaves a torn snapshot
+    std::string tmp = path + ".tmp";
+    FILE* file = std::fopen(tmp.c_str(), "wb");
+    if (!file) return 0;
+    bool ok = std::fwrite(out.data(), 1, out.size(), file) == out.size();
+    ok = std::fclose(file) == 0 && ok;
+    if (!ok || std::rename(tmp.c_str(), path.c_str()) != 0) {
+        std::remove(tmp.c_str());
+        return 0;
+    }
+    return written;
+}
+
+size_t QueryCache::load_snapshot(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return 0;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(SnapshotHeader)) {
+        close(fd);
+        return 0;
+    }
+
+    auto mapping = std::make_shared<MappedFile>();
+    mapping->size = static_cast<size_t>(st.st_size);
+    void* data = mmap(nullptr, mapping->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return 0;
+    mapping->data = data;
+
+    const char* base = static_cast<const char*>(data);
+    const char* end = base + mapping->size;
+    SnapshotHeader header;
+    std::memcpy(&header, base, sizeof(header));
+    if (std::memcmp(header.magic, SNAPSHOT_MAGIC, 4) != 0 || header.version != SNAPSHOT_VERSION) {
+        return 0;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t restored = 0;
+    const char* p = base + sizeof(SnapshotHeader);
+    auto now = std::chrono::steady_clock::now();
+
+    for (uint64_t i = 0; i < header.count && p + sizeof(RecordHeader) <= end; i++) {
+        RecordHeader record;
+        std::memcpy(&record, p, sizeof(record));
+        p += sizeof(record);
+
+        size_t source_span = pad8(record.source_length);
+        size_t blob_span = pad8(record.blob_length);
+        if (static_cast<size_t>(end - p) < source_span + blob_span) break;
+        std::string_view source(p, record.source_length);
+        std::string_view blob(p + source_span, record.blob_length);
+        p += source_span + blob_span;
+
+        if (cache_.size() >= max_size_) break;
+        std::string canonical;
+        uint64_t key = Tokenizer::canonical_hash(source.data(), source.size(), &canonical);
+        if (cache_.count(key)) continue;
+
+        FlatDocumentView view;
+        if (!FlatDocumentView::from_blob(blob.data(), blob.size(), source, view)) continue;
+
+        auto entry = std::make_unique<CacheEntry>(key, view, blob);
+        entry->canonical = std::move(canonical);
+        entry->access_count = record.access_count;
+        // Keep the saved recency order: earlier records are more recent
+        entry->last_access = now - std::chrono::nanoseconds(i);
+        entry->memory_size = sizeof(CacheEntry) + source.size() + blob.size() + entry->canonical.capacity();
+        if (memory_bytes_ + entry->memory_size > max_memory_bytes_) break;
+
+        // Restored entries go straight to the main region, in saved recency
+        // order, with their saved popularity fed back into the sketch
+        if (policy_ == EvictionPolicy::W_TINYLFU) {
+            for (uint32_t n = 0; n < std::min<uint32_t>(record.access_count, FrequencySketch::MAX_FREQUENCY); n++) {
+                sketch_.increment(key);
+            }
+        }
+        insert(std::move(entry), policy_ == EvictionPolicy::LRU ? Segment::WINDOW : Segment::PROBATION, false);
+        restored++;
+    }
+
+    if (restored) snapshots_.push_back(std::move(mapping));
+    return restored;
+}
@@ -0,0 +1,317 @@
+#include "json/json_reader.h"
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include "simd/json_escape_scan.h"
+#include "simd/simd_interface.h"
+
+namespace {
+
+bool is_whitespace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+}  // namespace
+
+JsonReader::JsonReader(std::string_view text)
+    : text_(text), pos_(0), after_value_(false) {}
+
+void JsonReader::skip_whitespace() {
+    // Compact JSON has none; pretty-printed has indentation runs for the kernel
+    if (pos_ >= text_.size() || !is_whitespace(text_[pos_])) return;
+    if (++pos_ < text_.size() && is_whitespace(text_[pos_])) {
+        static const SIMDInterface& kernels = SIMDInterface::getInstance();
+        pos_ = kernels.skipWhitespace(text_.data(), pos_, text_.size());
+    }
+}
+
+bool JsonReader::fail(const char* message) {
+    if (error_.empty()) {
+        error_ = std::string(message) + " at offset " + std::to_string(pos_);
+    }
+    return false;
+}
+
+JsonReader::Type JsonReader::peek() {
+    if (!ok()) return Type::INVALID;
+    skip_whitespace();
+    if (pos_ >= text_.size()) return Type::END;
+    switch (text_[pos_]) {
+        case '{': return Type::OBJECT;
+        case '[': return Type::ARRAY;
+        case '"': return Type::STRING;
+        case 't': case 'f': return Type::BOOLEAN;
+        case 'n': return Type::NULL_VALUE;
+        case '-': return Type::NUMBER;
+        default:
+            return (text_[pos_] >= '0' && text_[pos_] <= '9') ? Type::NUMBER : Type::INVALID;
+    }
+}
+
+bool JsonReader::begin_object() {
+    if (peek() != Type::OBJECT) return fail("Expected '{'");
+    pos_++;
+    after_value_ = false;
+    return true;
+}
+
+bool JsonReader::begin_array() {
+    if (peek() != Type::ARRAY) return fail("Expected '['");
+    pos_++;
+    after_value_ = false;
+    return true;
+}
+
+// Consumes the separator before the next item, or the closing bracket
+bool JsonReader::next_item(char close) {
+    if (!ok()) return false;
+    skip_whitespace();
+    if (pos_ >= text_.size()) return fail("Unexpected end of input");
+
+    if (text_[pos_] == close) {
+        pos_++;
+        after_value_ = true;  // The container itself was a value
+        return false;
+    }
+    if (after_value_) {
+        if (text_[pos_] != ',') return fail("Expected ','");
+        pos_++;
+    }
+    after_value_ = true;
+    return true;
+}
+
+bool JsonReader::next_key(std::string& key) {
+    if (!next_item('}')) return false;
+    if (!read_string(key)) return false;
+    skip_whitespace();
+    if (pos_ >= text_.size() || text_[pos_] != ':') return fail("Expected ':'");
+    pos_++;
+    return true;
+}
+
+bool JsonReader::next_element() {
+    return next_item(']');
+}
+
+bool JsonReader::next_key(std::string_view& key, ASTArena& arena) {
+    if (!next_item('}')) return false;
+    if (!read_string(key, arena)) return false;
+    skip_whitespace();
+    if (pos_ >= text_.size() || text_[pos_] != ':') return fail("Expected ':'");
+    pos_++;
+    return true;
+}
+
+// Consumes the string at pos_; body is what's between the quotes, still escaped
+bool JsonReader::scan_string(std::string_view& body, bool& escaped) {
+    if (peek() != Type::STRING) return fail("Expected string");
+    const char* text = text_.data();
+    size_t size = text_.size();
+    size_t begin = ++pos_;
+    escaped = false;
+
+    while (true) {
+        size_t at = pos_ + find_json_escape(text + pos_, size - pos_);
+        pos_ = at;
+        if (at >= size) break;
+        if (text[at] == '"') {
+            body = text_.substr(begin, at - begin);
+            pos_++;
+            return true;
+        }
+        if (text[at] != '\\') return fail("Unescaped control character in string");
+        // The escaped byte can't end the string; unescape() checks it
+        escaped = true;
+        pos_ = at + 2;
+        if (pos_ > size) break;
+    }
+    pos_ = size;
+    return fail("Unterminated string");
+}
+
+bool JsonReader::unescape(std::string_view body, std::string& out) {
+    out.clear();
+    out.reserve(body.size());
+    size_t i = 0;
+    while (i < body.size()) {
+        size_t run = body.find('\\', i);
+        if (run == std::string_view::npos) run = body.size();
+        out.append(body.data() + i, run - i);
+        if (run == body.size()) break;
+        i = run + 1;
+
+        char c = body[i++];
+        switch (c) {
+            case '"': out += '"'; break;
+            case '\\': out += '\\'; break;
+            case '/': out += '/'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'u': {
+                auto hex4 = [&body, &i](uint32_t& cp) {
+                    if (i + 4 > body.size()) return false;
+                    cp = 0;
+                    for (int k = 0; k < 4; k++) {
+                        char h = body[i++];
+                        cp <<= 4;
+                        if (h >= '0' && h <= '9') cp |= h - '0';
+                        else if (h >= 'a' && h <= 'f') cp |= h - 'a' + 10;
+                        else if (h >= 'A' && h <= 'F') cp |= h - 'A' + 10;
+                        else return false;
+                    }
+                    return true;
+                };
+                uint32_t cp;
+                if (!hex4(cp)) return fail("Invalid \\u escape");
+                // Surrogate pair; either half alone has no UTF-8 encoding
+                if (cp >= 0xD800 && cp <= 0xDFFF) {
+                    if (cp >= 0xDC00 || i + 2 > body.size() || body[i] != '\\' || body[i + 1] != 'u') {
+                        return fail("Invalid surrogate pair");
+                    }
+                    i += 2;
+                    uint32_t low;
+                    if (!hex4(low) || low < 0xDC00 || low > 0xDFFF) return fail("Invalid surrogate pair");
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                }
+                if (cp < 0x80) {
+                    out += static_cast<char>(cp);
+                } else if (cp < 0x800) {
+                    out += static_cast<char>(0xC0 | (cp >> 6));
+                    out += static_cast<char>(0x80 | (cp & 0x3F));
+                } else if (cp < 0x10000) {
+                    out += static_cast<char>(0xE0 | (cp >> 12));
+                    out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+                    out += static_cast<char>(0x80 | (cp & 0x3F));
+                } else {
+                    out += static_cast<char>(0xF0 | (cp >> 18));
+                    out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+                    out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+                    out += static_cast<char>(0x80 | (cp & 0x3F));
+                }
+                break;
+            }
+            default:
+                return fail("Invalid escape");
+        }
+    }
+    return true;
+}
+
+bool JsonReader::read_string(std::string& out) {
+    std::string_view body;
+    bool escaped;
+    if (!scan_string(body, escaped)) return false;
+    if (escaped) return unescape(body, out);
+    out.assign(body.data(), body.size());
+    return true;
+}
+
+bool JsonReader::read_string(std::string_view& out, ASTArena& arena) {
+    std::string_view body;
+    bool escaped;
+    if (!scan_string(body, escaped)) return false;
+    if (!escaped) {
+        out = body;
+        return true;
+    }
+    std::string unescaped;
+    if (!unescape(body, unescaped)) return false;
+    char* bytes = arena.allocate_array<char>(unescaped.size() ? unescaped.size() : 1);
+    if (!unescaped.empty()) std::memcpy(bytes, unescaped.data(), unescaped.size());
+    out = std::string_view(bytes, unescaped.size());
+    return true;
+}
+
+bool JsonReader::read_number(std::string_view& token, bool& integer) {
+    if (peek() != Type::NUMBER) return fail("Expected number");
+    // -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?
+    const char* text = text_.data();
+    size_t size = text_.size();
+    size_t end = pos_;
+    auto digits = [&]() {
+        size_t first = end;
+        while (end < size && text[end] >= '0' && text[end] <= '9') end++;
+        return end > first;
+    };
+    if (text[end] == '-') end++;
+    if (end < size && text[end] == '0') {
+        end++;
+    } else if (!digits()) {
+        return fail("Invalid number");
+    }
+    integer = true;
+    if (end < size && text[end] == '.') {
+        end++;
+        integer = false;
+        if (!digits()) return fail("Invalid number");
+    }
+    if (end < size && (text[end] == 'e' || text[end] == 'E')) {
+        end++;
+        integer = false;
+        if (end < size && (text[end] == '+' || text[end] == '-')) end++;
+        if (!digits()) return fail("Invalid number");
+    }
+    token = text_.substr(pos_, end - pos_);
+    pos_ = end;
+    return true;
+}
+
+bool JsonReader::read_number(double& out) {
+    std::string_view token;
+    bool integer;
+    if (!read_number(token, integer)) return false;
+    auto parsed = std::from_chars(token.data(), token.data() + token.size(), out);
+    if (parsed.ec != std::errc()) return fail("Invalid number");
+    return true;
+}
+
+bool JsonReader::expect_literal(std::string_view literal) {
+    if (text_.substr(pos_, literal.size()) != literal) return fail("Invalid literal");
+    pos_ += literal.size();
+    return true;
+}
+
+bool JsonReader::read_bool(bool& out) {
+    if (peek() != Type::BOOLEAN) return fail("Expected boolean");
+    out = text_[pos_] == 't';
+    return expect_literal(out ? "true" : "false");
+}
+
+bool JsonReader::read_null() {
+    if (peek() != Type::NULL_VALUE) return fail("Expected null");
+    return expect_literal("null");
+}
+
+bool JsonReader::skip_value() {
+    std::string scratch;
+    double number;
+    bool flag;
+    switch (peek()) {
+        case Type::OBJECT:
+            if (!begin_object()) return false;
+            while (next_key(scratch)) {
+                if (!skip_value()) return false;
+            }
+            return ok();
+        case Type::ARRAY:
+            if (!begin_array()) return false;
+            while (next_element()) {
+                if (!skip_value()) return false;
+            }
+            return ok();
+        case Type::STRING: {
+            std::string_view body;
+            bool escaped;
+            // Skipped strings are held to the same escape rules as read ones
+            return scan_string(body, escaped) && (!escaped || unescape(body, scratch));
+        }
+        case Type::NUMBER: return read_number(number);
+        case Type::BOOLEAN: return read_bool(flag);
+        case Type::NULL_VALUE: return read_null();
+        default: return fail("Expected value");
+    }
+}
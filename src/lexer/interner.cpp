@@ -0,0 +1,143 @@
+#include "lexer/interner.h"
+#include <cstring>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// Bit i set where control byte i of the group equals tag
+inline uint32_t match_group(const uint8_t* group, uint8_t tag) {
+#ifdef __SSE2__
+    __m128i ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+    return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(static_cast<char>(tag)))));
+#else
+    uint32_t mask = 0;
+    for (int i = 0; i < 16; i++) mask |= static_cast<uint32_t>(group[i] == tag) << i;
+    return mask;
+#endif
+}
+
+// The low 7 bits tag the slot; the rest pick the starting group
+inline uint8_t tag_of(uint64_t h) {
+    return static_cast<uint8_t>(h & 0x7F);
+}
+
+inline size_t group_of(uint64_t h) {
+    return static_cast<size_t>(h >> 7);
+}
+
+}  // namespace
+
+Interner::Interner(const Interner* base)
+    : base_(base),
+      base_size_(base ? static_cast<uint32_t>(base->size()) : 0),
+      control_(GROUP_SIZE, EMPTY),
+      slots_(GROUP_SIZE),
+      group_mask_(0),
+      chunk_(nullptr),
+      chunk_used_(0) {}
+
+uint64_t Interner::hash(std::string_view name) {
+    const char* p = name.data();
+    size_t n = name.size();
+    uint64_t h = 0x9E3779B97F4A7C15ull ^ n;
+    for (; n >= 8; p += 8, n -= 8) {
+        uint64_t w;
+        std::memcpy(&w, p, 8);
+        h = (h ^ w) * 0xFF51AFD7ED558CCDull;
+        h ^= h >> 32;
+    }
+    if (n) {
+        uint64_t w = 0;
+        std::memcpy(&w, p, n);
+        h = (h ^ w) * 0xFF51AFD7ED558CCDull;
+    }
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ull;
+    h ^= h >> 29;
+    return h;
+}
+
+uint32_t Interner::find_local(std::string_view name, uint64_t h) const {
+    uint8_t tag = tag_of(h);
+    // Triangular probing over groups visits every group once
+    size_t group = group_of(h) & group_mask_;
+    for (size_t step = 1;; step++) {
+        const uint8_t* ctrl = control_.data() + group * GROUP_SIZE;
+        for (uint32_t match = match_group(ctrl, tag); match; match &= match - 1) {
+            uint32_t local = slots_[group * GROUP_SIZE + __builtin_ctz(match)];
+            if (names_[local] == name) return local;
+        }
+        if (match_group(ctrl, EMPTY)) return INVALID;
+        group = (group + step) & group_mask_;
+    }
+}
+
+uint32_t Interner::find(std::string_view name) const {
+    if (base_) {
+        uint32_t id = base_->find(name);
+        if (id != INVALID) return id;
+    }
+    uint32_t local = find_local(name, hash(name));
+    return local != INVALID ? base_size_ + local : INVALID;
+}
+
+uint32_t Interner::intern(std::string_view name) {
+    if (base_) {
+        uint32_t id = base_->find(name);
+        if (id != INVALID) return id;
+    }
+    uint64_t h = hash(name);
+    uint32_t local = find_local(name, h);
+    if (local != INVALID) return base_size_ + local;
+
+    // Keep the table at most 7/8 full so every probe ends at an empty slot
+    if ((names_.size() + 1) * 8 > control_.size() * 7) grow();
+    local = static_cast<uint32_t>(names_.size());
+    names_.push_back(store(name));
+    insert_slot(local, h);
+    return base_size_ + local;
+}
+
+void Interner::insert_slot(uint32_t local, uint64_t h) {
+    size_t group = group_of(h) & group_mask_;
+    for (size_t step = 1;; step++) {
+        uint32_t empty = match_group(control_.data() + group * GROUP_SIZE, EMPTY);
+        if (empty) {
+            size_t slot = group * GROUP_SIZE + __builtin_ctz(empty);
+            control_[slot] = tag_of(h);
+            slots_[slot] = local;
+            return;
+        }
+        group = (group + step) & group_mask_;
+    }
+}
+
+void Interner::grow() {
+    size_t capacity = control_.size() * 2;
+    control_.assign(capacity, EMPTY);
+    slots_.assign(capacity, 0);
+    group_mask_ = capacity / GROUP_SIZE - 1;
+    for (uint32_t local = 0; local < names_.size(); local++) {
+        insert_slot(local, hash(names_[local]));
+    }
+}
+
+std::string_view Interner::store(std::string_view name) {
+    if (name.size() > CHUNK_SIZE / 4) {
+        // Oversized names get their own allocation
+        chunks_.emplace_back(new char[name.size()]);
+        std::memcpy(chunks_.back().get(), name.data(), name.size());
+        return std::string_view(chunks_.back().get(), name.size());
+    }
+    if (!chunk_ || chunk_used_ + name.size() > CHUNK_SIZE) {
+        chunks_.emplace_back(new char[CHUNK_SIZE]);
+        chunk_ = chunks_.back().get();
+        chunk_used_ = 0;
+    }
+    char* out = chunk_ + chunk_used_;
+    std::memcpy(out, name.data(), name.size());
+    chunk_used_ += name.size();
+    return std::string_view(out, name.size());
+}
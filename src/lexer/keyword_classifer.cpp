@@ -16,7 +16,7 @@
 
 uint32_t calculate_keyword_hash(std::string_view sv) {
     const size_t len = sv.length();
-    if (len < 2 || len > 11) return 0;
+    if (len < 2 || len > 12) return 0;
     
     // Use FNV-1a inspired hash algorithm
     uint32_t hash = 2166136261u; // FNV offset basis
@@ -51,7 +51,7 @@ uint32_t calculate_keyword_hash(std::string_view sv) {
 // Optimized keyword classifier with improved hash function
 TokenType classify_keyword(std::string_view sv) {
     const size_t len = sv.length();
-    if (len < 2 || len > 11) return TokenType::IDENTIFIER;
+    if (len < 2 || len > 12) return TokenType::IDENTIFIER;
     
     uint32_t hash = calculate_keyword_hash(sv);
     
@@ -103,8 +103,8 @@ TokenType classify_keyword(std::string_view sv) {
         case 0xc9177ae6: if (sv == "implements") return TokenType::KEYWORD_IMPLEMENTS; break;
         case 0xf7614f98: if (sv == "__typename") return TokenType::KEYWORD_TYPENAME; break;
         
-        // 11-letter keywords
-        case 0x00000000: if (sv == "subscription") return TokenType::KEYWORD_SUBSCRIPTION; break;
+        // 12-letter keywords
+        case 0xa57d196f: if (sv == "subscription") return TokenType::KEYWORD_SUBSCRIPTION; break;
     }
     return TokenType::IDENTIFIER;
 }
\ No newline at end of file
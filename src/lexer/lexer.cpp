@@ -4,6 +4,7 @@
 #include <memory>
 #include <immintrin.h>
 #include "lexer/lexer.h"
+#include "lexer/canonical_hash.h"
 #include "lexer/token/token_arena.h"
 #include "lexer/character_classifier.h"
 #include "lexer/keyword_classifier.h"
@@ -93,26 +94,12 @@ __attribute__((always_inline)) inline size_t skip_comments_simd(const char* __re
   return i;
 }
 
-// Optimized tokenizer with better SIMD usage and branch prediction
-std::pmr::vector<Token>& Tokenizer::tokenize(const char* text, 
-    size_t text_len, 
-    TokenArena& arena) {
-    
-    // Pre-allocate with exact size for small documents or a reasonable estimate for larger ones
-    std::pmr::vector<Token>& tokens = arena.tokens_vector;
-    tokens.clear();  // Ensure we have a clean vector
-    tokens.reserve(text_len > 1000 ? text_len / 3 : text_len);
-    
-    size_t i = 0;
-    
-    // Skip BOM if present (common in some GraphQL files)
-    if (text_len >= 3 && 
-        static_cast<unsigned char>(text[0]) == 0xEF && 
-        static_cast<unsigned char>(text[1]) == 0xBB && 
-        static_cast<unsigned char>(text[2]) == 0xBF) {
-        i = 3;
-    }
-
+// Scan the next token starting at i, skipping whitespace and comments.
+// This is the whole lexer: Tokenizer::tokenize and LexerCursor both drive it,
+// so the materialized and pull modes share the same SIMD kernels.
+// Returns false (with i == text_len) when the input is exhausted.
+__attribute__((always_inline)) inline bool scan_token(const char* __restrict__ text, size_t& i,
+                                                      size_t text_len, Token& out) {
     while (i < text_len) {
         // SIMD-accelerated whitespace skipping
         if (__builtin_expect(i + 32 <= text_len, 1)) {
@@ -162,9 +149,9 @@ std::pmr::vector<Token>& Tokenizer::tokenize(const char* text,
         
         // Check for ellipsis next
         if (i + 2 < text_len && text[i] == '.' && text[i + 1] == '.' && text[i + 2] == '.') {
-            tokens.emplace_back(TokenType::ELLIPSIS, std::string_view(&text[i], 3), i);
+            out = Token(TokenType::ELLIPSIS, std::string_view(&text[i], 3), i);
             i += 3;
-            continue;
+            return true;
         }
         
         // Check for variables ($) and directives (@)
@@ -180,23 +167,85 @@ std::pmr::vector<Token>& Tokenizer::tokenize(const char* text,
                 len++;
             }
         
-            tokens.emplace_back(type, std::string_view(text + start, len), start);
-            continue;
+            out = Token(type, std::string_view(text + start, len), start);
+            return true;
         }
         
         // Fast path for special characters
         if (__builtin_expect(getCharLookup().hasFlag(c, CharLookup::SPECIAL_CHAR_FLAG), 1)) {
             TokenType type = getCharLookup().getSpecialCharType(c);
-            tokens.emplace_back(type, std::string_view(text + i, 1), i);
+            out = Token(type, std::string_view(text + i, 1), i);
             i++;
-            continue;
+            return true;
         }
 
+        // Fast path for numbers with SIMD (including negative numbers)
+        // Checked before symbols so that '-' followed by a digit starts a number
+        if (__builtin_expect(getCharLookup().hasFlag(c, CharLookup::DIGIT_FLAG) || 
+            (c == '-' && i + 1 < text_len && getCharLookup().hasFlag(text[i + 1], CharLookup::DIGIT_FLAG)), 0)) {
+            size_t start = i;
+            bool has_decimal = false;
+            bool has_exponent = false;
+            
+            // Handle negative sign
+            if (c == '-') {
+                i++;
+            }
+            
+            // Integer part - use SIMD for bulk scanning
+            while (i + 32 <= text_len) {
+                __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i));
+                
+                // Check for digits only (no decimals in this pass)
+                __m256i is_digit = _mm256_and_si256(
+                    _mm256_cmpgt_epi8(chunk, _mm256_set1_epi8('0' - 1)),
+                    _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), chunk)
+                );
+                
+                uint32_t digit_bits = _mm256_movemask_epi8(is_digit);
+                
+                if (digit_bits == 0xFFFFFFFF) {
+                    i += 32;
+                    continue;
+                }
+                
+                // Found non-digit
+                unsigned int pos = __builtin_ctz(~digit_bits);
+                i += pos;
+                break;
+            }
+            
+            // Process remaining bytes (decimals, exponents)
+            while (i < text_len) {
+                c = text[i];
+                if (c >= '0' && c <= '9') {
+                    i++;
+                } else if (c == '.' && !has_decimal && !has_exponent) {
+                    // FIX: Ensure only one decimal point and not after exponent
+                    has_decimal = true;
+                    i++;
+                } else if ((c == 'e' || c == 'E') && !has_exponent) {
+                    // Scientific notation
+                    has_exponent = true;
+                    i++;
+                    // Optional sign after exponent
+                    if (i < text_len && (text[i] == '+' || text[i] == '-')) {
+                        i++;
+                    }
+                } else {
+                    break;
+                }
+            }
+            
+            out = Token(TokenType::NUMBER, std::string_view(text + start, i - start), start);
+            return true;
+        }
+        
         // Fast path for regular symbols
         if (__builtin_expect(getCharLookup().hasFlag(c, CharLookup::SYMBOL_FLAG), 1)) {
-            tokens.emplace_back(TokenType::SYMBOL, std::string_view(text + i, 1), i);
+            out = Token(TokenType::SYMBOL, std::string_view(text + i, 1), i);
             i++;
-            continue;
+            return true;
         }
         
         // Fast path for identifiers with optimized SIMD
@@ -265,77 +314,15 @@ std::pmr::vector<Token>& Tokenizer::tokenize(const char* text,
             std::string_view token_view(text + start, len);
             
             // Fast keyword checking
-            tokens.emplace_back(classify_keyword(token_view), token_view, start);
-
-            continue;
-        }
-        
-        // Fast path for numbers with SIMD (including negative numbers)
-        if (__builtin_expect(getCharLookup().hasFlag(c, CharLookup::DIGIT_FLAG) || 
-            (c == '-' && i + 1 < text_len && getCharLookup().hasFlag(text[i + 1], CharLookup::DIGIT_FLAG)), 0)) {
-            size_t start = i;
-            bool has_decimal = false;
-            bool has_exponent = false;
-            
-            // Handle negative sign
-            if (c == '-') {
-                i++;
-            }
-            
-            // Integer part - use SIMD for bulk scanning
-            while (i + 32 <= text_len) {
-                __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i));
-                
-                // Check for digits only (no decimals in this pass)
-                __m256i is_digit = _mm256_and_si256(
-                    _mm256_cmpgt_epi8(chunk, _mm256_set1_epi8('0' - 1)),
-                    _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), chunk)
-                );
-                
-                uint32_t digit_bits = _mm256_movemask_epi8(is_digit);
-                
-                if (digit_bits == 0xFFFFFFFF) {
-                    i += 32;
-                    continue;
-                }
-                
-                // Found non-digit
-                unsigned int pos = __builtin_ctz(~digit_bits);
-                i += pos;
-                break;
-            }
-            
-            // Process remaining bytes (decimals, exponents)
-            while (i < text_len) {
-                c = text[i];
-                if (c >= '0' && c <= '9') {
-                    i++;
-                } else if (c == '.' && !has_decimal && !has_exponent) {
-                    // FIX: Ensure only one decimal point and not after exponent
-                    has_decimal = true;
-                    i++;
-                } else if ((c == 'e' || c == 'E') && !has_exponent) {
-                    // Scientific notation
-                    has_exponent = true;
-                    i++;
-                    // Optional sign after exponent
-                    if (i < text_len && (text[i] == '+' || text[i] == '-')) {
-                        i++;
-                    }
-                } else {
-                    break;
-                }
-            }
-            
-            tokens.emplace_back(TokenType::NUMBER, std::string_view(text + start, i - start), start);
-            continue;
+            out = Token(classify_keyword(token_view), token_view, start);
+            return true;
         }
         
         // Handle string literals (including block strings)
         if (__builtin_expect(getCharLookup().hasFlag(c, CharLookup::STRING_DELIM_FLAG), 0)) {
             char quote_char = c;
             size_t start = i;
-            bool escaped = false;  // Declare at top to avoid goto issues
+            bool escaped = false;
             
             // Check for block string (triple quotes)
             if (i + 2 < text_len && text[i + 1] == quote_char && text[i + 2] == quote_char) {
@@ -345,15 +332,16 @@ std::pmr::vector<Token>& Tokenizer::tokenize(const char* text,
                 while (i + 2 < text_len) {
                     if (text[i] == quote_char && text[i + 1] == quote_char && text[i + 2] == quote_char) {
                         i += 3;
-                        tokens.emplace_back(TokenType::STRING, std::string_view(text + start, i - start), start);
-                        goto string_done;
+                        out = Token(TokenType::STRING, std::string_view(text + start, i - start), start);
+                        return true;
                     }
                     // Block strings can contain unescaped quotes and newlines
                     i++;
                 }
                 // ERROR: Unterminated block string
-                tokens.emplace_back(TokenType::UNKNOWN, std::string_view(text + start, i - start), start);
-                continue;
+                i = text_len;
+                out = Token(TokenType::UNKNOWN, std::string_view(text + start, i - start), start);
+                return true;
             }
             
             // Regular string - use improved escape tracking
@@ -370,16 +358,19 @@ std::pmr::vector<Token>& Tokenizer::tokenize(const char* text,
                 uint32_t escape_mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, escape_v));
                 uint32_t newline_mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, newline_v));
                 
-                // ERROR: Unescaped newline in string
-                if (newline_mask) {
+                // ERROR: Unescaped newline in string (only if it comes before
+                // the closing quote or an escape)
+                uint32_t stop_mask = quote_mask | escape_mask;
+                if (newline_mask &&
+                    (!stop_mask || __builtin_ctz(newline_mask) < __builtin_ctz(stop_mask))) {
                     unsigned int nl_pos = __builtin_ctz(newline_mask);
                     i += nl_pos;
-                    tokens.emplace_back(TokenType::UNKNOWN, std::string_view(text + start, i - start), start);
-                    goto string_done;
+                    out = Token(TokenType::UNKNOWN, std::string_view(text + start, i - start), start);
+                    return true;
                 }
                 
                 // Look for unescaped quote
-                if (quote_mask || escape_mask) {
+                if (stop_mask) {
                     // Fall back to scalar for this chunk (complex escape handling)
                     break;
                 }
@@ -402,27 +393,125 @@ std::pmr::vector<Token>& Tokenizer::tokenize(const char* text,
                     i++;
                 } else if (ch == quote_char) {
                     i++; // Include closing quote
-                    tokens.emplace_back(TokenType::STRING, std::string_view(text + start, i - start), start);
-                    goto string_done;
+                    out = Token(TokenType::STRING, std::string_view(text + start, i - start), start);
+                    return true;
                 } else if (ch == '\n') {
                     // ERROR: Unterminated string (newline)
-                    tokens.emplace_back(TokenType::UNKNOWN, std::string_view(text + start, i - start), start);
-                    goto string_done;
+                    out = Token(TokenType::UNKNOWN, std::string_view(text + start, i - start), start);
+                    return true;
                 } else {
                     i++;
                 }
             }
             
             // ERROR: Unterminated string (EOF)
-            tokens.emplace_back(TokenType::UNKNOWN, std::string_view(text + start, i - start), start);
-            string_done:
-            continue;
+            out = Token(TokenType::UNKNOWN, std::string_view(text + start, i - start), start);
+            return true;
         }
         
         // Handle unknown
-        tokens.emplace_back(TokenType::UNKNOWN, std::string_view(text + i, 1), i);
+        out = Token(TokenType::UNKNOWN, std::string_view(text + i, 1), i);
         i++;
+        return true;
+    }
+    
+    return false;
+}
+
+
+// Attach the interned symbol to name-like tokens
+inline void intern_token(Interner& interner, Token& token) {
+    if (token.type <= TokenType::IDENTIFIER) {
+        token.symbol = interner.intern(token.value);
+    } else if (token.type == TokenType::VARIABLE || token.type == TokenType::DIRECTIVE) {
+        token.symbol = interner.intern(token.value.substr(1));
+    }
+}
+
+// Skip BOM if present (common in some GraphQL files)
+inline size_t skip_bom(const char* text, size_t text_len) {
+    if (text_len >= 3 && 
+        static_cast<unsigned char>(text[0]) == 0xEF && 
+        static_cast<unsigned char>(text[1]) == 0xBB && 
+        static_cast<unsigned char>(text[2]) == 0xBF) {
+        return 3;
+    }
+    return 0;
+}
+
+// Optimized tokenizer with better SIMD usage and branch prediction
+std::pmr::vector<Token>& Tokenizer::tokenize(const char* text, 
+    size_t text_len, 
+    TokenArena& arena,
+    size_t max_tokens) {
+    
+    // Pre-allocate with exact size for small documents or a reasonable estimate for larger ones
+    std::pmr::vector<Token>& tokens = arena.tokens_vector;
+    tokens.clear();  // Ensure we have a clean vector
+    size_t estimate = text_len > 1000 ? text_len / 3 : text_len;
+    tokens.reserve(estimate < max_tokens ? estimate : max_tokens + 1);
+    
+    size_t i = skip_bom(text, text_len);
+    Token token;
+    
+    // Token limit: keep one extra token so the parser can tell the limit was hit
+    while (tokens.size() <= max_tokens && scan_token(text, i, text_len, token)) {
+        if (interner_) intern_token(*interner_, token);
+        tokens.push_back(token);
+    }
+    
+    return tokens;
+}
+
+std::pmr::vector<Token>& Tokenizer::tokenize(const char* text, 
+    size_t text_len, 
+    TokenArena& arena,
+    size_t max_tokens,
+    CanonicalHasher& hasher) {
+    
+    std::pmr::vector<Token>& tokens = arena.tokens_vector;
+    tokens.clear();
+    size_t estimate = text_len > 1000 ? text_len / 3 : text_len;
+    tokens.reserve(estimate < max_tokens ? estimate : max_tokens + 1);
+    
+    size_t i = skip_bom(text, text_len);
+    Token token;
+    
+    while (tokens.size() <= max_tokens && scan_token(text, i, text_len, token)) {
+        hasher.add(token);
+        if (interner_) intern_token(*interner_, token);
+        tokens.push_back(token);
     }
     
     return tokens;
 }
+
+uint64_t Tokenizer::canonical_hash(const char* text, size_t text_len, std::string* form) {
+    size_t i = skip_bom(text, text_len);
+    Token token;
+    CanonicalHasher hasher;
+    
+    while (scan_token(text, i, text_len, token)) {
+        hasher.add(token);
+    }
+    uint64_t hash = hasher.finish();
+    if (form) *form = hasher.form();
+    return hash;
+}
+
+// Pull-mode lexer
+LexerCursor::LexerCursor(const char* text, size_t text_len, Interner* interner)
+    : text_(text), text_len_(text_len), pos_(skip_bom(text, text_len)), produced_(0), done_(false),
+      interner_(interner) {}
+
+bool LexerCursor::fill(size_t index) {
+    while (produced_ <= index) {
+        if (done_ || !scan_token(text_, pos_, text_len_, ring_[produced_ & RING_MASK])) {
+            done_ = true;
+            return false;
+        }
+        if (interner_) intern_token(*interner_, ring_[produced_ & RING_MASK]);
+        produced_++;
+    }
+    return true;
+}
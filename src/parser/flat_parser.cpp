@@ -0,0 +1,432 @@
+#include "parser/flat_parser.h"
+#include <algorithm>
+#include "parser/parser.h"
+
+FlatParser::FlatParser(const std::vector<Token>& tokens, std::string_view source, const ParserOptions& options)
+    : tokens_(tokens), source_(source), options_(options), doc_(nullptr) {}
+
+bool FlatParser::parse_document(FlatDocument& out) {
+    out.clear();
+    out.source = source_;
+
+    ASTArena arena(source_.size() * 16 + 1024);
+    Parser parser(tokens_, arena, options_);
+    auto document = parser.parse_document();
+    errors_ = parser.get_errors();
+    limit_exceeded_ = parser.limit_exceeded();
+    if (!document || !errors_.empty()) return false;
+
+    flatten(*document, out);
+    return true;
+}
+
+void FlatParser::flatten(const Document& document, FlatDocument& out) {
+    doc_ = &out;
+    out.clear();
+    out.source = source_;
+    out.reserve(tokens_.size() + 1);
+    last_child_.clear();
+    last_child_.reserve(tokens_.size() + 1);
+
+    out.add_node(ASTNodeType::DOCUMENT, 0, 0, 0, 0);
+    last_child_.push_back(FLAT_NONE);
+    for (const Definition& definition : document.definitions) {
+        if (auto* op = std::get_if<arena_ptr<OperationDefinition>>(&definition)) {
+            flatten_operation(0, **op);
+        } else {
+            flatten_fragment(0, *std::get<arena_ptr<FragmentDefinition>>(definition));
+        }
+    }
+    doc_ = nullptr;
+}
+
+// Node construction
+uint32_t FlatParser::token_at(size_t position) const {
+    auto it = std::lower_bound(tokens_.begin(), tokens_.end(), position,
+                               [](const Token& token, size_t pos) { return token.position < pos; });
+    return static_cast<uint32_t>(it - tokens_.begin());
+}
+
+uint32_t FlatParser::offset_of(std::string_view text) const {
+    return static_cast<uint32_t>(text.data() - source_.data());
+}
+
+uint32_t FlatParser::add_child(uint32_t parent, ASTNodeType kind, size_t position, std::string_view text,
+                               uint32_t aux_offset, uint32_t aux_length) {
+    uint32_t text_offset = text.empty() ? static_cast<uint32_t>(position) : offset_of(text);
+    uint32_t node = doc_->add_node(kind, token_at(position), static_cast<uint32_t>(position), text_offset,
+                                   static_cast<uint32_t>(text.size()), aux_offset, aux_length);
+    last_child_.push_back(FLAT_NONE);
+
+    uint32_t tail = last_child_[parent];
+    if (tail == FLAT_NONE) {
+        doc_->first_child[parent] = node;
+    } else {
+        doc_->next_sibling[tail] = node;
+    }
+    last_child_[parent] = node;
+    return node;
+}
+
+uint32_t FlatParser::add_child(uint32_t parent, ASTNodeType kind, size_t position, std::string_view text,
+                               std::string_view aux) {
+    if (aux.empty()) return add_child(parent, kind, position, text);
+    return add_child(parent, kind, position, text, offset_of(aux), static_cast<uint32_t>(aux.size()));
+}
+
+// Definitions
+void FlatParser::flatten_operation(uint32_t parent, const OperationDefinition& op) {
+    uint32_t node = add_child(parent, ASTNodeType::OPERATION_DEFINITION, op.position, op.name,
+                              static_cast<uint32_t>(op.operation_type));
+    for (const auto& var_def : op.variable_definitions) {
+        uint32_t def = add_child(node, ASTNodeType::VARIABLE_DEFINITION, var_def->position,
+                                 var_def->variable->name);
+        flatten_type(def, *var_def->type);
+        if (var_def->default_value) flatten_value(def, *var_def->default_value);
+        flatten_directives(def, var_def->directives);
+    }
+    flatten_directives(node, op.directives);
+    if (op.selection_set) flatten_selection_set(node, *op.selection_set);
+}
+
+void FlatParser::flatten_fragment(uint32_t parent, const FragmentDefinition& fragment) {
+    uint32_t node = add_child(parent, ASTNodeType::FRAGMENT_DEFINITION, fragment.position, fragment.name,
+                              fragment.type_condition);
+    flatten_directives(node, fragment.directives);
+    if (fragment.selection_set) flatten_selection_set(node, *fragment.selection_set);
+}
+
+// Selections
+void FlatParser::flatten_selection_set(uint32_t parent, const SelectionSet& selection_set) {
+    uint32_t node = add_child(parent, ASTNodeType::SELECTION_SET, selection_set.position);
+    for (const Selection& selection : selection_set.selections) {
+        if (auto* field_ptr = std::get_if<arena_ptr<Field>>(&selection)) {
+            const Field& field = **field_ptr;
+            uint32_t child = add_child(node, ASTNodeType::FIELD, field.position, field.name, field.alias);
+            flatten_arguments(child, field.arguments);
+            flatten_directives(child, field.directives);
+            if (field.selection_set) flatten_selection_set(child, *field.selection_set);
+            continue;
+        }
+
+        // Tree positions of spreads are past the '...'; flat nodes start at it
+        uint32_t child;
+        if (auto* spread_ptr = std::get_if<arena_ptr<FragmentSpread>>(&selection)) {
+            const FragmentSpread& spread = **spread_ptr;
+            child = add_child(node, ASTNodeType::FRAGMENT_SPREAD, spread.position, spread.name);
+            flatten_directives(child, spread.directives);
+        } else {
+            const InlineFragment& fragment = *std::get<arena_ptr<InlineFragment>>(selection);
+            child = add_child(node, ASTNodeType::INLINE_FRAGMENT, fragment.position, std::string_view(),
+                              fragment.type_condition);
+            flatten_directives(child, fragment.directives);
+            if (fragment.selection_set) flatten_selection_set(child, *fragment.selection_set);
+        }
+        uint32_t token = doc_->token[child];
+        if (token > 0 && tokens_[token - 1].type == TokenType::ELLIPSIS) doc_->token[child] = token - 1;
+    }
+}
+
+void FlatParser::flatten_arguments(uint32_t parent, const std::vector<arena_ptr<Argument>>& arguments) {
+    for (const auto& argument : arguments) {
+        uint32_t node = add_child(parent, ASTNodeType::ARGUMENT, argument->position, argument->name);
+        flatten_value(node, argument->value);
+    }
+}
+
+void FlatParser::flatten_directives(uint32_t parent, const std::vector<arena_ptr<Directive>>& directives) {
+    for (const auto& directive : directives) {
+        uint32_t node = add_child(parent, ASTNodeType::DIRECTIVE, directive->position, directive->name);
+        flatten_arguments(node, directive->arguments);
+    }
+}
+
+// Types
+void FlatParser::flatten_type(uint32_t parent, const ASTNode& type) {
+    if (auto* named = std::get_if<NamedType>(&type.data)) {
+        add_child(parent, ASTNodeType::NAMED_TYPE, named->position, named->name);
+    } else if (auto* list = std::get_if<ListType>(&type.data)) {
+        flatten_type(add_child(parent, ASTNodeType::LIST_TYPE, list->position), *list->type);
+    } else {
+        // The tree records the '!' end; the flat node's token is the wrapped type's first
+        const NonNullType& non_null = std::get<NonNullType>(type.data);
+        const ASTNode& inner = *non_null.type;
+        size_t start = inner.type == ASTNodeType::NAMED_TYPE ? std::get<NamedType>(inner.data).position
+                                                             : std::get<ListType>(inner.data).position;
+        uint32_t node = add_child(parent, ASTNodeType::NON_NULL_TYPE, non_null.position);
+        doc_->token[node] = token_at(start);
+        doc_->text_offset[node] = static_cast<uint32_t>(start);
+        flatten_type(node, inner);
+    }
+}
+
+// Values
+void FlatParser::flatten_value(uint32_t parent, const Value& value) {
+    std::visit([&](const auto& v) {
+        using T = std::decay_t<decltype(v)>;
+        if constexpr (std::is_same_v<T, IntValue>) {
+            add_child(parent, ASTNodeType::INT_VALUE, v.position, v.value);
+        } else if constexpr (std::is_same_v<T, FloatValue>) {
+            add_child(parent, ASTNodeType::FLOAT_VALUE, v.position, v.value);
+        } else if constexpr (std::is_same_v<T, StringValue>) {
+            add_child(parent, ASTNodeType::STRING_VALUE, v.position, v.value);
+        } else if constexpr (std::is_same_v<T, EnumValue>) {
+            add_child(parent, ASTNodeType::ENUM_VALUE, v.position, v.value);
+        } else if constexpr (std::is_same_v<T, BooleanValue>) {
+            add_child(parent, ASTNodeType::BOOLEAN_VALUE, v.position, tokens_[token_at(v.position)].value,
+                      v.value ? 1 : 0);
+        } else if constexpr (std::is_same_v<T, NullValue>) {
+            add_child(parent, ASTNodeType::NULL_VALUE, v.position, tokens_[token_at(v.position)].value);
+        } else if constexpr (std::is_same_v<T, arena_ptr<Variable>>) {
+            add_child(parent, ASTNodeType::VARIABLE, v->position, v->name);
+        } else if constexpr (std::is_same_v<T, arena_ptr<ListValue>>) {
+            uint32_t node = add_child(parent, ASTNodeType::LIST_VALUE, v->position);
+            v->for_each([&](const Value& item) { flatten_value(node, item); });
+        } else {
+            uint32_t node = add_child(parent, ASTNodeType::OBJECT_VALUE, v->position);
+            for (const ObjectField& field : v->fields) {
+                flatten_value(add_child(node, ASTNodeType::OBJECT_FIELD, field.position, field.name), field.value);
+            }
+        }
+    }, value);
+}
+
+// FlatExpander
+
+FlatExpander::FlatExpander(const FlatDocumentView& view, ASTArena& arena, Interner* interner)
+    : view_(view), arena_(arena), interner_(interner) {}
+
+uint32_t FlatExpander::symbol(std::string_view name) const {
+    return interner_ && !name.empty() ? interner_->intern(name) : NO_SYMBOL;
+}
+
+template<typename T>
+ArenaSpan<T> FlatExpander::to_arena(std::vector<T>& items) {
+    if (items.empty()) return ArenaSpan<T>();
+    T* data = arena_.allocate_array<T>(items.size());
+    for (size_t i = 0; i < items.size(); i++) new (&data[i]) T(std::move(items[i]));
+    return ArenaSpan<T>(data, items.size());
+}
+
+arena_ptr<Document> FlatExpander::expand() {
+    if (view_.empty()) return nullptr;
+    auto* document = arena_.create<Document>();
+    FlatNode(&view_, 0).for_each_child([&](FlatNode node) {
+        if (node.kind() == ASTNodeType::OPERATION_DEFINITION) {
+            document->definitions.push_back(expand_operation(node));
+        } else {
+            document->definitions.push_back(expand_fragment(node));
+        }
+    });
+    return arena_ptr<Document>(document);
+}
+
+// Definitions
+arena_ptr<OperationDefinition> FlatExpander::expand_operation(FlatNode node) {
+    auto* op = arena_.create<OperationDefinition>();
+    op->operation_type = node.operation_type();
+    op->name = node.name();
+    op->position = node.position();
+    node.for_each_child([&](FlatNode child) {
+        if (child.kind() == ASTNodeType::VARIABLE_DEFINITION) {
+            auto* var_def = arena_.create<VariableDefinition>();
+            var_def->position = child.position();
+            auto* var = arena_.create<Variable>();
+            var->name = child.name();
+            var->name_id = symbol(var->name);
+            var->position = child.position();
+            var_def->variable = arena_ptr<Variable>(var);
+            child.for_each_child([&](FlatNode part) {
+                switch (part.kind()) {
+                    case ASTNodeType::NAMED_TYPE:
+                    case ASTNodeType::LIST_TYPE:
+                    case ASTNodeType::NON_NULL_TYPE:
+                        var_def->type = expand_type(part);
+                        break;
+                    case ASTNodeType::DIRECTIVE:
+                        var_def->directives.push_back(expand_directive(part));
+                        break;
+                    default:
+                        var_def->default_value = arena_ptr<Value>(arena_.create<Value>(expand_value(part)));
+                        break;
+                }
+            });
+            op->variable_definitions.push_back(arena_ptr<VariableDefinition>(var_def));
+        } else if (child.kind() == ASTNodeType::DIRECTIVE) {
+            op->directives.push_back(expand_directive(child));
+        } else {
+            op->selection_set = expand_selection_set(child);
+        }
+    });
+    return arena_ptr<OperationDefinition>(op);
+}
+
+arena_ptr<FragmentDefinition> FlatExpander::expand_fragment(FlatNode node) {
+    auto* fragment = arena_.create<FragmentDefinition>();
+    fragment->name = node.name();
+    fragment->name_id = symbol(fragment->name);
+    fragment->type_condition = node.type_condition();
+    fragment->type_condition_id = symbol(fragment->type_condition);
+    fragment->position = node.position();
+    node.for_each_child([&](FlatNode child) {
+        if (child.kind() == ASTNodeType::DIRECTIVE) {
+            fragment->directives.push_back(expand_directive(child));
+        } else {
+            fragment->selection_set = expand_selection_set(child);
+        }
+    });
+    return arena_ptr<FragmentDefinition>(fragment);
+}
+
+// Selections
+arena_ptr<SelectionSet> FlatExpander::expand_selection_set(FlatNode node) {
+    auto* selection_set = arena_.create<SelectionSet>();
+    selection_set->position = node.position();
+    node.for_each_child([&](FlatNode child) {
+        if (child.kind() == ASTNodeType::FIELD) {
+            auto* field = arena_.create<Field>();
+            field->alias = child.alias();
+            field->alias_id = symbol(field->alias);
+            field->name = child.name();
+            field->name_id = symbol(field->name);
+            field->position = child.position();
+            child.for_each_child([&](FlatNode part) {
+                if (part.kind() == ASTNodeType::ARGUMENT) {
+                    field->arguments.push_back(expand_argument(part));
+                } else if (part.kind() == ASTNodeType::DIRECTIVE) {
+                    field->directives.push_back(expand_directive(part));
+                } else {
+                    field->selection_set = expand_selection_set(part);
+                }
+            });
+            selection_set->selections.push_back(arena_ptr<Field>(field));
+        } else if (child.kind() == ASTNodeType::FRAGMENT_SPREAD) {
+            auto* spread = arena_.create<FragmentSpread>();
+            spread->name = child.name();
+            spread->name_id = symbol(spread->name);
+            spread->position = child.position();
+            child.for_each_child([&](FlatNode part) { spread->directives.push_back(expand_directive(part)); });
+            selection_set->selections.push_back(arena_ptr<FragmentSpread>(spread));
+        } else {
+            auto* fragment = arena_.create<InlineFragment>();
+            fragment->type_condition = child.type_condition();
+            fragment->type_condition_id = symbol(fragment->type_condition);
+            fragment->position = child.position();
+            child.for_each_child([&](FlatNode part) {
+                if (part.kind() == ASTNodeType::DIRECTIVE) {
+                    fragment->directives.push_back(expand_directive(part));
+                } else {
+                    fragment->selection_set = expand_selection_set(part);
+                }
+            });
+            selection_set->selections.push_back(arena_ptr<InlineFragment>(fragment));
+        }
+    });
+    return arena_ptr<SelectionSet>(selection_set);
+}
+
+arena_ptr<Argument> FlatExpander::expand_argument(FlatNode node) {
+    auto* argument = arena_.create<Argument>();
+    argument->name = node.name();
+    argument->name_id = symbol(argument->name);
+    argument->value = expand_value(node.first_child());
+    argument->position = node.position();
+    return arena_ptr<Argument>(argument);
+}
+
+arena_ptr<Directive> FlatExpander::expand_directive(FlatNode node) {
+    auto* directive = arena_.create<Directive>();
+    directive->name = node.name();
+    directive->name_id = symbol(directive->name);
+    directive->position = node.position();
+    node.for_each_child([&](FlatNode child) { directive->arguments.push_back(expand_argument(child)); });
+    return arena_ptr<Directive>(directive);
+}
+
+// Types
+arena_ptr<ASTNode> FlatExpander::expand_type(FlatNode node) {
+    ASTNode* type;
+    if (node.kind() == ASTNodeType::NAMED_TYPE) {
+        NamedType named;
+        named.name = node.name();
+        named.name_id = symbol(named.name);
+        named.position = node.position();
+        type = arena_.create<ASTNode>(std::move(named));
+    } else if (node.kind() == ASTNodeType::LIST_TYPE) {
+        ListType list;
+        list.type = expand_type(node.first_child());
+        list.position = node.position();
+        type = arena_.create<ASTNode>(std::move(list));
+    } else {
+        NonNullType non_null;
+        non_null.type = expand_type(node.first_child());
+        non_null.position = node.position();
+        type = arena_.create<ASTNode>(std::move(non_null));
+    }
+    return arena_ptr<ASTNode>(type);
+}
+
+// Values
+Value FlatExpander::expand_value(FlatNode node) {
+    size_t position = node.position();
+    switch (node.kind()) {
+        case ASTNodeType::INT_VALUE:     return IntValue{node.text(), position};
+        case ASTNodeType::FLOAT_VALUE:   return FloatValue{node.text(), position};
+        case ASTNodeType::STRING_VALUE:  return StringValue{node.text(), position};
+        case ASTNodeType::ENUM_VALUE:    return EnumValue{node.text(), position};
+        case ASTNodeType::BOOLEAN_VALUE: return BooleanValue{node.boolean_value(), position};
+        case ASTNodeType::NULL_VALUE:    return NullValue{position};
+        case ASTNodeType::VARIABLE: {
+            auto* var = arena_.create<Variable>();
+            var->name = node.name();
+            var->name_id = symbol(var->name);
+            var->position = position;
+            return arena_ptr<Variable>(var);
+        }
+        case ASTNodeType::LIST_VALUE: {
+            auto* list = arena_.create<ListValue>();
+            list->position = position;
+            list->source = view_.source.data() + position;
+
+            // Scalars of a single kind are packed, like Parser packs them
+            ASTNodeType kind = ASTNodeType::LIST_VALUE;
+            bool packable = true;
+            node.for_each_child([&](FlatNode item) {
+                ASTNodeType item_kind = item.kind();
+                bool scalar = item_kind == ASTNodeType::INT_VALUE || item_kind == ASTNodeType::FLOAT_VALUE ||
+                              item_kind == ASTNodeType::STRING_VALUE || item_kind == ASTNodeType::ENUM_VALUE;
+                if (!scalar || (kind != ASTNodeType::LIST_VALUE && item_kind != kind)) packable = false;
+                kind = item_kind;
+            });
+            if (packable && kind != ASTNodeType::LIST_VALUE) {
+                std::vector<PackedScalar> packed;
+                node.for_each_child([&](FlatNode item) {
+                    packed.push_back(PackedScalar{static_cast<uint32_t>(item.position() - position),
+                                                  static_cast<uint32_t>(item.text().size())});
+                });
+                list->packed = to_arena(packed);
+                list->packed_kind = kind;
+            } else {
+                std::vector<Value> values;
+                node.for_each_child([&](FlatNode item) { values.push_back(expand_value(item)); });
+                list->values = to_arena(values);
+            }
+            return arena_ptr<ListValue>(list);
+        }
+        default: {
+            auto* object = arena_.create<ObjectValue>();
+            object->position = position;
+            std::vector<ObjectField> fields;
+            node.for_each_child([&](FlatNode child) {
+                ObjectField field;
+                field.name = child.name();
+                field.name_id = symbol(field.name);
+                field.value = expand_value(child.first_child());
+                field.position = child.position();
+                fields.push_back(std::move(field));
+            });
+            object->fields = to_arena(fields);
+            return arena_ptr<ObjectValue>(object);
+        }
+    }
+}
@@ -1,34 +1,60 @@
 #include "parser/parser.h"
+#include "parser/parse_listener.h"
 #include <sstream>
 
-Parser::Parser(const std::vector<Token>& tokens, ASTArena& arena)
-    : tokens_(tokens), current_(0), arena_(arena) {}
+Parser::Parser(const std::vector<Token>& tokens, ASTArena& arena, const ParserOptions& options)
+    : tokens_(tokens.data()), token_count_(tokens.size()), cursor_(nullptr), current_(0), arena_(arena),
+      options_(options), depth_(0), alias_count_(0) {}
+
+Parser::Parser(const std::pmr::vector<Token>& tokens, ASTArena& arena, const ParserOptions& options)
+    : tokens_(tokens.data()), token_count_(tokens.size()), cursor_(nullptr), current_(0), arena_(arena),
+      options_(options), depth_(0), alias_count_(0) {}
+
+Parser::Parser(LexerCursor& cursor, ASTArena& arena, const ParserOptions& options)
+    : tokens_(nullptr), token_count_(0), cursor_(&cursor), current_(0), arena_(arena), options_(options),
+      depth_(0), alias_count_(0) {}
 
 // Token navigation
+// In fused mode the cursor keeps a few tokens around current_, which covers
+// the one token of lookbehind (previous_token) and lookahead (peek) used here.
 const Token& Parser::current_token() const {
-    if (current_ >= tokens_.size()) {
-        static Token eof_token{TokenType::UNKNOWN, "", 0};
+    static Token eof_token{TokenType::UNKNOWN, "", 0};
+    if (cursor_) {
+        return cursor_->has(current_) ? cursor_->at(current_) : eof_token;
+    }
+    if (current_ >= token_count_) {
         return eof_token;
     }
     return tokens_[current_];
 }
 
 const Token& Parser::peek(size_t offset) const {
+    static Token eof_token{TokenType::UNKNOWN, "", 0};
     size_t pos = current_ + offset;
-    if (pos >= tokens_.size()) {
-        static Token eof_token{TokenType::UNKNOWN, "", 0};
+    if (cursor_) {
+        return cursor_->has(pos) ? cursor_->at(pos) : eof_token;
+    }
+    if (pos >= token_count_) {
         return eof_token;
     }
     return tokens_[pos];
 }
 
 bool Parser::is_at_end() const {
-    return current_ >= tokens_.size();
+    if (cursor_) return !cursor_->has(current_);
+    return current_ >= token_count_;
 }
 
 const Token& Parser::advance() {
     if (!is_at_end()) current_++;
-    return tokens_[current_ - 1];
+    if (cursor_ && __builtin_expect(current_ > options_.max_tokens, 0)) {
+        limit_error(ParserLimit::TOKENS, "Maximum token count exceeded");
+    }
+    return previous_token();
+}
+
+const Token& Parser::previous_token() const {
+    return cursor_ ? cursor_->at(current_ - 1) : tokens_[current_ - 1];
 }
 
 bool Parser::check(TokenType type) const {
@@ -82,6 +108,82 @@ void Parser::synchronize() {
     }
 }
 
+// Resource limits
+void Parser::limit_error(ParserLimit limit, const char* message) {
+    limit_exceeded_ = limit;
+    throw ParseLimitExceeded(limit, message);
+}
+
+void Parser::enter_nesting() {
+    if (++depth_ > options_.max_depth) {
+        limit_error(ParserLimit::DEPTH, "Maximum nesting depth exceeded");
+    }
+}
+
+void Parser::check_ast_bytes() {
+    if (arena_.bytes_allocated() > options_.max_arena_bytes) {
+        limit_error(ParserLimit::ARENA_BYTES, "Maximum arena size exceeded");
+    }
+}
+
+void Parser::check_list_size(size_t size) {
+    if (size > options_.max_list_size) {
+        limit_error(ParserLimit::LIST_SIZE, "Maximum list/object value size exceeded");
+    }
+}
+
+// Two-pass preallocation: count the direct children of every selection set
+// '{' and argument/variable '(' group. A child starts at a name, variable or
+// '...' that isn't the tail of "alias: name", "name: value", "... on Type"
+// or "= default". List and object values are built through the scratch
+// stacks and sized exactly anyway, so their groups are only tracked to skip
+// what's inside them.
+void Parser::take_census() {
+    child_counts_.assign(token_count_, 0);
+    struct Group {
+        size_t open;
+        bool value;  // '[' or an object value '{'
+    };
+    std::vector<Group> open;
+    open.reserve(32);
+    
+    for (size_t i = 0; i < token_count_; i++) {
+        TokenType type = tokens_[i].type;
+        
+        if (type == TokenType::LEFT_BRACE || type == TokenType::LEFT_PAREN ||
+            type == TokenType::LEFT_BRACKET) {
+            // Selection sets never open inside '(' or a value, so a '{' there is an object value
+            bool value = type == TokenType::LEFT_BRACKET ||
+                         (type == TokenType::LEFT_BRACE && !open.empty() &&
+                          (open.back().value || tokens_[open.back().open].type == TokenType::LEFT_PAREN));
+            open.push_back(Group{i, value});
+            continue;
+        }
+        if (type == TokenType::RIGHT_BRACE || type == TokenType::RIGHT_PAREN ||
+            type == TokenType::RIGHT_BRACKET) {
+            if (!open.empty()) open.pop_back();
+            continue;
+        }
+        if (open.empty() || open.back().value || type == TokenType::COMMA) continue;
+        
+        TokenType prev = i > 0 ? tokens_[i - 1].type : TokenType::UNKNOWN;
+        bool starts_child;
+        if (type == TokenType::ELLIPSIS) {
+            starts_child = true;
+        } else if (type == TokenType::VARIABLE) {
+            starts_child = prev != TokenType::COLON;
+        } else if (type == TokenType::IDENTIFIER || (type <= TokenType::KEYWORD_ID && type != TokenType::KEYWORD_ON)) {
+            starts_child = prev != TokenType::COLON &&
+                           prev != TokenType::ELLIPSIS &&
+                           prev != TokenType::KEYWORD_ON &&
+                           prev != TokenType::SYMBOL;
+        } else {
+            starts_child = false;
+        }
+        if (starts_child) child_counts_[open.back().open]++;
+    }
+}
+
 std::string_view Parser::current_value() const {
     return current_token().value;
 }
@@ -105,6 +207,10 @@ bool Parser::is_name_token() const {
            type == TokenType::KEYWORD_EXTEND ||
            type == TokenType::KEYWORD_IMPLEMENTS ||
            type == TokenType::KEYWORD_SCHEMA ||
+           type == TokenType::KEYWORD_TYPENAME ||
+           type == TokenType::KEYWORD_QUERY ||
+           type == TokenType::KEYWORD_MUTATION ||
+           type == TokenType::KEYWORD_SUBSCRIPTION ||
            type == TokenType::KEYWORD_INT ||
            type == TokenType::KEYWORD_FLOAT ||
            type == TokenType::KEYWORD_STRING ||
@@ -115,7 +221,17 @@ bool Parser::is_name_token() const {
 // Main parsing
 arena_ptr<Document> Parser::parse_document() {
     try {
+        if (token_count_ > options_.max_tokens) {
+            limit_error(ParserLimit::TOKENS, "Maximum token count exceeded");
+        }
+        if (options_.exact_preallocation && !cursor_) {
+            take_census();
+        }
         return parse_document_impl();
+    } catch (const ParseLimitExceeded& e) {
+        limit_exceeded_ = e.limit();  // Also set for limits thrown by a listener
+        error(e.what());
+        return nullptr;
     } catch (const std::exception& e) {
         error(std::string("Exception during parsing: ") + e.what());
         return nullptr;
@@ -126,9 +242,16 @@ arena_ptr<Document> Parser::parse_document_impl() {
     auto* doc = arena_.create<Document>();
     
     while (!is_at_end()) {
+        size_t before = current_;
         try {
+            depth_ = 0;
             auto def = parse_definition();
             doc->definitions.push_back(std::move(def));
+            if (current_ == before) {
+                synchronize();  // Not a definition; skip to the next one
+            }
+        } catch (const ParseLimitExceeded&) {
+            throw;  // Limits abort the whole parse, no recovery
         } catch (...) {
             synchronize();
         }
@@ -164,7 +287,9 @@ arena_ptr<OperationDefinition> Parser::parse_operation_definition() {
     if (check(TokenType::LEFT_BRACE)) {
         op->operation_type = OperationType::QUERY;
         op->name = "";
+        if (options_.listener) options_.listener->begin_operation(*op);
         op->selection_set = parse_selection_set();
+        if (options_.listener) options_.listener->end_definition();
         return arena_ptr<OperationDefinition>(op);
     }
     
@@ -190,7 +315,9 @@ arena_ptr<OperationDefinition> Parser::parse_operation_definition() {
         error("Expected selection set");
         return arena_ptr<OperationDefinition>(op);
     }
+    if (options_.listener) options_.listener->begin_operation(*op);
     op->selection_set = parse_selection_set();
+    if (options_.listener) options_.listener->end_definition();
     
     return arena_ptr<OperationDefinition>(op);
 }
@@ -207,6 +334,7 @@ arena_ptr<FragmentDefinition> Parser::parse_fragment_definition() {
         return arena_ptr<FragmentDefinition>(frag);
     }
     frag->name = current_value();
+    frag->name_id = current_token().symbol;
     advance();
     
     // Type condition
@@ -217,13 +345,16 @@ arena_ptr<FragmentDefinition> Parser::parse_fragment_definition() {
         return arena_ptr<FragmentDefinition>(frag);
     }
     frag->type_condition = current_value();
+    frag->type_condition_id = current_token().symbol;
     advance();
     
     // Optional directives
     frag->directives = parse_directives();
     
     // Selection set
+    if (options_.listener) options_.listener->begin_fragment(*frag);
     frag->selection_set = parse_selection_set();
+    if (options_.listener) options_.listener->end_definition();
     
     return arena_ptr<FragmentDefinition>(frag);
 }
@@ -231,11 +362,14 @@ arena_ptr<FragmentDefinition> Parser::parse_fragment_definition() {
 arena_ptr<SelectionSet> Parser::parse_selection_set() {
     auto* sel_set = arena_.create<SelectionSet>();
     sel_set->position = current_token().position;
+    reserve_children(sel_set->selections, current_);
     
     expect(TokenType::LEFT_BRACE, "Expected '{'");
+    enter_nesting();
     
     while (!check(TokenType::RIGHT_BRACE) && !is_at_end()) {
         size_t before = current_;
+        check_ast_bytes();
         sel_set->selections.push_back(parse_selection());
         
         // Skip optional comma
@@ -249,6 +383,7 @@ arena_ptr<SelectionSet> Parser::parse_selection_set() {
     }
     
     expect(TokenType::RIGHT_BRACE, "Expected '}'");
+    leave_nesting();
     
     return arena_ptr<SelectionSet>(sel_set);
 }
@@ -258,8 +393,8 @@ Selection Parser::parse_selection() {
     if (check(TokenType::ELLIPSIS)) {
         advance();
         
-        // Inline fragment: ...on Type
-        if (check(TokenType::KEYWORD_ON)) {
+        // Inline fragment: ...on Type, or no type condition: ...@dir { } / ...{ }
+        if (check(TokenType::KEYWORD_ON) || check(TokenType::DIRECTIVE) || check(TokenType::LEFT_BRACE)) {
             return parse_inline_fragment();
         }
         
@@ -275,27 +410,34 @@ arena_ptr<Field> Parser::parse_field() {
     auto* field = arena_.create<Field>();
     field->position = current_token().position;
     
-    if (!check(TokenType::IDENTIFIER)) {
+    if (!is_name_token()) {
         error("Expected field name");
         return arena_ptr<Field>(field);
     }
     
     // Check for alias (fieldName: actualField)
     std::string_view first_name = current_value();
+    uint32_t first_id = current_token().symbol;
     advance();
     
     if (match(TokenType::COLON)) {
         // First name was alias
+        if (++alias_count_ > options_.max_aliases) {
+            limit_error(ParserLimit::ALIASES, "Maximum alias count exceeded");
+        }
         field->alias = first_name;
-        if (!check(TokenType::IDENTIFIER)) {
+        field->alias_id = first_id;
+        if (!is_name_token()) {
             error("Expected field name after ':'");
             return arena_ptr<Field>(field);
         }
         field->name = current_value();
+        field->name_id = current_token().symbol;
         advance();
     } else {
         // No alias
         field->name = first_name;
+        field->name_id = first_id;
     }
     
     // Optional arguments
@@ -307,9 +449,11 @@ arena_ptr<Field> Parser::parse_field() {
     field->directives = parse_directives();
     
     // Optional selection set
+    if (options_.listener) options_.listener->begin_field(*field);
     if (check(TokenType::LEFT_BRACE)) {
         field->selection_set = parse_selection_set();
     }
+    if (options_.listener) options_.listener->end_field(*field);
     
     return arena_ptr<Field>(field);
 }
@@ -324,9 +468,11 @@ arena_ptr<FragmentSpread> Parser::parse_fragment_spread() {
     }
     
     spread->name = current_value();
+    spread->name_id = current_token().symbol;
     advance();
     
     spread->directives = parse_directives();
+    if (options_.listener) options_.listener->fragment_spread(*spread);
     
     return arena_ptr<FragmentSpread>(spread);
 }
@@ -335,17 +481,17 @@ arena_ptr<InlineFragment> Parser::parse_inline_fragment() {
     auto* frag = arena_.create<InlineFragment>();
     frag->position = current_token().position;
     
-    // 'on' keyword already consumed
-    advance();
-    
     // Type condition
-    if (check(TokenType::IDENTIFIER)) {
+    if (match(TokenType::KEYWORD_ON) && check(TokenType::IDENTIFIER)) {
         frag->type_condition = current_value();
+        frag->type_condition_id = current_token().symbol;
         advance();
     }
     
     frag->directives = parse_directives();
+    if (options_.listener) options_.listener->begin_inline_fragment(*frag);
     frag->selection_set = parse_selection_set();
+    if (options_.listener) options_.listener->end_inline_fragment(*frag);
     
     return arena_ptr<InlineFragment>(frag);
 }
@@ -353,6 +499,7 @@ arena_ptr<InlineFragment> Parser::parse_inline_fragment() {
 // Arguments
 std::vector<arena_ptr<Argument>> Parser::parse_arguments() {
     std::vector<arena_ptr<Argument>> args;
+    reserve_children(args, current_);
     
     expect(TokenType::LEFT_PAREN, "Expected '('");
     
@@ -386,6 +533,7 @@ arena_ptr<Argument> Parser::parse_argument() {
     }
     
     arg->name = current_value();
+    arg->name_id = current_token().symbol;
     advance();
     
     expect(TokenType::COLON, "Expected ':' after argument name");
@@ -400,6 +548,9 @@ std::vector<arena_ptr<Directive>> Parser::parse_directives() {
     std::vector<arena_ptr<Directive>> directives;
     
     while (check(TokenType::DIRECTIVE)) {
+        if (directives.size() >= options_.max_directives_per_field) {
+            limit_error(ParserLimit::DIRECTIVES, "Maximum directive count exceeded");
+        }
         directives.push_back(parse_directive());
     }
     
@@ -417,6 +568,7 @@ arena_ptr<Directive> Parser::parse_directive() {
     } else {
         dir->name = full_value;
     }
+    dir->name_id = current_token().symbol;
     advance();
     
     // Optional arguments
@@ -430,6 +582,7 @@ arena_ptr<Directive> Parser::parse_directive() {
 // Variables
 std::vector<arena_ptr<VariableDefinition>> Parser::parse_variable_definitions() {
     std::vector<arena_ptr<VariableDefinition>> var_defs;
+    reserve_children(var_defs, current_);
     
     expect(TokenType::LEFT_PAREN, "Expected '('");
     
@@ -465,7 +618,7 @@ arena_ptr<VariableDefinition> Parser::parse_variable_definition() {
     var_def->type = parse_type();
     
     // Default value
-    if (match(TokenType::SYMBOL) && tokens_[current_ - 1].value == "=") {
+    if (match(TokenType::SYMBOL) && previous_token().value == "=") {
         auto* default_val = arena_.create<Value>(parse_value()); var_def->default_value = arena_ptr<Value>(default_val);
     }
     
@@ -491,6 +644,7 @@ arena_ptr<Variable> Parser::parse_variable() {
     } else {
         var->name = full_value;
     }
+    var->name_id = current_token().symbol;
     advance();
     
     return arena_ptr<Variable>(var);
@@ -526,6 +680,7 @@ arena_ptr<ASTNode> Parser::parse_named_type() {
         error("Expected type name");
     } else {
         nt.name = current_value();
+        nt.name_id = current_token().symbol;
         advance();
     }
     
@@ -538,7 +693,9 @@ arena_ptr<ASTNode> Parser::parse_list_type() {
     lt.position = current_token().position;
     
     expect(TokenType::LEFT_BRACKET, "Expected '['");
+    enter_nesting();
     lt.type = parse_type();
+    leave_nesting();
     expect(TokenType::RIGHT_BRACKET, "Expected ']'");
     
     auto* node = arena_.create<ASTNode>(std::move(lt));
@@ -547,6 +704,8 @@ arena_ptr<ASTNode> Parser::parse_list_type() {
 
 // Values
 Value Parser::parse_value() {
+    check_ast_bytes();
+    
     if (check(TokenType::VARIABLE)) {
         auto var = parse_variable();
         // Transfer ownership - var is already arena_ptr, just move it
@@ -640,15 +799,76 @@ Value Parser::parse_enum_value() {
     return ev;
 }
 
+ASTNodeType Parser::scalar_kind(const Token& token) {
+    switch (token.type) {
+        case TokenType::NUMBER:
+            return token.value.find_first_of(".eE") != std::string_view::npos
+                ? ASTNodeType::FLOAT_VALUE : ASTNodeType::INT_VALUE;
+        case TokenType::STRING:
+            return ASTNodeType::STRING_VALUE;
+        case TokenType::IDENTIFIER:
+            return ASTNodeType::ENUM_VALUE;
+        default:
+            return ASTNodeType::LIST_VALUE;  // Not a packable scalar
+    }
+}
+
 Value Parser::parse_list_value() {
     auto* lv = arena_.create<ListValue>();
     lv->position = current_token().position;
+    lv->source = current_value().data();
     
     expect(TokenType::LEFT_BRACKET, "Expected '['");
+    enter_nesting();
+    
+    // Fast path: optimistically pack items as 8-byte spans while they are all
+    // scalars of the same kind (ints, floats, strings or enums)
+    size_t packed_mark = packed_scratch_.size();
+    ASTNodeType kind = ASTNodeType::LIST_VALUE;
+    
+    while (!check(TokenType::RIGHT_BRACKET) && !is_at_end()) {
+        const Token& tok = current_token();
+        ASTNodeType item = scalar_kind(tok);
+        if (item == ASTNodeType::LIST_VALUE || (kind != ASTNodeType::LIST_VALUE && item != kind)) {
+            break;
+        }
+        kind = item;
+        check_list_size(packed_scratch_.size() - packed_mark + 1);
+        packed_scratch_.push_back(PackedScalar{static_cast<uint32_t>(tok.position - lv->position),
+                                               static_cast<uint32_t>(tok.value.size())});
+        advance();
+        match(TokenType::COMMA);
+    }
+    
+    if (kind != ASTNodeType::LIST_VALUE && (check(TokenType::RIGHT_BRACKET) || is_at_end())) {
+        expect(TokenType::RIGHT_BRACKET, "Expected ']'");
+        leave_nesting();
+        lv->packed = move_to_arena(packed_scratch_, packed_mark);
+        lv->packed_kind = kind;
+        return arena_ptr<ListValue>(lv);
+    }
+    
+    // Mixed list. Items collect on a scratch stack shared by all (nested)
+    // lists of this parse, then move into one exact-size arena array;
+    // anything packed so far is demoted to Values first.
+    size_t mark = value_scratch_.size();
+    for (size_t i = packed_mark; i < packed_scratch_.size(); i++) {
+        std::string_view text(lv->source + packed_scratch_[i].offset, packed_scratch_[i].length);
+        size_t pos = lv->position + packed_scratch_[i].offset;
+        switch (kind) {
+            case ASTNodeType::INT_VALUE:    value_scratch_.push_back(IntValue{text, pos}); break;
+            case ASTNodeType::FLOAT_VALUE:  value_scratch_.push_back(FloatValue{text, pos}); break;
+            case ASTNodeType::STRING_VALUE: value_scratch_.push_back(StringValue{text, pos}); break;
+            default:                        value_scratch_.push_back(EnumValue{text, pos}); break;
+        }
+    }
+    packed_scratch_.resize(packed_mark);
     
     while (!check(TokenType::RIGHT_BRACKET) && !is_at_end()) {
         size_t before = current_;
-        lv->values.push_back(parse_value());
+        check_list_size(value_scratch_.size() - mark + 1);
+        Value item = parse_value();
+        value_scratch_.push_back(std::move(item));
         
         // Skip optional comma
         match(TokenType::COMMA);
@@ -661,7 +881,9 @@ Value Parser::parse_list_value() {
     }
     
     expect(TokenType::RIGHT_BRACKET, "Expected ']'");
+    leave_nesting();
     
+    lv->values = move_to_arena(value_scratch_, mark);
     return arena_ptr<ListValue>(lv);
 }
 
@@ -670,9 +892,13 @@ Value Parser::parse_object_value() {
     ov->position = current_token().position;
     
     expect(TokenType::LEFT_BRACE, "Expected '{'");
+    enter_nesting();
+    
+    size_t mark = field_scratch_.size();
     
     while (!check(TokenType::RIGHT_BRACE) && !is_at_end()) {
         size_t before = current_;
+        check_list_size(field_scratch_.size() - mark + 1);
         ObjectField field;
         field.position = current_token().position;
         
@@ -684,13 +910,14 @@ Value Parser::parse_object_value() {
         }
         
         field.name = current_value();
+        field.name_id = current_token().symbol;
         advance();
         
         expect(TokenType::COLON, "Expected ':'");
         
         field.value = parse_value();
         
-        ov->fields.push_back(std::move(field));
+        field_scratch_.push_back(std::move(field));
         
         // Skip optional comma
         match(TokenType::COMMA);
@@ -703,7 +930,9 @@ Value Parser::parse_object_value() {
     }
     
     expect(TokenType::RIGHT_BRACE, "Expected '}'");
+    leave_nesting();
     
+    ov->fields = move_to_arena(field_scratch_, mark);
     return arena_ptr<ObjectValue>(ov);
 }
 
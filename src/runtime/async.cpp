@@ -0,0 +1,52 @@
+#include "runtime/async.h"
+#include <cstring>
+#include <exception>
+#include <string_view>
+
+// ResumeQueue
+
+void ResumeQueue::post(std::coroutine_handle<> handle) {
+    // Notified under the lock: once the executor sees the handle, the request may end and the queue go
+    std::lock_guard<std::mutex> lock(mutex_);
+    ready_.push_back(handle);
+    posted_.notify_one();
+}
+
+bool ResumeQueue::run_ready() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (ready_.empty()) return false;
+        std::swap(ready_, running_);
+    }
+    // Resumed coroutines may post again (e.g. a wakeup called inline); those wait for the next run
+    for (std::coroutine_handle<> handle : running_) handle.resume();
+    running_.clear();
+    return true;
+}
+
+void ResumeQueue::wait_and_run() {
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        posted_.wait(lock, [this] { return !ready_.empty(); });
+    }
+    run_ready();
+}
+
+void ResumeQueue::drain() {
+    while (outstanding_ > 0) wait_and_run();
+}
+
+// AsyncResolved
+
+void AsyncResolved::promise_type::unhandled_exception() {
+    std::string_view message = "Unknown error in async resolver";
+    try {
+        throw;
+    } catch (const std::exception& e) {
+        message = e.what();
+    } catch (...) {
+    }
+    char* text = arena_->allocate_array<char>(message.size() ? message.size() : 1);
+    if (!message.empty()) std::memcpy(text, message.data(), message.size());
+    finish(Resolved::error(std::string_view(text, message.size())));
+}
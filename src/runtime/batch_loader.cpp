@@ -0,0 +1,196 @@
+#include "runtime/batch_loader.h"
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <new>
+#include <string_view>
+
+namespace {
+
+constexpr uint32_t INITIAL_BUCKETS = 16;
+constexpr uint32_t INITIAL_QUEUE = 16;
+
+uint64_t mix(uint64_t hash, uint64_t value) {
+    hash ^= value + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+    return hash;
+}
+
+uint64_t hash_value(const ResponseValue& value) {
+    uint64_t hash = static_cast<uint64_t>(value.kind);
+    switch (value.kind) {
+        case ResponseKind::NULL_VALUE: return hash;
+        case ResponseKind::BOOLEAN: return mix(hash, value.boolean);
+        case ResponseKind::INT: return mix(hash, static_cast<uint64_t>(value.integer));
+        case ResponseKind::FLOAT: {
+            uint64_t bits;
+            std::memcpy(&bits, &value.number, sizeof(bits));
+            return mix(hash, bits);
+        }
+        case ResponseKind::STRING:
+        case ResponseKind::ENUM: {
+            // FNV-1a over the text
+            uint64_t text = 1469598103934665603ULL;
+            for (char c : value.text()) text = (text ^ static_cast<unsigned char>(c)) * 1099511628211ULL;
+            return mix(hash, text);
+        }
+        case ResponseKind::LIST:
+            for (uint32_t i = 0; i < value.size; i++) hash = mix(hash, hash_value(value.items[i]));
+            return hash;
+        case ResponseKind::OBJECT:
+            for (uint32_t i = 0; i < value.size; i++) {
+                hash = mix(hash, std::hash<std::string_view>()(value.fields[i].name));
+                hash = mix(hash, hash_value(value.fields[i].value));
+            }
+            return hash;
+    }
+    return hash;
+}
+
+bool same_value(const ResponseValue& a, const ResponseValue& b) {
+    if (a.kind != b.kind) return false;
+    switch (a.kind) {
+        case ResponseKind::NULL_VALUE: return true;
+        case ResponseKind::BOOLEAN: return a.boolean == b.boolean;
+        case ResponseKind::INT: return a.integer == b.integer;
+        case ResponseKind::FLOAT: return a.number == b.number;
+        case ResponseKind::STRING:
+        case ResponseKind::ENUM: return a.text() == b.text();
+        case ResponseKind::LIST:
+            if (a.size != b.size) return false;
+            for (uint32_t i = 0; i < a.size; i++) {
+                if (!same_value(a.items[i], b.items[i])) return false;
+            }
+            return true;
+        case ResponseKind::OBJECT:
+            if (a.size != b.size) return false;
+            for (uint32_t i = 0; i < a.size; i++) {
+                if (a.fields[i].name != b.fields[i].name || !same_value(a.fields[i].value, b.fields[i].value)) return false;
+            }
+            return true;
+    }
+    return false;
+}
+
+template <typename T>
+T* zeroed_array(ASTArena& arena, size_t count) {
+    T* items = arena.allocate_array<T>(count);
+    std::memset(static_cast<void*>(items), 0, sizeof(T) * count);
+    return items;
+}
+
+}  // namespace
+
+BatchLoads::BatchLoads(const ResolverRegistry& resolvers, ASTArena& arena, void* context)
+    : resolvers_(resolvers), arena_(arena), context_(context), queued_(0), batches_(0), keys_(0) {
+    size_t count = resolvers.loader_count();
+    loaders_ = zeroed_array<LoaderState>(arena, count ? count : 1);
+}
+
+LoadEntry* BatchLoads::load(uint32_t loader, const ResponseValue& key) {
+    LoaderState& state = loaders_[loader];
+    if (!state.buckets) {
+        state.buckets = zeroed_array<LoadEntry*>(arena_, INITIAL_BUCKETS);
+        state.bucket_count = INITIAL_BUCKETS;
+    }
+    uint64_t hash = hash_value(key);
+    for (LoadEntry* entry = state.buckets[hash & (state.bucket_count - 1)]; entry; entry = entry->next) {
+        if (entry->hash == hash && same_value(entry->key, key)) return entry;
+    }
+
+    // Keys usually point into the resolver's own data; copied so the cache doesn't depend on it
+    LoadEntry* entry = arena_.create<LoadEntry>();
+    entry->key = key;
+    if (key.kind == ResponseKind::STRING || key.kind == ResponseKind::ENUM) {
+        char* text = arena_.allocate_array<char>(key.size ? key.size : 1);
+        if (key.size) std::memcpy(text, key.string, key.size);
+        entry->key.string = text;
+    }
+    entry->hash = hash;
+    if (++state.size > state.bucket_count) grow(state);
+    LoadEntry*& bucket = state.buckets[hash & (state.bucket_count - 1)];
+    entry->next = bucket;
+    bucket = entry;
+    keys_++;
+
+    if (state.queued == state.queue_capacity) {
+        uint32_t capacity = state.queue_capacity ? state.queue_capacity * 2 : INITIAL_QUEUE;
+        LoadEntry** queue = arena_.allocate_array<LoadEntry*>(capacity);
+        if (state.queued) std::memcpy(queue, state.queue, state.queued * sizeof(LoadEntry*));
+        state.queue = queue;
+        state.queue_capacity = capacity;
+    }
+    state.queue[state.queued++] = entry;
+    queued_++;
+    return entry;
+}
+
+void BatchLoads::grow(LoaderState& state) {
+    // The old bucket array stays in the arena until the request ends
+    uint32_t count = state.bucket_count * 2;
+    LoadEntry** buckets = zeroed_array<LoadEntry*>(arena_, count);
+    for (uint32_t i = 0; i < state.bucket_count; i++) {
+        for (LoadEntry* entry = state.buckets[i]; entry;) {
+            LoadEntry* next = entry->next;
+            LoadEntry*& bucket = buckets[entry->hash & (count - 1)];
+            entry->next = bucket;
+            bucket = entry;
+            entry = next;
+        }
+    }
+    state.buckets = buckets;
+    state.bucket_count = count;
+}
+
+bool BatchLoads::dispatch() {
+    if (!queued_) return false;
+    for (uint32_t loader = 0; loader < resolvers_.loader_count(); loader++) {
+        LoaderState& state = loaders_[loader];
+        if (!state.queued) continue;
+        // Taken first: a batch function may itself load, queueing for the next dispatch
+        LoadEntry** queue = state.queue;
+        uint32_t queued = state.queued;
+        state.queue = nullptr;
+        state.queued = 0;
+        state.queue_capacity = 0;
+        queued_ -= queued;
+
+        uint32_t max_batch = resolvers_.max_batch(loader);
+        uint32_t step = max_batch ? max_batch : queued;
+        for (uint32_t first = 0; first < queued; first += step) {
+            call(loader, queue + first, queued - first < step ? queued - first : step);
+        }
+    }
+    return true;
+}
+
+void BatchLoads::call(uint32_t loader, LoadEntry* const* entries, uint32_t count) {
+    ResponseValue* keys = arena_.allocate_array<ResponseValue>(count);
+    Resolved* results = arena_.allocate_array<Resolved>(count);
+    for (uint32_t i = 0; i < count; i++) {
+        keys[i] = entries[i]->key;
+        new (results + i) Resolved();
+    }
+    batches_++;
+    try {
+        resolvers_.loader(loader)(BatchCall{keys, results, count, context_, &arena_});
+    } catch (const std::exception& e) {
+        // The whole batch fails; every field waiting on it reports the error
+        std::string_view message(e.what());
+        char* text = arena_.allocate_array<char>(message.size() ? message.size() : 1);
+        if (!message.empty()) std::memcpy(text, message.data(), message.size());
+        for (uint32_t i = 0; i < count; i++) results[i] = Resolved::error(std::string_view(text, message.size()));
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        // A deferred result would never complete
+        entries[i]->value = results[i].kind == Resolved::Kind::DEFERRED ? Resolved() : results[i];
+        entries[i]->done = true;
+    }
+}
+
+// FieldContext
+
+Resolved FieldContext::load(uint32_t loader, const ResponseValue& key) const {
+    if (!loads || loader >= loads->loader_count()) return Resolved::error("Unknown batch loader");
+    const LoadEntry* entry = loads->load(loader, key);
+    return entry->done ? entry->value : Resolved::deferred(entry);
+}
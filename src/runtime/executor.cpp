@@ -0,0 +1,933 @@
+#include "runtime/executor.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <new>
+#include "cache/query_cache.h"
+
+namespace {
+
+std::string quoted(std::string_view name) {
+    return "\"" + std::string(name) + "\"";
+}
+
+template <typename T>
+T* make_array(ASTArena& arena, size_t count) {
+    T* items = arena.allocate_array<T>(count ? count : 1);
+    for (size_t i = 0; i < count; i++) new (items + i) T();
+    return items;
+}
+
+std::string_view arena_copy(ASTArena& arena, std::string_view text) {
+    char* bytes = arena.allocate_array<char>(text.size() ? text.size() : 1);
+    if (!text.empty()) std::memcpy(bytes, text.data(), text.size());
+    return std::string_view(bytes, text.size());
+}
+
+}  // namespace
+
+Executor::Executor(const Schema& schema, const ResolverRegistry& resolvers)
+    : schema_(schema),
+      resolvers_(resolvers),
+      coercer_(schema),
+      schema_names_(static_cast<uint32_t>(schema.names().size())),
+      typename_id_(schema.name_id("__typename")),
+      skip_id_(schema.name_id("skip")),
+      include_id_(schema.name_id("include")),
+      arena_(nullptr),
+      request_(nullptr),
+      result_(nullptr),
+      plan_(nullptr),
+      parallel_(nullptr),
+      path_base_(0),
+      loads_(nullptr),
+      defer_pending_(false),
+      null_boundary_(nullptr) {}
+
+void Executor::error(size_t position, std::string message) {
+    result_->errors.push_back(ExecutionError{
+        std::move(message), position, std::vector<PathSegment>(path_.begin() + path_base_, path_.end())});
+}
+
+bool Executor::coerce_variables(const OperationDefinition& operation, const ExecutionRequest& request,
+                                ASTArena& arena) {
+    if (request.variables || request.variables_json.empty()) {
+        return coercer_.coerce_variables(operation, request.variables, arena, variables_, error_);
+    }
+    return coercer_.coerce_variables(operation, request.variables_json, arena, variables_, error_);
+}
+
+uint32_t Executor::schema_name(uint32_t symbol, std::string_view name) const {
+    if (symbol != NO_SYMBOL) return symbol < schema_names_ ? symbol : Schema::NONE;
+    return schema_.name_id(name);
+}
+
+const FragmentDefinition* Executor::fragment_named(std::string_view name) const {
+    auto it = fragments_.find(name);
+    return it != fragments_.end() ? it->second : nullptr;
+}
+
+ExecutionResult Executor::execute(const Document& document, ASTArena& arena, const ExecutionRequest& request) {
+    ExecutionResult result;
+    arena_ = &arena;
+    request_ = &request;
+    result_ = &result;
+    plan_ = nullptr;
+    parallel_ = nullptr;
+    path_base_ = 0;
+    loads_ = nullptr;
+    defer_pending_ = false;
+    fragments_.clear();
+    collected_.clear();
+    groups_.clear();
+    sets_.clear();
+    visited_.clear();
+    path_.clear();
+
+    const OperationDefinition* operation = nullptr;
+    size_t operations = 0;
+    for (const Definition& definition : document.definitions) {
+        if (auto* op = std::get_if<arena_ptr<OperationDefinition>>(&definition)) {
+            operations++;
+            if (request.operation_name.empty() ? !operation : (*op)->name == request.operation_name) {
+                operation = op->get();
+            }
+        } else {
+            const FragmentDefinition* fragment = std::get<arena_ptr<FragmentDefinition>>(definition).get();
+            fragments_.emplace(fragment->name, fragment);
+        }
+    }
+    if (request.operation_name.empty() && operations > 1) {
+        error(0, "Must provide operation name if query contains multiple operations.");
+        return result;
+    }
+    if (!operation) {
+        error(0, request.operation_name.empty() ? "Must provide an operation."
+                                                : "Unknown operation named " + quoted(request.operation_name) + ".");
+        return result;
+    }
+
+    uint32_t root = Schema::NONE;
+    switch (operation->operation_type) {
+        case OperationType::QUERY: root = schema_.query_type(); break;
+        case OperationType::MUTATION: root = schema_.mutation_type(); break;
+        case OperationType::SUBSCRIPTION: root = schema_.subscription_type(); break;
+    }
+    if (root == Schema::NONE || !operation->selection_set) {
+        error(operation->position, "Schema is not configured to execute this operation type.");
+        return result;
+    }
+
+    if (!coerce_variables(*operation, request, arena)) {
+        error(operation->position, error_);
+        return result;
+    }
+
+    result.has_data = true;
+    if (resolvers_.loader_count()) loads_ = arena.create<BatchLoads>(resolvers_, arena, request.context);
+    sets_.push_back(operation->selection_set.get());
+    execute_selection_sets(root, 0, request.root_value, result.data);
+    resume_.drain();  // Coroutines of fields abandoned by null propagation
+    return result;
+}
+
+// Field collection
+
+bool Executor::included(const std::vector<arena_ptr<Directive>>& directives) {
+    static const TypeRef BOOLEAN_NON_NULL{Schema::BUILTIN_BOOLEAN, 0, 1};
+    for (const auto& directive : directives) {
+        uint32_t name = schema_name(directive->name_id, directive->name);
+        if (name == Schema::NONE || (name != skip_id_ && name != include_id_)) continue;
+        for (const auto& argument : directive->arguments) {
+            if (argument->name != "if") continue;
+            ResponseValue value;
+            if (!coercer_.coerce_literal(argument->value, BOOLEAN_NON_NULL, variables_, *arena_, value, error_)) break;
+            if (value.boolean == (name == skip_id_)) return false;
+        }
+    }
+    return true;
+}
+
+bool Executor::type_applies(std::string_view condition, uint32_t condition_id, uint32_t object_type) const {
+    uint32_t type = schema_.type_index(schema_name(condition_id, condition));
+    if (type == Schema::NONE) return false;
+    return type == object_type || (schema_.type(type).is_abstract() && schema_.is_possible_type(type, object_type));
+}
+
+void Executor::collect_fields(uint32_t object_type, const SelectionSet& set, size_t group_begin,
+                              size_t visited_begin) {
+    for (const Selection& selection : set.selections) {
+        if (auto* field = std::get_if<arena_ptr<Field>>(&selection)) {
+            if (!included((*field)->directives)) continue;
+            std::string_view key = (*field)->alias.empty() ? (*field)->name : (*field)->alias;
+            size_t group = groups_.size();
+            for (size_t i = group_begin; i < groups_.size(); i++) {
+                if (groups_[i].key == key) {
+                    group = i;
+                    break;
+                }
+            }
+            if (group == groups_.size()) groups_.push_back(FieldGroup{key, field->get()});
+            collected_.push_back(CollectedField{field->get(), static_cast<uint32_t>(group)});
+        } else if (auto* inline_fragment = std::get_if<arena_ptr<InlineFragment>>(&selection)) {
+            const InlineFragment& fragment = **inline_fragment;
+            if (!included(fragment.directives)) continue;
+            if (!fragment.type_condition.empty() &&
+                !type_applies(fragment.type_condition, fragment.type_condition_id, object_type)) {
+                continue;
+            }
+            if (fragment.selection_set) collect_fields(object_type, *fragment.selection_set, group_begin, visited_begin);
+        } else {
+            const FragmentSpread& spread = *std::get<arena_ptr<FragmentSpread>>(selection);
+            if (!included(spread.directives)) continue;
+            const FragmentDefinition* fragment = fragment_named(spread.name);
+            if (!fragment) continue;
+            bool visited = false;
+            for (size_t i = visited_begin; i < visited_.size(); i++) visited = visited || visited_[i] == fragment;
+            if (visited) continue;
+            visited_.push_back(fragment);
+            if (!type_applies(fragment->type_condition, fragment->type_condition_id, object_type)) continue;
+            if (fragment->selection_set) collect_fields(object_type, *fragment->selection_set, group_begin, visited_begin);
+        }
+    }
+}
+
+// Execution
+
+bool Executor::execute_selection_sets(uint32_t object_type, size_t set_begin, const void* source,
+                                      ResponseValue& out) {
+    size_t group_begin = groups_.size();
+    size_t collected_begin = collected_.size();
+    size_t visited_begin = visited_.size();
+    size_t set_end = sets_.size();
+    // The merged selection sets of one response key share one collection
+    for (size_t i = set_begin; i < set_end; i++) collect_fields(object_type, *sets_[i], group_begin, visited_begin);
+    visited_.resize(visited_begin);
+
+    uint32_t count = static_cast<uint32_t>(groups_.size() - group_begin);
+    ResponseField* fields = make_array<ResponseField>(*arena_, count);
+    bool ok = true;
+    for (uint32_t i = 0; i < count && ok; i++) {
+        ok = execute_field(object_type, source, group_begin + i, collected_begin, fields[i]);
+    }
+
+    groups_.resize(group_begin);
+    collected_.resize(collected_begin);
+    sets_.resize(set_begin);
+    out = ok ? ResponseValue::of_object(fields, count) : ResponseValue::null();
+    return ok;
+}
+
+bool Executor::execute_field(uint32_t object_type, const void* source, size_t group_index, size_t collected_begin,
+                             ResponseField& out) {
+    const FieldGroup group = groups_[group_index];  // Copied: nested sets grow groups_
+    const Field& field = *group.first;
+    out.name = group.key;
+
+    uint32_t name = schema_name(field.name_id, field.name);
+    if ((name != Schema::NONE && name == typename_id_) || field.name == "__typename") {
+        out.value = ResponseValue::of_string(schema_.type_name(object_type));
+        return true;
+    }
+    const FieldDef* def = schema_.field(object_type, name);
+    if (!def) {
+        out.value = ResponseValue::null();  // Unknown field; validation rejects these
+        return true;
+    }
+
+    path_.push_back(PathSegment{group.key});
+    bool ok;
+    ResponseValue* arguments = make_array<ResponseValue>(*arena_, def->arg_count);
+    Completion completion{&field, object_type, group_index, collected_begin, nullptr};
+    if (!coercer_.coerce_arguments(field.arguments, schema_.arguments(*def), variables_, *arena_, arguments, error_)) {
+        ok = field_error(field, def->type, error_, out.value);
+    } else {
+        ok = resolve_field(*def, resolvers_.find(object_type, *def), arguments, source, completion, out.value);
+    }
+    path_.pop_back();
+    return ok;
+}
+
+bool Executor::resolve_field(const FieldDef& def, const Resolver* resolver, const ResponseValue* arguments,
+                             const void* source, const Completion& completion, ResponseValue& out) {
+    const Field& field = *completion.field;
+    if (!resolver) {
+        return field_error(field, def.type,
+                           "No resolver for field " + field_label(field, completion.parent_type) + ".", out);
+    }
+    FieldContext context{&schema_, source, completion.parent_type, &def, &field, arguments, request_->context, arena_,
+                         loads_, &resume_};
+    Resolved resolved;
+    try {
+        resolved = (*resolver)(context);
+    } catch (const std::exception& e) {
+        return field_error(field, def.type, e.what(), out);
+    }
+    return complete_value(def.type, resolved, completion, out);
+}
+
+bool Executor::complete_value(TypeRef type, const Resolved& resolved, const Completion& completion,
+                              ResponseValue& out) {
+    const Field& field = *completion.field;
+    uint32_t parent_type = completion.parent_type;
+    if (resolved.kind == Resolved::Kind::DEFERRED) {
+        const DeferredValue& value = *resolved.later;
+        if (!value.done && defer_pending_ && completion.plan_field) {
+            // Completed by complete_pending() once the batch has run or the coroutine finished
+            pending_.push_back(Pending{type, &value, completion, &out, null_boundary_, copy_path(),
+                                       static_cast<uint32_t>(path_.size() - path_base_)});
+            out = ResponseValue::null();
+            return true;
+        }
+        wait_for(value);
+        return complete_value(type, value.value, completion, out);
+    }
+    if (resolved.kind == Resolved::Kind::ERROR) {
+        return field_error(field, type, std::string(resolved.error_message()), out);
+    }
+    if ((resolved.kind == Resolved::Kind::LEAF && resolved.leaf.is_null()) ||
+        (resolved.kind == Resolved::Kind::OBJECT && !resolved.source)) {
+        if (type.is_non_null()) {
+            return field_error(field, type,
+                               "Cannot return null for non-nullable field " + field_label(field, parent_type) + ".", out);
+        }
+        out = ResponseValue::null();
+        return true;
+    }
+
+    if (type.is_list()) {
+        if (resolved.kind != Resolved::Kind::LIST) {
+            return field_error(field, type, "Expected a list for field " + field_label(field, parent_type) + ".", out);
+        }
+        if (parallel_ && completion.plan_field && completion.plan_field->expensive_children && resolved.size > 1) {
+            return complete_list_parallel(type, resolved, completion, out);
+        }
+        TypeRef item = type.item();
+        ResponseValue* items = make_array<ResponseValue>(*arena_, resolved.size);
+        ResponseValue* boundary = null_boundary_;
+        if (!type.is_non_null()) null_boundary_ = &out;
+        bool ok = true;
+        for (uint32_t i = 0; i < resolved.size && ok; i++) {
+            path_.push_back(PathSegment{{}, i});
+            ok = complete_value(item, resolved.items[i], completion, items[i]);
+            path_.pop_back();
+        }
+        null_boundary_ = boundary;
+        if (!ok) {
+            // A non-null item failed: the whole list is null
+            out = ResponseValue::null();
+            return !type.is_non_null();
+        }
+        out = ResponseValue::of_list(items, resolved.size);
+        return true;
+    }
+
+    const TypeDef& def = schema_.type(type.type);
+    if (def.is_leaf()) {
+        if (resolved.kind != Resolved::Kind::LEAF || !complete_leaf(type.type, resolved.leaf, out)) {
+            return field_error(field, type, "Expected a value of type " + quoted(schema_.type_name(type.type)) +
+                                                " for field " + field_label(field, parent_type) + ".", out);
+        }
+        return true;
+    }
+
+    if (resolved.kind != Resolved::Kind::OBJECT) {
+        return field_error(field, type, "Expected an object for field " + field_label(field, parent_type) + ".", out);
+    }
+    uint32_t object_type = type.type;
+    if (def.is_abstract()) {
+        object_type = resolved.type;
+        if (object_type == Schema::NONE) {
+            if (const TypeResolver* type_resolver = resolvers_.type_resolver(type.type)) {
+                object_type = (*type_resolver)(resolved.source, schema_);
+            }
+        }
+        if (object_type == Schema::NONE || schema_.type(object_type).kind != TypeKind::OBJECT ||
+            !schema_.is_possible_type(type.type, object_type)) {
+            return field_error(field, type, "Could not resolve the concrete type of field " +
+                                                field_label(field, parent_type) + ".", out);
+        }
+    }
+
+    bool ok;
+    ResponseValue* boundary = null_boundary_;
+    if (!type.is_non_null()) null_boundary_ = &out;
+    if (const PlanField* plan_field = completion.plan_field) {
+        uint32_t block = plan_field->child;
+        if (def.is_abstract()) {
+            const PlanDispatch* first = plan_->dispatch(plan_field->child);
+            const PlanDispatch* last = first + plan_field->dispatch_count;
+            block = std::lower_bound(first, last, object_type, [](const PlanDispatch& d, uint32_t t) {
+                        return d.type < t;
+                    })->block;
+        }
+        ok = execute_block(block, resolved.source, out);
+    } else {
+        // Sub-selections of every field with this response key, merged
+        size_t set_begin = sets_.size();
+        for (size_t i = completion.collected_begin; i < collected_.size(); i++) {
+            if (collected_[i].group == completion.group_index && collected_[i].field->selection_set) {
+                sets_.push_back(collected_[i].field->selection_set.get());
+            }
+        }
+        ok = execute_selection_sets(object_type, set_begin, resolved.source, out);
+    }
+    null_boundary_ = boundary;
+    if (!ok) {
+        out = ResponseValue::null();
+        return !type.is_non_null();
+    }
+    return true;
+}
+
+bool Executor::complete_leaf(uint32_t type, const ResponseValue& value, ResponseValue& out) {
+    switch (type) {
+        case Schema::BUILTIN_INT:
+            if (value.kind == ResponseKind::INT && value.integer >= INT32_MIN && value.integer <= INT32_MAX) {
+                out = value;
+                return true;
+            }
+            if (value.kind == ResponseKind::FLOAT && std::trunc(value.number) == value.number &&
+                value.number >= INT32_MIN && value.number <= INT32_MAX) {
+                out = ResponseValue::of_int(static_cast<int64_t>(value.number));
+                return true;
+            }
+            return false;
+        case Schema::BUILTIN_FLOAT:
+            if (value.kind == ResponseKind::INT) {
+                out = ResponseValue::of_float(static_cast<double>(value.integer));
+                return true;
+            }
+            out = value;
+            return value.kind == ResponseKind::FLOAT && std::isfinite(value.number);
+        case Schema::BUILTIN_STRING:
+            out = value;
+            return value.kind == ResponseKind::STRING;
+        case Schema::BUILTIN_BOOLEAN:
+            out = value;
+            return value.kind == ResponseKind::BOOLEAN;
+        case Schema::BUILTIN_ID:
+            if (value.kind == ResponseKind::INT) {
+                out = ResponseValue::of_string(arena_copy(*arena_, std::to_string(value.integer)));
+                return true;
+            }
+            out = value;
+            return value.kind == ResponseKind::STRING;
+        default:
+            break;
+    }
+    if (schema_.type(type).kind == TypeKind::ENUM) {
+        if ((value.kind != ResponseKind::STRING && value.kind != ResponseKind::ENUM) ||
+            !schema_.enum_value(type, schema_.name_id(value.text()))) {
+            return false;
+        }
+        out = ResponseValue::of_enum(value.text());
+        return true;
+    }
+    out = value;  // Custom scalars serialize as given
+    return true;
+}
+
+bool Executor::field_error(const Field& field, TypeRef type, std::string message, ResponseValue& out) {
+    error(field.position, std::move(message));
+    out = ResponseValue::null();
+    return !type.is_non_null();
+}
+
+std::string Executor::field_label(const Field& field, uint32_t parent_type) const {
+    return quoted(std::string(schema_.type_name(parent_type)) + "." + std::string(field.name));
+}
+
+// Plan execution
+
+const PlanOperation* Executor::begin_plan(const QueryPlan& plan, ASTArena& arena, const ExecutionRequest& request,
+                                          ExecutionResult& result) {
+    arena_ = &arena;
+    request_ = &request;
+    result_ = &result;
+    plan_ = &plan;
+    parallel_ = nullptr;
+    path_base_ = 0;
+    path_.clear();
+    loads_ = nullptr;
+    defer_pending_ = false;
+
+    const PlanOperation* operation = plan.operation(request.operation_name);
+    if (!operation) {
+        if (request.operation_name.empty() && plan.operation_count() > 1) {
+            error(0, "Must provide operation name if query contains multiple operations.");
+        } else {
+            error(0, request.operation_name.empty() ? "Must provide an operation."
+                                                    : "Unknown operation named " + quoted(request.operation_name) + ".");
+        }
+        return nullptr;
+    }
+    if (operation->block == Schema::NONE) {
+        error(operation->definition->position, "Schema is not configured to execute this operation type.");
+        return nullptr;
+    }
+    if (!coerce_variables(*operation->definition, request, arena)) {
+        error(operation->definition->position, error_);
+        return nullptr;
+    }
+    result.has_data = true;
+    if (resolvers_.loader_count()) loads_ = arena.create<BatchLoads>(resolvers_, arena, request.context);
+    return operation;
+}
+
+ExecutionResult Executor::execute(const QueryPlan& plan, ASTArena& arena, const ExecutionRequest& request) {
+    ExecutionResult result;
+    if (const PlanOperation* operation = begin_plan(plan, arena, request, result)) {
+        defer_pending_ = true;
+        null_boundary_ = &result.data;
+        execute_root(*operation, request.root_value, result.data);
+        complete_pending();
+        defer_pending_ = false;
+        resume_.drain();
+    }
+    plan_ = nullptr;
+    return result;
+}
+
+void Executor::complete_pending() {
+    // Each tick dispatches every loader once and resumes the coroutines
+    // woken so far, then completes the values that are done; those may load
+    // or suspend again, deferring to a later tick
+    while (!pending_.empty()) {
+        bool progress = loads_ && loads_->dispatch();
+        progress = resume_.run_ready() || progress;
+        if (!progress && std::none_of(pending_.begin(), pending_.end(), [](const Pending& p) { return p.value->done; })) {
+            resume_.wait_and_run();
+        }
+        std::swap(pending_, completing_);
+        for (const Pending& pending : completing_) {
+            if (!pending.value->done) {
+                pending_.push_back(pending);
+                continue;
+            }
+            path_.resize(path_base_);
+            path_.insert(path_.end(), pending.path, pending.path + pending.path_size);
+            null_boundary_ = pending.boundary;
+            if (!complete_value(pending.type, pending.value->value, pending.completion, *pending.out)) {
+                *pending.boundary = ResponseValue::null();
+            }
+        }
+        completing_.clear();
+    }
+    path_.resize(path_base_);
+}
+
+void Executor::wait_for(const DeferredValue& value) {
+    // Loader keys are done once dispatched; coroutines once they are woken and finish
+    while (!value.done) {
+        if (!(loads_ && loads_->dispatch())) resume_.wait_and_run();
+    }
+}
+
+void Executor::settle(const Resolved& resolved) {
+    if (resolved.kind == Resolved::Kind::DEFERRED) {
+        wait_for(*resolved.later);
+        settle(resolved.later->value);
+    } else if (resolved.kind == Resolved::Kind::LIST) {
+        for (uint32_t i = 0; i < resolved.size; i++) settle(resolved.items[i]);
+    }
+}
+
+ExecutionResult Executor::execute(const CacheEntry& entry, ASTArena& arena, const ExecutionRequest& request) {
+    std::shared_ptr<const QueryPlan> plan = std::atomic_load(&entry.plan);
+    if (!plan || plan->generation() != schema_.generation() || plan->resolver_version() != resolvers_.version()) {
+        // Racing compilers build equivalent plans; the last store wins
+        plan = QueryPlan::compile(resolvers_, coercer_, entry);
+        if (!plan) {
+            if (entry.ast) return execute(*entry.ast, arena, request);
+            ExecutionResult result;
+            result.errors.push_back(ExecutionError{"Could not compile the cached operation.", 0, {}});
+            return result;
+        }
+        std::atomic_store(&entry.plan, plan);
+    }
+    return execute(*plan, arena, request);
+}
+
+bool Executor::guards_hold(const PlanField& field) const {
+    // Any occurrence of the field whose conditions all hold includes it
+    for (uint32_t g = 0; g < field.guard_count; g++) {
+        const PlanGuard& guard = plan_->guard(field.first_guard + g);
+        bool holds = true;
+        for (uint32_t c = 0; c < guard.condition_count && holds; c++) {
+            const PlanCondition& condition = plan_->condition(guard.first_condition + c);
+            const ResponseValue* value = variables_.find(condition.variable);
+            holds = !value || value->is_null() || value->boolean == condition.expected;
+        }
+        if (holds) return true;
+    }
+    return false;
+}
+
+bool Executor::execute_block(uint32_t block, const void* source, ResponseValue& out) {
+    const PlanBlock& plan_block = plan_->block(block);
+    if (parallel_ && plan_block.expensive) return execute_block_parallel(plan_block, source, out);
+    ResponseField* fields = make_array<ResponseField>(*arena_, plan_block.field_count);
+    uint32_t count = 0;
+    bool ok = true;
+    for (uint32_t i = 0; i < plan_block.field_count && ok; i++) {
+        const PlanField& field = plan_->field(plan_block.first_field + i);
+        if (field.guard_count && !guards_hold(field)) continue;
+        ok = execute_plan_field(field, plan_block.type, source, fields[count++]);
+    }
+    out = ok ? ResponseValue::of_object(fields, count) : ResponseValue::null();
+    return ok;
+}
+
+bool Executor::execute_root(const PlanOperation& operation, const void* source, ResponseValue& out) {
+    if (operation.definition->operation_type != OperationType::MUTATION) {
+        return execute_block(operation.block, source, out);
+    }
+
+    // Mutation fields run one at a time in document order, each finished
+    // (its deferred values included) before the next starts; only their
+    // subtrees defer and run in parallel
+    const PlanBlock& plan_block = plan_->block(operation.block);
+    ResponseField* fields = make_array<ResponseField>(*arena_, plan_block.field_count);
+    ResponseValue* boundary = null_boundary_;
+    ResponseValue root = ResponseValue::of_bool(true);  // Nulled by a deferred failure past the field
+    uint32_t count = 0;
+    bool ok = true;
+    for (uint32_t i = 0; i < plan_block.field_count && ok; i++) {
+        const PlanField& field = plan_->field(plan_block.first_field + i);
+        if (field.guard_count && !guards_hold(field)) continue;
+        null_boundary_ = &root;
+        ok = execute_plan_field(field, plan_block.type, source, fields[count++]);
+        complete_pending();
+        ok = ok && !root.is_null();
+    }
+    null_boundary_ = boundary;
+    out = ok ? ResponseValue::of_object(fields, count) : ResponseValue::null();
+    return ok;
+}
+
+bool Executor::execute_plan_field(const PlanField& field, uint32_t object_type, const void* source,
+                                  ResponseField& out) {
+    out.name = field.key;
+    out.plan_field = &field;
+    if (!field.def) {
+        out.value = field.type.type == Schema::NONE ? ResponseValue::null()
+                                                    : ResponseValue::of_string(schema_.type_name(object_type));
+        return true;
+    }
+
+    path_.push_back(PathSegment{field.key});
+    bool ok = true;
+    const ResponseValue* arguments = field.arguments;
+    if (field.dynamic_count) {
+        // Constant slots are shared with the plan; only those referencing variables are coerced
+        ResponseValue* slots = make_array<ResponseValue>(*arena_, field.def->arg_count);
+        std::copy(field.arguments, field.arguments + field.def->arg_count, slots);
+        SchemaSpan<InputValueDef> defs = schema_.arguments(*field.def);
+        for (uint32_t i = 0; i < field.dynamic_count && ok; i++) {
+            const PlanArgument& argument = plan_->dynamic_argument(field.first_dynamic + i);
+            ok = coercer_.coerce_argument(argument.literal, defs[argument.slot], variables_, *arena_,
+                                          slots[argument.slot], error_);
+        }
+        arguments = slots;
+    }
+    Completion completion{field.field, object_type, 0, 0, &field};
+    if (!ok) {
+        ok = field_error(*field.field, field.def->type, error_, out.value);
+    } else {
+        ok = resolve_field(*field.def, resolvers_.at(field.resolver), arguments, source, completion, out.value);
+    }
+    path_.pop_back();
+    return ok;
+}
+
+// Parallel execution
+//
+// Tasks run on whichever worker picks them up, with that worker's Executor
+// and arena. A task carries its response path and output slot; the thread
+// that spawned it waits (helping with other tasks) and then checks ok.
+//
+// Within a task, loaded fields are deferred as in sequential plan runs and
+// completed in ticks when the task ends, on the worker's BatchLoads: keys
+// reached anywhere under one task share a loader call per level. A list's
+// items are split into one share per worker rather than one task each, so
+// a field loaded under every item costs at most a call per worker.
+
+struct Executor::ParallelRun {
+    Scheduler* scheduler;
+    WorkerArenas* arenas;
+    Executor* root;
+    const QueryPlan* plan;
+    const ExecutionRequest* request;
+    ResponseValue variables;
+    std::vector<ExecutionResult> errors;  // Per arena, merged at the end
+    std::vector<BatchLoads*> loads;       // Per arena, created by its first task
+};
+
+struct Executor::BlockTask {
+    Task task;
+    ParallelRun* run;
+    const PlanOperation* operation;
+    ResponseValue out;
+};
+
+struct Executor::FieldTask {
+    Task task;
+    ParallelRun* run;
+    const PlanField* field;
+    uint32_t object_type;
+    const void* source;
+    ResponseField* out;
+    const PathSegment* path;
+    uint32_t path_size;
+    bool ok;
+};
+
+// Completes items [first, end) of a list into the matching out slots
+struct Executor::ItemTask {
+    Task task;
+    ParallelRun* run;
+    TypeRef type;
+    const Resolved* items;
+    ResponseValue* out;
+    uint32_t first;
+    uint32_t end;
+    Completion completion;
+    const PathSegment* path;  // The list's
+    uint32_t path_size;
+    bool ok;
+};
+
+// Points the worker's Executor at the run for one task. Waiting inside a
+// task can run another task on the same thread, so state is restored
+// afterwards, the task's path is appended above whatever is there and its
+// deferred fields are kept apart from the interrupted task's.
+class Executor::TaskScope {
+public:
+    TaskScope(Executor& executor, ParallelRun& run, const PathSegment* path, uint32_t path_size)
+        : executor_(executor),
+          arena_(executor.arena_),
+          request_(executor.request_),
+          result_(executor.result_),
+          plan_(executor.plan_),
+          parallel_(executor.parallel_),
+          variables_(executor.variables_),
+          path_base_(executor.path_base_),
+          loads_(executor.loads_),
+          defer_pending_(executor.defer_pending_),
+          null_boundary_(executor.null_boundary_) {
+        size_t index = run.scheduler->worker_index();
+        executor.arena_ = &(*run.arenas)[index];
+        if (executor.resolvers_.loader_count() && !run.loads[index]) {
+            run.loads[index] = executor.arena_->create<BatchLoads>(executor.resolvers_, *executor.arena_,
+                                                                   run.request->context);
+        }
+        executor.loads_ = run.loads[index];
+        executor.defer_pending_ = true;
+        executor.null_boundary_ = &boundary_;
+        std::swap(executor.pending_, pending_);
+        std::swap(executor.completing_, completing_);
+        executor.request_ = run.request;
+        executor.result_ = &run.errors[index];
+        executor.plan_ = run.plan;
+        executor.parallel_ = &run;
+        executor.variables_ = run.variables;
+        executor.path_base_ = executor.path_.size();
+        executor.path_.insert(executor.path_.end(), path, path + path_size);
+    }
+
+    ~TaskScope() {
+        std::swap(executor_.pending_, pending_);
+        std::swap(executor_.completing_, completing_);
+        executor_.path_.resize(executor_.path_base_);
+        executor_.arena_ = arena_;
+        executor_.request_ = request_;
+        executor_.result_ = result_;
+        executor_.plan_ = plan_;
+        executor_.parallel_ = parallel_;
+        executor_.variables_ = variables_;
+        executor_.path_base_ = path_base_;
+        executor_.loads_ = loads_;
+        executor_.defer_pending_ = defer_pending_;
+        executor_.null_boundary_ = null_boundary_;
+    }
+
+    // Completes the task's deferred fields; false if a failed one nulls
+    // beyond the task's output, which the spawner then handles
+    bool finish() {
+        executor_.complete_pending();
+        return !boundary_.is_null();
+    }
+
+private:
+    Executor& executor_;
+    ASTArena* arena_;
+    const ExecutionRequest* request_;
+    ExecutionResult* result_;
+    const QueryPlan* plan_;
+    ParallelRun* parallel_;
+    ResponseValue variables_;
+    size_t path_base_;
+    BatchLoads* loads_;
+    bool defer_pending_;
+    ResponseValue* null_boundary_;
+    ResponseValue boundary_ = ResponseValue::of_bool(true);  // Nulled by a deferred failure past the task
+    std::vector<Pending> pending_;
+    std::vector<Pending> completing_;
+};
+
+ExecutionResult Executor::execute(const QueryPlan& plan, WorkerArenas& arenas, Scheduler& scheduler,
+                                  const ExecutionRequest& request) {
+    ExecutionResult result;
+    const PlanOperation* operation = begin_plan(plan, arenas.local(), request, result);
+    plan_ = nullptr;
+    if (!operation) return result;
+
+    // Created before any task runs, so workers never race to create them
+    while (workers_.size() < scheduler.worker_count()) {
+        workers_.push_back(std::make_unique<Executor>(schema_, resolvers_));
+    }
+
+    ParallelRun run{&scheduler, &arenas, this, &plan, &request, variables_, {}, {}};
+    run.errors.resize(arenas.size());
+    run.loads.resize(arenas.size(), nullptr);
+    BlockTask root{{&Executor::run_block_task, nullptr}, &run, operation, ResponseValue()};
+    TaskGroup group;
+    scheduler.spawn(group, &root.task);
+    scheduler.wait(group);
+    for (auto& worker : workers_) worker->resume_.drain();
+
+    result.data = root.out;
+    for (ExecutionResult& errors : run.errors) {
+        for (ExecutionError& error : errors.errors) result.errors.push_back(std::move(error));
+    }
+    return result;
+}
+
+Executor& Executor::worker_executor(size_t index) {
+    return index < workers_.size() ? *workers_[index] : *this;
+}
+
+const PathSegment* Executor::copy_path() {
+    size_t size = path_.size() - path_base_;
+    PathSegment* path = arena_->allocate_array<PathSegment>(size ? size : 1);
+    for (size_t i = 0; i < size; i++) new (path + i) PathSegment(path_[path_base_ + i]);
+    return path;
+}
+
+bool Executor::execute_block_parallel(const PlanBlock& block, const void* source, ResponseValue& out) {
+    ResponseField* fields = make_array<ResponseField>(*arena_, block.field_count);
+    FieldTask** tasks = arena_->allocate_array<FieldTask*>(block.field_count);
+    const PathSegment* path = copy_path();
+    uint32_t path_size = static_cast<uint32_t>(path_.size() - path_base_);
+    TaskGroup group;
+    uint32_t count = 0;
+    uint32_t spawned = 0;
+    bool ok = true;
+
+    // Each expensive field is deferred until the next one is found, then spawned;
+    // the last runs inline, so this thread stays busy instead of only waiting
+    const PlanField* deferred = nullptr;
+    uint32_t deferred_slot = 0;
+    for (uint32_t i = 0; i < block.field_count; i++) {
+        const PlanField& field = plan_->field(block.first_field + i);
+        if (field.guard_count && !guards_hold(field)) continue;
+        uint32_t slot = count++;
+        if (!field.expensive) {
+            ok = execute_plan_field(field, block.type, source, fields[slot]) && ok;
+            continue;
+        }
+        if (deferred) {
+            FieldTask* task = arena_->create<FieldTask>();
+            *task = FieldTask{{&Executor::run_field_task, nullptr}, parallel_, deferred, block.type, source,
+                              &fields[deferred_slot], path, path_size, true};
+            tasks[spawned++] = task;
+            parallel_->scheduler->spawn(group, &task->task);
+        }
+        deferred = &field;
+        deferred_slot = slot;
+    }
+    if (deferred) ok = execute_plan_field(*deferred, block.type, source, fields[deferred_slot]) && ok;
+    parallel_->scheduler->wait(group);
+    for (uint32_t i = 0; i < spawned; i++) ok = ok && tasks[i]->ok;
+
+    out = ok ? ResponseValue::of_object(fields, count) : ResponseValue::null();
+    return ok;
+}
+
+bool Executor::complete_list_parallel(TypeRef type, const Resolved& resolved, const Completion& completion,
+                                      ResponseValue& out) {
+    // Keys and coroutines belong to this thread's executor: items are waited
+    // for here, not on whichever worker completes them
+    settle(resolved);
+    TypeRef item = type.item();
+    ResponseValue* items = make_array<ResponseValue>(*arena_, resolved.size);
+    const PathSegment* path = copy_path();
+    uint32_t path_size = static_cast<uint32_t>(path_.size() - path_base_);
+
+    // One share per worker; the last runs inline
+    uint32_t workers = static_cast<uint32_t>(std::max<size_t>(parallel_->scheduler->worker_count(), 1));
+    uint32_t share = (resolved.size + workers - 1) / workers;
+    uint32_t spawned = (resolved.size - 1) / share;
+    ItemTask* tasks = arena_->allocate_array<ItemTask>(spawned ? spawned : 1);
+    TaskGroup group;
+    for (uint32_t i = 0; i < spawned; i++) {
+        new (tasks + i) ItemTask{{&Executor::run_item_task, nullptr}, parallel_, item, resolved.items, items,
+                                 i * share, (i + 1) * share, completion, path, path_size, true};
+        parallel_->scheduler->spawn(group, &tasks[i].task);
+    }
+    ResponseValue* boundary = null_boundary_;
+    if (!type.is_non_null()) null_boundary_ = &out;
+    bool ok = complete_items(item, resolved.items, completion, items, spawned * share, resolved.size);
+    null_boundary_ = boundary;
+    parallel_->scheduler->wait(group);
+    for (uint32_t i = 0; i < spawned; i++) ok = ok && tasks[i].ok;
+
+    if (!ok) {
+        // A non-null item failed: the whole list is null
+        out = ResponseValue::null();
+        return !type.is_non_null();
+    }
+    out = ResponseValue::of_list(items, resolved.size);
+    return true;
+}
+
+bool Executor::complete_items(TypeRef type, const Resolved* resolved, const Completion& completion,
+                              ResponseValue* out, uint32_t first, uint32_t end) {
+    bool ok = true;
+    for (uint32_t i = first; i < end && ok; i++) {
+        path_.push_back(PathSegment{{}, i});
+        ok = complete_value(type, resolved[i], completion, out[i]);
+        path_.pop_back();
+    }
+    return ok;
+}
+
+void Executor::run_block_task(Task* task) {
+    BlockTask& block = *reinterpret_cast<BlockTask*>(task);
+    ParallelRun& run = *block.run;
+    Executor& executor = run.root->worker_executor(run.scheduler->worker_index());
+    TaskScope scope(executor, run, nullptr, 0);
+    executor.execute_root(*block.operation, run.request->root_value, block.out);
+    if (!scope.finish()) block.out = ResponseValue::null();
+}
+
+void Executor::run_field_task(Task* task) {
+    FieldTask& field = *reinterpret_cast<FieldTask*>(task);
+    ParallelRun& run = *field.run;
+    Executor& executor = run.root->worker_executor(run.scheduler->worker_index());
+    TaskScope scope(executor, run, field.path, field.path_size);
+    field.ok = executor.execute_plan_field(*field.field, field.object_type, field.source, *field.out);
+    field.ok = scope.finish() && field.ok;
+}
+
+void Executor::run_item_task(Task* task) {
+    ItemTask& item = *reinterpret_cast<ItemTask*>(task);
+    ParallelRun& run = *item.run;
+    Executor& executor = run.root->worker_executor(run.scheduler->worker_index());
+    TaskScope scope(executor, run, item.path, item.path_size);
+    item.ok = executor.complete_items(item.type, item.items, item.completion, item.out, item.first, item.end);
+    item.ok = scope.finish() && item.ok;
+}
@@ -0,0 +1,944 @@
+#include "runtime/input_values.h"
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+
+namespace {
+
+std::string quoted(std::string_view name) {
+    return "\"" + std::string(name) + "\"";
+}
+
+template <typename T>
+T* make_array(ASTArena& arena, size_t count) {
+    T* items = arena.allocate_array<T>(count ? count : 1);
+    for (size_t i = 0; i < count; i++) new (items + i) T();
+    return items;
+}
+
+// Next slot of an arena array grown by doubling; outgrown arrays stay in the arena
+template <typename T>
+T& append(ASTArena& arena, T*& items, uint32_t& size, uint32_t& capacity) {
+    if (size == capacity) {
+        capacity = capacity ? capacity * 2 : 4;
+        T* grown = make_array<T>(arena, capacity);
+        if (size) std::memcpy(static_cast<void*>(grown), items, size * sizeof(T));
+        items = grown;
+    }
+    return items[size++];
+}
+
+std::string_view arena_copy(ASTArena& arena, std::string_view text) {
+    char* bytes = arena.allocate_array<char>(text.size() ? text.size() : 1);
+    if (!text.empty()) std::memcpy(bytes, text.data(), text.size());
+    return std::string_view(bytes, text.size());
+}
+
+bool parse_int(std::string_view text, int64_t& out) {
+    std::string digits(text);
+    char* end = nullptr;
+    errno = 0;
+    long long n = std::strtoll(digits.c_str(), &end, 10);
+    if (errno != 0 || digits.empty() || end != digits.c_str() + digits.size()) return false;
+    out = n;
+    return true;
+}
+
+bool parse_float(std::string_view text, double& out) {
+    std::string digits(text);
+    char* end = nullptr;
+    errno = 0;
+    double n = std::strtod(digits.c_str(), &end);
+    if (errno != 0 || digits.empty() || end != digits.c_str() + digits.size() || !std::isfinite(n)) return false;
+    out = n;
+    return true;
+}
+
+bool fits_int32(int64_t n) {
+    return n >= INT32_MIN && n <= INT32_MAX;
+}
+
+bool hex4(std::string_view text, size_t at, uint32_t& out) {
+    if (at + 4 > text.size()) return false;
+    out = 0;
+    for (size_t i = at; i < at + 4; i++) {
+        char c = text[i];
+        uint32_t digit;
+        if (c >= '0' && c <= '9') digit = c - '0';
+        else if (c >= 'a' && c <= 'f') digit = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') digit = c - 'A' + 10;
+        else return false;
+        out = out << 4 | digit;
+    }
+    return true;
+}
+
+void append_utf8(std::string& out, uint32_t cp) {
+    if (cp < 0x80) {
+        out += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        out += static_cast<char>(0xC0 | cp >> 6);
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += static_cast<char>(0xE0 | cp >> 12);
+        out += static_cast<char>(0x80 | (cp >> 6 & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | cp >> 18);
+        out += static_cast<char>(0x80 | (cp >> 12 & 0x3F));
+        out += static_cast<char>(0x80 | (cp >> 6 & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+bool is_blank(std::string_view line) {
+    return line.find_first_not_of(" \t") == std::string_view::npos;
+}
+
+// BlockStringValue() from the spec: common indentation and blank first/last lines removed
+std::string block_string_value(std::string_view raw) {
+    std::string text;
+    text.reserve(raw.size());
+    for (size_t i = 0; i < raw.size(); i++) {
+        if (raw.compare(i, 4, "\\\"\"\"") == 0) {
+            text += "\"\"\"";
+            i += 3;
+        } else if (raw[i] == '\r') {
+            text += '\n';
+            if (i + 1 < raw.size() && raw[i + 1] == '\n') i++;
+        } else {
+            text += raw[i];
+        }
+    }
+
+    std::vector<std::string_view> lines;
+    std::string_view rest(text);
+    while (true) {
+        size_t newline = rest.find('\n');
+        lines.push_back(rest.substr(0, newline));
+        if (newline == std::string_view::npos) break;
+        rest.remove_prefix(newline + 1);
+    }
+
+    size_t indent = std::string_view::npos;
+    for (size_t i = 1; i < lines.size(); i++) {
+        size_t leading = lines[i].find_first_not_of(" \t");
+        if (leading != std::string_view::npos && leading < indent) indent = leading;
+    }
+    if (indent != std::string_view::npos) {
+        for (size_t i = 1; i < lines.size(); i++) lines[i].remove_prefix(std::min(indent, lines[i].size()));
+    }
+
+    size_t first = 0, last = lines.size();
+    while (first < last && is_blank(lines[first])) first++;
+    while (last > first && is_blank(lines[last - 1])) last--;
+
+    std::string value;
+    for (size_t i = first; i < last; i++) {
+        if (i > first) value += '\n';
+        value += lines[i];
+    }
+    return value;
+}
+
+// Custom scalar input: JSON as it is, numbers as INT when integral and in range
+bool read_raw_json(JsonReader& reader, ASTArena& arena, ResponseValue& out) {
+    switch (reader.peek()) {
+        case JsonReader::Type::NULL_VALUE:
+            out = ResponseValue();
+            return reader.read_null();
+        case JsonReader::Type::BOOLEAN: {
+            bool value;
+            if (!reader.read_bool(value)) return false;
+            out = ResponseValue::of_bool(value);
+            return true;
+        }
+        case JsonReader::Type::NUMBER: {
+            std::string_view token;
+            bool integer;
+            if (!reader.read_number(token, integer)) return false;
+            int64_t n;
+            double number;
+            const char* end = token.data() + token.size();
+            if (integer && std::from_chars(token.data(), end, n).ec == std::errc()) {
+                out = ResponseValue::of_int(n);
+            } else if (std::from_chars(token.data(), end, number).ec == std::errc()) {
+                out = ResponseValue::of_float(number);
+            } else {
+                return false;
+            }
+            return true;
+        }
+        case JsonReader::Type::STRING: {
+            std::string_view text;
+            if (!reader.read_string(text, arena)) return false;
+            out = ResponseValue::of_string(text);
+            return true;
+        }
+        case JsonReader::Type::ARRAY: {
+            ResponseValue* items = nullptr;
+            uint32_t size = 0, capacity = 0;
+            reader.begin_array();
+            while (reader.next_element()) {
+                if (!read_raw_json(reader, arena, append(arena, items, size, capacity))) return false;
+            }
+            if (!reader.ok()) return false;
+            out = ResponseValue::of_list(items, size);
+            return true;
+        }
+        case JsonReader::Type::OBJECT: {
+            ResponseField* fields = nullptr;
+            uint32_t size = 0, capacity = 0;
+            std::string_view key;
+            reader.begin_object();
+            while (reader.next_key(key, arena)) {
+                ResponseField& field = append(arena, fields, size, capacity);
+                field.name = key;
+                if (!read_raw_json(reader, arena, field.value)) return false;
+            }
+            if (!reader.ok()) return false;
+            out = ResponseValue::of_object(fields, size);
+            return true;
+        }
+        default:
+            return reader.skip_value();  // Fails with the reader's message
+    }
+}
+
+bool is_absent_variable(const Value& value, const ResponseValue& variables) {
+    auto* variable = std::get_if<arena_ptr<Variable>>(&value);
+    return variable && !variables.find((*variable)->name);
+}
+
+}  // namespace
+
+std::string_view string_literal_value(std::string_view token, ASTArena& arena) {
+    if (token.size() >= 6 && token.compare(0, 3, "\"\"\"") == 0) {
+        return arena_copy(arena, block_string_value(token.substr(3, token.size() - 6)));
+    }
+    if (token.size() < 2) return {};
+    std::string_view body = token.substr(1, token.size() - 2);
+    if (body.find('\\') == std::string_view::npos) return body;
+
+    std::string out;
+    out.reserve(body.size());
+    for (size_t i = 0; i < body.size(); i++) {
+        char c = body[i];
+        if (c != '\\' || i + 1 == body.size()) {
+            out += c;
+            continue;
+        }
+        char escape = body[++i];
+        switch (escape) {
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'u': {
+                uint32_t cp, low;
+                if (!hex4(body, i + 1, cp)) {
+                    out += "\\u";  // Invalid; the lexer doesn't reject it either
+                    break;
+                }
+                i += 4;
+                // Surrogate pair
+                if (cp >= 0xD800 && cp < 0xDC00 && body.compare(i + 1, 2, "\\u") == 0 && hex4(body, i + 3, low) &&
+                    low >= 0xDC00 && low < 0xE000) {
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                    i += 6;
+                }
+                append_utf8(out, cp);
+                break;
+            }
+            default: out += escape; break;  // \" \\ \/
+        }
+    }
+    return arena_copy(arena, out);
+}
+
+InputCoercer::InputCoercer(const Schema& schema)
+    : schema_(schema),
+      schema_names_(static_cast<uint32_t>(schema.names().size())),
+      defaults_arena_(new ASTArena(16 * 1024)) {
+    // Input objects first, so argument defaults can use their field defaults
+    std::vector<bool> prepared(schema.type_count(), false);
+    for (uint32_t type = 0; type < schema.type_count(); type++) {
+        if (schema.type(type).kind == TypeKind::INPUT_OBJECT && !prepared[type]) {
+            prepared[type] = true;
+            coerce_defaults(schema.input_fields(type), prepared);
+        }
+    }
+    for (uint32_t type = 0; type < schema.type_count(); type++) {
+        for (const FieldDef& field : schema.fields(type)) coerce_defaults(schema.arguments(field), prepared);
+    }
+    for (uint32_t i = 0; i < schema.directive_count(); i++) {
+        coerce_defaults(schema.arguments(schema.directive(i)), prepared);
+    }
+}
+
+InputCoercer::~InputCoercer() = default;
+
+void InputCoercer::coerce_defaults(SchemaSpan<InputValueDef> defs, std::vector<bool>& prepared) {
+    for (const InputValueDef& def : defs) {
+        // Nested input objects first: their field defaults fill in this default's missing fields
+        uint32_t type = def.type.type;
+        if (schema_.type(type).kind == TypeKind::INPUT_OBJECT && !prepared[type]) {
+            prepared[type] = true;
+            coerce_defaults(schema_.input_fields(type), prepared);
+        }
+        if (!def.has_default() || defaults_.count(&def)) continue;
+
+        // Parsed as an argument of a throwaway field; the source stays alive for the AST's views
+        const std::string& source = default_sources_.emplace_back("{f(v:" + std::string(def.default_value) + ")}");
+        LexerCursor cursor(source.data(), source.size(), nullptr);
+        Parser parser(cursor, *defaults_arena_);
+        auto document = parser.parse_document();
+        if (parser.has_errors() || !document || document->definitions.empty()) continue;
+        auto* operation = std::get_if<arena_ptr<OperationDefinition>>(&document->definitions[0]);
+        if (!operation || !(*operation)->selection_set || (*operation)->selection_set->selections.empty()) continue;
+        const Field& field = *std::get<arena_ptr<Field>>((*operation)->selection_set->selections[0]);
+        if (field.arguments.empty()) continue;
+
+        ResponseValue value;
+        std::string error;
+        if (coerce_literal(field.arguments[0]->value, def.type, ResponseValue(), *defaults_arena_, value, error)) {
+            defaults_.emplace(&def, value);
+        }
+    }
+}
+
+uint32_t InputCoercer::schema_name(uint32_t symbol, std::string_view name) const {
+    if (symbol != NO_SYMBOL) return symbol < schema_names_ ? symbol : Schema::NONE;
+    return schema_.name_id(name);
+}
+
+bool InputCoercer::resolve_type(const ASTNode& node, TypeRef& out) const {
+    const ASTNode* current = &node;
+    unsigned level = 0;
+    while (true) {
+        if (current->type == ASTNodeType::NON_NULL_TYPE) {
+            out.non_null |= static_cast<uint16_t>(1u << level);
+            current = std::get<NonNullType>(current->data).type.get();
+        } else if (current->type == ASTNodeType::LIST_TYPE) {
+            if (++level > TypeRef::MAX_LIST_DEPTH) return false;
+            current = std::get<ListType>(current->data).type.get();
+        } else {
+            const NamedType& named = std::get<NamedType>(current->data);
+            out.type = schema_.type_index(schema_name(named.name_id, named.name));
+            out.list_depth = static_cast<uint8_t>(level);
+            return out.type != Schema::NONE && schema_.type(out.type).is_input();
+        }
+        if (!current) return false;
+    }
+}
+
+// Variables and arguments
+
+bool InputCoercer::coerce_variables(const OperationDefinition& operation, const ResponseValue* raw,
+                                    ASTArena& arena, ResponseValue& out, std::string& error) const {
+    const auto& definitions = operation.variable_definitions;
+    ResponseField* fields = make_array<ResponseField>(arena, definitions.size());
+    uint32_t count = 0;
+
+    for (const auto& definition : definitions) {
+        std::string_view name = definition->variable->name;
+        std::string label = "Variable \"$" + std::string(name) + "\"";
+        TypeRef type;
+        if (!definition->type || !resolve_type(*definition->type, type)) {
+            error = label + " has an unknown or non-input type.";
+            return false;
+        }
+
+        const ResponseValue* given = raw ? raw->find(name) : nullptr;
+        if (!given) {
+            if (!absent_variable(*definition, type, label, arena, fields, count, error)) return false;
+            continue;
+        }
+        if (given->is_null() && type.is_non_null()) {
+            error = label + " of non-null type " + quoted(schema_.type_string(type)) + " must not be null.";
+            return false;
+        }
+        if (!coerce_value(*given, type, arena, fields[count].value, error)) {
+            error = label + " got invalid value: " + error;
+            return false;
+        }
+        fields[count++].name = name;
+    }
+    out = ResponseValue::of_object(fields, count);
+    return true;
+}
+
+bool InputCoercer::coerce_variables(const OperationDefinition& operation, std::string_view json,
+                                    ASTArena& arena, ResponseValue& out, std::string& error) const {
+    const auto& definitions = operation.variable_definitions;
+    size_t size = definitions.size();
+    TypeRef* types = make_array<TypeRef>(arena, size);
+    ResponseValue* values = make_array<ResponseValue>(arena, size);
+    bool* given = make_array<bool>(arena, size);
+    for (size_t i = 0; i < size; i++) {
+        if (!definitions[i]->type || !resolve_type(*definitions[i]->type, types[i])) {
+            error = "Variable \"$" + std::string(definitions[i]->variable->name) + "\" has an unknown or non-input type.";
+            return false;
+        }
+    }
+
+    JsonReader reader(json);
+    if (reader.peek() == JsonReader::Type::NULL_VALUE) {
+        reader.read_null();
+    } else if (reader.peek() != JsonReader::Type::END && reader.begin_object()) {
+        std::string_view key;
+        while (reader.next_key(key, arena)) {
+            size_t i = 0;
+            while (i < size && definitions[i]->variable->name != key) i++;
+            if (i == size) {
+                reader.skip_value();  // Not a variable of this operation
+                continue;
+            }
+            if (reader.peek() == JsonReader::Type::NULL_VALUE && types[i].is_non_null()) {
+                error = "Variable \"$" + std::string(key) + "\" of non-null type " +
+                        quoted(schema_.type_string(types[i])) + " must not be null.";
+                return false;
+            }
+            if (!coerce_json(reader, types[i], arena, values[i], error)) {
+                if (!reader.ok()) break;
+                error = "Variable \"$" + std::string(key) + "\" got invalid value: " + error;
+                return false;
+            }
+            given[i] = true;
+        }
+    }
+    if (!reader.ok()) {
+        error = "Variables are not valid JSON: " + reader.error() + ".";
+        return false;
+    }
+    if (reader.peek() != JsonReader::Type::END) {
+        error = "Variables are not valid JSON: unexpected text at offset " + std::to_string(reader.position()) + ".";
+        return false;
+    }
+
+    ResponseField* fields = make_array<ResponseField>(arena, size);
+    uint32_t count = 0;
+    for (size_t i = 0; i < size; i++) {
+        if (!given[i]) {
+            std::string label = "Variable \"$" + std::string(definitions[i]->variable->name) + "\"";
+            if (!absent_variable(*definitions[i], types[i], label, arena, fields, count, error)) return false;
+            continue;
+        }
+        fields[count].name = definitions[i]->variable->name;
+        fields[count++].value = values[i];
+    }
+    out = ResponseValue::of_object(fields, count);
+    return true;
+}
+
+bool InputCoercer::absent_variable(const VariableDefinition& definition, TypeRef type, const std::string& label,
+                                   ASTArena& arena, ResponseField* fields, uint32_t& count,
+                                   std::string& error) const {
+    if (definition.default_value) {
+        if (!coerce_literal(*definition.default_value, type, ResponseValue(), arena, fields[count].value, error)) {
+            error = label + " has an invalid default value: " + error;
+            return false;
+        }
+        fields[count++].name = definition.variable->name;
+    } else if (type.is_non_null()) {
+        error = label + " of required type " + quoted(schema_.type_string(type)) + " was not provided.";
+        return false;
+    }
+    return true;
+}
+
+bool InputCoercer::coerce_arguments(const std::vector<arena_ptr<Argument>>& arguments,
+                                    SchemaSpan<InputValueDef> defs, const ResponseValue& variables,
+                                    ASTArena& arena, ResponseValue* slots, std::string& error) const {
+    for (size_t slot = 0; slot < defs.size(); slot++) {
+        const InputValueDef& def = defs[slot];
+        const Value* literal = nullptr;
+        for (const auto& argument : arguments) {
+            if (schema_name(argument->name_id, argument->name) == def.name) {
+                literal = &argument->value;
+                break;
+            }
+        }
+        if (!coerce_argument(literal, def, variables, arena, slots[slot], error)) return false;
+    }
+    return true;
+}
+
+bool InputCoercer::coerce_argument(const Value* literal, const InputValueDef& def, const ResponseValue& variables,
+                                   ASTArena& arena, ResponseValue& slot, std::string& error) const {
+    if (literal && !is_absent_variable(*literal, variables)) {
+        if (!coerce_literal(*literal, def.type, variables, arena, slot, error)) {
+            error = "Argument " + quoted(schema_.name(def.name)) + " has an invalid value: " + error;
+            return false;
+        }
+    } else if (const ResponseValue* value = default_value(def)) {
+        slot = *value;
+    } else if (def.type.is_non_null()) {
+        error = "Argument " + quoted(schema_.name(def.name)) + " of required type " +
+                quoted(schema_.type_string(def.type)) + " was not provided.";
+        return false;
+    } else {
+        slot = ResponseValue::null();
+    }
+    return true;
+}
+
+// Literals
+
+bool InputCoercer::coerce_literal(const Value& literal, TypeRef type, const ResponseValue& variables,
+                                  ASTArena& arena, ResponseValue& out, std::string& error) const {
+    if (auto* variable = std::get_if<arena_ptr<Variable>>(&literal)) {
+        // Already coerced to the variable's type, which validation matched to this position
+        const ResponseValue* value = variables.find((*variable)->name);
+        out = value ? *value : ResponseValue::null();
+        if (out.is_null() && type.is_non_null()) {
+            error = "Variable \"$" + std::string((*variable)->name) + "\" of required type " +
+                    quoted(schema_.type_string(type)) + " was not provided.";
+            return false;
+        }
+        return true;
+    }
+    if (std::holds_alternative<NullValue>(literal)) {
+        if (type.is_non_null()) {
+            error = "Expected value of non-null type " + quoted(schema_.type_string(type)) + ", found null.";
+            return false;
+        }
+        out = ResponseValue::null();
+        return true;
+    }
+
+    if (type.is_list()) {
+        TypeRef item = type.item();
+        auto* list = std::get_if<arena_ptr<ListValue>>(&literal);
+        if (!list) {
+            // A single value coerces to a one-item list
+            ResponseValue* items = make_array<ResponseValue>(arena, 1);
+            if (!coerce_literal(literal, item, variables, arena, items[0], error)) return false;
+            out = ResponseValue::of_list(items, 1);
+            return true;
+        }
+        ResponseValue* items = make_array<ResponseValue>(arena, (*list)->size());
+        uint32_t count = 0;
+        bool ok = true;
+        (*list)->for_each([&](const Value& value) {
+            ok = ok && coerce_literal(value, item, variables, arena, items[count++], error);
+        });
+        if (!ok) return false;
+        out = ResponseValue::of_list(items, count);
+        return true;
+    }
+
+    const TypeDef& def = schema_.type(type.type);
+    bool ok;
+    if (def.kind == TypeKind::INPUT_OBJECT) {
+        auto* object = std::get_if<arena_ptr<ObjectValue>>(&literal);
+        if (object) return coerce_input_object(**object, type.type, variables, arena, out, error);
+        ok = false;
+    } else if (def.kind == TypeKind::ENUM) {
+        auto* value = std::get_if<EnumValue>(&literal);
+        ok = value && schema_.enum_value(type.type, schema_.name_id(value->value));
+        if (ok) out = ResponseValue::of_enum(value->value);
+    } else {
+        ok = coerce_scalar_literal(literal, type.type, arena, out);
+    }
+    if (!ok) error = "Expected value of type " + quoted(schema_.type_string(type)) + ".";
+    return ok;
+}
+
+bool InputCoercer::coerce_scalar_literal(const Value& literal, uint32_t type, ASTArena& arena,
+                                         ResponseValue& out) const {
+    int64_t integer;
+    double number;
+    switch (type) {
+        case Schema::BUILTIN_INT: {
+            auto* value = std::get_if<IntValue>(&literal);
+            if (!value || !parse_int(value->value, integer) || !fits_int32(integer)) return false;
+            out = ResponseValue::of_int(integer);
+            return true;
+        }
+        case Schema::BUILTIN_FLOAT: {
+            std::string_view text;
+            if (auto* value = std::get_if<IntValue>(&literal)) text = value->value;
+            else if (auto* value = std::get_if<FloatValue>(&literal)) text = value->value;
+            else return false;
+            if (!parse_float(text, number)) return false;
+            out = ResponseValue::of_float(number);
+            return true;
+        }
+        case Schema::BUILTIN_STRING: {
+            auto* value = std::get_if<StringValue>(&literal);
+            if (!value) return false;
+            out = ResponseValue::of_string(string_literal_value(value->value, arena));
+            return true;
+        }
+        case Schema::BUILTIN_BOOLEAN: {
+            auto* value = std::get_if<BooleanValue>(&literal);
+            if (!value) return false;
+            out = ResponseValue::of_bool(value->value);
+            return true;
+        }
+        case Schema::BUILTIN_ID: {
+            if (auto* value = std::get_if<StringValue>(&literal)) {
+                out = ResponseValue::of_string(string_literal_value(value->value, arena));
+            } else if (auto* value = std::get_if<IntValue>(&literal)) {
+                out = ResponseValue::of_string(value->value);
+            } else {
+                return false;
+            }
+            return true;
+        }
+        default:
+            break;
+    }
+
+    // Custom scalars take any literal, converted structurally
+    return std::visit([&](const auto& value) -> bool {
+        using T = std::decay_t<decltype(value)>;
+        if constexpr (std::is_same_v<T, IntValue>) {
+            if (parse_int(value.value, integer)) out = ResponseValue::of_int(integer);
+            else if (parse_float(value.value, number)) out = ResponseValue::of_float(number);
+            else return false;
+        } else if constexpr (std::is_same_v<T, FloatValue>) {
+            if (!parse_float(value.value, number)) return false;
+            out = ResponseValue::of_float(number);
+        } else if constexpr (std::is_same_v<T, StringValue>) {
+            out = ResponseValue::of_string(string_literal_value(value.value, arena));
+        } else if constexpr (std::is_same_v<T, BooleanValue>) {
+            out = ResponseValue::of_bool(value.value);
+        } else if constexpr (std::is_same_v<T, EnumValue>) {
+            out = ResponseValue::of_enum(value.value);
+        } else if constexpr (std::is_same_v<T, arena_ptr<ListValue>>) {
+            ResponseValue* items = make_array<ResponseValue>(arena, value->size());
+            uint32_t count = 0;
+            bool ok = true;
+            value->for_each([&](const Value& item) {
+                if (std::holds_alternative<NullValue>(item)) count++;
+                else ok = ok && coerce_scalar_literal(item, type, arena, items[count++]);
+            });
+            if (!ok) return false;
+            out = ResponseValue::of_list(items, count);
+        } else if constexpr (std::is_same_v<T, arena_ptr<ObjectValue>>) {
+            ResponseField* fields = make_array<ResponseField>(arena, value->fields.size());
+            uint32_t count = 0;
+            for (const ObjectField& field : value->fields) {
+                fields[count].name = field.name;
+                if (!std::holds_alternative<NullValue>(field.value) &&
+                    !coerce_scalar_literal(field.value, type, arena, fields[count].value)) {
+                    return false;
+                }
+                count++;
+            }
+            out = ResponseValue::of_object(fields, count);
+        } else {
+            return false;  // Variables are handled by coerce_literal; NullValue never gets here
+        }
+        return true;
+    }, literal);
+}
+
+bool InputCoercer::coerce_input_object(const ObjectValue& object, uint32_t type, const ResponseValue& variables,
+                                       ASTArena& arena, ResponseValue& out, std::string& error) const {
+    for (const ObjectField& field : object.fields) {
+        if (!schema_.input_field(type, schema_name(field.name_id, field.name))) {
+            error = "Field " + quoted(field.name) + " is not defined by type " + quoted(schema_.type_name(type)) + ".";
+            return false;
+        }
+    }
+
+    SchemaSpan<InputValueDef> defs = schema_.input_fields(type);
+    ResponseField* fields = make_array<ResponseField>(arena, defs.size());
+    uint32_t count = 0;
+    for (const InputValueDef& def : defs) {
+        const ObjectField* given = nullptr;
+        for (const ObjectField& field : object.fields) {
+            if (schema_name(field.name_id, field.name) == def.name) {
+                given = &field;
+                break;
+            }
+        }
+
+        std::string_view name = schema_.name(def.name);
+        if (given && !is_absent_variable(given->value, variables)) {
+            if (!coerce_literal(given->value, def.type, variables, arena, fields[count].value, error)) return false;
+        } else if (const ResponseValue* value = default_value(def)) {
+            fields[count].value = *value;
+        } else if (def.type.is_non_null()) {
+            error = "Field " + quoted(std::string(schema_.type_name(type)) + "." + std::string(name)) +
+                    " of required type " + quoted(schema_.type_string(def.type)) + " was not provided.";
+            return false;
+        } else {
+            continue;  // Absent stays absent
+        }
+        fields[count++].name = name;
+    }
+    out = ResponseValue::of_object(fields, count);
+    return true;
+}
+
+// Raw values
+
+bool InputCoercer::coerce_value(const ResponseValue& raw, TypeRef type, ASTArena& arena, ResponseValue& out,
+                                std::string& error) const {
+    if (raw.is_null()) {
+        if (type.is_non_null()) {
+            error = "Expected value of non-null type " + quoted(schema_.type_string(type)) + ", found null.";
+            return false;
+        }
+        out = raw;
+        return true;
+    }
+
+    if (type.is_list()) {
+        TypeRef item = type.item();
+        if (raw.kind != ResponseKind::LIST) {
+            ResponseValue* items = make_array<ResponseValue>(arena, 1);
+            if (!coerce_value(raw, item, arena, items[0], error)) return false;
+            out = ResponseValue::of_list(items, 1);
+            return true;
+        }
+        ResponseValue* items = make_array<ResponseValue>(arena, raw.size);
+        for (uint32_t i = 0; i < raw.size; i++) {
+            if (!coerce_value(raw.items[i], item, arena, items[i], error)) return false;
+        }
+        out = ResponseValue::of_list(items, raw.size);
+        return true;
+    }
+
+    const TypeDef& def = schema_.type(type.type);
+    bool ok = false;
+    if (def.kind == TypeKind::INPUT_OBJECT) {
+        if (raw.kind == ResponseKind::OBJECT) {
+            for (uint32_t i = 0; i < raw.size; i++) {
+                if (!schema_.input_field(type.type, schema_.name_id(raw.fields[i].name))) {
+                    error = "Field " + quoted(raw.fields[i].name) + " is not defined by type " +
+                            quoted(schema_.type_name(type.type)) + ".";
+                    return false;
+                }
+            }
+            SchemaSpan<InputValueDef> defs = schema_.input_fields(type.type);
+            ResponseField* fields = make_array<ResponseField>(arena, defs.size());
+            uint32_t count = 0;
+            for (const InputValueDef& field : defs) {
+                std::string_view name = schema_.name(field.name);
+                if (const ResponseValue* given = raw.find(name)) {
+                    if (!coerce_value(*given, field.type, arena, fields[count].value, error)) return false;
+                } else if (const ResponseValue* value = default_value(field)) {
+                    fields[count].value = *value;
+                } else if (field.type.is_non_null()) {
+                    error = "Field " + quoted(std::string(schema_.type_name(type.type)) + "." + std::string(name)) +
+                            " of required type " + quoted(schema_.type_string(field.type)) + " was not provided.";
+                    return false;
+                } else {
+                    continue;
+                }
+                fields[count++].name = name;
+            }
+            out = ResponseValue::of_object(fields, count);
+            return true;
+        }
+    } else if (def.kind == TypeKind::ENUM) {
+        ok = (raw.kind == ResponseKind::STRING || raw.kind == ResponseKind::ENUM) &&
+             schema_.enum_value(type.type, schema_.name_id(raw.text()));
+        if (ok) out = ResponseValue::of_enum(raw.text());
+    } else {
+        switch (type.type) {
+            case Schema::BUILTIN_INT:
+                if (raw.kind == ResponseKind::INT) {
+                    ok = fits_int32(raw.integer);
+                    out = raw;
+                } else if (raw.kind == ResponseKind::FLOAT) {
+                    ok = std::trunc(raw.number) == raw.number && raw.number >= INT32_MIN && raw.number <= INT32_MAX;
+                    if (ok) out = ResponseValue::of_int(static_cast<int64_t>(raw.number));
+                }
+                break;
+            case Schema::BUILTIN_FLOAT:
+                ok = raw.kind == ResponseKind::INT || raw.kind == ResponseKind::FLOAT;
+                if (ok) out = ResponseValue::of_float(raw.kind == ResponseKind::INT ? raw.integer : raw.number);
+                break;
+            case Schema::BUILTIN_STRING:
+                ok = raw.kind == ResponseKind::STRING;
+                out = raw;
+                break;
+            case Schema::BUILTIN_BOOLEAN:
+                ok = raw.kind == ResponseKind::BOOLEAN;
+                out = raw;
+                break;
+            case Schema::BUILTIN_ID:
+                if (raw.kind == ResponseKind::STRING) {
+                    ok = true;
+                    out = raw;
+                } else if (raw.kind == ResponseKind::INT) {
+                    ok = true;
+                    out = ResponseValue::of_string(arena_copy(arena, std::to_string(raw.integer)));
+                }
+                break;
+            default:
+                ok = true;  // Custom scalars pass through
+                out = raw;
+                break;
+        }
+    }
+    if (!ok) error = "Expected value of type " + quoted(schema_.type_string(type)) + ".";
+    return ok;
+}
+
+// JSON values
+
+bool InputCoercer::coerce_json(JsonReader& reader, TypeRef type, ASTArena& arena, ResponseValue& out,
+                               std::string& error) const {
+    JsonReader::Type next = reader.peek();
+    if (next == JsonReader::Type::NULL_VALUE) {
+        if (type.is_non_null()) {
+            error = "Expected value of non-null type " + quoted(schema_.type_string(type)) + ", found null.";
+            return false;
+        }
+        out = ResponseValue();
+        return reader.read_null();
+    }
+
+    if (type.is_list()) {
+        TypeRef item = type.item();
+        if (next != JsonReader::Type::ARRAY) {
+            ResponseValue* items = make_array<ResponseValue>(arena, 1);
+            if (!coerce_json(reader, item, arena, items[0], error)) return false;
+            out = ResponseValue::of_list(items, 1);
+            return true;
+        }
+        ResponseValue* items = nullptr;
+        uint32_t size = 0, capacity = 0;
+        reader.begin_array();
+        while (reader.next_element()) {
+            if (!coerce_json(reader, item, arena, append(arena, items, size, capacity), error)) return false;
+        }
+        if (!reader.ok()) return false;
+        out = ResponseValue::of_list(items, size);
+        return true;
+    }
+
+    const TypeDef& def = schema_.type(type.type);
+    bool ok = false;
+    if (def.kind == TypeKind::INPUT_OBJECT) {
+        if (next == JsonReader::Type::OBJECT) return coerce_json_object(reader, type.type, arena, out, error);
+    } else if (def.kind == TypeKind::ENUM) {
+        std::string_view name;
+        ok = next == JsonReader::Type::STRING && reader.read_string(name, arena) &&
+             schema_.enum_value(type.type, schema_.name_id(name));
+        if (ok) out = ResponseValue::of_enum(name);
+    } else {
+        ok = coerce_json_scalar(reader, type.type, arena, out);
+    }
+    if (!ok && reader.ok()) error = "Expected value of type " + quoted(schema_.type_string(type)) + ".";
+    return ok;
+}
+
+bool InputCoercer::coerce_json_object(JsonReader& reader, uint32_t type, ASTArena& arena, ResponseValue& out,
+                                      std::string& error) const {
+    SchemaSpan<InputValueDef> defs = schema_.input_fields(type);
+    ResponseValue* values = make_array<ResponseValue>(arena, defs.size());
+    bool* given = make_array<bool>(arena, defs.size());
+    std::string_view key;
+    reader.begin_object();
+    while (reader.next_key(key, arena)) {
+        const InputValueDef* field = schema_.input_field(type, schema_.name_id(key));
+        if (!field) {
+            error = "Field " + quoted(key) + " is not defined by type " + quoted(schema_.type_name(type)) + ".";
+            return false;
+        }
+        size_t slot = field - defs.begin();
+        if (!coerce_json(reader, field->type, arena, values[slot], error)) return false;
+        given[slot] = true;
+    }
+    if (!reader.ok()) return false;
+
+    // Schema order, with defaults and required fields as for raw values
+    ResponseField* fields = make_array<ResponseField>(arena, defs.size());
+    uint32_t count = 0;
+    for (size_t i = 0; i < defs.size(); i++) {
+        const InputValueDef& field = defs[i];
+        std::string_view name = schema_.name(field.name);
+        if (given[i]) {
+            fields[count].value = values[i];
+        } else if (const ResponseValue* value = default_value(field)) {
+            fields[count].value = *value;
+        } else if (field.type.is_non_null()) {
+            error = "Field " + quoted(std::string(schema_.type_name(type)) + "." + std::string(name)) +
+                    " of required type " + quoted(schema_.type_string(field.type)) + " was not provided.";
+            return false;
+        } else {
+            continue;
+        }
+        fields[count++].name = name;
+    }
+    out = ResponseValue::of_object(fields, count);
+    return true;
+}
+
+bool InputCoercer::coerce_json_scalar(JsonReader& reader, uint32_t type, ASTArena& arena, ResponseValue& out) const {
+    JsonReader::Type next = reader.peek();
+    std::string_view token;
+    bool integer = false;
+    switch (type) {
+        case Schema::BUILTIN_INT: {
+            if (next != JsonReader::Type::NUMBER || !reader.read_number(token, integer)) return false;
+            const char* end = token.data() + token.size();
+            if (integer) {
+                int64_t n;
+                if (std::from_chars(token.data(), end, n).ec != std::errc() || !fits_int32(n)) return false;
+                out = ResponseValue::of_int(n);
+                return true;
+            }
+            // 1.0 and 1e3 are Ints too
+            double n;
+            if (std::from_chars(token.data(), end, n).ec != std::errc() || std::trunc(n) != n || n < INT32_MIN ||
+                n > INT32_MAX) {
+                return false;
+            }
+            out = ResponseValue::of_int(static_cast<int64_t>(n));
+            return true;
+        }
+        case Schema::BUILTIN_FLOAT: {
+            double n;
+            if (next != JsonReader::Type::NUMBER || !reader.read_number(token, integer) ||
+                std::from_chars(token.data(), token.data() + token.size(), n).ec != std::errc()) {
+                return false;
+            }
+            out = ResponseValue::of_float(n);
+            return true;
+        }
+        case Schema::BUILTIN_STRING:
+            if (next != JsonReader::Type::STRING || !reader.read_string(token, arena)) return false;
+            out = ResponseValue::of_string(token);
+            return true;
+        case Schema::BUILTIN_BOOLEAN: {
+            bool value;
+            if (next != JsonReader::Type::BOOLEAN || !reader.read_bool(value)) return false;
+            out = ResponseValue::of_bool(value);
+            return true;
+        }
+        case Schema::BUILTIN_ID:
+            if (next == JsonReader::Type::STRING) {
+                if (!reader.read_string(token, arena)) return false;
+                out = ResponseValue::of_string(token);
+                return true;
+            }
+            if (next == JsonReader::Type::NUMBER) {
+                int64_t n;
+                if (!reader.read_number(token, integer) || !integer ||
+                    std::from_chars(token.data(), token.data() + token.size(), n).ec != std::errc()) {
+                    return false;
+                }
+                out = ResponseValue::of_string(arena_copy(arena, std::to_string(n)));
+                return true;
+            }
+            return false;
+        default:
+            // Custom scalars pass through as raw values
+            return read_raw_json(reader, arena, out);
+    }
+}
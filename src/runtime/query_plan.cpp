@@ -0,0 +1,390 @@
+#include "runtime/query_plan.h"
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <unordered_map>
+#include "cache/query_cache.h"
+#include "lexer/interner.h"
+#include "parser/flat_parser.h"
+
+namespace {
+
+template <typename T>
+T* make_array(ASTArena& arena, size_t count) {
+    T* items = arena.allocate_array<T>(count ? count : 1);
+    for (size_t i = 0; i < count; i++) new (items + i) T();
+    return items;
+}
+
+bool has_variables(const Value& value) {
+    if (std::holds_alternative<arena_ptr<Variable>>(value)) return true;
+    if (auto* list = std::get_if<arena_ptr<ListValue>>(&value)) {
+        if ((*list)->is_packed()) return false;
+        for (const Value& item : (*list)->values) {
+            if (has_variables(item)) return true;
+        }
+    } else if (auto* object = std::get_if<arena_ptr<ObjectValue>>(&value)) {
+        for (const ObjectField& field : (*object)->fields) {
+            if (has_variables(field.value)) return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace
+
+class PlanCompiler {
+public:
+    PlanCompiler(const ResolverRegistry& resolvers, const InputCoercer& coercer, QueryPlan& plan, size_t max_fields)
+        : resolvers_(resolvers),
+          coercer_(coercer),
+          schema_(resolvers.schema()),
+          plan_(plan),
+          max_fields_(max_fields),
+          schema_names_(static_cast<uint32_t>(schema_.names().size())),
+          typename_id_(schema_.name_id("__typename")),
+          skip_id_(schema_.name_id("skip")),
+          include_id_(schema_.name_id("include")),
+          overflow_(false) {}
+
+    bool compile(const Document& document, std::string& error);
+
+private:
+    // A selection set to merge, with the conditions on the path to it
+    struct Occurrence {
+        const SelectionSet* set;
+        PlanGuard conditions;
+    };
+
+    struct Collected {
+        const Field* field;
+        PlanGuard conditions;
+    };
+
+    const ResolverRegistry& resolvers_;
+    const InputCoercer& coercer_;
+    const Schema& schema_;
+    QueryPlan& plan_;
+    size_t max_fields_;
+    uint32_t schema_names_;
+    uint32_t typename_id_;
+    uint32_t skip_id_;
+    uint32_t include_id_;
+    bool overflow_;
+    std::unordered_map<std::string_view, const FragmentDefinition*> fragments_;
+
+    uint32_t schema_name(uint32_t symbol, std::string_view name) const {
+        if (symbol != NO_SYMBOL) return symbol < schema_names_ ? symbol : Schema::NONE;
+        return schema_.name_id(name);
+    }
+    bool type_applies(std::string_view condition, uint32_t condition_id, uint32_t object_type) const;
+    bool apply_directives(const std::vector<arena_ptr<Directive>>& directives, PlanGuard& conditions);
+    void collect(uint32_t object_type, const SelectionSet& set, PlanGuard conditions, std::vector<Collected>& out,
+                 std::vector<std::pair<const FragmentDefinition*, PlanGuard>>& visited);
+    uint32_t compile_block(uint32_t object_type, const std::vector<Occurrence>& sets);
+    void compile_arguments(const Field& field, const FieldDef& def, PlanField& out);
+};
+
+bool PlanCompiler::compile(const Document& document, std::string& error) {
+    for (const Definition& definition : document.definitions) {
+        if (auto* fragment = std::get_if<arena_ptr<FragmentDefinition>>(&definition)) {
+            fragments_.emplace((*fragment)->name, fragment->get());
+        }
+    }
+
+    for (const Definition& definition : document.definitions) {
+        auto* operation = std::get_if<arena_ptr<OperationDefinition>>(&definition);
+        if (!operation) continue;
+        PlanOperation compiled{(*operation)->name, operation->get(), Schema::NONE, Schema::NONE};
+        switch ((*operation)->operation_type) {
+            case OperationType::QUERY: compiled.root_type = schema_.query_type(); break;
+            case OperationType::MUTATION: compiled.root_type = schema_.mutation_type(); break;
+            case OperationType::SUBSCRIPTION: compiled.root_type = schema_.subscription_type(); break;
+        }
+        if (compiled.root_type != Schema::NONE && (*operation)->selection_set) {
+            compiled.block = compile_block(compiled.root_type, {Occurrence{(*operation)->selection_set.get(), {0, 0}}});
+        }
+        plan_.operations_.push_back(compiled);
+    }
+
+    if (overflow_) {
+        error = "Query plan exceeds " + std::to_string(max_fields_) + " fields.";
+        return false;
+    }
+    return true;
+}
+
+bool PlanCompiler::type_applies(std::string_view condition, uint32_t condition_id, uint32_t object_type) const {
+    uint32_t type = schema_.type_index(schema_name(condition_id, condition));
+    if (type == Schema::NONE) return false;
+    return type == object_type || (schema_.type(type).is_abstract() && schema_.is_possible_type(type, object_type));
+}
+
+bool PlanCompiler::apply_directives(const std::vector<arena_ptr<Directive>>& directives, PlanGuard& conditions) {
+    std::vector<PlanCondition>& all = plan_.conditions_;
+    bool extended = false;
+    for (const auto& directive : directives) {
+        uint32_t name = schema_name(directive->name_id, directive->name);
+        if (name == Schema::NONE || (name != skip_id_ && name != include_id_)) continue;
+        bool include = name == include_id_;
+        for (const auto& argument : directive->arguments) {
+            if (argument->name != "if") continue;
+            if (auto* literal = std::get_if<BooleanValue>(&argument->value)) {
+                if (literal->value != include) return false;  // Excluded for every request
+            } else if (auto* variable = std::get_if<arena_ptr<Variable>>(&argument->value)) {
+                // Conditions are extended by copying the inherited conjunction to the end
+                if (!extended) {
+                    uint32_t first = static_cast<uint32_t>(all.size());
+                    for (uint32_t i = 0; i < conditions.condition_count; i++) {
+                        PlanCondition inherited = all[conditions.first_condition + i];
+                        all.push_back(inherited);
+                    }
+                    conditions.first_condition = first;
+                    extended = true;
+                }
+                all.push_back(PlanCondition{(*variable)->name, include});
+                conditions.condition_count++;
+            }
+        }
+    }
+    return true;
+}
+
+void PlanCompiler::collect(uint32_t object_type, const SelectionSet& set, PlanGuard conditions,
+                           std::vector<Collected>& out,
+                           std::vector<std::pair<const FragmentDefinition*, PlanGuard>>& visited) {
+    for (const Selection& selection : set.selections) {
+        PlanGuard guard = conditions;
+        if (auto* field = std::get_if<arena_ptr<Field>>(&selection)) {
+            if (apply_directives((*field)->directives, guard)) out.push_back(Collected{field->get(), guard});
+        } else if (auto* inline_fragment = std::get_if<arena_ptr<InlineFragment>>(&selection)) {
+            const InlineFragment& fragment = **inline_fragment;
+            if (!apply_directives(fragment.directives, guard) || !fragment.selection_set) continue;
+            if (!fragment.type_condition.empty() &&
+                !type_applies(fragment.type_condition, fragment.type_condition_id, object_type)) {
+                continue;
+            }
+            collect(object_type, *fragment.selection_set, guard, out, visited);
+        } else {
+            const FragmentSpread& spread = *std::get<arena_ptr<FragmentSpread>>(selection);
+            if (!apply_directives(spread.directives, guard)) continue;
+            auto it = fragments_.find(spread.name);
+            if (it == fragments_.end() || !it->second->selection_set) continue;
+            const FragmentDefinition* fragment = it->second;
+
+            // A fragment spread again under the same conditions adds nothing
+            bool seen = false;
+            for (const auto& [done, done_guard] : visited) {
+                seen = seen || (done == fragment && done_guard.first_condition == guard.first_condition &&
+                                done_guard.condition_count == guard.condition_count);
+            }
+            if (seen) continue;
+            visited.emplace_back(fragment, guard);
+            if (!type_applies(fragment->type_condition, fragment->type_condition_id, object_type)) continue;
+            collect(object_type, *fragment->selection_set, guard, out, visited);
+        }
+    }
+}
+
+uint32_t PlanCompiler::compile_block(uint32_t object_type, const std::vector<Occurrence>& sets) {
+    std::vector<Collected> collected;
+    std::vector<std::pair<const FragmentDefinition*, PlanGuard>> visited;
+    for (const Occurrence& occurrence : sets) collect(object_type, *occurrence.set, occurrence.conditions, collected, visited);
+
+    // Group by response key, in order of first occurrence
+    std::vector<std::vector<uint32_t>> groups;
+    std::unordered_map<std::string_view, uint32_t> group_index;
+    for (uint32_t i = 0; i < collected.size(); i++) {
+        const Field& field = *collected[i].field;
+        std::string_view key = field.alias.empty() ? field.name : field.alias;
+        auto [it, inserted] = group_index.try_emplace(key, static_cast<uint32_t>(groups.size()));
+        if (inserted) groups.emplace_back();
+        groups[it->second].push_back(i);
+    }
+
+    uint32_t block = static_cast<uint32_t>(plan_.blocks_.size());
+    uint32_t first_field = static_cast<uint32_t>(plan_.fields_.size());
+    plan_.blocks_.push_back(PlanBlock{object_type, first_field, static_cast<uint32_t>(groups.size()), false});
+    // Reserved up front so the block's fields stay contiguous; children are appended after them
+    plan_.fields_.resize(first_field + groups.size());
+    if (plan_.fields_.size() > max_fields_) {
+        overflow_ = true;
+        return block;
+    }
+
+    for (uint32_t g = 0; g < groups.size() && !overflow_; g++) {
+        const Collected& first = collected[groups[g][0]];
+        const Field& field = *first.field;
+        PlanField compiled{};
+        compiled.key = field.alias.empty() ? field.name : field.alias;
+        compiled.field = &field;
+        compiled.child = Schema::NONE;
+
+        // Included when any occurrence is; an unconditional occurrence means always
+        bool always = false;
+        for (uint32_t index : groups[g]) always = always || collected[index].conditions.condition_count == 0;
+        compiled.first_guard = static_cast<uint32_t>(plan_.guards_.size());
+        if (!always) {
+            for (uint32_t index : groups[g]) plan_.guards_.push_back(collected[index].conditions);
+        }
+        compiled.guard_count = static_cast<uint32_t>(plan_.guards_.size()) - compiled.first_guard;
+
+        uint32_t name = schema_name(field.name_id, field.name);
+        if ((name != Schema::NONE && name == typename_id_) || field.name == "__typename") {
+            compiled.type = TypeRef{Schema::BUILTIN_STRING, 0, 1};
+            plan_.fields_[first_field + g] = compiled;
+            continue;
+        }
+        const FieldDef* def = schema_.field(object_type, name);
+        if (!def) {
+            plan_.fields_[first_field + g] = compiled;  // Unknown field; validation rejects these
+            continue;
+        }
+        compiled.def = def;
+        compiled.type = def->type;
+        compiled.resolver = resolvers_.slot(object_type, *def);
+        compile_arguments(field, *def, compiled);
+
+        const TypeDef& type = schema_.type(def->type.type);
+        if (type.is_composite()) {
+            std::vector<Occurrence> children;
+            for (uint32_t index : groups[g]) {
+                const Collected& occurrence = collected[index];
+                if (occurrence.field->selection_set) {
+                    children.push_back(Occurrence{occurrence.field->selection_set.get(), occurrence.conditions});
+                }
+            }
+            if (!type.is_abstract()) {
+                compiled.child = compile_block(def->type.type, children);
+                compiled.expensive_children = plan_.blocks_[compiled.child].expensive;
+            } else {
+                // Sorted by type so execution can binary-search the concrete type
+                SchemaSpan<uint32_t> span = schema_.possible_types(def->type.type);
+                std::vector<uint32_t> possible(span.begin(), span.end());
+                std::sort(possible.begin(), possible.end());
+                compiled.child = static_cast<uint32_t>(plan_.dispatch_.size());
+                compiled.dispatch_count = static_cast<uint32_t>(possible.size());
+                plan_.dispatch_.resize(plan_.dispatch_.size() + possible.size());
+                for (size_t i = 0; i < possible.size() && !overflow_; i++) {
+                    uint32_t child = compile_block(possible[i], children);
+                    plan_.dispatch_[compiled.child + i] = PlanDispatch{possible[i], child};
+                    compiled.expensive_children = compiled.expensive_children || plan_.blocks_[child].expensive;
+                }
+            }
+        }
+        compiled.expensive = resolvers_.expensive(compiled.resolver) || compiled.expensive_children;
+        plan_.blocks_[block].expensive = plan_.blocks_[block].expensive || compiled.expensive;
+        plan_.fields_[first_field + g] = compiled;
+    }
+    return block;
+}
+
+void PlanCompiler::compile_arguments(const Field& field, const FieldDef& def, PlanField& out) {
+    SchemaSpan<InputValueDef> defs = schema_.arguments(def);
+    ResponseValue* slots = make_array<ResponseValue>(*plan_.arena_, defs.size());
+    out.arguments = slots;
+    out.first_dynamic = static_cast<uint32_t>(plan_.dynamic_arguments_.size());
+
+    std::string error;
+    for (uint32_t slot = 0; slot < defs.size(); slot++) {
+        const Value* literal = nullptr;
+        for (const auto& argument : field.arguments) {
+            if (schema_name(argument->name_id, argument->name) == defs[slot].name) {
+                literal = &argument->value;
+                break;
+            }
+        }
+        bool constant = !literal || !has_variables(*literal);
+        if (constant &&
+            coercer_.coerce_argument(literal, defs[slot], ResponseValue(), *plan_.arena_, slots[slot], error)) {
+            continue;
+        }
+        // Coerced per request; also for constants that fail, so the error is reported at execution
+        plan_.dynamic_arguments_.push_back(PlanArgument{slot, literal});
+        if (const ResponseValue* value = coercer_.default_value(defs[slot])) slots[slot] = *value;
+    }
+    out.dynamic_count = static_cast<uint32_t>(plan_.dynamic_arguments_.size()) - out.first_dynamic;
+}
+
+// QueryPlan
+
+std::shared_ptr<const QueryPlan> QueryPlan::compile(const ResolverRegistry& resolvers, const InputCoercer& coercer,
+                                                    const Document& document, std::string* error,
+                                                    size_t max_fields) {
+    std::shared_ptr<QueryPlan> plan(new QueryPlan());
+    plan->generation_ = resolvers.schema().generation();
+    plan->resolver_version_ = resolvers.version();
+    plan->arena_.reset(new ASTArena(16 * 1024));
+    PlanCompiler compiler(resolvers, coercer, *plan, max_fields);
+    std::string message;
+    if (!compiler.compile(document, message)) {
+        if (error) *error = message;
+        return nullptr;
+    }
+    plan->quote_keys();
+    return plan;
+}
+
+std::shared_ptr<const QueryPlan> QueryPlan::compile(const ResolverRegistry& resolvers, const InputCoercer& coercer,
+                                                    const CacheEntry& entry, std::string* error,
+                                                    size_t max_fields) {
+    if (!entry.is_warm()) return compile(resolvers, coercer, *entry.ast, error, max_fields);
+
+    // Warm entries only carry the flat view; the plan owns a tree expanded
+    // from it (nothing is lexed or parsed)
+    auto arena = std::make_unique<ASTArena>(entry.text().size() * 16 + 1024);
+    Interner symbols(&resolvers.schema().names());
+    auto document = FlatExpander(entry.flat, *arena, &symbols).expand();
+    if (!document) {
+        if (error) *error = "Cached document is empty";
+        return nullptr;
+    }
+    auto plan = compile(resolvers, coercer, *document, error, max_fields);
+    if (plan) const_cast<QueryPlan&>(*plan).document_arena_ = std::move(arena);
+    return plan;
+}
+
+void QueryPlan::quote_keys() {
+    // Keys are GraphQL names, so they never need escaping
+    constexpr size_t NONE = SIZE_MAX;
+    std::unordered_map<std::string_view, size_t> offsets;
+    size_t size = 0;
+    for (const PlanField& field : fields_) {
+        if (offsets.emplace(field.key, NONE).second) size += field.key.size() + 3;
+    }
+    keys_.reset(new char[size ? size : 1]);
+    keys_size_ = size;
+    size_t used = 0;
+    for (PlanField& field : fields_) {
+        size_t& offset = offsets[field.key];
+        char* out = keys_.get() + (offset == NONE ? used : offset);
+        if (offset == NONE) {
+            out[0] = '"';
+            std::memcpy(out + 1, field.key.data(), field.key.size());
+            out[field.key.size() + 1] = '"';
+            out[field.key.size() + 2] = ':';
+            offset = used;
+            used += field.key.size() + 3;
+        }
+        field.key_offset = static_cast<uint32_t>(offset);
+        field.key_size = static_cast<uint32_t>(field.key.size() + 3);
+        field.key = std::string_view(out + 1, field.key.size());
+    }
+}
+
+const PlanOperation* QueryPlan::operation(std::string_view name) const {
+    if (name.empty()) return operations_.size() == 1 ? &operations_[0] : nullptr;
+    for (const PlanOperation& operation : operations_) {
+        if (operation.name == name) return &operation;
+    }
+    return nullptr;
+}
+
+size_t QueryPlan::memory_bytes() const {
+    return sizeof(QueryPlan) + operations_.capacity() * sizeof(PlanOperation) +
+           blocks_.capacity() * sizeof(PlanBlock) + fields_.capacity() * sizeof(PlanField) +
+           dispatch_.capacity() * sizeof(PlanDispatch) + guards_.capacity() * sizeof(PlanGuard) +
+           conditions_.capacity() * sizeof(PlanCondition) +
+           dynamic_arguments_.capacity() * sizeof(PlanArgument) + arena_->bytes_allocated() +
+           (document_arena_ ? document_arena_->bytes_allocated() : 0) + keys_size_;
+}
@@ -0,0 +1,48 @@
+#include "runtime/resolver.h"
+#include "runtime/async.h"
+#include <atomic>
+
+ResolverRegistry::ResolverRegistry(const Schema& schema)
+    : schema_(schema), first_slot_(schema.type_count()), type_resolvers_(schema.type_count()) {
+    uint32_t slots = 0;
+    for (uint32_t type = 0; type < schema.type_count(); type++) {
+        first_slot_[type] = slots;
+        slots += static_cast<uint32_t>(schema.fields(type).size());
+    }
+    resolvers_.resize(slots);
+    costs_.resize(slots, ResolverCost::CHEAP);
+    version_ = next_version();
+}
+
+uint64_t ResolverRegistry::next_version() {
+    static std::atomic<uint64_t> next{1};
+    return next.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool ResolverRegistry::add(std::string_view type, std::string_view field, Resolver resolver, ResolverCost cost) {
+    uint32_t index = schema_.type_index(type);
+    // Fields execute on object types only
+    if (index == Schema::NONE || schema_.type(index).kind != TypeKind::OBJECT) return false;
+    const FieldDef* def = schema_.field(index, field);
+    if (!def) return false;
+    resolvers_[slot(index, *def)] = std::move(resolver);
+    costs_[slot(index, *def)] = cost;
+    version_ = next_version();
+    return true;
+}
+
+bool ResolverRegistry::add_async(std::string_view type, std::string_view field, AsyncResolver resolver,
+                                 ResolverCost cost) {
+    if (!resolver) return add(type, field, Resolver(), cost);
+    return add(type, field, [resolver = std::move(resolver)](const FieldContext& ctx) {
+        // The coroutine holds ctx by reference across suspensions, so it gets a copy that lives with the request
+        return resolver(*ctx.arena->create<FieldContext>(ctx)).result();
+    }, cost);
+}
+
+bool ResolverRegistry::add_type_resolver(std::string_view type, TypeResolver resolver) {
+    uint32_t index = schema_.type_index(type);
+    if (index == Schema::NONE || !schema_.type(index).is_abstract()) return false;
+    type_resolvers_[index] = std::move(resolver);
+    return true;
+}
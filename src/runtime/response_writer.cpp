@@ -0,0 +1,221 @@
+#include "runtime/response_writer.h"
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include "simd/json_escape_scan.h"
+
+namespace {
+
+const char HEX[] = "0123456789abcdef";
+
+// Longest std::to_chars output for int64_t and (shortest form) double
+constexpr size_t NUMBER_SPACE = 32;
+
+}  // namespace
+
+ResponseWriter::ResponseWriter(JsonBuffer buffer, Flush flush, const QueryPlan* plan)
+    : buffer_(buffer.data),
+      capacity_(buffer.data ? buffer.size : 0),
+      used_(0),
+      flushed_(0),
+      flush_(std::move(flush)),
+      plan_(plan),
+      failed_(false) {}
+
+bool ResponseWriter::next_buffer() {
+    if (failed_) return false;
+    JsonBuffer next = flush_ ? flush_(buffer_, used_) : JsonBuffer{nullptr, 0};
+    if (!next.data || !next.size) {
+        // Stays full, so every later put() lands here and is dropped
+        failed_ = true;
+        return false;
+    }
+    flushed_ += used_;
+    buffer_ = next.data;
+    capacity_ = next.size;
+    used_ = 0;
+    return true;
+}
+
+void ResponseWriter::put(const char* data, size_t size) {
+    while (size > 0) {
+        if (used_ == capacity_ && !next_buffer()) return;
+        size_t chunk = std::min(size, capacity_ - used_);
+        std::memcpy(buffer_ + used_, data, chunk);
+        used_ += chunk;
+        data += chunk;
+        size -= chunk;
+    }
+}
+
+bool ResponseWriter::finish() {
+    if (failed_) return false;
+    if (flush_ && used_ > 0) {
+        flush_(buffer_, used_);
+        flushed_ += used_;
+        used_ = 0;
+    }
+    return true;
+}
+
+bool ResponseWriter::write(const ExecutionResult& result) {
+    put('{');
+    if (!result.errors.empty()) {
+        put("\"errors\":[");
+        for (size_t i = 0; i < result.errors.size(); i++) {
+            if (i) put(',');
+            write_error(result.errors[i]);
+        }
+        put(']');
+    }
+    if (result.has_data) {
+        if (!result.errors.empty()) put(',');
+        put("\"data\":");
+        write_value(result.data);
+    }
+    put('}');
+    return !failed_;
+}
+
+bool ResponseWriter::write(const ResponseValue& value) {
+    write_value(value);
+    return !failed_;
+}
+
+void ResponseWriter::write_value(const ResponseValue& value) {
+    switch (value.kind) {
+        case ResponseKind::NULL_VALUE: put("null"); return;
+        case ResponseKind::BOOLEAN: value.boolean ? put("true") : put("false"); return;
+        case ResponseKind::INT: write_int(value.integer); return;
+        case ResponseKind::FLOAT: write_float(value.number); return;
+        case ResponseKind::STRING:
+        case ResponseKind::ENUM: write_string(value.text()); return;
+        case ResponseKind::LIST:
+            put('[');
+            for (uint32_t i = 0; i < value.size; i++) {
+                if (i) put(',');
+                write_value(value.items[i]);
+            }
+            put(']');
+            return;
+        case ResponseKind::OBJECT:
+            put('{');
+            for (uint32_t i = 0; i < value.size; i++) {
+                if (i) put(',');
+                write_key(value.fields[i]);
+                write_value(value.fields[i].value);
+            }
+            put('}');
+            return;
+    }
+}
+
+void ResponseWriter::write_string(std::string_view text) {
+    put('"');
+    const char* at = text.data();
+    size_t left = text.size();
+    while (left > 0) {
+        size_t clean = find_json_escape(at, left);
+        put(at, clean);
+        if (clean == left) break;
+        unsigned char c = static_cast<unsigned char>(at[clean]);
+        switch (c) {
+            case '"': put("\\\"", 2); break;
+            case '\\': put("\\\\", 2); break;
+            case '\b': put("\\b", 2); break;
+            case '\f': put("\\f", 2); break;
+            case '\n': put("\\n", 2); break;
+            case '\r': put("\\r", 2); break;
+            case '\t': put("\\t", 2); break;
+            default: {
+                char escape[6] = {'\\', 'u', '0', '0', HEX[c >> 4], HEX[c & 0xF]};
+                put(escape, sizeof(escape));
+            }
+        }
+        at += clean + 1;
+        left -= clean + 1;
+    }
+    put('"');
+}
+
+void ResponseWriter::write_key(const ResponseField& field) {
+    if (plan_ && field.plan_field) {
+        put(plan_->key_fragment(*field.plan_field));
+        return;
+    }
+    write_string(field.name);
+    put(':');
+}
+
+void ResponseWriter::write_int(int64_t value) {
+    // Straight into the buffer when there's room, else via a scratch copy
+    if (capacity_ - used_ >= NUMBER_SPACE) {
+        used_ = std::to_chars(buffer_ + used_, buffer_ + capacity_, value).ptr - buffer_;
+        return;
+    }
+    char scratch[NUMBER_SPACE];
+    put(scratch, std::to_chars(scratch, scratch + sizeof(scratch), value).ptr - scratch);
+}
+
+void ResponseWriter::write_float(double value) {
+    if (!std::isfinite(value)) {
+        put("null");
+        return;
+    }
+    if (capacity_ - used_ >= NUMBER_SPACE) {
+        used_ = std::to_chars(buffer_ + used_, buffer_ + capacity_, value).ptr - buffer_;
+        return;
+    }
+    char scratch[NUMBER_SPACE];
+    put(scratch, std::to_chars(scratch, scratch + sizeof(scratch), value).ptr - scratch);
+}
+
+void ResponseWriter::write_error(const ExecutionError& error) {
+    put("{\"message\":");
+    write_string(error.message);
+    if (!error.path.empty()) {
+        put(",\"path\":[");
+        for (size_t i = 0; i < error.path.size(); i++) {
+            if (i) put(',');
+            const PathSegment& segment = error.path[i];
+            if (segment.key.empty()) {
+                write_int(static_cast<int64_t>(segment.index));
+            } else {
+                write_string(segment.key);
+            }
+        }
+        put(']');
+    }
+    put('}');
+}
+
+size_t write_response(const ExecutionResult& result, struct iovec* iov, size_t count, const QueryPlan* plan) {
+    if (count == 0) return 0;
+    size_t current = 0;
+    ResponseWriter writer({static_cast<char*>(iov[0].iov_base), iov[0].iov_len},
+                          [&](const char*, size_t size) {
+                              iov[current].iov_len = size;
+                              if (++current == count) return JsonBuffer{nullptr, 0};
+                              return JsonBuffer{static_cast<char*>(iov[current].iov_base), iov[current].iov_len};
+                          },
+                          plan);
+    writer.write(result);
+    if (!writer.ok()) return 0;
+    iov[current].iov_len = writer.buffered();
+    return current + 1;
+}
+
+std::string response_to_json(const ExecutionResult& result, const QueryPlan* plan) {
+    std::string out(4096, '\0');
+    size_t done = 0;
+    ResponseWriter writer({out.data(), out.size()},
+                          [&](const char*, size_t size) {
+                              done += size;
+                              out.resize(out.size() * 2);
+                              return JsonBuffer{out.data() + done, out.size() - done};
+                          },
+                          plan);
+    writer.write(result);
+    out.resize(done + writer.buffered());
+    return out;
+}
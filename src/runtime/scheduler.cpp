@@ -0,0 +1,197 @@
+#include "runtime/scheduler.h"
+
+namespace {
+
+// Worker identity of the current thread
+thread_local const Scheduler* current_scheduler = nullptr;
+thread_local size_t current_worker = 0;
+
+// Failed scans before an idle worker sleeps
+constexpr int IDLE_SPINS = 64;
+
+}  // namespace
+
+// Deque
+
+Scheduler::Deque::Deque() : top_(0), bottom_(0), buffer_(new std::atomic<Task*>[DEQUE_CAPACITY]) {}
+
+bool Scheduler::Deque::push(Task* task) {
+    int64_t bottom = bottom_.load(std::memory_order_relaxed);
+    int64_t top = top_.load(std::memory_order_acquire);
+    if (bottom - top >= static_cast<int64_t>(DEQUE_CAPACITY)) return false;
+    // Release on the slot too (not only the fence) so race detectors see the task's writes published
+    buffer_[bottom & (DEQUE_CAPACITY - 1)].store(task, std::memory_order_release);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom_.store(bottom + 1, std::memory_order_relaxed);
+    return true;
+}
+
+Task* Scheduler::Deque::pop() {
+    int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+    bottom_.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t top = top_.load(std::memory_order_relaxed);
+    if (top > bottom) {
+        bottom_.store(bottom + 1, std::memory_order_relaxed);  // Empty
+        return nullptr;
+    }
+    Task* task = buffer_[bottom & (DEQUE_CAPACITY - 1)].load(std::memory_order_relaxed);
+    if (top == bottom) {
+        // Last task: race thieves for it
+        if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            task = nullptr;
+        }
+        bottom_.store(bottom + 1, std::memory_order_relaxed);
+    }
+    return task;
+}
+
+Task* Scheduler::Deque::steal() {
+    int64_t top = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t bottom = bottom_.load(std::memory_order_acquire);
+    if (top >= bottom) return nullptr;
+    Task* task = buffer_[top & (DEQUE_CAPACITY - 1)].load(std::memory_order_acquire);
+    if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+        return nullptr;
+    }
+    return task;
+}
+
+// Scheduler
+
+Scheduler::Scheduler(size_t threads)
+    : stopping_(false), injected_count_(0), work_epoch_(0), sleepers_(0) {
+    if (threads == 0) threads = 1;
+    for (size_t i = 0; i < threads; i++) workers_.push_back(std::make_unique<Worker>());
+    // Started after every deque exists, since workers steal from all of them
+    for (size_t i = 0; i < threads; i++) workers_[i]->thread = std::thread([this, i] { run_worker(i); });
+}
+
+Scheduler::~Scheduler() {
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        stopping_.store(true, std::memory_order_release);
+    }
+    work_available_.notify_all();
+    for (auto& worker : workers_) worker->thread.join();
+}
+
+size_t Scheduler::worker_index() const {
+    return current_scheduler == this ? current_worker : workers_.size();
+}
+
+void Scheduler::spawn(TaskGroup& group, Task* task) {
+    task->group = &group;
+    group.pending_.fetch_add(1, std::memory_order_relaxed);
+    size_t index = worker_index();
+    if (index < workers_.size()) {
+        if (!workers_[index]->deque.push(task)) {
+            execute(task);  // Deque full: no room to defer, run it now
+            return;
+        }
+    } else {
+        std::lock_guard<std::mutex> lock(injected_mutex_);
+        injected_.push_back(task);
+        injected_count_.fetch_add(1, std::memory_order_release);
+    }
+    notify_work();
+}
+
+void Scheduler::wait(TaskGroup& group) {
+    size_t index = worker_index();
+    if (index < workers_.size()) {
+        // Help instead of blocking: the group's tasks are most likely on our own deque
+        while (!group.done()) {
+            if (Task* task = find_task(index)) {
+                execute(task);
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        return;
+    }
+    std::unique_lock<std::mutex> lock(sleep_mutex_);
+    group_done_.wait(lock, [&group] { return group.done(); });
+}
+
+void Scheduler::notify_work() {
+    work_epoch_.fetch_add(1, std::memory_order_seq_cst);
+    if (sleepers_.load(std::memory_order_seq_cst) > 0) {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        work_available_.notify_one();
+    }
+}
+
+void Scheduler::execute(Task* task) {
+    TaskGroup* group = task->group;
+    task->run(task);
+    if (group->pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        // The group may be destroyed as soon as a waiter sees it done; only the scheduler is touched here
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        group_done_.notify_all();
+    }
+}
+
+Task* Scheduler::find_task(size_t index) {
+    if (Task* task = workers_[index]->deque.pop()) return task;
+
+    if (injected_count_.load(std::memory_order_acquire) > 0) {
+        std::lock_guard<std::mutex> lock(injected_mutex_);
+        if (!injected_.empty()) {
+            Task* task = injected_.back();
+            injected_.pop_back();
+            injected_count_.fetch_sub(1, std::memory_order_relaxed);
+            return task;
+        }
+    }
+
+    // Steal, starting from the next worker so victims are spread out
+    size_t count = workers_.size();
+    for (size_t i = 1; i < count; i++) {
+        if (Task* task = workers_[(index + i) % count]->deque.steal()) return task;
+    }
+    return nullptr;
+}
+
+void Scheduler::run_worker(size_t index) {
+    current_scheduler = this;
+    current_worker = index;
+    int idle = 0;
+    while (!stopping_.load(std::memory_order_acquire)) {
+        uint64_t epoch = work_epoch_.load(std::memory_order_seq_cst);
+        if (Task* task = find_task(index)) {
+            execute(task);
+            idle = 0;
+            continue;
+        }
+        if (++idle < IDLE_SPINS) {
+            std::this_thread::yield();
+            continue;
+        }
+        // Sleep unless work was announced since the scan above
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        sleepers_.fetch_add(1, std::memory_order_seq_cst);
+        work_available_.wait(lock, [&] {
+            return stopping_.load(std::memory_order_acquire) || work_epoch_.load(std::memory_order_seq_cst) != epoch;
+        });
+        sleepers_.fetch_sub(1, std::memory_order_seq_cst);
+        idle = 0;
+    }
+}
+
+// WorkerArenas
+
+WorkerArenas::WorkerArenas(const Scheduler& scheduler, size_t initial_size) : scheduler_(scheduler) {
+    for (size_t i = 0; i <= scheduler.worker_count(); i++) arenas_.push_back(std::make_unique<ASTArena>(initial_size));
+}
+
+void WorkerArenas::reset() {
+    for (auto& arena : arenas_) arena->reset();
+}
+
+size_t WorkerArenas::bytes_allocated() const {
+    size_t total = 0;
+    for (const auto& arena : arenas_) total += arena->bytes_allocated();
+    return total;
+}
@@ -0,0 +1,339 @@
+#include <memory>
+#include <string>
+#include <vector>
+#include "json/json_reader.h"
+#include "schema/schema.h"
+#include "schema/schema_builder.h"
+
+// Loader for the result of the standard introspection query. Types named
+// __* are the introspection types themselves and are skipped.
+
+namespace {
+
+class IntrospectionReader {
+public:
+    IntrospectionReader(std::string_view json, SchemaBuilder& builder)
+        : reader_(json), builder_(builder) {}
+
+    bool parse() {
+        std::string key;
+        if (!reader_.begin_object()) return fail();
+        bool found = false;
+        while (reader_.next_key(key)) {
+            if (key == "data") {
+                if (!reader_.begin_object()) return fail();
+                while (reader_.next_key(key)) {
+                    if (key == "__schema") {
+                        if (!parse_schema()) return false;
+                        found = true;
+                    } else if (!reader_.skip_value()) {
+                        return fail();
+                    }
+                }
+            } else if (key == "__schema") {
+                if (!parse_schema()) return false;
+                found = true;
+            } else if (!reader_.skip_value()) {
+                return fail();
+            }
+        }
+        if (!reader_.ok()) return fail();
+        if (!found) {
+            builder_.error("No __schema in introspection result");
+            return false;
+        }
+        return true;
+    }
+
+private:
+    // Nested introspection __Type reference, e.g. NON_NULL(LIST(NAMED))
+    struct RawTypeRef {
+        std::string kind;
+        std::string name;
+        std::unique_ptr<RawTypeRef> of_type;
+    };
+
+    JsonReader reader_;
+    SchemaBuilder& builder_;
+
+    bool fail() {
+        builder_.error("Invalid introspection JSON at offset " + std::to_string(reader_.position()) +
+                       (reader_.ok() ? "" : ": " + reader_.error()));
+        return false;
+    }
+
+    // Nullable values: true with present=false for null
+    bool begin_nullable(JsonReader::Type type, bool& present) {
+        present = false;
+        if (reader_.peek() == JsonReader::Type::NULL_VALUE) return reader_.read_null();
+        if (type == JsonReader::Type::OBJECT ? !reader_.begin_object() : !reader_.begin_array()) return false;
+        present = true;
+        return true;
+    }
+
+    bool read_nullable_string(std::string& out, bool& present) {
+        present = false;
+        if (reader_.peek() == JsonReader::Type::NULL_VALUE) return reader_.read_null();
+        present = true;
+        return reader_.read_string(out);
+    }
+
+    // {"name": "..."} or null
+    bool parse_named(std::string& out) {
+        bool present;
+        std::string key;
+        if (!begin_nullable(JsonReader::Type::OBJECT, present)) return false;
+        if (!present) return true;
+        while (reader_.next_key(key)) {
+            if (key == "name") {
+                bool has_name;
+                if (!read_nullable_string(out, has_name)) return false;
+            } else if (!reader_.skip_value()) {
+                return false;
+            }
+        }
+        return reader_.ok();
+    }
+
+    bool parse_raw_type_ref(RawTypeRef& out, unsigned depth) {
+        bool present;
+        std::string key;
+        if (depth > 2 * TypeRef::MAX_LIST_DEPTH + 2) {
+            builder_.error("Type reference nested too deeply");
+            return false;
+        }
+        if (!begin_nullable(JsonReader::Type::OBJECT, present)) return false;
+        if (!present) return true;
+        while (reader_.next_key(key)) {
+            bool has_value;
+            if (key == "kind") {
+                if (!reader_.read_string(out.kind)) return false;
+            } else if (key == "name") {
+                if (!read_nullable_string(out.name, has_value)) return false;
+            } else if (key == "ofType") {
+                out.of_type = std::make_unique<RawTypeRef>();
+                if (!parse_raw_type_ref(*out.of_type, depth + 1)) return false;
+            } else if (!reader_.skip_value()) {
+                return false;
+            }
+        }
+        return reader_.ok();
+    }
+
+    bool parse_type_ref(SchemaBuilder::TypeRefSpec& out) {
+        RawTypeRef raw;
+        if (!parse_raw_type_ref(raw, 0)) return false;
+
+        unsigned level = 0;
+        for (const RawTypeRef* ref = &raw; ref; ref = ref->of_type.get()) {
+            if (ref->kind == "NON_NULL") {
+                out.non_null |= static_cast<uint16_t>(1u << level);
+            } else if (ref->kind == "LIST") {
+                if (++level > TypeRef::MAX_LIST_DEPTH) break;
+            } else {
+                out.name = ref->name;
+                out.list_depth = static_cast<uint8_t>(level);
+                return true;
+            }
+        }
+        builder_.error("Malformed type reference");
+        return false;
+    }
+
+    bool parse_input_values(std::vector<SchemaBuilder::InputValueSpec>& out) {
+        bool present;
+        if (!begin_nullable(JsonReader::Type::ARRAY, present)) return false;
+        if (!present) return true;
+        std::string key;
+        while (reader_.next_element()) {
+            SchemaBuilder::InputValueSpec value;
+            if (!reader_.begin_object()) return false;
+            while (reader_.next_key(key)) {
+                if (key == "name") {
+                    if (!reader_.read_string(value.name)) return false;
+                } else if (key == "type") {
+                    if (!parse_type_ref(value.type)) return false;
+                } else if (key == "defaultValue") {
+                    if (!read_nullable_string(value.default_value, value.has_default)) return false;
+                } else if (!reader_.skip_value()) {
+                    return false;
+                }
+            }
+            out.push_back(std::move(value));
+        }
+        return reader_.ok();
+    }
+
+    bool parse_type_names(std::vector<std::string>& out) {
+        bool present;
+        if (!begin_nullable(JsonReader::Type::ARRAY, present)) return false;
+        if (!present) return true;
+        while (reader_.next_element()) {
+            out.emplace_back();
+            if (!parse_named(out.back())) return false;
+        }
+        return reader_.ok();
+    }
+
+    bool parse_fields(std::vector<SchemaBuilder::FieldSpec>& out) {
+        bool present;
+        if (!begin_nullable(JsonReader::Type::ARRAY, present)) return false;
+        if (!present) return true;
+        std::string key;
+        while (reader_.next_element()) {
+            SchemaBuilder::FieldSpec field;
+            if (!reader_.begin_object()) return false;
+            while (reader_.next_key(key)) {
+                if (key == "name") {
+                    if (!reader_.read_string(field.name)) return false;
+                } else if (key == "args") {
+                    if (!parse_input_values(field.args)) return false;
+                } else if (key == "type") {
+                    if (!parse_type_ref(field.type)) return false;
+                } else if (key == "isDeprecated") {
+                    if (!reader_.read_bool(field.deprecated)) return false;
+                } else if (!reader_.skip_value()) {
+                    return false;
+                }
+            }
+            out.push_back(std::move(field));
+        }
+        return reader_.ok();
+    }
+
+    bool parse_enum_values(std::vector<SchemaBuilder::EnumValueSpec>& out) {
+        bool present;
+        if (!begin_nullable(JsonReader::Type::ARRAY, present)) return false;
+        if (!present) return true;
+        std::string key;
+        while (reader_.next_element()) {
+            SchemaBuilder::EnumValueSpec value;
+            if (!reader_.begin_object()) return false;
+            while (reader_.next_key(key)) {
+                if (key == "name") {
+                    if (!reader_.read_string(value.name)) return false;
+                } else if (key == "isDeprecated") {
+                    if (!reader_.read_bool(value.deprecated)) return false;
+                } else if (!reader_.skip_value()) {
+                    return false;
+                }
+            }
+            out.push_back(std::move(value));
+        }
+        return reader_.ok();
+    }
+
+    bool parse_type() {
+        // Keys may come in any order, so collect everything before defining
+        SchemaBuilder::TypeSpec spec;
+        std::string kind, key;
+        bool has_name = false;
+        if (!reader_.begin_object()) return fail();
+        while (reader_.next_key(key)) {
+            bool ok;
+            if (key == "kind") ok = reader_.read_string(kind);
+            else if (key == "name") ok = read_nullable_string(spec.name, has_name);
+            else if (key == "fields") ok = parse_fields(spec.fields);
+            else if (key == "inputFields") ok = parse_input_values(spec.input_fields);
+            else if (key == "interfaces") ok = parse_type_names(spec.interfaces);
+            else if (key == "possibleTypes") ok = parse_type_names(spec.union_members);
+            else if (key == "enumValues") ok = parse_enum_values(spec.enum_values);
+            else ok = reader_.skip_value();
+            if (!ok) return reader_.ok() ? false : fail();
+        }
+        if (!reader_.ok()) return fail();
+        if (!has_name || spec.name.compare(0, 2, "__") == 0) return true;
+
+        TypeKind type_kind;
+        if (kind == "SCALAR") type_kind = TypeKind::SCALAR;
+        else if (kind == "OBJECT") type_kind = TypeKind::OBJECT;
+        else if (kind == "INTERFACE") type_kind = TypeKind::INTERFACE;
+        else if (kind == "UNION") type_kind = TypeKind::UNION;
+        else if (kind == "ENUM") type_kind = TypeKind::ENUM;
+        else if (kind == "INPUT_OBJECT") type_kind = TypeKind::INPUT_OBJECT;
+        else {
+            builder_.error("Type " + spec.name + " has unknown kind " + kind);
+            return false;
+        }
+
+        // Interfaces' possible types are derived from their implementers
+        if (type_kind != TypeKind::UNION) spec.union_members.clear();
+        SchemaBuilder::TypeSpec& type = builder_.define_type(spec.name, type_kind);
+        type.fields = std::move(spec.fields);
+        type.input_fields = std::move(spec.input_fields);
+        type.enum_values = std::move(spec.enum_values);
+        type.interfaces = std::move(spec.interfaces);
+        type.union_members = std::move(spec.union_members);
+        return true;
+    }
+
+    bool parse_directive() {
+        SchemaBuilder::DirectiveSpec spec;
+        std::string key;
+        if (!reader_.begin_object()) return fail();
+        while (reader_.next_key(key)) {
+            bool ok = true;
+            if (key == "name") {
+                ok = reader_.read_string(spec.name);
+            } else if (key == "args") {
+                ok = parse_input_values(spec.args);
+            } else if (key == "isRepeatable") {
+                ok = reader_.read_bool(spec.repeatable);
+            } else if (key == "locations") {
+                ok = reader_.begin_array();
+                std::string name;
+                while (ok && reader_.next_element()) {
+                    DirectiveLocation location;
+                    ok = reader_.read_string(name);
+                    if (ok && directive_location_from_name(name, location)) {
+                        spec.locations |= 1u << static_cast<unsigned>(location);
+                    }
+                }
+            } else {
+                ok = reader_.skip_value();
+            }
+            if (!ok || !reader_.ok()) return reader_.ok() ? false : fail();
+        }
+        if (!reader_.ok()) return fail();
+        std::string name = spec.name;
+        builder_.define_directive(name) = std::move(spec);
+        return true;
+    }
+
+    bool parse_schema() {
+        std::string key;
+        if (!reader_.begin_object()) return fail();
+        while (reader_.next_key(key)) {
+            bool ok = true;
+            if (key == "queryType") {
+                ok = parse_named(builder_.query_type);
+            } else if (key == "mutationType") {
+                ok = parse_named(builder_.mutation_type);
+            } else if (key == "subscriptionType") {
+                ok = parse_named(builder_.subscription_type);
+            } else if (key == "types" || key == "directives") {
+                bool types = key == "types";
+                if (!reader_.begin_array()) return fail();
+                while (reader_.next_element()) {
+                    if (!(types ? parse_type() : parse_directive())) return false;
+                }
+            } else {
+                ok = reader_.skip_value();
+            }
+            if (!ok || !reader_.ok()) return fail();
+        }
+        return reader_.ok() || fail();
+    }
+};
+
+}  // namespace
+
+std::unique_ptr<Schema> Schema::from_introspection(std::string_view json, std::vector<std::string>* errors) {
+    SchemaBuilder builder;
+    std::unique_ptr<Schema> schema;
+    if (IntrospectionReader(json, builder).parse()) {
+        schema = builder.build();
+    }
+    if (errors) *errors = builder.errors();
+    return schema;
+}
@@ -0,0 +1,396 @@
+#include "schema/schema.h"
+#include <algorithm>
+#include <atomic>
+#include "schema/schema_builder.h"
+
+namespace {
+
+constexpr const char* LOCATION_NAMES[] = {
+    "QUERY", "MUTATION", "SUBSCRIPTION", "FIELD", "FRAGMENT_DEFINITION", "FRAGMENT_SPREAD",
+    "INLINE_FRAGMENT", "VARIABLE_DEFINITION", "SCHEMA", "SCALAR", "OBJECT", "FIELD_DEFINITION",
+    "ARGUMENT_DEFINITION", "INTERFACE", "UNION", "ENUM", "ENUM_VALUE", "INPUT_OBJECT",
+    "INPUT_FIELD_DEFINITION"
+};
+
+inline uint32_t location_bit(DirectiveLocation location) {
+    return 1u << static_cast<unsigned>(location);
+}
+
+inline uint32_t member_hash(uint32_t name_id) {
+    uint32_t h = name_id * 0x9E3779B1u;
+    return h ^ (h >> 16);
+}
+
+inline uint32_t to_u32(size_t n) {
+    return static_cast<uint32_t>(n);
+}
+
+const char* kind_name(TypeKind kind) {
+    switch (kind) {
+        case TypeKind::SCALAR: return "scalar";
+        case TypeKind::OBJECT: return "type";
+        case TypeKind::INTERFACE: return "interface";
+        case TypeKind::UNION: return "union";
+        case TypeKind::ENUM: return "enum";
+        case TypeKind::INPUT_OBJECT: return "input";
+    }
+    return "type";
+}
+
+}  // namespace
+
+bool directive_location_from_name(std::string_view name, DirectiveLocation& out) {
+    for (size_t i = 0; i < sizeof(LOCATION_NAMES) / sizeof(LOCATION_NAMES[0]); i++) {
+        if (name == LOCATION_NAMES[i]) {
+            out = static_cast<DirectiveLocation>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Schema
+
+uint32_t Schema::member_name(const TypeDef& type, uint32_t member) const {
+    uint32_t index = type.first_member + member;
+    switch (type.kind) {
+        case TypeKind::OBJECT:
+        case TypeKind::INTERFACE: return fields_[index].name;
+        case TypeKind::INPUT_OBJECT: return input_values_[index].name;
+        case TypeKind::ENUM: return enum_values_[index].name;
+        default: return NONE;
+    }
+}
+
+uint32_t Schema::find_member(uint32_t type_index, uint32_t name_id) const {
+    const TypeDef& type = types_[type_index];
+    if (type.member_count == 0 || name_id == NONE) return NONE;
+
+    const uint32_t* table = member_table_.data() + type.table_offset;
+    for (uint32_t slot = member_hash(name_id) & type.table_mask;; slot = (slot + 1) & type.table_mask) {
+        uint32_t member = table[slot];
+        if (member == NONE) return NONE;
+        if (member_name(type, member) == name_id) return member;
+    }
+}
+
+const FieldDef* Schema::field(uint32_t type, uint32_t name_id) const {
+    const TypeDef& def = types_[type];
+    if (def.kind != TypeKind::OBJECT && def.kind != TypeKind::INTERFACE) return nullptr;
+    uint32_t member = find_member(type, name_id);
+    return member != NONE ? &fields_[def.first_member + member] : nullptr;
+}
+
+const InputValueDef* Schema::input_field(uint32_t type, uint32_t name_id) const {
+    const TypeDef& def = types_[type];
+    if (def.kind != TypeKind::INPUT_OBJECT) return nullptr;
+    uint32_t member = find_member(type, name_id);
+    return member != NONE ? &input_values_[def.first_member + member] : nullptr;
+}
+
+const EnumValueDef* Schema::enum_value(uint32_t type, uint32_t name_id) const {
+    const TypeDef& def = types_[type];
+    if (def.kind != TypeKind::ENUM) return nullptr;
+    uint32_t member = find_member(type, name_id);
+    return member != NONE ? &enum_values_[def.first_member + member] : nullptr;
+}
+
+// Argument lists are short, so a scan beats a table
+const InputValueDef* Schema::argument(const FieldDef& field, uint32_t name_id) const {
+    for (const InputValueDef& arg : arguments(field)) {
+        if (arg.name == name_id) return &arg;
+    }
+    return nullptr;
+}
+
+const InputValueDef* Schema::argument(const DirectiveDef& directive, uint32_t name_id) const {
+    for (const InputValueDef& arg : arguments(directive)) {
+        if (arg.name == name_id) return &arg;
+    }
+    return nullptr;
+}
+
+SchemaSpan<FieldDef> Schema::fields(uint32_t type) const {
+    const TypeDef& def = types_[type];
+    if (def.kind != TypeKind::OBJECT && def.kind != TypeKind::INTERFACE) return {fields_.data(), 0};
+    return {fields_.data() + def.first_member, def.member_count};
+}
+
+SchemaSpan<InputValueDef> Schema::input_fields(uint32_t type) const {
+    const TypeDef& def = types_[type];
+    if (def.kind != TypeKind::INPUT_OBJECT) return {input_values_.data(), 0};
+    return {input_values_.data() + def.first_member, def.member_count};
+}
+
+SchemaSpan<EnumValueDef> Schema::enum_values(uint32_t type) const {
+    const TypeDef& def = types_[type];
+    if (def.kind != TypeKind::ENUM) return {enum_values_.data(), 0};
+    return {enum_values_.data() + def.first_member, def.member_count};
+}
+
+std::string Schema::type_string(const TypeRef& type) const {
+    std::string out(type.list_depth, '[');
+    out += type.type < types_.size() ? type_name(type.type) : std::string_view("?");
+    for (int level = type.list_depth; level >= 0; level--) {
+        if (type.non_null & (1u << level)) out += '!';
+        if (level > 0) out += ']';
+    }
+    return out;
+}
+
+bool Schema::is_possible_type(uint32_t abstract_type, uint32_t object_type) const {
+    if (abstract_type == object_type) return true;
+    SchemaSpan<uint32_t> possible = possible_types(abstract_type);
+    return std::binary_search(possible.begin(), possible.end(), object_type);
+}
+
+size_t Schema::memory_bytes() const {
+    size_t bytes = sizeof(Schema);
+    bytes += types_.capacity() * sizeof(TypeDef);
+    bytes += fields_.capacity() * sizeof(FieldDef);
+    bytes += input_values_.capacity() * sizeof(InputValueDef);
+    bytes += enum_values_.capacity() * sizeof(EnumValueDef);
+    bytes += directives_.capacity() * sizeof(DirectiveDef);
+    bytes += (type_lists_.capacity() + member_table_.capacity() + type_by_name_.capacity() +
+              directive_by_name_.capacity()) * sizeof(uint32_t);
+    for (size_t i = 0; i < names_.size(); i++) {
+        bytes += sizeof(std::string) + names_.name(static_cast<uint32_t>(i)).size() + 16;
+    }
+    for (const std::string& value : default_values_) bytes += sizeof(std::string) + value.size();
+    return bytes;
+}
+
+// SchemaBuilder
+
+SchemaBuilder::SchemaBuilder() {
+    // Built-in scalars first, at the indices Schema::BUILTIN_* name
+    for (const char* name : {"Int", "Float", "String", "Boolean", "ID"}) {
+        types_.push_back(TypeSpec{name, TypeKind::SCALAR, {}, {}, {}, {}, {}});
+        user_defined_.push_back(false);
+    }
+
+    uint32_t executable_field = location_bit(DirectiveLocation::FIELD) |
+                                location_bit(DirectiveLocation::FRAGMENT_SPREAD) |
+                                location_bit(DirectiveLocation::INLINE_FRAGMENT);
+    for (const char* name : {"skip", "include"}) {
+        DirectiveSpec& directive = define_directive(name);
+        directive.args.push_back(InputValueSpec{"if", TypeRefSpec{"Boolean", 0, 1}, "", false});
+        directive.locations = executable_field;
+    }
+
+    DirectiveSpec& deprecated = define_directive("deprecated");
+    deprecated.args.push_back(InputValueSpec{"reason", TypeRefSpec{"String", 0, 0},
+                                             "\"No longer supported\"", true});
+    deprecated.locations = location_bit(DirectiveLocation::FIELD_DEFINITION) |
+                           location_bit(DirectiveLocation::ARGUMENT_DEFINITION) |
+                           location_bit(DirectiveLocation::INPUT_FIELD_DEFINITION) |
+                           location_bit(DirectiveLocation::ENUM_VALUE);
+
+    DirectiveSpec& specified_by = define_directive("specifiedBy");
+    specified_by.args.push_back(InputValueSpec{"url", TypeRefSpec{"String", 0, 1}, "", false});
+    specified_by.locations = location_bit(DirectiveLocation::SCALAR);
+}
+
+SchemaBuilder::TypeSpec& SchemaBuilder::define_type(std::string_view name, TypeKind kind, bool extension) {
+    for (size_t i = 0; i < types_.size(); i++) {
+        if (types_[i].name != name) continue;
+        if (types_[i].kind != kind) {
+            error("Type " + std::string(name) + " is already defined as " + kind_name(types_[i].kind));
+        } else if (!extension && user_defined_[i] && kind != TypeKind::SCALAR) {
+            error("Type " + std::string(name) + " is defined more than once");
+        } else {
+            if (!extension) user_defined_[i] = true;
+            return types_[i];
+        }
+        scratch_ = TypeSpec{std::string(name), kind, {}, {}, {}, {}, {}};
+        return scratch_;
+    }
+
+    types_.push_back(TypeSpec{std::string(name), kind, {}, {}, {}, {}, {}});
+    user_defined_.push_back(!extension);
+    return types_.back();
+}
+
+SchemaBuilder::DirectiveSpec& SchemaBuilder::define_directive(std::string_view name) {
+    for (DirectiveSpec& directive : directives_) {
+        if (directive.name == name) {
+            directive = DirectiveSpec{std::string(name), {}, 0, false};
+            return directive;
+        }
+    }
+    directives_.push_back(DirectiveSpec{std::string(name), {}, 0, false});
+    return directives_.back();
+}
+
+bool SchemaBuilder::resolve(Schema& schema, const TypeRefSpec& spec, bool input,
+                            std::string_view context, TypeRef& out) {
+    uint32_t index = schema.type_index(spec.name);
+    if (index == Schema::NONE) {
+        error("Unknown type " + spec.name + " in " + std::string(context));
+        return false;
+    }
+    const TypeDef& type = schema.types_[index];
+    if (input ? !type.is_input() : type.kind == TypeKind::INPUT_OBJECT) {
+        error(std::string(context) + " cannot have " + (input ? "output" : "input") + " type " + spec.name);
+        return false;
+    }
+    out = TypeRef{index, spec.list_depth, spec.non_null};
+    return true;
+}
+
+uint32_t SchemaBuilder::add_input_values(Schema& schema, const std::vector<InputValueSpec>& values,
+                                         std::string_view context) {
+    uint32_t first = to_u32(schema.input_values_.size());
+    for (const InputValueSpec& value : values) {
+        InputValueDef def{schema.names_.intern(value.name), TypeRef{}, std::string_view()};
+        resolve(schema, value.type, true, std::string(context) + "(" + value.name + ")", def.type);
+        if (value.has_default) {
+            schema.default_values_.push_back(value.default_value);
+            def.default_value = schema.default_values_.back();
+        }
+        for (uint32_t i = first; i < schema.input_values_.size(); i++) {
+            if (schema.input_values_[i].name == def.name) {
+                error("Duplicate " + value.name + " in " + std::string(context));
+            }
+        }
+        schema.input_values_.push_back(def);
+    }
+    return first;
+}
+
+void SchemaBuilder::build_member_table(Schema& schema, TypeDef& type) {
+    // Power-of-two capacity at most half full, so probes stay short
+    uint32_t capacity = 2;
+    while (capacity < type.member_count * 2) capacity *= 2;
+
+    type.table_offset = to_u32(schema.member_table_.size());
+    type.table_mask = capacity - 1;
+    if (type.member_count == 0) return;
+    schema.member_table_.resize(schema.member_table_.size() + capacity, Schema::NONE);
+
+    uint32_t* table = schema.member_table_.data() + type.table_offset;
+    for (uint32_t member = 0; member < type.member_count; member++) {
+        uint32_t name = schema.member_name(type, member);
+        uint32_t slot = member_hash(name) & type.table_mask;
+        while (table[slot] != Schema::NONE) {
+            if (schema.member_name(type, table[slot]) == name) {
+                error("Duplicate member " + std::string(schema.name(name)) + " in " +
+                      std::string(schema.name(type.name)));
+                break;
+            }
+            slot = (slot + 1) & type.table_mask;
+        }
+        if (table[slot] == Schema::NONE) table[slot] = member;
+    }
+}
+
+std::unique_ptr<Schema> SchemaBuilder::build() {
+    if (!errors_.empty()) return nullptr;
+    std::unique_ptr<Schema> schema(new Schema());
+    Schema& s = *schema;
+    static std::atomic<uint64_t> next_generation{1};
+    s.generation_ = next_generation.fetch_add(1, std::memory_order_relaxed);
+
+    // Type indices follow definition order
+    s.types_.reserve(types_.size());
+    for (const TypeSpec& spec : types_) {
+        uint32_t name = s.names_.intern(spec.name);
+        if (s.type_by_name_.size() <= name) s.type_by_name_.resize(name + 1, Schema::NONE);
+        s.type_by_name_[name] = to_u32(s.types_.size());
+        s.types_.push_back(TypeDef{name, spec.kind, 0, 0, 0, 0, 0, 0, 0, 0});
+    }
+
+    auto root = [&](const std::string& name, const char* fallback, uint32_t& out) {
+        const std::string& wanted = name.empty() ? std::string(fallback) : name;
+        uint32_t index = s.type_index(wanted);
+        if (index != Schema::NONE && s.types_[index].kind == TypeKind::OBJECT) {
+            out = index;
+        } else if (!name.empty()) {
+            error("Root type " + name + " is not a defined object type");
+        }
+    };
+    root(query_type, "Query", s.query_type_);
+    root(mutation_type, "Mutation", s.mutation_type_);
+    root(subscription_type, "Subscription", s.subscription_type_);
+
+    // Members, interfaces and union members
+    std::vector<std::vector<uint32_t>> possible(types_.size());
+    for (uint32_t t = 0; t < types_.size(); t++) {
+        const TypeSpec& spec = types_[t];
+        TypeDef& type = s.types_[t];
+
+        switch (spec.kind) {
+            case TypeKind::OBJECT:
+            case TypeKind::INTERFACE:
+                type.first_member = to_u32(s.fields_.size());
+                type.member_count = to_u32(spec.fields.size());
+                for (const FieldSpec& field : spec.fields) {
+                    std::string context = spec.name + "." + field.name;
+                    FieldDef def{s.names_.intern(field.name), TypeRef{}, 0, 0, field.deprecated};
+                    resolve(s, field.type, false, context, def.type);
+                    def.first_arg = add_input_values(s, field.args, context);
+                    def.arg_count = to_u32(field.args.size());
+                    s.fields_.push_back(def);
+                }
+                break;
+            case TypeKind::INPUT_OBJECT:
+                type.first_member = add_input_values(s, spec.input_fields, spec.name);
+                type.member_count = to_u32(spec.input_fields.size());
+                break;
+            case TypeKind::ENUM:
+                type.first_member = to_u32(s.enum_values_.size());
+                type.member_count = to_u32(spec.enum_values.size());
+                for (const EnumValueSpec& value : spec.enum_values) {
+                    s.enum_values_.push_back(EnumValueDef{s.names_.intern(value.name), value.deprecated});
+                }
+                break;
+            default:
+                break;
+        }
+
+        type.first_interface = to_u32(s.type_lists_.size());
+        for (const std::string& name : spec.interfaces) {
+            uint32_t index = s.type_index(name);
+            if (index == Schema::NONE || s.types_[index].kind != TypeKind::INTERFACE) {
+                error(spec.name + " cannot implement " + name + ": not an interface");
+                continue;
+            }
+            s.type_lists_.push_back(index);
+            if (spec.kind == TypeKind::OBJECT) possible[index].push_back(t);
+        }
+        type.interface_count = to_u32(s.type_lists_.size()) - type.first_interface;
+
+        for (const std::string& name : spec.union_members) {
+            uint32_t index = s.type_index(name);
+            if (index == Schema::NONE || s.types_[index].kind != TypeKind::OBJECT) {
+                error("Union " + spec.name + " member " + name + " is not an object type");
+                continue;
+            }
+            possible[t].push_back(index);
+        }
+    }
+
+    for (uint32_t t = 0; t < types_.size(); t++) {
+        TypeDef& type = s.types_[t];
+        std::vector<uint32_t>& list = possible[t];
+        std::sort(list.begin(), list.end());
+        list.erase(std::unique(list.begin(), list.end()), list.end());
+        type.first_possible = to_u32(s.type_lists_.size());
+        type.possible_count = to_u32(list.size());
+        s.type_lists_.insert(s.type_lists_.end(), list.begin(), list.end());
+        build_member_table(s, type);
+    }
+
+    for (const DirectiveSpec& spec : directives_) {
+        uint32_t name = s.names_.intern(spec.name);
+        DirectiveDef def{name, 0, to_u32(spec.args.size()), spec.locations, spec.repeatable};
+        def.first_arg = add_input_values(s, spec.args, "@" + spec.name);
+        if (s.directive_by_name_.size() <= name) s.directive_by_name_.resize(name + 1, Schema::NONE);
+        s.directive_by_name_[name] = to_u32(s.directives_.size());
+        s.directives_.push_back(def);
+    }
+
+    if (s.query_type_ == Schema::NONE) error("Schema has no query root type");
+    if (!errors_.empty()) return nullptr;
+    return schema;
+}
@@ -0,0 +1,317 @@
+#include <string>
+#include <vector>
+#include "lexer/lexer.h"
+#include "schema/schema.h"
+#include "schema/schema_builder.h"
+
+// Type system definition language (SDL) loader. Parses straight from the
+// token stream into a SchemaBuilder; descriptions and directive
+// applications other than @deprecated are skipped.
+
+namespace {
+
+class SdlReader {
+public:
+    SdlReader(std::string_view source, std::vector<Token> tokens, SchemaBuilder& builder)
+        : source_(source), tokens_(std::move(tokens)), pos_(0), builder_(builder) {}
+
+    bool parse_document() {
+        while (!at_end()) {
+            if (!parse_definition()) return false;
+        }
+        return true;
+    }
+
+private:
+    std::string_view source_;
+    std::vector<Token> tokens_;  // Commas removed
+    size_t pos_;
+    SchemaBuilder& builder_;
+
+    bool at_end() const { return pos_ >= tokens_.size(); }
+    const Token& current() const {
+        static const Token end_token(TokenType::UNKNOWN, std::string_view(), 0);
+        return at_end() ? end_token : tokens_[pos_];
+    }
+    bool check(TokenType type) const { return !at_end() && tokens_[pos_].type == type; }
+    bool check_symbol(char c) const {
+        return check(TokenType::SYMBOL) && tokens_[pos_].value[0] == c;
+    }
+    // Keywords lex as their own token types but are valid names here
+    bool check_name() const {
+        return !at_end() && tokens_[pos_].type <= TokenType::IDENTIFIER;
+    }
+    bool check_word(std::string_view word) const { return check_name() && tokens_[pos_].value == word; }
+
+    bool fail(const std::string& message) {
+        size_t position = at_end() ? source_.size() : tokens_[pos_].position;
+        size_t line = 1;
+        for (size_t i = 0; i < position && i < source_.size(); i++) line += source_[i] == '\n';
+        std::string found = at_end() ? "end of input" : "'" + std::string(tokens_[pos_].value) + "'";
+        builder_.error("Line " + std::to_string(line) + ": " + message + ", found " + found);
+        return false;
+    }
+
+    bool expect(TokenType type, const char* what) {
+        if (!check(type)) return fail(std::string("Expected ") + what);
+        pos_++;
+        return true;
+    }
+
+    bool expect_name(std::string& out) {
+        if (!check_name()) return fail("Expected name");
+        out = std::string(tokens_[pos_++].value);
+        return true;
+    }
+
+    void skip_description() {
+        if (check(TokenType::STRING)) pos_++;
+    }
+
+    // Skips a bracketed group starting at the current opening token
+    bool skip_group() {
+        int depth = 0;
+        do {
+            if (at_end()) return fail("Unbalanced brackets");
+            TokenType type = tokens_[pos_++].type;
+            if (type == TokenType::LEFT_PAREN || type == TokenType::LEFT_BRACKET || type == TokenType::LEFT_BRACE) depth++;
+            if (type == TokenType::RIGHT_PAREN || type == TokenType::RIGHT_BRACKET || type == TokenType::RIGHT_BRACE) depth--;
+        } while (depth > 0);
+        return true;
+    }
+
+    // Directive applications; reports whether @deprecated was among them
+    bool parse_directives(bool* deprecated = nullptr) {
+        while (check(TokenType::DIRECTIVE)) {
+            if (deprecated && tokens_[pos_].value == "@deprecated") *deprecated = true;
+            pos_++;
+            if (check(TokenType::LEFT_PAREN) && !skip_group()) return false;
+        }
+        return true;
+    }
+
+    bool parse_type(SchemaBuilder::TypeRefSpec& out, unsigned level = 0) {
+        if (check(TokenType::LEFT_BRACKET)) {
+            if (level >= TypeRef::MAX_LIST_DEPTH) return fail("List type nested too deeply");
+            pos_++;
+            if (!parse_type(out, level + 1) || !expect(TokenType::RIGHT_BRACKET, "']'")) return false;
+        } else {
+            if (!expect_name(out.name)) return false;
+            out.list_depth = static_cast<uint8_t>(level);
+        }
+        if (check(TokenType::EXCLAMATION)) {
+            pos_++;
+            out.non_null |= static_cast<uint16_t>(1u << level);
+        }
+        return true;
+    }
+
+    // Default values are kept as source text
+    bool parse_value(std::string& out) {
+        if (at_end()) return fail("Expected value");
+        const Token& first = tokens_[pos_];
+        if (check(TokenType::LEFT_BRACKET) || check(TokenType::LEFT_BRACE)) {
+            if (!skip_group()) return false;
+        } else {
+            pos_++;
+        }
+        const Token& last = tokens_[pos_ - 1];
+        out.assign(first.value.data(), last.value.data() + last.value.size() - first.value.data());
+        return true;
+    }
+
+    bool parse_input_value(SchemaBuilder::InputValueSpec& out) {
+        skip_description();
+        if (!expect_name(out.name) || !expect(TokenType::COLON, "':'") || !parse_type(out.type)) return false;
+        if (check_symbol('=')) {
+            pos_++;
+            if (!parse_value(out.default_value)) return false;
+            out.has_default = true;
+        }
+        return parse_directives();
+    }
+
+    bool parse_arguments(std::vector<SchemaBuilder::InputValueSpec>& out) {
+        if (!check(TokenType::LEFT_PAREN)) return true;
+        pos_++;
+        while (!check(TokenType::RIGHT_PAREN)) {
+            out.emplace_back();
+            if (!parse_input_value(out.back())) return false;
+        }
+        pos_++;
+        return true;
+    }
+
+    bool parse_fields(SchemaBuilder::TypeSpec& type) {
+        if (!check(TokenType::LEFT_BRACE)) return true;
+        pos_++;
+        while (!check(TokenType::RIGHT_BRACE)) {
+            SchemaBuilder::FieldSpec field;
+            skip_description();
+            if (!expect_name(field.name) || !parse_arguments(field.args) ||
+                !expect(TokenType::COLON, "':'") || !parse_type(field.type) ||
+                !parse_directives(&field.deprecated)) {
+                return false;
+            }
+            type.fields.push_back(std::move(field));
+        }
+        pos_++;
+        return true;
+    }
+
+    bool parse_input_fields(SchemaBuilder::TypeSpec& type) {
+        if (!check(TokenType::LEFT_BRACE)) return true;
+        pos_++;
+        while (!check(TokenType::RIGHT_BRACE)) {
+            type.input_fields.emplace_back();
+            if (!parse_input_value(type.input_fields.back())) return false;
+        }
+        pos_++;
+        return true;
+    }
+
+    bool parse_enum_values(SchemaBuilder::TypeSpec& type) {
+        if (!check(TokenType::LEFT_BRACE)) return true;
+        pos_++;
+        while (!check(TokenType::RIGHT_BRACE)) {
+            SchemaBuilder::EnumValueSpec value;
+            skip_description();
+            if (!expect_name(value.name) || !parse_directives(&value.deprecated)) return false;
+            type.enum_values.push_back(std::move(value));
+        }
+        pos_++;
+        return true;
+    }
+
+    // implements A & B (a leading '&' is allowed)
+    bool parse_implements(SchemaBuilder::TypeSpec& type) {
+        if (!check_word("implements")) return true;
+        pos_++;
+        if (check_symbol('&')) pos_++;
+        do {
+            type.interfaces.emplace_back();
+            if (!expect_name(type.interfaces.back())) return false;
+        } while (check_symbol('&') && ++pos_);
+        return true;
+    }
+
+    bool parse_schema_definition() {
+        if (!parse_directives()) return false;
+        if (!check(TokenType::LEFT_BRACE)) return true;
+        pos_++;
+        while (!check(TokenType::RIGHT_BRACE)) {
+            std::string operation, type;
+            if (!expect_name(operation) || !expect(TokenType::COLON, "':'") || !expect_name(type)) return false;
+            if (operation == "query") builder_.query_type = type;
+            else if (operation == "mutation") builder_.mutation_type = type;
+            else if (operation == "subscription") builder_.subscription_type = type;
+            else return fail("Unknown operation type " + operation);
+        }
+        pos_++;
+        return true;
+    }
+
+    bool parse_directive_definition() {
+        if (!check(TokenType::DIRECTIVE)) return fail("Expected directive name");
+        std::string_view name = tokens_[pos_++].value.substr(1);
+        SchemaBuilder::DirectiveSpec& directive = builder_.define_directive(name);
+        if (!parse_arguments(directive.args)) return false;
+        if (check_word("repeatable")) {
+            directive.repeatable = true;
+            pos_++;
+        }
+        if (!check_word("on")) return fail("Expected 'on'");
+        pos_++;
+        if (check_symbol('|')) pos_++;
+        do {
+            DirectiveLocation location;
+            if (!check_name() || !directive_location_from_name(tokens_[pos_].value, location)) {
+                return fail("Expected directive location");
+            }
+            directive.locations |= 1u << static_cast<unsigned>(location);
+            pos_++;
+        } while (check_symbol('|') && ++pos_);
+        return true;
+    }
+
+    bool parse_definition() {
+        skip_description();
+        bool extension = false;
+        if (check_word("extend")) {
+            extension = true;
+            pos_++;
+        }
+        if (!check_name()) return fail("Expected definition");
+        std::string_view keyword = tokens_[pos_++].value;
+
+        if (keyword == "schema") return parse_schema_definition();
+        if (keyword == "directive") return parse_directive_definition();
+
+        TypeKind kind;
+        if (keyword == "scalar") kind = TypeKind::SCALAR;
+        else if (keyword == "type") kind = TypeKind::OBJECT;
+        else if (keyword == "interface") kind = TypeKind::INTERFACE;
+        else if (keyword == "union") kind = TypeKind::UNION;
+        else if (keyword == "enum") kind = TypeKind::ENUM;
+        else if (keyword == "input") kind = TypeKind::INPUT_OBJECT;
+        else {
+            pos_--;
+            return fail("Expected definition");
+        }
+
+        std::string name;
+        if (!expect_name(name)) return false;
+        SchemaBuilder::TypeSpec& type = builder_.define_type(name, kind, extension);
+
+        switch (kind) {
+            case TypeKind::OBJECT:
+            case TypeKind::INTERFACE:
+                return parse_implements(type) && parse_directives() && parse_fields(type);
+            case TypeKind::UNION:
+                if (!parse_directives()) return false;
+                if (check_symbol('=')) {
+                    pos_++;
+                    if (check_symbol('|')) pos_++;
+                    do {
+                        type.union_members.emplace_back();
+                        if (!expect_name(type.union_members.back())) return false;
+                    } while (check_symbol('|') && ++pos_);
+                }
+                return true;
+            case TypeKind::ENUM:
+                return parse_directives() && parse_enum_values(type);
+            case TypeKind::INPUT_OBJECT:
+                return parse_directives() && parse_input_fields(type);
+            default:
+                return parse_directives();
+        }
+    }
+};
+
+}  // namespace
+
+std::unique_ptr<Schema> Schema::from_sdl(std::string_view sdl, std::vector<std::string>* errors) {
+    SchemaBuilder builder;
+
+    TokenArena arena;
+    Tokenizer tokenizer;
+    std::pmr::vector<Token>& lexed = tokenizer.tokenize(sdl.data(), sdl.size(), arena);
+    std::vector<Token> tokens;
+    tokens.reserve(lexed.size());
+    bool lexed_ok = true;
+    for (const Token& token : lexed) {
+        if (token.type == TokenType::UNKNOWN) {
+            builder.error("Invalid token at offset " + std::to_string(token.position));
+            lexed_ok = false;
+            break;
+        }
+        if (token.type != TokenType::COMMA) tokens.push_back(token);
+    }
+
+    std::unique_ptr<Schema> schema;
+    if (lexed_ok && SdlReader(sdl, std::move(tokens), builder).parse_document()) {
+        schema = builder.build();
+    }
+    if (errors) *errors = builder.errors();
+    return schema;
+}
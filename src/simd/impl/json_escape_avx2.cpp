@@ -0,0 +1,47 @@
+#include "simd/json_escape_scan.h"
+#include <cstdint>
+#include "simd/simd_detect.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+namespace json_escape_detail {
+
+bool avx2_supported() {
+    static const bool supported = SIMDDetector::hasAVX2();
+    return supported;
+}
+
+size_t find_avx2(const char* text, size_t size) {
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i control = _mm256_set1_epi8(0x1F);
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i));
+        // Unsigned x <= 0x1F is min(x, 0x1F) == x
+        __m256i hits = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote), _mm256_cmpeq_epi8(chunk, backslash)),
+            _mm256_cmpeq_epi8(_mm256_min_epu8(chunk, control), chunk));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(hits));
+        if (mask) return i + __builtin_ctz(mask);
+    }
+    return i + find_sse2(text + i, size - i);
+}
+
+}  // namespace json_escape_detail
+
+#else
+
+namespace json_escape_detail {
+
+// Built without AVX2 support: never selected
+bool avx2_supported() { return false; }
+
+size_t find_avx2(const char* text, size_t size) {
+    return find_sse2(text, size);
+}
+
+}  // namespace json_escape_detail
+
+#endif
@@ -0,0 +1,75 @@
+#include "simd/json_escape_scan.h"
+#include <cstdint>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace json_escape_detail {
+
+namespace {
+
+// Bytes JSON strings can't hold as they are
+struct EscapeTable {
+    bool escape[256];
+    EscapeTable() : escape() {
+        for (int c = 0; c < 0x20; c++) escape[c] = true;
+        escape[static_cast<unsigned char>('"')] = true;
+        escape[static_cast<unsigned char>('\\')] = true;
+    }
+};
+
+const EscapeTable ESCAPES;
+
+}  // namespace
+
+size_t find_scalar(const char* text, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        if (ESCAPES.escape[static_cast<unsigned char>(text[i])]) return i;
+    }
+    return size;
+}
+
+#if defined(__SSE2__)
+
+size_t find_sse2(const char* text, size_t size) {
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1F);
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i));
+        // Unsigned x <= 0x1F is min(x, 0x1F) == x
+        __m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)),
+                                    _mm_cmpeq_epi8(_mm_min_epu8(chunk, control), chunk));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(hits));
+        if (mask) return i + __builtin_ctz(mask);
+    }
+    return i + find_scalar(text + i, size - i);
+}
+
+#else
+
+size_t find_sse2(const char* text, size_t size) {
+    return find_scalar(text, size);
+}
+
+#endif
+
+}  // namespace json_escape_detail
+
+namespace {
+
+using FindEscapeFn = size_t (*)(const char*, size_t);
+
+FindEscapeFn select_find_escape() {
+    return json_escape_detail::avx2_supported() ? json_escape_detail::find_avx2 : json_escape_detail::find_sse2;
+}
+
+const FindEscapeFn find_escape = select_find_escape();
+
+}  // namespace
+
+size_t find_json_escape(const char* text, size_t size) {
+    return find_escape(text, size);
+}
@@ -35,6 +35,41 @@ SIMDType SIMDDetector::detectBestSIMD() {
     return SIMDType::SCALAR;
 }
 
+bool SIMDDetector::hasSHA() {
+#if defined(__x86_64__) || defined(__i386__)
+    uint32_t eax, ebx, ecx, edx;
+    if (__get_cpuid_max(0, nullptr) < 7) return false;
+
+    // SHA-NI code also relies on SSE4.1 shuffles/blends
+    __cpuid(1, eax, ebx, ecx, edx);
+    if (!(ecx & (1 << 19))) return false;
+
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+    return ebx & (1 << 29);
+#else
+    return false;
+#endif
+}
+
+bool SIMDDetector::hasAVX2() {
+#if defined(__x86_64__) || defined(__i386__)
+    uint32_t eax, ebx, ecx, edx;
+    if (__get_cpuid_max(0, nullptr) < 7) return false;
+
+    // The OS must save the YMM state (OSXSAVE, then XCR0 bits 1 and 2)
+    __cpuid(1, eax, ebx, ecx, edx);
+    if (!(ecx & (1 << 27))) return false;
+    uint32_t xcr0_low, xcr0_high;
+    __asm__("xgetbv" : "=a"(xcr0_low), "=d"(xcr0_high) : "c"(0));
+    if ((xcr0_low & 6) != 6) return false;
+
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+    return ebx & (1 << 5);
+#else
+    return false;
+#endif
+}
+
 #include <iostream>
 
 void SIMDDetector::printBestSIMD() {
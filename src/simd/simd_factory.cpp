@@ -1,4 +1,5 @@
 #include "simd/simd_factory.h"
+#include <memory>
 #include "simd/impl/avx2_impl.h"
 #include "simd/impl/avx512_impl.h"
 #include "simd/impl/neon_impl.h"
@@ -25,3 +26,8 @@ SIMDInterface* createBestSIMDImplementation() {
             return new ScalarTextProcessor();
     }
 }
+
+const SIMDInterface& SIMDInterface::getInstance() {
+    static const std::unique_ptr<SIMDInterface> instance(createBestSIMDImplementation());
+    return *instance;
+}
@@ -0,0 +1,263 @@
+#include "validation/cost_analyzer.h"
+#include <algorithm>
+#include "parser/parser_options.h"
+
+namespace {
+
+uint64_t saturating_add(uint64_t a, uint64_t b) {
+    return a > UINT64_MAX - b ? UINT64_MAX : a + b;
+}
+
+uint64_t saturating_mul(uint64_t a, uint64_t b) {
+    if (a == 0 || b == 0) return 0;
+    return a > UINT64_MAX / b ? UINT64_MAX : a * b;
+}
+
+// Non-negative integer literal, saturating; false for anything else
+bool parse_count(std::string_view text, uint64_t& out) {
+    if (text.empty() || text[0] == '-') return false;
+    out = 0;
+    for (char c : text) {
+        if (c < '0' || c > '9') return false;
+        out = saturating_add(saturating_mul(out, 10), static_cast<uint64_t>(c - '0'));
+    }
+    return true;
+}
+
+}  // namespace
+
+CostAnalyzer::CostAnalyzer(CostOptions options)
+    : options_(std::move(options)), exceeded_(false), current_(NONE) {
+    for (const auto& [key, cost] : options_.field_costs) {
+        size_t dot = key.find('.');
+        if (dot == std::string::npos) {
+            name_costs_[key] = cost;
+            continue;
+        }
+        if (!options_.schema) continue;
+        uint32_t type = options_.schema->type_index(std::string_view(key).substr(0, dot));
+        uint32_t field = options_.schema->name_id(std::string_view(key).substr(dot + 1));
+        if (type != Schema::NONE && field != Schema::NONE) {
+            typed_costs_[static_cast<uint64_t>(type) << 32 | field] = cost;
+        }
+    }
+}
+
+void CostAnalyzer::reset(std::string_view operation_name) {
+    operation_name_ = std::string(operation_name);
+    definitions_.clear();
+    fragment_index_.clear();
+    waiting_.clear();
+    exceeded_ = false;
+    current_ = NONE;
+    multipliers_.clear();
+    types_.clear();
+}
+
+uint64_t CostAnalyzer::cost() const {
+    uint64_t result = 0;
+    for (const DefinitionCost& definition : definitions_) {
+        if (definition.operation) result = std::max(result, definition.cost);
+    }
+    return result;
+}
+
+uint64_t CostAnalyzer::analyze(const Document& document, std::string_view operation_name) {
+    reset(operation_name);
+    try {
+        for (const Definition& definition : document.definitions) {
+            if (auto* operation = std::get_if<arena_ptr<OperationDefinition>>(&definition)) {
+                begin_operation(**operation);
+                if ((*operation)->selection_set) walk(*(*operation)->selection_set);
+            } else {
+                const FragmentDefinition& fragment = *std::get<arena_ptr<FragmentDefinition>>(definition);
+                begin_fragment(fragment);
+                if (fragment.selection_set) walk(*fragment.selection_set);
+            }
+            end_definition();
+        }
+    } catch (const ParseLimitExceeded&) {
+        // Over budget; exceeded() is set
+    }
+    return cost();
+}
+
+void CostAnalyzer::walk(const SelectionSet& set) {
+    for (const Selection& selection : set.selections) {
+        if (auto* field = std::get_if<arena_ptr<Field>>(&selection)) {
+            begin_field(**field);
+            if ((*field)->selection_set) walk(*(*field)->selection_set);
+            end_field(**field);
+        } else if (auto* inline_fragment = std::get_if<arena_ptr<InlineFragment>>(&selection)) {
+            begin_inline_fragment(**inline_fragment);
+            if ((*inline_fragment)->selection_set) walk(*(*inline_fragment)->selection_set);
+            end_inline_fragment(**inline_fragment);
+        } else {
+            fragment_spread(*std::get<arena_ptr<FragmentSpread>>(selection));
+        }
+    }
+}
+
+// Definitions
+
+void CostAnalyzer::begin_definition(uint32_t index, uint32_t type) {
+    current_ = index;
+    multipliers_.assign(1, 1);
+    types_.assign(1, type);
+}
+
+void CostAnalyzer::begin_operation(const OperationDefinition& operation) {
+    end_definition();
+    if (!operation_name_.empty() && operation.name != operation_name_) return;
+
+    uint32_t root = Schema::NONE;
+    if (options_.schema) {
+        switch (operation.operation_type) {
+            case OperationType::QUERY: root = options_.schema->query_type(); break;
+            case OperationType::MUTATION: root = options_.schema->mutation_type(); break;
+            case OperationType::SUBSCRIPTION: root = options_.schema->subscription_type(); break;
+        }
+    }
+    definitions_.emplace_back();
+    definitions_.back().operation = true;
+    begin_definition(static_cast<uint32_t>(definitions_.size() - 1), root);
+}
+
+void CostAnalyzer::begin_fragment(const FragmentDefinition& fragment) {
+    end_definition();
+    uint32_t index = fragment_slot(fragment.name);
+    if (definitions_[index].defined) return;  // Duplicate; validation reports it
+    definitions_[index].defined = true;
+    begin_definition(index, type_named(fragment.type_condition));
+}
+
+void CostAnalyzer::end_definition() {
+    if (current_ == NONE) return;
+    DefinitionCost& definition = definitions_[current_];
+    definition.complete = true;
+    uint32_t index = current_;
+    current_ = NONE;
+    if (!definition.operation && definition.unresolved == 0) resolve(index);
+}
+
+uint32_t CostAnalyzer::fragment_slot(std::string_view name) {
+    auto [it, inserted] = fragment_index_.try_emplace(name, static_cast<uint32_t>(definitions_.size()));
+    if (inserted) definitions_.emplace_back();
+    if (waiting_.size() < definitions_.size()) waiting_.resize(definitions_.size());
+    return it->second;
+}
+
+void CostAnalyzer::add(uint32_t index, uint64_t amount) {
+    DefinitionCost& definition = definitions_[index];
+    definition.cost = saturating_add(definition.cost, amount);
+    if (definition.operation && definition.cost > options_.max_cost && !exceeded_) {
+        exceeded_ = true;
+        throw ParseLimitExceeded(ParserLimit::COST, "Query cost exceeds the budget of " +
+                                                        std::to_string(options_.max_cost));
+    }
+}
+
+void CostAnalyzer::resolve(uint32_t fragment) {
+    std::vector<uint32_t> ready{fragment};
+    while (!ready.empty()) {
+        uint32_t index = ready.back();
+        ready.pop_back();
+        definitions_[index].resolved = true;
+
+        // Each waiting spread is settled once, then dropped
+        std::vector<std::pair<uint32_t, uint64_t>> waiters = std::move(waiting_[index]);
+        waiting_[index].clear();
+        for (const auto& [waiter, multiplier] : waiters) {
+            DefinitionCost& definition = definitions_[waiter];
+            definition.unresolved--;
+            add(waiter, saturating_mul(multiplier, definitions_[index].cost));
+            if (!definition.operation && definition.complete && definition.unresolved == 0 && !definition.resolved) {
+                ready.push_back(waiter);
+            }
+        }
+    }
+}
+
+// Selections
+
+void CostAnalyzer::begin_field(const Field& field) {
+    if (current_ == NONE) return;
+    uint32_t parent = types_.back();
+    uint64_t multiplier = multipliers_.back();
+    add(current_, saturating_mul(field_weight(field, parent), multiplier));
+
+    uint32_t type = Schema::NONE;
+    if (options_.schema && parent != Schema::NONE) {
+        const FieldDef* def = options_.schema->field(parent, field.name);
+        if (def) type = def->type.type;
+    }
+    multipliers_.push_back(saturating_mul(multiplier, list_size(field)));
+    types_.push_back(type);
+}
+
+void CostAnalyzer::end_field(const Field&) {
+    if (current_ == NONE || multipliers_.size() < 2) return;
+    multipliers_.pop_back();
+    types_.pop_back();
+}
+
+void CostAnalyzer::begin_inline_fragment(const InlineFragment& fragment) {
+    if (current_ == NONE) return;
+    multipliers_.push_back(multipliers_.back());
+    types_.push_back(fragment.type_condition.empty() ? types_.back() : type_named(fragment.type_condition));
+}
+
+void CostAnalyzer::end_inline_fragment(const InlineFragment&) {
+    if (current_ == NONE || multipliers_.size() < 2) return;
+    multipliers_.pop_back();
+    types_.pop_back();
+}
+
+void CostAnalyzer::fragment_spread(const FragmentSpread& spread) {
+    if (current_ == NONE) return;
+    uint32_t current = current_;
+    uint64_t multiplier = multipliers_.back();
+    uint32_t fragment = fragment_slot(spread.name);
+    if (definitions_[fragment].resolved) {
+        add(current, saturating_mul(multiplier, definitions_[fragment].cost));
+        return;
+    }
+    waiting_[fragment].emplace_back(current, multiplier);
+    definitions_[current].unresolved++;
+}
+
+// Weights
+
+uint64_t CostAnalyzer::field_weight(const Field& field, uint32_t parent_type) const {
+    if (!typed_costs_.empty() && parent_type != Schema::NONE) {
+        uint32_t name = options_.schema->name_id(field.name);
+        auto it = typed_costs_.find(static_cast<uint64_t>(parent_type) << 32 | name);
+        if (it != typed_costs_.end()) return it->second;
+    }
+    if (!name_costs_.empty()) {
+        auto it = name_costs_.find(field.name);
+        if (it != name_costs_.end()) return it->second;
+    }
+    return options_.default_field_cost;
+}
+
+uint64_t CostAnalyzer::list_size(const Field& field) const {
+    uint64_t size = 1;
+    for (const auto& argument : field.arguments) {
+        if (std::find(options_.list_size_arguments.begin(), options_.list_size_arguments.end(), argument->name) ==
+            options_.list_size_arguments.end()) {
+            continue;
+        }
+        uint64_t value;
+        if (auto* literal = std::get_if<IntValue>(&argument->value)) {
+            if (parse_count(literal->value, value)) size = std::max(size, value);
+        } else if (std::holds_alternative<arena_ptr<Variable>>(argument->value)) {
+            size = std::max(size, options_.assumed_list_size);
+        }
+    }
+    return size;
+}
+
+uint32_t CostAnalyzer::type_named(std::string_view name) const {
+    return options_.schema ? options_.schema->type_index(name) : Schema::NONE;
+}
@@ -0,0 +1,195 @@
+#include "validation/depth_analyzer.h"
+#include <algorithm>
+
+namespace {
+
+uint64_t saturating_add(uint64_t a, uint64_t b) {
+    return a > UINT64_MAX - b ? UINT64_MAX : a + b;
+}
+
+uint32_t saturating_add(uint32_t a, uint32_t b) {
+    return a > UINT32_MAX - b ? UINT32_MAX : a + b;
+}
+
+}  // namespace
+
+DepthReport DepthAnalyzer::analyze(const Document& document, std::string_view operation_name) {
+    nodes_.clear();
+    spreads_.clear();
+    set_fields_.clear();
+    fragment_index_.clear();
+
+    for (const Definition& definition : document.definitions) {
+        if (auto* operation = std::get_if<arena_ptr<OperationDefinition>>(&definition)) {
+            uint32_t node = static_cast<uint32_t>(nodes_.size());
+            nodes_.emplace_back();
+            nodes_[node].name = (*operation)->name;
+            nodes_[node].operation = true;
+            nodes_[node].defined = true;
+            if ((*operation)->selection_set) record(node, *(*operation)->selection_set);
+        } else {
+            const FragmentDefinition& fragment = *std::get<arena_ptr<FragmentDefinition>>(definition);
+            uint32_t node = fragment_node(fragment.name);
+            if (nodes_[node].defined) continue;  // Duplicate; validation reports it
+            nodes_[node].defined = true;
+            if (fragment.selection_set) record(node, *fragment.selection_set);
+        }
+    }
+
+    DepthReport report;
+    uint32_t counter = 0;
+    for (uint32_t node = 0; node < nodes_.size(); node++) {
+        if (nodes_[node].index == NONE) strongconnect(node, counter, report);
+    }
+
+    for (const Node& node : nodes_) {
+        if (!node.operation || (!operation_name.empty() && node.name != operation_name)) continue;
+        report.max_depth = std::max(report.max_depth, node.depth);
+        report.field_count = std::max(report.field_count, node.fields);
+        report.max_breadth = std::max(report.max_breadth, node.breadth);
+    }
+    return report;
+}
+
+uint32_t DepthAnalyzer::fragment_node(std::string_view name) {
+    auto [it, inserted] = fragment_index_.try_emplace(name, static_cast<uint32_t>(nodes_.size()));
+    if (inserted) {
+        nodes_.emplace_back();
+        nodes_.back().name = name;
+    }
+    return it->second;
+}
+
+void DepthAnalyzer::record(uint32_t node, const SelectionSet& root) {
+    // Counted locally: fragment_node() may grow nodes_
+    uint32_t local_depth = 0;
+    uint64_t local_fields = 0;
+    uint32_t first_spread = static_cast<uint32_t>(spreads_.size());
+    uint32_t first_set = static_cast<uint32_t>(set_fields_.size());
+
+    set_fields_.push_back(0);
+    walk_stack_.assign(1, WalkFrame{&root, first_set, 0});
+    while (!walk_stack_.empty()) {
+        WalkFrame frame = walk_stack_.back();
+        walk_stack_.pop_back();
+        for (const Selection& selection : frame.set->selections) {
+            if (auto* field = std::get_if<arena_ptr<Field>>(&selection)) {
+                set_fields_[frame.set_index]++;
+                local_fields++;
+                uint32_t depth = frame.depth + 1;
+                local_depth = std::max(local_depth, depth);
+                if ((*field)->selection_set) {
+                    uint32_t set_index = static_cast<uint32_t>(set_fields_.size());
+                    set_fields_.push_back(0);
+                    walk_stack_.push_back(WalkFrame{(*field)->selection_set.get(), set_index, depth});
+                }
+            } else if (auto* inline_fragment = std::get_if<arena_ptr<InlineFragment>>(&selection)) {
+                // Merges into the enclosing selection set
+                if ((*inline_fragment)->selection_set) {
+                    walk_stack_.push_back(WalkFrame{(*inline_fragment)->selection_set.get(), frame.set_index,
+                                                    frame.depth});
+                }
+            } else {
+                const FragmentSpread& spread = *std::get<arena_ptr<FragmentSpread>>(selection);
+                spreads_.push_back(Spread{fragment_node(spread.name), frame.depth, frame.set_index});
+            }
+        }
+    }
+
+    Node& n = nodes_[node];
+    n.local_depth = local_depth;
+    n.local_fields = local_fields;
+    n.first_spread = first_spread;
+    n.spread_count = static_cast<uint32_t>(spreads_.size()) - first_spread;
+    n.first_set = first_set;
+    n.set_count = static_cast<uint32_t>(set_fields_.size()) - first_set;
+}
+
+void DepthAnalyzer::strongconnect(uint32_t root, uint32_t& counter, DepthReport& report) {
+    auto visit = [&](uint32_t node) {
+        nodes_[node].index = nodes_[node].low = counter++;
+        nodes_[node].on_stack = true;
+        tarjan_stack_.push_back(node);
+        call_stack_.emplace_back(node, 0);
+    };
+
+    call_stack_.clear();
+    visit(root);
+    while (!call_stack_.empty()) {
+        uint32_t node = call_stack_.back().first;
+        uint32_t next = call_stack_.back().second;
+        if (next < nodes_[node].spread_count) {
+            call_stack_.back().second++;
+            uint32_t target = spreads_[nodes_[node].first_spread + next].target;
+            if (nodes_[target].index == NONE) {
+                visit(target);
+            } else if (nodes_[target].on_stack) {
+                nodes_[node].low = std::min(nodes_[node].low, nodes_[target].index);
+            }
+            continue;
+        }
+
+        // All spreads explored
+        call_stack_.pop_back();
+        if (nodes_[node].low == nodes_[node].index) close_component(node, report);
+        if (!call_stack_.empty()) {
+            uint32_t parent = call_stack_.back().first;
+            nodes_[parent].low = std::min(nodes_[parent].low, nodes_[node].low);
+        }
+    }
+}
+
+void DepthAnalyzer::close_component(uint32_t root, DepthReport& report) {
+    size_t start = tarjan_stack_.size();
+    do {
+        start--;
+        nodes_[tarjan_stack_[start]].on_stack = false;
+    } while (tarjan_stack_[start] != root);
+
+    bool cyclic = tarjan_stack_.size() - start > 1;
+    if (!cyclic) {
+        const Node& node = nodes_[root];
+        for (uint32_t i = 0; i < node.spread_count; i++) {
+            if (spreads_[node.first_spread + i].target == root) cyclic = true;
+        }
+    }
+
+    if (cyclic) {
+        std::vector<std::string_view> names;
+        for (size_t i = start; i < tarjan_stack_.size(); i++) {
+            Node& node = nodes_[tarjan_stack_[i]];
+            node.cyclic = true;
+            node.depth = DepthReport::UNBOUNDED_DEPTH;
+            node.fields = node.top_fields = node.breadth = DepthReport::UNBOUNDED;
+            names.push_back(node.name);
+        }
+        report.cycles.push_back(std::move(names));
+    } else {
+        // Every spread target is in a component that has already closed
+        evaluate(nodes_[root]);
+    }
+    tarjan_stack_.resize(start);
+}
+
+void DepthAnalyzer::evaluate(Node& node) {
+    uint32_t depth = node.local_depth;
+    uint64_t fields = node.local_fields;
+    uint64_t breadth = 0;
+    set_breadth_.assign(set_fields_.begin() + node.first_set, set_fields_.begin() + node.first_set + node.set_count);
+
+    for (uint32_t i = 0; i < node.spread_count; i++) {
+        const Spread& spread = spreads_[node.first_spread + i];
+        const Node& target = nodes_[spread.target];
+        depth = std::max(depth, saturating_add(spread.depth, target.depth));
+        fields = saturating_add(fields, target.fields);
+        uint64_t& set = set_breadth_[spread.set - node.first_set];
+        set = saturating_add(set, target.top_fields);
+        breadth = std::max(breadth, target.breadth);
+    }
+    for (uint64_t set : set_breadth_) breadth = std::max(breadth, set);
+
+    node.depth = depth;
+    node.fields = fields;
+    node.top_fields = set_breadth_.empty() ? 0 : set_breadth_[0];
+    node.breadth = breadth;
+}
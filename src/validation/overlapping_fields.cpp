@@ -0,0 +1,301 @@
+#include "validation/overlapping_fields.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+bool values_equal(const Value& a, const Value& b);
+
+// Kind and text of a scalar list item, packed or not
+bool scalar_item(const ListValue& list, size_t i, ASTNodeType& kind, std::string_view& text) {
+    if (list.is_packed()) {
+        kind = list.packed_kind;
+        text = list.packed_text(i);
+        return true;
+    }
+    const Value& v = list.values[i];
+    if (auto* iv = std::get_if<IntValue>(&v)) { kind = ASTNodeType::INT_VALUE; text = iv->value; return true; }
+    if (auto* fv = std::get_if<FloatValue>(&v)) { kind = ASTNodeType::FLOAT_VALUE; text = fv->value; return true; }
+    if (auto* sv = std::get_if<StringValue>(&v)) { kind = ASTNodeType::STRING_VALUE; text = sv->value; return true; }
+    if (auto* ev = std::get_if<EnumValue>(&v)) { kind = ASTNodeType::ENUM_VALUE; text = ev->value; return true; }
+    return false;
+}
+
+bool lists_equal(const ListValue& a, const ListValue& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (!a.is_packed() && !b.is_packed()) {
+            if (!values_equal(a.values[i], b.values[i])) return false;
+            continue;
+        }
+        ASTNodeType a_kind, b_kind;
+        std::string_view a_text, b_text;
+        if (!scalar_item(a, i, a_kind, a_text) || !scalar_item(b, i, b_kind, b_text) ||
+            a_kind != b_kind || a_text != b_text) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool objects_equal(const ObjectValue& a, const ObjectValue& b) {
+    if (a.fields.size() != b.fields.size()) return false;
+    for (const ObjectField& field : a.fields) {
+        auto match = std::find_if(b.fields.begin(), b.fields.end(),
+                                  [&](const ObjectField& other) { return other.name == field.name; });
+        if (match == b.fields.end() || !values_equal(field.value, match->value)) return false;
+    }
+    return true;
+}
+
+bool values_equal(const Value& a, const Value& b) {
+    if (a.index() != b.index()) return false;
+    switch (a.index()) {
+        case 0: return std::get<IntValue>(a).value == std::get<IntValue>(b).value;
+        case 1: return std::get<FloatValue>(a).value == std::get<FloatValue>(b).value;
+        case 2: return std::get<StringValue>(a).value == std::get<StringValue>(b).value;
+        case 3: return std::get<BooleanValue>(a).value == std::get<BooleanValue>(b).value;
+        case 4: return true;
+        case 5: return std::get<EnumValue>(a).value == std::get<EnumValue>(b).value;
+        case 6: return lists_equal(*std::get<arena_ptr<ListValue>>(a), *std::get<arena_ptr<ListValue>>(b));
+        case 7: return objects_equal(*std::get<arena_ptr<ObjectValue>>(a), *std::get<arena_ptr<ObjectValue>>(b));
+        case 8: return std::get<arena_ptr<Variable>>(a)->name == std::get<arena_ptr<Variable>>(b)->name;
+    }
+    return false;
+}
+
+// clear() costs the bucket count, so scratch grown by one huge selection
+// set would tax every small one after it
+template <typename Table>
+void clear_scratch(Table& table) {
+    if (table.bucket_count() > 1024) {
+        Table().swap(table);
+    } else {
+        table.clear();
+    }
+}
+
+}  // namespace
+
+OverlapChecker::OverlapChecker(const Schema& schema, std::vector<ValidationError>& errors)
+    : schema_(schema), errors_(errors), schema_names_(static_cast<uint32_t>(schema.names().size())) {}
+
+uint32_t OverlapChecker::schema_name(uint32_t symbol, std::string_view name) const {
+    if (symbol != NO_SYMBOL) return symbol < schema_names_ ? symbol : Schema::NONE;
+    return schema_.name_id(name);
+}
+
+void OverlapChecker::reset() {
+    fragments_.clear();
+    pool_.clear();
+    group_results_.clear();
+}
+
+void OverlapChecker::add_fragment(const FragmentDefinition* definition, uint32_t type) {
+    fragments_.emplace(definition->name, FragmentEntry{definition, type});
+}
+
+void OverlapChecker::collect(const SelectionSet& set, uint32_t parent_type, FieldGroup& out) {
+    for (const Selection& selection : set.selections) {
+        if (auto* field_ptr = std::get_if<arena_ptr<Field>>(&selection)) {
+            const Field& field = **field_ptr;
+            CollectedField collected{field.alias.empty() ? field.name : field.alias, &field, parent_type, TypeRef{}};
+            if (field.name == "__typename") {
+                collected.type = TypeRef{Schema::BUILTIN_STRING, 0, 1};
+            } else if (parent_type != Schema::NONE) {
+                const FieldDef* def = schema_.field(parent_type, schema_name(field.name_id, field.name));
+                if (def) collected.type = def->type;
+            }
+            pool_.push_back(collected);
+            out.push_back(&pool_.back());
+        } else if (auto* inline_ptr = std::get_if<arena_ptr<InlineFragment>>(&selection)) {
+            const InlineFragment& fragment = **inline_ptr;
+            if (!fragment.selection_set) continue;
+            uint32_t type = parent_type;
+            if (!fragment.type_condition.empty()) {
+                type = schema_.type_index(schema_name(fragment.type_condition_id, fragment.type_condition));
+            }
+            collect(*fragment.selection_set, type, out);
+        } else if (auto* spread_ptr = std::get_if<arena_ptr<FragmentSpread>>(&selection)) {
+            // Also stops spread cycles
+            if (!expanded_.insert((*spread_ptr)->name).second) continue;
+            auto it = fragments_.find((*spread_ptr)->name);
+            if (it == fragments_.end() || !it->second.definition->selection_set) continue;
+            collect(*it->second.definition->selection_set, it->second.type, out);
+        }
+    }
+}
+
+void OverlapChecker::group_fields(const FieldGroup& fields, std::vector<FieldGroup>& groups) {
+    groups.clear();
+    clear_scratch(group_index_);
+    for (const CollectedField* field : fields) {
+        auto [it, inserted] = group_index_.try_emplace(field->response_name, groups.size());
+        if (inserted) groups.emplace_back();
+        groups[it->second].push_back(field);
+    }
+    for (FieldGroup& group : groups) {
+        if (group.size() < 2) continue;
+        std::sort(group.begin(), group.end(), [](const CollectedField* a, const CollectedField* b) {
+            return a->field->position < b->field->position;
+        });
+    }
+}
+
+void OverlapChecker::merge_children(const FieldGroup& group, FieldGroup& out) {
+    clear_scratch(expanded_);
+    for (const CollectedField* field : group) {
+        if (field->field->selection_set) collect(*field->field->selection_set, field->type.type, out);
+    }
+}
+
+bool OverlapChecker::same_shape(const TypeRef& a, const TypeRef& b) const {
+    if (a.list_depth != b.list_depth || a.non_null != b.non_null) return false;
+    const TypeDef& ta = schema_.type(a.type);
+    const TypeDef& tb = schema_.type(b.type);
+    if (ta.is_leaf() || tb.is_leaf()) return a.type == b.type;
+    return true;  // Composite shapes are compared through their sub-selections
+}
+
+bool OverlapChecker::same_arguments(const Field& a, const Field& b) const {
+    if (a.arguments.size() != b.arguments.size()) return false;
+    for (const auto& arg : a.arguments) {
+        auto match = std::find_if(b.arguments.begin(), b.arguments.end(),
+                                  [&](const arena_ptr<Argument>& other) { return other->name == arg->name; });
+        if (match == b.arguments.end() || !values_equal(arg->value, (*match)->value)) return false;
+    }
+    return true;
+}
+
+OverlapChecker::Conflict OverlapChecker::memoized(char mode, const FieldGroup& group) {
+    // Groups are sorted and deduplicated, so equal groups have equal keys
+    std::string key(1 + group.size() * sizeof(const Field*), mode);
+    for (size_t i = 0; i < group.size(); i++) {
+        std::memcpy(&key[1 + i * sizeof(const Field*)], &group[i]->field, sizeof(const Field*));
+    }
+    auto [it, inserted] = group_results_.try_emplace(key);
+    // A group reached again while it is being checked (through a spread cycle) reads as mergeable
+    if (!inserted) return it->second;
+
+    Conflict result = mode == 's' ? shape_conflict(group) : parent_conflict(group);
+    group_results_[key] = result;
+    return result;
+}
+
+OverlapChecker::Conflict OverlapChecker::children_conflict(char mode, const FieldGroup& group) {
+    FieldGroup children;
+    merge_children(group, children);
+    if (children.size() < 2) return {};
+
+    std::vector<FieldGroup> groups;
+    group_fields(children, groups);
+    for (const FieldGroup& child : groups) {
+        if (child.size() < 2) continue;
+        Conflict conflict = memoized(mode, child);
+        if (!conflict.reason.empty()) {
+            conflict.reason = "subfields \"" + std::string(child[0]->response_name) + "\" conflict because " +
+                              conflict.reason;
+            return conflict;
+        }
+    }
+    return {};
+}
+
+OverlapChecker::Conflict OverlapChecker::shape_conflict(const FieldGroup& group) {
+    // Same shape is an equivalence: compare everything with the first typed field
+    const CollectedField* first = nullptr;
+    for (const CollectedField* field : group) {
+        if (field->type.type == Schema::NONE) continue;
+        if (!first) {
+            first = field;
+        } else if (!same_shape(first->type, field->type)) {
+            return Conflict{"they return conflicting types \"" + schema_.type_string(first->type) + "\" and \"" +
+                                schema_.type_string(field->type) + "\"",
+                            field->field};
+        }
+    }
+    return children_conflict('s', group);
+}
+
+OverlapChecker::Conflict OverlapChecker::parent_conflict(const FieldGroup& group) {
+    // Fields under distinct object types never apply together; fields under an
+    // abstract (or unknown) parent may apply alongside any of them
+    FieldGroup abstract;
+    std::vector<FieldGroup> objects;
+    std::unordered_map<uint32_t, size_t> object_index;
+    for (const CollectedField* field : group) {
+        if (field->parent == Schema::NONE || schema_.type(field->parent).kind != TypeKind::OBJECT) {
+            abstract.push_back(field);
+            continue;
+        }
+        auto [it, inserted] = object_index.try_emplace(field->parent, objects.size());
+        if (inserted) objects.emplace_back();
+        objects[it->second].push_back(field);
+    }
+
+    if (objects.empty()) return parent_partition_conflict(abstract);
+    for (FieldGroup& partition : objects) {
+        if (!abstract.empty()) {
+            partition.insert(partition.end(), abstract.begin(), abstract.end());
+            std::sort(partition.begin(), partition.end(), [](const CollectedField* a, const CollectedField* b) {
+                return a->field->position < b->field->position;
+            });
+        }
+        Conflict conflict = parent_partition_conflict(partition);
+        if (!conflict.reason.empty()) return conflict;
+    }
+    return {};
+}
+
+OverlapChecker::Conflict OverlapChecker::parent_partition_conflict(const FieldGroup& partition) {
+    if (partition.size() < 2) return {};
+    // Same name and arguments is an equivalence: compare everything with the first field
+    const Field& first = *partition[0]->field;
+    for (size_t i = 1; i < partition.size(); i++) {
+        const Field& field = *partition[i]->field;
+        if (first.name != field.name) {
+            return Conflict{"\"" + std::string(first.name) + "\" and \"" + std::string(field.name) +
+                                "\" are different fields",
+                            &field};
+        }
+        if (!same_arguments(first, field)) return Conflict{"they have differing arguments", &field};
+    }
+    return children_conflict('p', partition);
+}
+
+void OverlapChecker::check(const SelectionSet& set, uint32_t parent_type) {
+    FieldGroup& fields = check_fields_;
+    fields.clear();
+    clear_scratch(expanded_);
+    collect(set, parent_type, fields);
+    if (fields.size() < 2) return;
+
+    // Most selection sets repeat no response name; for small ones a direct scan beats hashing
+    if (fields.size() <= 16) {
+        bool repeated = false;
+        for (size_t i = 0; i < fields.size() && !repeated; i++) {
+            for (size_t j = i + 1; j < fields.size(); j++) {
+                if (fields[i]->response_name == fields[j]->response_name) {
+                    repeated = true;
+                    break;
+                }
+            }
+        }
+        if (!repeated) return;
+    }
+
+    std::vector<FieldGroup>& groups = check_groups_;
+    group_fields(fields, groups);
+
+    // One error per response name
+    for (const FieldGroup& group : groups) {
+        if (group.size() < 2) continue;
+        Conflict conflict = memoized('s', group);
+        if (conflict.reason.empty()) conflict = memoized('p', group);
+        if (conflict.reason.empty()) continue;
+        errors_.push_back(ValidationError{
+            "Fields \"" + std::string(group[0]->response_name) + "\" conflict because " + conflict.reason +
+                ". Use different aliases on the fields to fetch both if this was intentional.",
+            conflict.field->position});
+    }
+}
@@ -0,0 +1,729 @@
+#include "validation/validator.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include "cache/query_cache.h"
+#include "lexer/interner.h"
+#include "parser/flat_parser.h"
+#include "validation/overlapping_fields.h"
+
+namespace {
+
+const char* operation_kind(OperationType type) {
+    switch (type) {
+        case OperationType::MUTATION: return "mutation";
+        case OperationType::SUBSCRIPTION: return "subscription";
+        default: return "query";
+    }
+}
+
+DirectiveLocation operation_location(OperationType type) {
+    switch (type) {
+        case OperationType::MUTATION: return DirectiveLocation::MUTATION;
+        case OperationType::SUBSCRIPTION: return DirectiveLocation::SUBSCRIPTION;
+        default: return DirectiveLocation::QUERY;
+    }
+}
+
+std::string quoted(std::string_view name) {
+    return "\"" + std::string(name) + "\"";
+}
+
+size_t value_position(const Value& value) {
+    return std::visit([](const auto& v) -> size_t {
+        using T = std::decay_t<decltype(v)>;
+        if constexpr (std::is_same_v<T, arena_ptr<ListValue>> || std::is_same_v<T, arena_ptr<ObjectValue>> ||
+                      std::is_same_v<T, arena_ptr<Variable>>) {
+            return v ? v->position : 0;
+        } else {
+            return v.position;
+        }
+    }, value);
+}
+
+// Int literals must fit in a signed 32-bit integer
+bool valid_int(std::string_view text) {
+    std::string digits(text);
+    errno = 0;
+    long long n = std::strtoll(digits.c_str(), nullptr, 10);
+    return errno == 0 && n >= INT32_MIN && n <= INT32_MAX;
+}
+
+}  // namespace
+
+Validator::Validator(const Schema& schema)
+    : schema_(schema),
+      schema_names_(static_cast<uint32_t>(schema.names().size())),
+      typename_id_(schema.name_id("__typename")),
+      spreads_(nullptr),
+      usages_(nullptr),
+      overlap_(new OverlapChecker(schema, errors_)) {}
+
+Validator::~Validator() = default;
+
+void Validator::error(size_t position, std::string message) {
+    errors_.push_back(ValidationError{std::move(message), position});
+}
+
+uint32_t Validator::schema_name(uint32_t symbol, std::string_view name) const {
+    if (symbol != NO_SYMBOL) return symbol < schema_names_ ? symbol : Schema::NONE;
+    return schema_.name_id(name);
+}
+
+uint32_t Validator::fragment_named(const FragmentSpread& spread) const {
+    auto it = fragment_index_.find(spread.name);
+    return it != fragment_index_.end() ? it->second : Schema::NONE;
+}
+
+bool Validator::validate(const Document& document) {
+    errors_.clear();
+    fragments_.clear();
+    fragment_index_.clear();
+    overlap_->reset();
+
+    collect_fragments(document);
+    check_operation_names(document);
+
+    for (uint32_t i = 0; i < fragments_.size(); i++) validate_fragment(i);
+    check_fragment_cycles();
+
+    for (const Definition& definition : document.definitions) {
+        if (auto* operation = std::get_if<arena_ptr<OperationDefinition>>(&definition)) {
+            validate_operation(**operation);
+        }
+    }
+
+    for (const FragmentInfo& fragment : fragments_) {
+        if (!fragment.used) {
+            error(fragment.definition->position,
+                  "Fragment " + quoted(fragment.definition->name) + " is never used.");
+        }
+    }
+    return errors_.empty();
+}
+
+bool Validator::validate(const CacheEntry& entry) {
+    uint64_t generation = schema_.generation();
+    if (entry.validated_for(generation)) {
+        errors_.clear();
+        return true;
+    }
+
+    bool valid;
+    if (!entry.is_warm()) {
+        valid = validate(*entry.ast);
+    } else {
+        // Warm entries only carry the flat view; the rules walk a tree
+        // expanded from it, without lexing or parsing the text again
+        Interner symbols(&schema_.names());
+        ASTArena arena(entry.text().size() * 16 + 1024);
+        auto document = FlatExpander(entry.flat, arena, &symbols).expand();
+        if (!document) {
+            errors_.clear();
+            error(0, "Cached document is empty.");
+            return false;
+        }
+        valid = validate(*document);
+    }
+    if (valid) entry.validated_generation.store(generation, std::memory_order_release);
+    return valid;
+}
+
+// Definitions
+
+void Validator::collect_fragments(const Document& document) {
+    for (const Definition& definition : document.definitions) {
+        auto* fragment_ptr = std::get_if<arena_ptr<FragmentDefinition>>(&definition);
+        if (!fragment_ptr) continue;
+        const FragmentDefinition& fragment = **fragment_ptr;
+
+        uint32_t index = static_cast<uint32_t>(fragments_.size());
+        if (!fragment_index_.emplace(fragment.name, index).second) {
+            error(fragment.position, "There can be only one fragment named " + quoted(fragment.name) + ".");
+            continue;
+        }
+
+        // Fragments on composite types
+        uint32_t type = schema_.type_index(schema_name(fragment.type_condition_id, fragment.type_condition));
+        if (type == Schema::NONE) {
+            error(fragment.position, "Unknown type " + quoted(fragment.type_condition) + ".");
+        } else if (!schema_.type(type).is_composite()) {
+            error(fragment.position, "Fragment " + quoted(fragment.name) + " cannot condition on non composite type " +
+                                         quoted(fragment.type_condition) + ".");
+            type = Schema::NONE;
+        }
+        fragments_.push_back(FragmentInfo{&fragment, type, {}, {}, false, 0});
+        overlap_->add_fragment(&fragment, type);
+    }
+}
+
+void Validator::check_operation_names(const Document& document) {
+    size_t operations = 0;
+    const OperationDefinition* anonymous = nullptr;
+    names_seen_.clear();
+    for (const Definition& definition : document.definitions) {
+        auto* operation_ptr = std::get_if<arena_ptr<OperationDefinition>>(&definition);
+        if (!operation_ptr) continue;
+        const OperationDefinition& operation = **operation_ptr;
+        operations++;
+        if (operation.name.empty()) {
+            anonymous = &operation;
+        } else if (!names_seen_.emplace(operation.name, operation.position).second) {
+            error(operation.position, "There can be only one operation named " + quoted(operation.name) + ".");
+        }
+    }
+    if (anonymous && operations > 1) {
+        error(anonymous->position, "This anonymous operation must be the only defined operation.");
+    }
+}
+
+void Validator::validate_fragment(uint32_t index) {
+    FragmentInfo& fragment = fragments_[index];
+    spreads_ = &fragment.spreads;
+    usages_ = &fragment.usages;
+    check_directives(fragment.definition->directives, DirectiveLocation::FRAGMENT_DEFINITION);
+    if (fragment.definition->selection_set) {
+        visit_selection_set(*fragment.definition->selection_set, fragment.type);
+    }
+    spreads_ = nullptr;
+    usages_ = nullptr;
+}
+
+void Validator::check_fragment_cycles() {
+    // Iterative DFS over spread edges; a spread back into an in-progress fragment closes a cycle
+    struct Frame {
+        uint32_t fragment;
+        size_t next;
+    };
+    std::vector<Frame> stack;
+    for (uint32_t root = 0; root < fragments_.size(); root++) {
+        if (fragments_[root].state != 0) continue;
+        stack.push_back(Frame{root, 0});
+        fragments_[root].state = 1;
+        while (!stack.empty()) {
+            Frame& frame = stack.back();
+            FragmentInfo& fragment = fragments_[frame.fragment];
+            if (frame.next == fragment.spreads.size()) {
+                fragment.state = 2;
+                stack.pop_back();
+                continue;
+            }
+            uint32_t target = fragment.spreads[frame.next++];
+            if (fragments_[target].state == 1) {
+                error(fragment.definition->position,
+                      "Cannot spread fragment " + quoted(fragments_[target].definition->name) + " within itself.");
+            } else if (fragments_[target].state == 0) {
+                fragments_[target].state = 1;
+                stack.push_back(Frame{target, 0});
+            }
+        }
+    }
+}
+
+void Validator::reach_fragments(const std::vector<uint32_t>& spreads) {
+    // reached_ doubles as the work list; state 3 marks "reached by this operation"
+    for (uint32_t target : spreads) {
+        if (fragments_[target].state == 3) continue;
+        fragments_[target].state = 3;
+        reached_.push_back(target);
+    }
+}
+
+void Validator::validate_operation(const OperationDefinition& operation) {
+    uint32_t root = Schema::NONE;
+    switch (operation.operation_type) {
+        case OperationType::QUERY: root = schema_.query_type(); break;
+        case OperationType::MUTATION: root = schema_.mutation_type(); break;
+        case OperationType::SUBSCRIPTION: root = schema_.subscription_type(); break;
+    }
+    if (root == Schema::NONE) {
+        error(operation.position, std::string("Schema is not configured to execute ") +
+                                      operation_kind(operation.operation_type) + " operation.");
+    }
+
+    std::vector<uint32_t> spreads;
+    std::vector<VariableUsage> usages;
+    spreads_ = &spreads;
+    usages_ = &usages;
+
+    // Variable definitions: unique, input types, valid defaults
+    names_seen_.clear();
+    for (const auto& definition : operation.variable_definitions) {
+        const Variable& variable = *definition->variable;
+        if (!names_seen_.emplace(variable.name, definition->position).second) {
+            error(definition->position, "There can be only one variable named \"$" + std::string(variable.name) + "\".");
+        }
+        TypeRef type;
+        if (definition->type && resolve_type(*definition->type, type)) {
+            if (!schema_.type(type.type).is_input()) {
+                error(definition->position, "Variable \"$" + std::string(variable.name) +
+                                                "\" cannot be non-input type \"" + schema_.type_string(type) + "\".");
+            } else if (definition->default_value) {
+                // Defaults are constants: a variable here is reported as undefined
+                std::vector<VariableUsage>* saved = usages_;
+                std::vector<VariableUsage> ignored;
+                usages_ = &ignored;
+                check_value(*definition->default_value, type, false);
+                usages_ = saved;
+                for (const VariableUsage& usage : ignored) {
+                    error(usage.variable->position, "Variable \"$" + std::string(usage.variable->name) +
+                                                        "\" cannot be used in a default value.");
+                }
+            }
+        }
+        check_directives(definition->directives, DirectiveLocation::VARIABLE_DEFINITION);
+    }
+
+    check_directives(operation.directives, operation_location(operation.operation_type));
+    if (operation.selection_set) {
+        visit_selection_set(*operation.selection_set, root);
+        if (operation.operation_type == OperationType::SUBSCRIPTION) check_subscription_root(operation);
+    }
+    spreads_ = nullptr;
+    usages_ = nullptr;
+
+    // Fragments reached from this operation, transitively
+    reached_.clear();
+    reach_fragments(spreads);
+    for (size_t i = 0; i < reached_.size(); i++) {
+        FragmentInfo& fragment = fragments_[reached_[i]];
+        fragment.used = true;
+        usages.insert(usages.end(), fragment.usages.begin(), fragment.usages.end());
+        reach_fragments(fragment.spreads);
+    }
+    for (uint32_t index : reached_) fragments_[index].state = 2;
+
+    check_variable_usages(operation, usages);
+}
+
+void Validator::check_subscription_root(const OperationDefinition& operation) {
+    // Root fields of the subscription, through fragments (each fragment once)
+    size_t fields = 0;
+    std::vector<const SelectionSet*> sets{operation.selection_set.get()};
+    std::vector<uint32_t> seen;
+    while (!sets.empty()) {
+        const SelectionSet* set = sets.back();
+        sets.pop_back();
+        for (const Selection& selection : set->selections) {
+            if (auto* field = std::get_if<arena_ptr<Field>>(&selection)) {
+                if ((*field)->name != "__typename") fields++;
+            } else if (auto* inline_fragment = std::get_if<arena_ptr<InlineFragment>>(&selection)) {
+                if ((*inline_fragment)->selection_set) sets.push_back((*inline_fragment)->selection_set.get());
+            } else if (auto* spread = std::get_if<arena_ptr<FragmentSpread>>(&selection)) {
+                uint32_t index = fragment_named(**spread);
+                if (index == Schema::NONE || std::find(seen.begin(), seen.end(), index) != seen.end()) continue;
+                seen.push_back(index);
+                if (fragments_[index].definition->selection_set) {
+                    sets.push_back(fragments_[index].definition->selection_set.get());
+                }
+            }
+        }
+    }
+    if (fields != 1) {
+        error(operation.position, operation.name.empty()
+                                      ? std::string("Anonymous Subscription must select only one top level field.")
+                                      : "Subscription " + quoted(operation.name) +
+                                            " must select only one top level field.");
+    }
+}
+
+// Selections
+
+void Validator::visit_selection_set(const SelectionSet& set, uint32_t parent_type) {
+    if (parent_type != Schema::NONE) overlap_->check(set, parent_type);
+
+    for (const Selection& selection : set.selections) {
+        if (auto* field = std::get_if<arena_ptr<Field>>(&selection)) {
+            visit_field(**field, parent_type);
+        } else if (auto* spread = std::get_if<arena_ptr<FragmentSpread>>(&selection)) {
+            visit_fragment_spread(**spread, parent_type);
+        } else if (auto* inline_fragment = std::get_if<arena_ptr<InlineFragment>>(&selection)) {
+            visit_inline_fragment(**inline_fragment, parent_type);
+        }
+    }
+}
+
+void Validator::visit_field(const Field& field, uint32_t parent_type) {
+    check_directives(field.directives, DirectiveLocation::FIELD);
+
+    const FieldDef* def = nullptr;
+    uint32_t field_type = Schema::NONE;
+    bool leaf = false;
+
+    if (parent_type != Schema::NONE) {
+        uint32_t name = schema_name(field.name_id, field.name);
+        if ((name != Schema::NONE && name == typename_id_) || field.name == "__typename") {
+            leaf = true;
+        } else if ((field.name == "__schema" || field.name == "__type") && parent_type == schema_.query_type()) {
+            // Introspection: not modeled, so the sub-selection is not checked against types
+        } else if (!(def = schema_.field(parent_type, name))) {
+            error(field.position, "Cannot query field " + quoted(field.name) + " on type " +
+                                      quoted(schema_.type_name(parent_type)) + ".");
+        } else {
+            field_type = def->type.type;
+            leaf = schema_.type(field_type).is_leaf();
+        }
+    }
+
+    if (def) {
+        check_arguments(field.arguments, *def, field.name, field.position);
+    } else {
+        // Unknown field: still collect variable usages from the arguments
+        for (const auto& argument : field.arguments) check_value(argument->value, TypeRef{}, false);
+    }
+
+    // Leaf field selections
+    if (leaf && field.selection_set) {
+        error(field.position, "Field " + quoted(field.name) + " must not have a selection since type " +
+                                  quoted(def ? schema_.type_string(def->type) : "String!") + " has no subfields.");
+    } else if (def && !leaf && !field.selection_set) {
+        error(field.position, "Field " + quoted(field.name) + " of type " + quoted(schema_.type_string(def->type)) +
+                                  " must have a selection of subfields.");
+    }
+
+    if (field.selection_set) visit_selection_set(*field.selection_set, leaf ? Schema::NONE : field_type);
+}
+
+void Validator::visit_fragment_spread(const FragmentSpread& spread, uint32_t parent_type) {
+    check_directives(spread.directives, DirectiveLocation::FRAGMENT_SPREAD);
+    uint32_t index = fragment_named(spread);
+    if (index == Schema::NONE) {
+        error(spread.position, "Unknown fragment " + quoted(spread.name) + ".");
+        return;
+    }
+    if (spreads_) spreads_->push_back(index);
+    check_spread_possible(fragments_[index].type, parent_type, spread.position, spread.name);
+}
+
+void Validator::visit_inline_fragment(const InlineFragment& fragment, uint32_t parent_type) {
+    check_directives(fragment.directives, DirectiveLocation::INLINE_FRAGMENT);
+    uint32_t type = parent_type;
+    if (!fragment.type_condition.empty()) {
+        type = schema_.type_index(schema_name(fragment.type_condition_id, fragment.type_condition));
+        if (type == Schema::NONE) {
+            error(fragment.position, "Unknown type " + quoted(fragment.type_condition) + ".");
+        } else if (!schema_.type(type).is_composite()) {
+            error(fragment.position, "Fragment cannot condition on non composite type " +
+                                         quoted(fragment.type_condition) + ".");
+            type = Schema::NONE;
+        } else {
+            check_spread_possible(type, parent_type, fragment.position, {});
+        }
+    }
+    if (fragment.selection_set) visit_selection_set(*fragment.selection_set, type);
+}
+
+void Validator::check_spread_possible(uint32_t fragment_type, uint32_t parent_type, size_t position,
+                                      std::string_view fragment_name) {
+    if (fragment_type == Schema::NONE || parent_type == Schema::NONE || fragment_type == parent_type) return;
+
+    const TypeDef& a = schema_.type(fragment_type);
+    const TypeDef& b = schema_.type(parent_type);
+    bool possible;
+    if (!a.is_abstract()) {
+        possible = schema_.is_possible_type(parent_type, fragment_type);
+    } else if (!b.is_abstract()) {
+        possible = schema_.is_possible_type(fragment_type, parent_type);
+    } else {
+        // Two abstract types: some object type must belong to both
+        possible = false;
+        for (uint32_t object : schema_.possible_types(fragment_type)) {
+            if (schema_.is_possible_type(parent_type, object)) {
+                possible = true;
+                break;
+            }
+        }
+    }
+    if (possible) return;
+
+    std::string subject = fragment_name.empty() ? "Fragment" : "Fragment " + quoted(fragment_name);
+    error(position, subject + " cannot be spread here as objects of type " + quoted(schema_.type_name(parent_type)) +
+                        " can never be of type " + quoted(schema_.type_name(fragment_type)) + ".");
+}
+
+// Arguments, directives and values
+
+template <typename Args, typename Owner>
+void Validator::check_arguments(const Args& arguments, const Owner& owner, std::string_view owner_name,
+                                size_t position) {
+    for (size_t i = 0; i < arguments.size(); i++) {
+        const Argument& argument = *arguments[i];
+        for (size_t j = 0; j < i; j++) {
+            if (arguments[j]->name == argument.name) {
+                error(argument.position, "There can be only one argument named " + quoted(argument.name) + ".");
+                break;
+            }
+        }
+
+        const InputValueDef* def = schema_.argument(owner, schema_name(argument.name_id, argument.name));
+        if (!def) {
+            error(argument.position, "Unknown argument " + quoted(argument.name) + " on " +
+                                         std::string(owner_name) + ".");
+            check_value(argument.value, TypeRef{}, false);
+            continue;
+        }
+        check_value(argument.value, def->type, def->has_default());
+    }
+
+    // Required arguments
+    for (const InputValueDef& def : schema_.arguments(owner)) {
+        if (!def.type.is_non_null() || def.has_default()) continue;
+        bool provided = false;
+        for (const auto& argument : arguments) {
+            if (schema_name(argument->name_id, argument->name) == def.name) {
+                provided = true;
+                break;
+            }
+        }
+        if (!provided) {
+            error(position, std::string(owner_name) + " argument " + quoted(schema_.name(def.name)) + " of type " +
+                                quoted(schema_.type_string(def.type)) + " is required, but it was not provided.");
+        }
+    }
+}
+
+void Validator::check_directives(const std::vector<arena_ptr<Directive>>& directives, DirectiveLocation location) {
+    for (size_t i = 0; i < directives.size(); i++) {
+        const Directive& directive = *directives[i];
+        const DirectiveDef* def = schema_.find_directive(schema_name(directive.name_id, directive.name));
+        if (!def) {
+            error(directive.position, "Unknown directive \"@" + std::string(directive.name) + "\".");
+            for (const auto& argument : directive.arguments) check_value(argument->value, TypeRef{}, false);
+            continue;
+        }
+        if (!def->allows(location)) {
+            error(directive.position, "Directive \"@" + std::string(directive.name) + "\" may not be used here.");
+        }
+        if (!def->repeatable) {
+            for (size_t j = 0; j < i; j++) {
+                if (directives[j]->name == directive.name) {
+                    error(directive.position, "The directive \"@" + std::string(directive.name) +
+                                                  "\" can only be used once at this location.");
+                    break;
+                }
+            }
+        }
+        check_arguments(directive.arguments, *def, "directive \"@" + std::string(directive.name) + "\"",
+                        directive.position);
+    }
+}
+
+void Validator::check_value(const Value& value, TypeRef expected, bool location_default) {
+    if (auto* variable = std::get_if<arena_ptr<Variable>>(&value)) {
+        if (usages_) usages_->push_back(VariableUsage{variable->get(), expected, location_default});
+        return;
+    }
+
+    bool known = expected.type != Schema::NONE;
+    if (std::holds_alternative<NullValue>(value)) {
+        if (known && expected.is_non_null()) {
+            error(value_position(value), "Expected value of type " + quoted(schema_.type_string(expected)) +
+                                             ", found null.");
+        }
+        return;
+    }
+
+    if (auto* list_ptr = std::get_if<arena_ptr<ListValue>>(&value)) {
+        const ListValue& list = **list_ptr;
+        if (known && !expected.is_list()) {
+            error(list.position, "Expected value of type " + quoted(schema_.type_string(expected)) + ", found a list.");
+            known = false;
+        }
+        TypeRef item = known ? expected.item() : TypeRef{};
+        if (list.is_packed() && !known) return;  // Packed lists hold no variables
+        list.for_each([&](const Value& v) { check_value(v, item, false); });
+        return;
+    }
+
+    // Input coercion: a single value where a list is expected is a one-item list
+    while (known && expected.is_list()) expected = expected.item();
+
+    if (auto* object_ptr = std::get_if<arena_ptr<ObjectValue>>(&value)) {
+        const ObjectValue& object = **object_ptr;
+        if (known && schema_.type(expected.type).kind != TypeKind::INPUT_OBJECT) {
+            error(object.position, "Expected value of type " + quoted(schema_.type_string(expected)) +
+                                       ", found an object.");
+            known = false;
+        }
+        for (size_t i = 0; i < object.fields.size(); i++) {
+            const ObjectField& field = object.fields[i];
+            for (size_t j = 0; j < i; j++) {
+                if (object.fields[j].name == field.name) {
+                    error(field.position, "There can be only one input field named " + quoted(field.name) + ".");
+                    break;
+                }
+            }
+            const InputValueDef* def = known ? schema_.input_field(expected.type, schema_name(field.name_id, field.name))
+                                             : nullptr;
+            if (known && !def) {
+                error(field.position, "Field " + quoted(field.name) + " is not defined by type " +
+                                          quoted(schema_.type_name(expected.type)) + ".");
+            }
+            check_value(field.value, def ? def->type : TypeRef{}, def && def->has_default());
+        }
+        if (!known) return;
+        for (const InputValueDef& def : schema_.input_fields(expected.type)) {
+            if (!def.type.is_non_null() || def.has_default()) continue;
+            bool provided = false;
+            for (const ObjectField& field : object.fields) {
+                if (schema_name(field.name_id, field.name) == def.name) {
+                    provided = true;
+                    break;
+                }
+            }
+            if (!provided) {
+                error(object.position, "Field \"" + std::string(schema_.type_name(expected.type)) + "." +
+                                           std::string(schema_.name(def.name)) + "\" of required type " +
+                                           quoted(schema_.type_string(def.type)) + " was not provided.");
+            }
+        }
+        return;
+    }
+
+    if (known) check_scalar_literal(value, expected.type);
+}
+
+void Validator::check_scalar_literal(const Value& value, uint32_t type) {
+    const TypeDef& def = schema_.type(type);
+    bool valid = true;
+    if (def.kind == TypeKind::ENUM) {
+        auto* enum_value = std::get_if<EnumValue>(&value);
+        valid = enum_value && schema_.enum_value(type, schema_.name_id(enum_value->value));
+    } else if (def.kind != TypeKind::SCALAR) {
+        valid = false;  // Input object expected
+    } else if (type == Schema::BUILTIN_INT) {
+        auto* int_value = std::get_if<IntValue>(&value);
+        valid = int_value && valid_int(int_value->value);
+    } else if (type == Schema::BUILTIN_FLOAT) {
+        valid = std::holds_alternative<IntValue>(value) || std::holds_alternative<FloatValue>(value);
+    } else if (type == Schema::BUILTIN_STRING) {
+        valid = std::holds_alternative<StringValue>(value);
+    } else if (type == Schema::BUILTIN_BOOLEAN) {
+        valid = std::holds_alternative<BooleanValue>(value);
+    } else if (type == Schema::BUILTIN_ID) {
+        valid = std::holds_alternative<StringValue>(value) || std::holds_alternative<IntValue>(value);
+    }
+    // Custom scalars accept any literal
+
+    if (!valid) {
+        error(value_position(value), "Expected value of type " + quoted(schema_.type_name(type)) + ".");
+    }
+}
+
+bool Validator::resolve_type(const ASTNode& node, TypeRef& out, unsigned level) {
+    if (level > TypeRef::MAX_LIST_DEPTH) {
+        error(0, "Type is nested too deeply.");
+        return false;
+    }
+    switch (node.type) {
+        case ASTNodeType::NON_NULL_TYPE: {
+            const NonNullType& non_null = std::get<NonNullType>(node.data);
+            out.non_null |= static_cast<uint16_t>(1u << level);
+            return non_null.type && resolve_type(*non_null.type, out, level);
+        }
+        case ASTNodeType::LIST_TYPE: {
+            const ListType& list = std::get<ListType>(node.data);
+            return list.type && resolve_type(*list.type, out, level + 1);
+        }
+        default: {
+            const NamedType& named = std::get<NamedType>(node.data);
+            out.type = schema_.type_index(schema_name(named.name_id, named.name));
+            out.list_depth = static_cast<uint8_t>(level);
+            if (out.type == Schema::NONE) {
+                error(named.position, "Unknown type " + quoted(named.name) + ".");
+                return false;
+            }
+            return true;
+        }
+    }
+}
+
+// Variables
+
+bool Validator::allowed_position(TypeRef variable_type, bool variable_default, const VariableUsage& usage) const {
+    TypeRef location = usage.type;
+    // A nullable variable may feed a non-null location that has a default, or
+    // when the variable itself has a non-null default
+    if (location.is_non_null() && !variable_type.is_non_null()) {
+        if (!variable_default && !usage.location_default) return false;
+        location = location.nullable();
+    }
+
+    // Compare wrapper by wrapper: each non-null location needs a non-null
+    // variable, lists must line up, and the named types must match
+    while (true) {
+        if (location.is_non_null()) {
+            if (!variable_type.is_non_null()) return false;
+            location = location.nullable();
+            variable_type = variable_type.nullable();
+            continue;
+        }
+        if (variable_type.is_non_null()) {
+            variable_type = variable_type.nullable();
+            continue;
+        }
+        if (location.is_list() || variable_type.is_list()) {
+            if (!location.is_list() || !variable_type.is_list()) return false;
+            location = location.item();
+            variable_type = variable_type.item();
+            continue;
+        }
+        if (location.type == variable_type.type) return true;
+        // An object variable can't satisfy an abstract input; only identical named types match
+        return false;
+    }
+}
+
+void Validator::check_variable_usages(const OperationDefinition& operation, const std::vector<VariableUsage>& usages) {
+    const auto& definitions = operation.variable_definitions;
+    std::vector<bool> used(definitions.size(), false);
+    std::vector<TypeRef> types(definitions.size());
+    std::vector<bool> resolved(definitions.size(), false);
+
+    std::string operation_label = operation.name.empty() ? std::string() : " by operation " + quoted(operation.name);
+
+    for (const VariableUsage& usage : usages) {
+        size_t index = definitions.size();
+        for (size_t i = 0; i < definitions.size(); i++) {
+            if (definitions[i]->variable->name == usage.variable->name) {
+                index = i;
+                break;
+            }
+        }
+        if (index == definitions.size()) {
+            error(usage.variable->position, "Variable \"$" + std::string(usage.variable->name) +
+                                                "\" is not defined" + operation_label + ".");
+            continue;
+        }
+        used[index] = true;
+        if (usage.type.type == Schema::NONE || !definitions[index]->type) continue;
+
+        if (!resolved[index]) {
+            // Resolve quietly: unknown types were reported with the definition
+            size_t errors = errors_.size();
+            resolved[index] = resolve_type(*definitions[index]->type, types[index]);
+            errors_.resize(errors);
+            if (!resolved[index]) {
+                types[index].type = Schema::NONE;
+                resolved[index] = true;
+            }
+        }
+        if (types[index].type == Schema::NONE) continue;
+
+        const Value* default_value = definitions[index]->default_value.get();
+        bool has_default = default_value && !std::holds_alternative<NullValue>(*default_value);
+        if (!allowed_position(types[index], has_default, usage)) {
+            error(usage.variable->position, "Variable \"$" + std::string(usage.variable->name) + "\" of type " +
+                                                quoted(schema_.type_string(types[index])) +
+                                                " used in position expecting type " +
+                                                quoted(schema_.type_string(usage.type)) + ".");
+        }
+    }
+
+    for (size_t i = 0; i < definitions.size(); i++) {
+        if (!used[i]) {
+            error(definitions[i]->position, "Variable \"$" + std::string(definitions[i]->variable->name) +
+                                                "\" is never used" + operation_label + ".");
+        }
+    }
+}
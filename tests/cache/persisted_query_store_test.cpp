@@ -0,0 +1,159 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include "cache/persisted_query_store.h"
+#include "cache/sha256.h"
+
+TEST(Sha256Test, KnownVectors) {
+    EXPECT_EQ(sha256_to_hex(sha256("")),
+              "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+    EXPECT_EQ(sha256_to_hex(sha256("abc")),
+              "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    EXPECT_EQ(sha256_to_hex(sha256("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq")),
+              "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+    EXPECT_EQ(sha256_to_hex(sha256(std::string(1000000, 'a'))),
+              "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+
+    Sha256Digest digest;
+    EXPECT_TRUE(sha256_from_hex("BA7816BF8F01CFEA414140DE5DAE2223B00361A396177A9CB410FF61F20015AD", digest));
+    EXPECT_EQ(digest, sha256("abc"));
+    EXPECT_FALSE(sha256_from_hex("ba7816bf", digest));
+    EXPECT_FALSE(sha256_from_hex(std::string(64, 'g'), digest));
+}
+
+TEST(Sha256Test, ShaNiMatchesScalar) {
+    if (!sha256_detail::shani_supported()) GTEST_SKIP() << "SHA-NI not available";
+
+    std::mt19937 rng(42);
+    std::vector<uint8_t> data(64 * 9);
+    for (auto& b : data) b = static_cast<uint8_t>(rng());
+
+    for (size_t blocks = 1; blocks <= 9; blocks++) {
+        uint32_t a[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+        uint32_t b[8];
+        std::memcpy(b, a, sizeof(a));
+        sha256_detail::compress_scalar(a, data.data(), blocks);
+        sha256_detail::compress_shani(b, data.data(), blocks);
+        EXPECT_EQ(0, std::memcmp(a, b, sizeof(a))) << blocks << " blocks";
+    }
+}
+
+TEST(PersistedQueryStoreTest, RegisterAndLookup) {
+    QueryCache cache;
+    PersistedQueryStore apq(cache);
+    std::string query = "query Me { me { id name } }";
+    std::string hash = sha256_to_hex(sha256(query));
+
+    EXPECT_EQ(apq.lookup(hash).status, PersistedQueryStore::Status::NOT_FOUND);
+    EXPECT_EQ(apq.lookup("not-a-hash").status, PersistedQueryStore::Status::INVALID_HASH);
+    EXPECT_EQ(apq.register_query(hash, query + " ").status, PersistedQueryStore::Status::HASH_MISMATCH);
+
+    auto registered = apq.register_query(hash, query);
+    ASSERT_EQ(registered.status, PersistedQueryStore::Status::OK);
+    ASSERT_TRUE(registered.entry);
+
+    auto found = apq.lookup(hash);
+    EXPECT_EQ(found.status, PersistedQueryStore::Status::OK);
+    EXPECT_EQ(found.entry.get(), registered.entry.get());
+
+    // Documents evicted from the cache are reparsed from the stored text
+    cache.clear();
+    found = apq.lookup(hash);
+    ASSERT_EQ(found.status, PersistedQueryStore::Status::OK);
+    EXPECT_EQ(found.entry->source, query);
+}
+
+TEST(PersistedQueryStoreTest, EquivalentRegistrationsShareVerifiedEntry) {
+    QueryCache cache;
+    PersistedQueryStore apq(cache);
+    std::string compact = "{ user(id: 1, active: true) { id } }";
+    std::string spaced = "{\n  user(active: true id: 1) {\n    id\n  }\n}";
+    ASSERT_EQ(apq.register_query(sha256_to_hex(sha256(compact)), compact).status, PersistedQueryStore::Status::OK);
+    ASSERT_EQ(apq.register_query(sha256_to_hex(sha256(spaced)), spaced).status, PersistedQueryStore::Status::OK);
+    EXPECT_EQ(cache.get_stats().total_entries, 1u);
+
+    // Either digest resolves to the one cached document, whose text is the first registration's
+    auto found = apq.lookup(sha256(spaced));
+    ASSERT_EQ(found.status, PersistedQueryStore::Status::OK);
+    EXPECT_EQ(found.entry.get(), apq.lookup(sha256(compact)).entry.get());
+    EXPECT_EQ(found.entry->source, compact);
+
+    // A different document cached in the meantime is never returned for it
+    cache.clear();
+    ASSERT_TRUE(cache.put("{ user(id: 2, active: true) { id } }"));
+    found = apq.lookup(sha256(spaced));
+    ASSERT_EQ(found.status, PersistedQueryStore::Status::OK);
+    EXPECT_EQ(found.entry->source, spaced);
+}
+
+TEST(PersistedQueryStoreTest, EvictsLeastRecentlyUsed) {
+    QueryCache cache;
+    PersistedQueryStore apq(cache, 2);
+    std::vector<std::string> queries = {"{ a }", "{ b }", "{ c }"};
+    std::vector<std::string> hashes;
+    for (const auto& q : queries) hashes.push_back(sha256_to_hex(sha256(q)));
+
+    apq.register_query(hashes[0], queries[0]);
+    apq.register_query(hashes[1], queries[1]);
+    apq.lookup(hashes[0]);
+    apq.register_query(hashes[2], queries[2]);
+
+    EXPECT_EQ(apq.size(), 2u);
+    EXPECT_EQ(apq.lookup(hashes[1]).status, PersistedQueryStore::Status::NOT_FOUND);
+    EXPECT_EQ(apq.lookup(hashes[0]).status, PersistedQueryStore::Status::OK);
+}
+
+TEST(PersistedQueryStoreTest, LoadsManifests) {
+    std::string q1 = "query A { a }";
+    std::string body2 = "query B($id: ID!) { b(id: $id) { c } }";
+
+    QueryCache cache;
+    PersistedQueryStore apq(cache);
+    std::string manifest =
+        "{\"format\": \"apollo-persisted-query-manifest\", \"version\": 1, \"operations\": ["
+        "{\"id\": \"" + sha256_to_hex(sha256(q1)) + "\", \"name\": \"A\", \"type\": \"query\", \"body\": \"query A { a }\"},"
+        "{\"id\": \"" + sha256_to_hex(sha256(body2)) + "\", \"body\": \"query B($id: ID!) {\\n b(id: $id) { c } }\"}"
+        "]}";
+    EXPECT_EQ(apq.load_manifest_json(manifest), 1u);
+    EXPECT_EQ(apq.errors().size(), 1u);  // The second body was reformatted, so its hash no longer matches
+    EXPECT_EQ(apq.lookup(sha256(q1)).status, PersistedQueryStore::Status::OK);
+
+    // Flat map format
+    std::string flat = "{\"" + sha256_to_hex(sha256(body2)) + "\": \"query B($id: ID!) { b(id: $id) { c } }\"}";
+    EXPECT_EQ(apq.load_manifest_json(flat), 1u);
+    EXPECT_EQ(apq.size(), 2u);
+
+    EXPECT_EQ(apq.load_manifest("/nonexistent/manifest.json"), 0u);
+}
+
+TEST(PersistedQueryStoreTest, ServesQueriesTheCacheTurnsAway) {
+    QueryCache cache(100, 1);
+    for (int i = 0; i < 100; ++i) {
+        std::string hot = "{ hot" + std::to_string(i) + " }";
+        cache.put(hot);
+        for (int j = 0; j < 8; ++j) cache.get(hot);
+    }
+
+    // Admission keeps the hot entries, but the manifest query still loads
+    PersistedQueryStore apq(cache);
+    std::string q = "query Cold { cold }";
+    std::string manifest = "{\"" + sha256_to_hex(sha256(q)) + "\": \"" + q + "\"}";
+    EXPECT_EQ(apq.load_manifest_json(manifest), 1u);
+    EXPECT_TRUE(apq.errors().empty());
+    EXPECT_EQ(apq.lookup(sha256(q)).status, PersistedQueryStore::Status::OK);
+
+    // Larger than the whole memory budget: valid, so not a parse error
+    std::string big = "{";
+    for (int i = 0; i < 200000; ++i) big += " f" + std::to_string(i % 1000);
+    big += " }";
+    auto result = apq.register_query(sha256_to_hex(sha256(big)), big);
+    EXPECT_EQ(result.status, PersistedQueryStore::Status::OK);
+    ASSERT_TRUE(result.entry);
+    EXPECT_NE(result.entry->ast, nullptr);
+
+    std::string broken = "{ user(id: }";
+    EXPECT_EQ(apq.register_query(sha256_to_hex(sha256(broken)), broken).status,
+              PersistedQueryStore::Status::PARSE_ERROR);
+}
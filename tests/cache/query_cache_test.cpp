@@ -0,0 +1,261 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include "cache/query_cache.h"
+#include "lexer/canonical_hash.h"
+#include "lexer/lexer.h"
+#include "parser/flat_parser.h"
+#include "../parser/ast_outline.h"
+
+TEST(CanonicalHashTest, IgnoresFormattingAndArgumentOrder) {
+    uint64_t base = QueryCache::key_for("query Q($a: Int, $b: String) { user(id: 1, name: \"x\") { id name } }");
+
+    EXPECT_EQ(base, QueryCache::key_for(
+        "# cached\nquery Q($b: String $a: Int) {\n  user(name: \"x\", id: 1) {\n    id, name # fields\n  }\n}\n"));
+
+    // Selection order, values and argument pairing are significant
+    EXPECT_NE(base, QueryCache::key_for("query Q($a: Int, $b: String) { user(id: 1, name: \"x\") { name id } }"));
+    EXPECT_NE(base, QueryCache::key_for("query Q($a: Int, $b: String) { user(id: 2, name: \"x\") { id name } }"));
+    EXPECT_NE(QueryCache::key_for("{ f(a: 1, b: 2) }"), QueryCache::key_for("{ f(a: 2, b: 1) }"));
+    EXPECT_NE(QueryCache::key_for("{ f(a: [1, 2]) }"), QueryCache::key_for("{ f(a: [2, 1]) }"));
+
+    // Input object fields commute too
+    EXPECT_EQ(QueryCache::key_for("{ f(o: {x: 1, y: {z: 2, w: 3}}) }"),
+              QueryCache::key_for("{ f(o: {y: {w: 3, z: 2}, x: 1}) }"));
+
+    // The tokenize overload computes the same hash and form in the same pass
+    std::string query = "{ a(x: 1) { b } }";
+    TokenArena arena;
+    CanonicalHasher hasher;
+    Tokenizer().tokenize(query.data(), query.size(), arena, SIZE_MAX, hasher);
+    std::string form;
+    EXPECT_EQ(hasher.finish(), Tokenizer::canonical_hash(query.data(), query.size(), &form));
+    EXPECT_EQ(hasher.form(), form);
+}
+
+TEST(CanonicalHashTest, KeyedFormsDecideEquality) {
+    // SipHash-2-4 reference vectors: key 00..0f, messages 00..(n-1)
+    CanonicalHasher::Key key{0x0706050403020100ull, 0x0F0E0D0C0B0A0908ull};
+    char message[15];
+    for (int i = 0; i < 15; i++) message[i] = static_cast<char>(i);
+    EXPECT_EQ(CanonicalHasher::siphash(key, message, 0), 0x726FDB47DD0E0E31ull);
+    EXPECT_EQ(CanonicalHasher::siphash(key, message, 15), 0xA129CA6149BE45E5ull);
+
+    // The same tokens hash differently under another key
+    std::string query = "{ f(a: 1) }";
+    TokenArena arena;
+    CanonicalHasher fixed(key);
+    Tokenizer().tokenize(query.data(), query.size(), arena, SIZE_MAX, fixed);
+    EXPECT_NE(fixed.finish(), QueryCache::key_for(query));
+
+    // Equivalent documents have one form; anything else differs
+    auto form_of = [](const std::string& text) {
+        std::string form;
+        Tokenizer::canonical_hash(text.data(), text.size(), &form);
+        return form;
+    };
+    EXPECT_EQ(form_of("{ f(o: {x: 1, y: {z: 2, w: 3}}, b: $v) }"), form_of("{ f(b: $v o: {y: {w: 3 z: 2} x: 1}) }"));
+    EXPECT_NE(form_of("{ f(a: 1, b: 2) }"), form_of("{ f(a: 2, b: 1) }"));
+    EXPECT_NE(form_of("{ f(a: \"x y\") }"), form_of("{ f(a: \"x\" y) }"));
+}
+
+TEST(QueryCacheTest, EquivalentQueriesShareEntry) {
+    QueryCache cache;
+    QueryCache::Handle entry = cache.put("{ user(id: 1, active: true) { id } }");
+    ASSERT_TRUE(entry);
+    ASSERT_NE(entry->ast, nullptr);
+    EXPECT_EQ(entry->ast->definitions.size(), 1u);
+
+    EXPECT_EQ(cache.get("{\n  user(active: true id: 1) {\n    id\n  }\n}").get(), entry.get());
+    EXPECT_FALSE(cache.get("{ user(id: 2, active: true) { id } }"));
+    EXPECT_EQ(cache.get_or_put("{ user(active: true, id: 1) { id } }").get(), entry.get());
+
+    QueryCache::Stats stats = cache.get_stats();
+    EXPECT_EQ(stats.hits, 2u);
+    EXPECT_EQ(stats.misses, 1u);
+    EXPECT_EQ(stats.total_entries, 1u);
+    EXPECT_GT(stats.total_memory_bytes, 0u);
+
+    // Parse failures are not cached
+    EXPECT_FALSE(cache.put("{ user(id: }"));
+}
+
+TEST(QueryCacheTest, PutReturnsEntriesItDoesNotKeep) {
+    QueryCache cache(10, 1);
+    std::string big = "{";
+    for (int i = 0; i < 200000; ++i) big += " f" + std::to_string(i % 1000);
+    big += " }";
+    QueryCache::Handle entry = cache.put(big);
+    ASSERT_TRUE(entry);  // Over the memory budget, but parsed
+    EXPECT_EQ(entry->source, big);
+    EXPECT_EQ(cache.get_stats().total_entries, 0u);
+    EXPECT_FALSE(cache.get(big));
+}
+
+TEST(QueryCacheTest, EvictsLeastRecentlyUsed) {
+    QueryCache cache(2);
+    ASSERT_TRUE(cache.put("{ a }"));
+    ASSERT_TRUE(cache.put("{ b }"));
+    ASSERT_TRUE(cache.get("{ a }"));
+    ASSERT_TRUE(cache.put("{ c }"));
+
+    EXPECT_TRUE(cache.get("{ a }"));
+    EXPECT_FALSE(cache.get("{ b }"));
+    EXPECT_TRUE(cache.get("{ c }"));
+    EXPECT_EQ(cache.get_stats().total_entries, 2u);
+}
+
+TEST(QueryCacheTest, SnapshotRestoresWarmEntries) {
+    std::string path = ::testing::TempDir() + "query_cache_snapshot.bin";
+    std::string hot = "query Hot($id: ID!) { user(id: $id) { name friends(first: [1, 2]) { id } } }";
+    std::string cold = "{ cold }";
+
+    {
+        QueryCache cache;
+        ASSERT_TRUE(cache.put(cold));
+        ASSERT_TRUE(cache.put(hot));
+        ASSERT_TRUE(cache.get(hot));
+        EXPECT_EQ(cache.save_snapshot(path), 2u);
+    }
+
+    QueryCache restored;
+    ASSERT_EQ(restored.load_snapshot(path), 2u);
+
+    QueryCache::Handle entry = restored.get("query Hot($id: ID!) {\n  user(id: $id) { name friends(first: [1 2]) { id } }\n}");
+    ASSERT_TRUE(entry);
+    EXPECT_TRUE(entry->is_warm());
+    EXPECT_EQ(entry->text(), hot);
+
+    FlatNode op = FlatNode(&entry->flat, 0).first_child();
+    EXPECT_EQ(op.name(), "Hot");
+    FlatNode user = op.child(ASTNodeType::SELECTION_SET).first_child();
+    EXPECT_EQ(user.name(), "user");
+
+    // Restored entries can be snapshotted again (which also applies buffered reads)
+    EXPECT_EQ(restored.save_snapshot(path), 2u);
+    EXPECT_EQ(entry->access_count, 3u);  // put + get + the get above
+
+    // Recency survives the round trip: the cold entry is evicted first
+    QueryCache small(1);
+    EXPECT_EQ(small.load_snapshot(path), 1u);
+    EXPECT_TRUE(small.get(hot));
+    EXPECT_FALSE(small.get(cold));
+
+    // Missing or foreign files restore nothing
+    EXPECT_EQ(small.load_snapshot(path + ".missing"), 0u);
+    std::remove(path.c_str());
+}
+
+TEST(QueryCacheTest, SnapshotKeepsKeywordNamedDocuments) {
+    std::string path = ::testing::TempDir() + "query_cache_keywords.bin";
+    std::vector<std::string> queries = {
+        "{ __typename user { id } }",
+        "{ user { type } }",
+        "query { search(query: \"x\", on: true) { id fragment: name } }",
+        "mutation { input(type: {query: 1, input: [ENUM]}) { subscription } }",
+    };
+
+    QueryCache cache;
+    for (const auto& q : queries) ASSERT_TRUE(cache.put(q)) << q;
+    ASSERT_EQ(cache.save_snapshot(path), queries.size());
+
+    QueryCache restored;
+    ASSERT_EQ(restored.load_snapshot(path), queries.size());
+    for (const auto& q : queries) {
+        QueryCache::Handle live = cache.get(q);
+        QueryCache::Handle warm = restored.get(q);
+        ASSERT_TRUE(warm) << q;
+        ASSERT_TRUE(warm->is_warm());
+
+        ASTArena arena;
+        auto expanded = FlatExpander(warm->flat, arena).expand();
+        ASSERT_TRUE(expanded) << q;
+        EXPECT_EQ(outline_tree(*expanded), outline_tree(*live->ast)) << q;
+    }
+    std::remove(path.c_str());
+}
+
+TEST(QueryCacheTest, TinyLfuResistsOneOffScans) {
+    auto run = [](EvictionPolicy policy) {
+        QueryCache cache(20, 50, ParserOptions(), policy);
+        std::vector<std::string> hot;
+        for (int i = 0; i < 10; i++) hot.push_back("{ hot" + std::to_string(i) + " { id } }");
+        for (int round = 0; round < 3; round++) {
+            for (const auto& q : hot) cache.get_or_put(q);
+        }
+        // A long tail of ad-hoc queries, each seen once
+        for (int i = 0; i < 200; i++) cache.get_or_put("{ adhoc" + std::to_string(i) + " }");
+
+        size_t retained = 0;
+        for (const auto& q : hot) retained += static_cast<bool>(cache.get(q));
+        EXPECT_LE(cache.get_stats().total_entries, 20u);
+        return retained;
+    };
+
+    EXPECT_EQ(run(EvictionPolicy::W_TINYLFU), 10u);
+    EXPECT_EQ(run(EvictionPolicy::LRU), 0u);
+}
+
+TEST(QueryCacheTest, ConcurrentReadersDuringChurn) {
+    QueryCache cache(8);
+    std::vector<std::string> queries;
+    for (int i = 0; i < 32; i++) queries.push_back("{ field" + std::to_string(i) + " }");
+    std::vector<uint64_t> keys;
+    for (const auto& q : queries) keys.push_back(QueryCache::key_for(q));
+
+    // A pinned entry outlives its eviction
+    ASSERT_TRUE(cache.put(queries[0]));
+    QueryCache::Handle pinned = cache.get(keys[0]);
+    ASSERT_TRUE(pinned);
+
+    std::atomic<bool> stop{false};
+    std::atomic<size_t> hits{0};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; t++) {
+        readers.emplace_back([&, t]() {
+            size_t local = 0;
+            for (size_t n = t; !stop.load(std::memory_order_relaxed); n++) {
+                QueryCache::Handle handle = cache.get(keys[n % keys.size()]);
+                if (handle) {
+                    EXPECT_EQ(handle->text(), queries[n % keys.size()]);
+                    local++;
+                }
+            }
+            hits += local;
+        });
+    }
+
+    for (int round = 0; round < 200; round++) {
+        cache.put(queries[round % queries.size()]);
+    }
+    stop = true;
+    for (auto& reader : readers) reader.join();
+
+    EXPECT_EQ(pinned->text(), queries[0]);
+    EXPECT_LE(cache.get_stats().total_entries, 8u);
+    EXPECT_GT(cache.get_stats().hits, 0u);
+}
+
+TEST(QueryCacheTest, HandlesBeyondReaderSlots) {
+    // One thread pinning more entries than EpochManager has slots
+    QueryCache cache(8);
+    ASSERT_TRUE(cache.put("{ a }"));
+    std::vector<QueryCache::Handle> handles;
+    for (size_t i = 0; i < EpochManager::MAX_READERS + 10; i++) {
+        handles.push_back(cache.get("{ a }"));
+        ASSERT_TRUE(handles.back());
+    }
+
+    EXPECT_EQ(cache.get_stats().hits, EpochManager::MAX_READERS + 10);
+
+    // Unlinked while pinned through the shared slot, and still readable
+    cache.clear();
+    EXPECT_FALSE(cache.get("{ a }"));
+    EXPECT_EQ(handles.back()->text(), "{ a }");
+
+    handles.clear();
+    EXPECT_TRUE(cache.put("{ c }"));
+}
@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+#include <string>
+#include "json/json_reader.h"
+
+TEST(JsonReaderTest, ReadsNestedValues) {
+    JsonReader reader(R"({"name": "caf\u00e9 \ud83d\ude00\n", "n": -1.5e2, "ok": true,
+                          "skip": {"a": [1, {"b": null}], "c": "x"}, "list": [1, 2, 3], "none": null})");
+    std::string key, name;
+    double n = 0, sum = 0;
+    bool flag = false;
+
+    ASSERT_TRUE(reader.begin_object());
+    while (reader.next_key(key)) {
+        if (key == "name") ASSERT_TRUE(reader.read_string(name));
+        else if (key == "n") ASSERT_TRUE(reader.read_number(n));
+        else if (key == "ok") ASSERT_TRUE(reader.read_bool(flag));
+        else if (key == "list") {
+            ASSERT_TRUE(reader.begin_array());
+            while (reader.next_element()) {
+                double item;
+                ASSERT_TRUE(reader.read_number(item));
+                sum += item;
+            }
+        } else {
+            ASSERT_TRUE(reader.skip_value());
+        }
+    }
+    EXPECT_TRUE(reader.ok()) << reader.error();
+    EXPECT_EQ(reader.peek(), JsonReader::Type::END);
+    EXPECT_EQ(name, "caf\xC3\xA9 \xF0\x9F\x98\x80\n");
+    EXPECT_EQ(n, -150);
+    EXPECT_TRUE(flag);
+    EXPECT_EQ(sum, 6);
+}
+
+TEST(JsonReaderTest, ReportsErrors) {
+    JsonReader missing_comma(R"([1 2])");
+    ASSERT_TRUE(missing_comma.begin_array());
+    double item;
+    while (missing_comma.next_element()) missing_comma.read_number(item);
+    EXPECT_FALSE(missing_comma.ok());
+
+    JsonReader unterminated(R"({"a": "b)");
+    EXPECT_FALSE(unterminated.skip_value());
+    EXPECT_NE(unterminated.error().find("Unterminated"), std::string::npos);
+}
+
+TEST(JsonReaderTest, RejectsBadEscapesInReadAndSkippedStrings) {
+    JsonReader skipped(R"({"w": "\q", "v": 3})");
+    EXPECT_FALSE(skipped.skip_value());
+    EXPECT_NE(skipped.error().find("Invalid escape"), std::string::npos);
+
+    const char* surrogates[] = {R"("\ud83d")", R"("\ud83d tail")", R"("\ude00")", R"("\ud83d\u0041")"};
+    for (const char* text : surrogates) {
+        std::string value;
+        JsonReader read(text);
+        EXPECT_FALSE(read.read_string(value)) << text;
+        EXPECT_NE(read.error().find("Invalid surrogate pair"), std::string::npos) << text;
+        JsonReader skip(text);
+        EXPECT_FALSE(skip.skip_value()) << text;
+    }
+
+    std::string value;
+    JsonReader paired(R"("\ud83d\ude00")");
+    ASSERT_TRUE(paired.read_string(value));
+    EXPECT_EQ(value, "\xF0\x9F\x98\x80");
+}
+
+TEST(JsonReaderTest, ReadsStringsInPlaceAndNumberTokens) {
+    std::string text = R"({"plain": "a long string with no escapes in it at all",
+                           "escaped": "tab\there, quote\" and é past the first sixteen bytes",
+                           "n": [0, -12, 1.5e-3, 01]})";
+    ASTArena arena;
+    JsonReader reader(text);
+    std::string_view key, value, token;
+    bool integer = false;
+
+    ASSERT_TRUE(reader.begin_object());
+    ASSERT_TRUE(reader.next_key(key, arena));
+    EXPECT_EQ(key.data(), text.data() + 2);
+    ASSERT_TRUE(reader.read_string(value, arena));
+    EXPECT_EQ(value, "a long string with no escapes in it at all");
+    EXPECT_GE(value.data(), text.data());
+    EXPECT_LT(value.data(), text.data() + text.size());
+
+    ASSERT_TRUE(reader.next_key(key, arena));
+    ASSERT_TRUE(reader.read_string(value, arena));
+    EXPECT_EQ(value, "tab\there, quote\" and \xC3\xA9 past the first sixteen bytes");
+
+    ASSERT_TRUE(reader.next_key(key, arena));
+    ASSERT_TRUE(reader.begin_array());
+    const char* expected[] = {"0", "-12", "1.5e-3"};
+    for (const char* number : expected) {
+        ASSERT_TRUE(reader.next_element());
+        ASSERT_TRUE(reader.read_number(token, integer));
+        EXPECT_EQ(token, number);
+        EXPECT_EQ(integer, token.find_first_of(".e") == std::string_view::npos);
+    }
+    // A leading zero ends the number; what follows isn't a separator
+    ASSERT_TRUE(reader.next_element());
+    ASSERT_TRUE(reader.read_number(token, integer));
+    EXPECT_FALSE(reader.next_element());
+    EXPECT_NE(reader.error().find("Expected ','"), std::string::npos);
+
+    JsonReader control("\"line\nbreak\"");
+    EXPECT_FALSE(control.read_string(value, arena));
+    EXPECT_NE(control.error().find("control character"), std::string::npos);
+}
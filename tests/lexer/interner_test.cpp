@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "ast/ast_arena.h"
+#include "lexer/interner.h"
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "schema/schema.h"
+
+TEST(InternerTest, AssignsDenseIds) {
+    Interner interner;
+    EXPECT_EQ(interner.intern("user"), 0u);
+    EXPECT_EQ(interner.intern("name"), 1u);
+    EXPECT_EQ(interner.intern("user"), 0u);
+    EXPECT_EQ(interner.intern(""), 2u);
+    EXPECT_EQ(interner.find("name"), 1u);
+    EXPECT_EQ(interner.find("missing"), Interner::INVALID);
+    EXPECT_EQ(interner.name(1), "name");
+
+    // Growth keeps every ID and name stable, including long names
+    std::vector<std::string> names;
+    for (size_t i = 0; i < 50000; i++) {
+        names.push_back("field_" + std::to_string(i) + (i % 1000 == 0 ? std::string(5000, 'x') : ""));
+        ASSERT_EQ(interner.intern(names.back()), i + 3);
+    }
+    for (size_t i = 0; i < names.size(); i++) {
+        ASSERT_EQ(interner.find(names[i]), i + 3);
+        ASSERT_EQ(interner.name(static_cast<uint32_t>(i + 3)), names[i]);
+    }
+}
+
+TEST(InternerTest, LayersOverBase) {
+    Interner base;
+    base.intern("id");
+    base.intern("name");
+
+    Interner layer(&base);
+    EXPECT_EQ(layer.intern("name"), 1u);
+    EXPECT_EQ(layer.intern("local"), 2u);
+    EXPECT_EQ(layer.find("local"), 2u);
+    EXPECT_EQ(layer.name(2), "local");
+    EXPECT_EQ(layer.name(0), "id");
+    EXPECT_EQ(base.find("local"), Interner::INVALID);
+}
+
+TEST(InternerTest, TokensAndAstCarrySchemaSymbols) {
+    auto schema = Schema::from_sdl("type Query { user(id: ID!): User } type User { id: ID! name: String }");
+    ASSERT_NE(schema, nullptr);
+
+    Interner symbols(&schema->names());
+    const char* query = "query Q($id: ID!) { me: user(id: $id) @include(if: true) { name ...F } } "
+                        "fragment F on User { id }";
+
+    TokenArena token_arena;
+    Tokenizer tokenizer(&symbols);
+    auto& lexed = tokenizer.tokenize(query, std::strlen(query), token_arena);
+    std::vector<Token> tokens(lexed.begin(), lexed.end());
+    for (const Token& token : tokens) {
+        if (token.type == TokenType::IDENTIFIER) {
+            EXPECT_EQ(symbols.name(token.symbol), token.value);
+        } else if (token.type == TokenType::LEFT_BRACE) {
+            EXPECT_EQ(token.symbol, NO_SYMBOL);
+        }
+    }
+
+    ASTArena arena;
+    Parser parser(tokens, arena);
+    auto doc = parser.parse_document();
+    ASSERT_FALSE(parser.has_errors());
+
+    auto& op = std::get<arena_ptr<OperationDefinition>>(doc->definitions[0]);
+    auto& field = std::get<arena_ptr<Field>>(op->selection_set->selections[0]);
+    EXPECT_EQ(field->name_id, schema->name_id("user"));
+    EXPECT_EQ(symbols.name(field->alias_id), "me");
+    EXPECT_EQ(field->arguments[0]->name_id, schema->name_id("id"));
+    EXPECT_EQ(field->directives[0]->name_id, schema->name_id("include"));
+    EXPECT_EQ(op->variable_definitions[0]->variable->name_id, symbols.find("id"));
+
+    auto& spread = std::get<arena_ptr<FragmentSpread>>(field->selection_set->selections[1]);
+    auto& fragment = std::get<arena_ptr<FragmentDefinition>>(doc->definitions[1]);
+    EXPECT_EQ(spread->name_id, fragment->name_id);
+    EXPECT_EQ(fragment->type_condition_id, schema->name_id("User"));
+
+    // The schema lookup is by symbol, no string hashing
+    uint32_t user = schema->type_index(fragment->type_condition_id);
+    const auto& name_field = std::get<arena_ptr<Field>>(field->selection_set->selections[0]);
+    EXPECT_NE(schema->field(user, name_field->name_id), nullptr);
+
+    // Fused mode assigns the same symbols
+    LexerCursor cursor(query, std::strlen(query), &symbols);
+    ASTArena fused_arena;
+    Parser fused(cursor, fused_arena);
+    auto fused_doc = fused.parse_document();
+    auto& fused_op = std::get<arena_ptr<OperationDefinition>>(fused_doc->definitions[0]);
+    EXPECT_EQ(std::get<arena_ptr<Field>>(fused_op->selection_set->selections[0])->name_id, field->name_id);
+}
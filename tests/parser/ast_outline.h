@@ -0,0 +1,143 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include "ast/ast_nodes.h"
+#include "ast/flat_ast.h"
+
+// Test helpers: node-by-node outlines, "(kind text|extra ...children)", of
+// tree and flat documents. Equal outlines mean the same structure, names
+// and literals, whichever form or parse mode produced them.
+
+inline void outline(std::string& out, int kind, std::string_view text, std::string_view extra = std::string_view()) {
+    out += "(" + std::to_string(kind) + " ";
+    out.append(text.data(), text.size());
+    if (!extra.empty()) out += "|" + std::string(extra);
+}
+
+inline void outline_flat(std::string& out, FlatNode node) {
+    std::string extra;
+    switch (node.kind()) {
+        case ASTNodeType::OPERATION_DEFINITION: extra = std::to_string(static_cast<int>(node.operation_type())); break;
+        case ASTNodeType::BOOLEAN_VALUE: extra = node.boolean_value() ? "1" : "0"; break;
+        case ASTNodeType::FIELD:
+        case ASTNodeType::FRAGMENT_DEFINITION:
+        case ASTNodeType::INLINE_FRAGMENT: extra = std::string(node.aux_text()); break;
+        default: break;
+    }
+    bool named = node.kind() != ASTNodeType::INLINE_FRAGMENT && node.kind() != ASTNodeType::SELECTION_SET &&
+                 node.kind() != ASTNodeType::LIST_TYPE && node.kind() != ASTNodeType::NON_NULL_TYPE &&
+                 node.kind() != ASTNodeType::LIST_VALUE && node.kind() != ASTNodeType::OBJECT_VALUE;
+    outline(out, static_cast<int>(node.kind()), named ? node.text() : std::string_view(), extra);
+    node.for_each_child([&](FlatNode child) { outline_flat(out, child); });
+    out += ")";
+}
+
+inline void outline_tree(std::string& out, const Value& value);
+inline void outline_tree(std::string& out, const SelectionSet& selection_set);
+
+inline void outline_tree(std::string& out, const std::vector<arena_ptr<Argument>>& arguments) {
+    for (const auto& argument : arguments) {
+        outline(out, static_cast<int>(ASTNodeType::ARGUMENT), argument->name);
+        outline_tree(out, argument->value);
+        out += ")";
+    }
+}
+
+inline void outline_tree(std::string& out, const std::vector<arena_ptr<Directive>>& directives) {
+    for (const auto& directive : directives) {
+        outline(out, static_cast<int>(ASTNodeType::DIRECTIVE), directive->name);
+        outline_tree(out, directive->arguments);
+        out += ")";
+    }
+}
+
+inline void outline_tree(std::string& out, const ASTNode& type) {
+    if (auto* named = std::get_if<NamedType>(&type.data)) {
+        outline(out, static_cast<int>(ASTNodeType::NAMED_TYPE), named->name);
+    } else if (auto* list = std::get_if<ListType>(&type.data)) {
+        outline(out, static_cast<int>(ASTNodeType::LIST_TYPE), "");
+        outline_tree(out, *list->type);
+    } else {
+        outline(out, static_cast<int>(ASTNodeType::NON_NULL_TYPE), "");
+        outline_tree(out, *std::get<NonNullType>(type.data).type);
+    }
+    out += ")";
+}
+
+inline void outline_tree(std::string& out, const Value& value) {
+    if (auto* v = std::get_if<IntValue>(&value)) outline(out, static_cast<int>(ASTNodeType::INT_VALUE), v->value);
+    if (auto* v = std::get_if<FloatValue>(&value)) outline(out, static_cast<int>(ASTNodeType::FLOAT_VALUE), v->value);
+    if (auto* v = std::get_if<StringValue>(&value)) outline(out, static_cast<int>(ASTNodeType::STRING_VALUE), v->value);
+    if (auto* v = std::get_if<EnumValue>(&value)) outline(out, static_cast<int>(ASTNodeType::ENUM_VALUE), v->value);
+    if (std::holds_alternative<NullValue>(value)) outline(out, static_cast<int>(ASTNodeType::NULL_VALUE), "null");
+    if (auto* v = std::get_if<BooleanValue>(&value)) {
+        outline(out, static_cast<int>(ASTNodeType::BOOLEAN_VALUE), v->value ? "true" : "false", v->value ? "1" : "0");
+    }
+    if (auto* v = std::get_if<arena_ptr<Variable>>(&value)) outline(out, static_cast<int>(ASTNodeType::VARIABLE), (*v)->name);
+    if (auto* v = std::get_if<arena_ptr<ListValue>>(&value)) {
+        outline(out, static_cast<int>(ASTNodeType::LIST_VALUE), "");
+        (*v)->for_each([&](const Value& item) { outline_tree(out, item); });
+    }
+    if (auto* v = std::get_if<arena_ptr<ObjectValue>>(&value)) {
+        outline(out, static_cast<int>(ASTNodeType::OBJECT_VALUE), "");
+        for (const ObjectField& field : (*v)->fields) {
+            outline(out, static_cast<int>(ASTNodeType::OBJECT_FIELD), field.name);
+            outline_tree(out, field.value);
+            out += ")";
+        }
+    }
+    out += ")";
+}
+
+inline void outline_tree(std::string& out, const SelectionSet& selection_set) {
+    outline(out, static_cast<int>(ASTNodeType::SELECTION_SET), "");
+    for (const Selection& selection : selection_set.selections) {
+        if (auto* field = std::get_if<arena_ptr<Field>>(&selection)) {
+            outline(out, static_cast<int>(ASTNodeType::FIELD), (*field)->name, (*field)->alias);
+            outline_tree(out, (*field)->arguments);
+            outline_tree(out, (*field)->directives);
+            if ((*field)->selection_set) outline_tree(out, *(*field)->selection_set);
+        } else if (auto* spread = std::get_if<arena_ptr<FragmentSpread>>(&selection)) {
+            outline(out, static_cast<int>(ASTNodeType::FRAGMENT_SPREAD), (*spread)->name);
+            outline_tree(out, (*spread)->directives);
+        } else {
+            const InlineFragment& fragment = *std::get<arena_ptr<InlineFragment>>(selection);
+            outline(out, static_cast<int>(ASTNodeType::INLINE_FRAGMENT), "", fragment.type_condition);
+            outline_tree(out, fragment.directives);
+            outline_tree(out, *fragment.selection_set);
+        }
+        out += ")";
+    }
+    out += ")";
+}
+
+inline std::string outline_tree(const Document& document) {
+    std::string out;
+    outline(out, static_cast<int>(ASTNodeType::DOCUMENT), "");
+    for (const Definition& definition : document.definitions) {
+        if (auto* op_ptr = std::get_if<arena_ptr<OperationDefinition>>(&definition)) {
+            const OperationDefinition& op = **op_ptr;
+            outline(out, static_cast<int>(ASTNodeType::OPERATION_DEFINITION), op.name,
+                    std::to_string(static_cast<int>(op.operation_type)));
+            for (const auto& var_def : op.variable_definitions) {
+                outline(out, static_cast<int>(ASTNodeType::VARIABLE_DEFINITION), var_def->variable->name);
+                outline_tree(out, *var_def->type);
+                if (var_def->default_value) outline_tree(out, *var_def->default_value);
+                outline_tree(out, var_def->directives);
+                out += ")";
+            }
+            outline_tree(out, op.directives);
+            outline_tree(out, *op.selection_set);
+        } else {
+            const FragmentDefinition& fragment = *std::get<arena_ptr<FragmentDefinition>>(definition);
+            outline(out, static_cast<int>(ASTNodeType::FRAGMENT_DEFINITION), fragment.name, fragment.type_condition);
+            outline_tree(out, fragment.directives);
+            outline_tree(out, *fragment.selection_set);
+        }
+        out += ")";
+    }
+    out += ")";
+    return out;
+}
@@ -0,0 +1,219 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "lexer/lexer.h"
+#include "lexer/token/token_arena.h"
+#include "parser/flat_parser.h"
+#include "parser/parser.h"
+#include "ast/flat_ast.h"
+#include "ast_outline.h"
+
+class FlatParserTest : public ::testing::Test {
+protected:
+    TokenArena token_arena;
+    std::vector<Token> tokens;
+    std::string source;
+    FlatDocument doc;
+
+    bool parse(const std::string& query, const ParserOptions& options = ParserOptions()) {
+        source = query;
+        Tokenizer tokenizer;
+        auto& toks = tokenizer.tokenize(source.data(), source.size(), token_arena);
+        tokens.assign(toks.begin(), toks.end());
+        FlatParser parser(tokens, source, options);
+        return parser.parse_document(doc);
+    }
+};
+
+struct KindCounter {
+    std::vector<int> entered = std::vector<int>(32, 0);
+    int left = 0;
+    bool enter(FlatNode node) { entered[static_cast<int>(node.kind())]++; return true; }
+    void leave(FlatNode) { left++; }
+};
+
+TEST_F(FlatParserTest, BuildsLinkedNodes) {
+    ASSERT_TRUE(parse("query GetUser($id: ID!, $tags: [String!] = [\"a\"]) @live {"
+                      "  u: user(id: $id) { name ...F ... on Admin { level } }"
+                      "}"
+                      "fragment F on User { email }"));
+    FlatDocumentView view = doc.view();
+
+    FlatNode root(&view, 0);
+    ASSERT_EQ(root.kind(), ASTNodeType::DOCUMENT);
+
+    FlatNode op = root.first_child();
+    ASSERT_EQ(op.kind(), ASTNodeType::OPERATION_DEFINITION);
+    EXPECT_EQ(op.name(), "GetUser");
+    EXPECT_EQ(op.operation_type(), OperationType::QUERY);
+
+    FlatNode var = op.first_child();
+    ASSERT_EQ(var.kind(), ASTNodeType::VARIABLE_DEFINITION);
+    EXPECT_EQ(var.name(), "id");
+    FlatNode non_null = var.first_child();
+    ASSERT_EQ(non_null.kind(), ASTNodeType::NON_NULL_TYPE);
+    EXPECT_EQ(non_null.first_child().name(), "ID");
+
+    FlatNode tags = var.next_sibling();
+    EXPECT_EQ(tags.name(), "tags");
+    EXPECT_EQ(tags.first_child().kind(), ASTNodeType::LIST_TYPE);
+    EXPECT_EQ(tags.child(ASTNodeType::LIST_VALUE).first_child().text(), "\"a\"");
+
+    EXPECT_EQ(op.child(ASTNodeType::DIRECTIVE).name(), "live");
+
+    FlatNode user = op.child(ASTNodeType::SELECTION_SET).first_child();
+    ASSERT_EQ(user.kind(), ASTNodeType::FIELD);
+    EXPECT_EQ(user.name(), "user");
+    EXPECT_EQ(user.alias(), "u");
+    EXPECT_EQ(tokens[user.token()].value, "u");
+
+    FlatNode arg = user.child(ASTNodeType::ARGUMENT);
+    EXPECT_EQ(arg.name(), "id");
+    EXPECT_EQ(arg.first_child().kind(), ASTNodeType::VARIABLE);
+    EXPECT_EQ(arg.first_child().name(), "id");
+
+    FlatNode name = user.child(ASTNodeType::SELECTION_SET).first_child();
+    EXPECT_EQ(name.name(), "name");
+    EXPECT_EQ(name.next_sibling().kind(), ASTNodeType::FRAGMENT_SPREAD);
+    EXPECT_EQ(name.next_sibling().next_sibling().type_condition(), "Admin");
+
+    FlatNode frag = op.next_sibling();
+    ASSERT_EQ(frag.kind(), ASTNodeType::FRAGMENT_DEFINITION);
+    EXPECT_EQ(frag.name(), "F");
+    EXPECT_EQ(frag.type_condition(), "User");
+    EXPECT_FALSE(frag.next_sibling().valid());
+}
+
+TEST_F(FlatParserTest, WalkVisitsEveryNodeOnce) {
+    ASSERT_TRUE(parse("{ a b(x: [1, 2.5, {k: true}]) { c } }"));
+    FlatDocumentView view = doc.view();
+
+    KindCounter counter;
+    walk_flat(view, counter);
+
+    EXPECT_EQ(counter.left, static_cast<int>(view.node_count));
+    EXPECT_EQ(counter.entered[static_cast<int>(ASTNodeType::FIELD)], 3);
+    EXPECT_EQ(counter.entered[static_cast<int>(ASTNodeType::INT_VALUE)], 1);
+    EXPECT_EQ(counter.entered[static_cast<int>(ASTNodeType::FLOAT_VALUE)], 1);
+    EXPECT_EQ(counter.entered[static_cast<int>(ASTNodeType::BOOLEAN_VALUE)], 1);
+    EXPECT_EQ(counter.entered[static_cast<int>(ASTNodeType::OBJECT_FIELD)], 1);
+}
+
+TEST_F(FlatParserTest, BlobRoundTrip) {
+    ASSERT_TRUE(parse("mutation M { update(input: {id: 1, tags: [A, B]}) { ok } }"));
+
+    std::string blob;
+    doc.serialize(blob);
+    EXPECT_EQ(blob.size(), FlatDocument::blob_size(doc.size()));
+
+    // Relocate the blob and the source to new, aligned buffers
+    std::vector<uint32_t> storage((blob.size() + 3) / 4);
+    std::memcpy(storage.data(), blob.data(), blob.size());
+    std::string copy = source;
+
+    FlatDocumentView view;
+    ASSERT_TRUE(FlatDocumentView::from_blob(storage.data(), blob.size(), copy, view));
+    ASSERT_EQ(view.node_count, doc.size());
+
+    FlatNode op = FlatNode(&view, 0).first_child();
+    EXPECT_EQ(op.operation_type(), OperationType::MUTATION);
+    EXPECT_EQ(op.name(), "M");
+    FlatNode field = op.child(ASTNodeType::SELECTION_SET).first_child();
+    EXPECT_EQ(field.name(), "update");
+    EXPECT_EQ(field.name().data(), copy.data() + source.find("update"));
+
+    // Truncated or mismatched blobs are rejected
+    EXPECT_FALSE(FlatDocumentView::from_blob(storage.data(), blob.size() - 4, copy, view));
+    EXPECT_FALSE(FlatDocumentView::from_blob(storage.data(), blob.size(), "short", view));
+}
+
+TEST_F(FlatParserTest, EnforcesLimits) {
+    ParserOptions options;
+    options.max_depth = 2;
+    EXPECT_FALSE(parse("{ a { b { c } } }", options));
+
+    options = ParserOptions();
+    options.max_list_size = 2;
+    EXPECT_FALSE(parse("{ a(x: [1, 2, 3]) }", options));
+}
+
+TEST_F(FlatParserTest, MatchesTreeParserStructure) {
+    // Everything Parser accepts comes out node for node, keyword names included
+    const char* documents[] = {
+        "{ user { id name } }",
+        "{ __typename user { id } }",
+        "{ user { type } }",
+        "query { search(query: \"x\", mutation: 1, subscription: 2, on: true) { id } }",
+        "{ query: user { fragment: id on: name input: type } }",
+        "{ ... { a } ... @include(if: true) { b } ... on User { c } }",
+        "subscription S($v: [[Int!]]! = [[1]] @d) @live { f(a: {x: [1, \"s\", E, null, false], y: $v}) }",
+        "mutation M { m(l: [1.5, 2e3], e: [RED, GREEN], s: [\"a\", \"\"\"b\"\"\"]) { ...F @skip(if: $x) } }",
+        "fragment F on T @d(a: 1) { a b: c(x: {type: 1, query: {input: 2}}) }",
+    };
+    for (const char* text : documents) {
+        ASSERT_TRUE(parse(text)) << text;
+
+        ASTArena arena;
+        Parser parser(tokens, arena);
+        auto document = parser.parse_document();
+        ASSERT_FALSE(parser.has_errors()) << text;
+
+        FlatDocumentView view = doc.view();
+        std::string flat;
+        outline_flat(flat, FlatNode(&view, 0));
+        EXPECT_EQ(flat, outline_tree(*document)) << text;
+        EXPECT_EQ(tokens[FlatNode(&view, 0).first_child().token()].position,
+                  source.find_first_not_of(' ')) << text;
+    }
+
+    // And what it rejects is rejected, leaving no partial document
+    for (const char* text : {"{ a(x: ) }", "query Q { a", "fragment on T { a }"}) {
+        EXPECT_FALSE(parse(text)) << text;
+        EXPECT_EQ(doc.size(), 0u);
+    }
+}
+
+TEST_F(FlatParserTest, ExpandsBackToTheSameTree) {
+    const char* documents[] = {
+        "{ __typename user { type } }",
+        "query { search(query: \"x\", mutation: 1, on: true) { fragment: id } }",
+        "subscription S($v: [[Int!]]! = [[1]] @d) @live { f(a: {x: [1, \"s\", E, null, false], y: $v}) }",
+        "mutation M { m(l: [1.5, 2e3], e: [RED, GREEN], n: []) { ...F @skip(if: $x) ... on T { a } } }",
+        "fragment F on T @d(a: 1) { a b: c(x: {type: 1, query: {input: 2}}) }",
+    };
+    for (const char* text : documents) {
+        ASSERT_TRUE(parse(text)) << text;
+        FlatDocumentView view = doc.view();
+
+        ASTArena arena;
+        Interner symbols;
+        auto expanded = FlatExpander(view, arena, &symbols).expand();
+        ASSERT_TRUE(expanded) << text;
+
+        ASTArena tree_arena;
+        Parser parser(tokens, tree_arena);
+        auto document = parser.parse_document();
+        EXPECT_EQ(outline_tree(*expanded), outline_tree(*document)) << text;
+
+        // Flattening the expanded tree reproduces every column, positions included
+        FlatDocument again;
+        FlatParser(tokens, source).flatten(*expanded, again);
+        EXPECT_EQ(again.kind, doc.kind) << text;
+        EXPECT_EQ(again.token, doc.token) << text;
+        EXPECT_EQ(again.position, doc.position) << text;
+        EXPECT_EQ(again.text_offset, doc.text_offset) << text;
+        EXPECT_EQ(again.aux_offset, doc.aux_offset) << text;
+    }
+
+    // Names are interned as the Tokenizer would intern them
+    ASSERT_TRUE(parse("{ user { type } }"));
+    FlatDocumentView view = doc.view();
+    ASTArena arena;
+    Interner symbols;
+    auto expanded = FlatExpander(view, arena, &symbols).expand();
+    const auto& op = *std::get<arena_ptr<OperationDefinition>>(expanded->definitions[0]);
+    const Field& user = *std::get<arena_ptr<Field>>(op.selection_set->selections[0]);
+    EXPECT_EQ(user.name_id, symbols.find("user"));
+    EXPECT_EQ(user.alias_id, NO_SYMBOL);
+}
@@ -0,0 +1,295 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include "lexer/lexer.h"
+#include "lexer/token/token_arena.h"
+#include "parser/parser.h"
+#include "ast/ast_arena.h"
+#include "ast_outline.h"
+
+class ParserTest : public ::testing::Test {
+protected:
+    TokenArena token_arena;
+    ASTArena ast_arena;
+    std::vector<Token> tokens;
+    std::string source;  // Tokens and AST point into this
+
+    Parser makeParser(const std::string& query, const ParserOptions& options = ParserOptions()) {
+        source = query;
+        Tokenizer tokenizer;
+        auto& toks = tokenizer.tokenize(source.data(), source.size(), token_arena);
+        tokens.assign(toks.begin(), toks.end());
+        return Parser(tokens, ast_arena, options);
+    }
+};
+
+TEST_F(ParserTest, ParsesWithDefaultOptions) {
+    std::string query = "query Q($id: ID!) { a: user(id: $id) @include(if: true) { name tags(first: [1, 2, 3]) } }";
+    Parser parser = makeParser(query);
+    auto doc = parser.parse_document();
+
+    ASSERT_NE(doc, nullptr);
+    EXPECT_FALSE(parser.has_errors());
+    EXPECT_FALSE(parser.limit_exceeded().has_value());
+    EXPECT_EQ(doc->definitions.size(), 1u);
+    EXPECT_GT(ast_arena.bytes_allocated(), 0u);
+}
+
+TEST_F(ParserTest, TokenLimitAbortsBeforeParsing) {
+    ParserOptions options;
+    options.max_tokens = 4;
+    Parser parser = makeParser("{ a b c d e f }", options);
+
+    EXPECT_EQ(parser.parse_document(), nullptr);
+    ASSERT_TRUE(parser.limit_exceeded().has_value());
+    EXPECT_EQ(*parser.limit_exceeded(), ParserLimit::TOKENS);
+}
+
+TEST_F(ParserTest, TokenizerStopsAfterTokenLimit) {
+    std::string query = "{ a b c d e f g h }";
+    Tokenizer tokenizer;
+    auto& toks = tokenizer.tokenize(query.data(), query.size(), token_arena, 3);
+    EXPECT_EQ(toks.size(), 4u);
+}
+
+TEST_F(ParserTest, DepthLimit) {
+    ParserOptions options;
+    options.max_depth = 3;
+
+    Parser ok = makeParser("{ a { b { c } } }", options);
+    EXPECT_NE(ok.parse_document(), nullptr);
+    EXPECT_FALSE(ok.limit_exceeded().has_value());
+
+    Parser deep = makeParser("{ a { b { c { d } } } }", options);
+    EXPECT_EQ(deep.parse_document(), nullptr);
+    EXPECT_EQ(*deep.limit_exceeded(), ParserLimit::DEPTH);
+}
+
+TEST_F(ParserTest, DepthLimitCoversNestedValues) {
+    ParserOptions options;
+    options.max_depth = 2;
+    Parser parser = makeParser("{ a(x: [[[1]]]) }", options);
+    EXPECT_EQ(parser.parse_document(), nullptr);
+    EXPECT_EQ(*parser.limit_exceeded(), ParserLimit::DEPTH);
+}
+
+TEST_F(ParserTest, AliasLimit) {
+    ParserOptions options;
+    options.max_aliases = 2;
+    Parser parser = makeParser("{ a: x b: x c: x }", options);
+    EXPECT_EQ(parser.parse_document(), nullptr);
+    EXPECT_EQ(*parser.limit_exceeded(), ParserLimit::ALIASES);
+}
+
+TEST_F(ParserTest, DirectiveLimit) {
+    ParserOptions options;
+    options.max_directives_per_field = 2;
+    Parser parser = makeParser("{ a @x @y @z }", options);
+    EXPECT_EQ(parser.parse_document(), nullptr);
+    EXPECT_EQ(*parser.limit_exceeded(), ParserLimit::DIRECTIVES);
+}
+
+TEST_F(ParserTest, ListAndObjectSizeLimit) {
+    ParserOptions options;
+    options.max_list_size = 3;
+
+    Parser list = makeParser("{ a(x: [1, 2, 3, 4]) }", options);
+    EXPECT_EQ(list.parse_document(), nullptr);
+    EXPECT_EQ(*list.limit_exceeded(), ParserLimit::LIST_SIZE);
+
+    Parser object = makeParser("{ a(x: {p: 1, q: 2, r: 3, s: 4}) }", options);
+    EXPECT_EQ(object.parse_document(), nullptr);
+    EXPECT_EQ(*object.limit_exceeded(), ParserLimit::LIST_SIZE);
+}
+
+TEST_F(ParserTest, ArenaBytesLimit) {
+    ParserOptions options;
+    options.max_arena_bytes = 256;
+    std::string query = "{";
+    for (int i = 0; i < 100; i++) query += " f" + std::to_string(i);
+    query += " }";
+
+    Parser parser = makeParser(query, options);
+    EXPECT_EQ(parser.parse_document(), nullptr);
+    EXPECT_EQ(*parser.limit_exceeded(), ParserLimit::ARENA_BYTES);
+}
+
+TEST_F(ParserTest, ExactPreallocationReservesExactChildCounts) {
+    ParserOptions options;
+    options.exact_preallocation = true;
+    std::string query = R"(
+        query Q($a: Int = 1, $b: [String!]!, $c: Color = RED) {
+            alias: user(id: $a, filter: {name: "x", tags: [A, B, C], nested: {k: 1}}) @skip(if: false) {
+                name
+                ...UserFields
+                ... on Admin { level rights(first: 2) }
+                friends(ids: [1, 2, 3, 4]) { id }
+            }
+        }
+    )";
+    Parser parser = makeParser(query, options);
+    auto doc = parser.parse_document();
+    ASSERT_NE(doc, nullptr);
+    EXPECT_FALSE(parser.has_errors());
+
+    auto& op = std::get<arena_ptr<OperationDefinition>>(doc->definitions[0]);
+    EXPECT_EQ(op->variable_definitions.size(), 3u);
+    EXPECT_EQ(op->variable_definitions.capacity(), 3u);
+    EXPECT_EQ(op->selection_set->selections.capacity(), 1u);
+
+    auto& user = std::get<arena_ptr<Field>>(op->selection_set->selections[0]);
+    EXPECT_EQ(user->arguments.capacity(), 2u);
+    EXPECT_EQ(user->selection_set->selections.size(), 4u);
+    EXPECT_EQ(user->selection_set->selections.capacity(), 4u);
+
+    auto& filter = std::get<arena_ptr<ObjectValue>>(user->arguments[1]->value);
+    EXPECT_EQ(filter->fields.size(), 3u);
+}
+
+TEST_F(ParserTest, HomogeneousScalarListsArePacked) {
+    std::string query = R"({ a(ints: [1, 2, 30], strs: ["x", "y"], enums: [RED, GREEN,], floats: [1.5, 2e3]) })";
+    Parser parser = makeParser(query);
+    auto doc = parser.parse_document();
+    ASSERT_NE(doc, nullptr);
+    EXPECT_FALSE(parser.has_errors());
+
+    auto& op = std::get<arena_ptr<OperationDefinition>>(doc->definitions[0]);
+    auto& field = std::get<arena_ptr<Field>>(op->selection_set->selections[0]);
+    ASSERT_EQ(field->arguments.size(), 4u);
+
+    auto& ints = std::get<arena_ptr<ListValue>>(field->arguments[0]->value);
+    ASSERT_TRUE(ints->is_packed());
+    EXPECT_EQ(ints->packed_kind, ASTNodeType::INT_VALUE);
+    EXPECT_EQ(ints->size(), 3u);
+    EXPECT_TRUE(ints->values.empty());
+    EXPECT_EQ(ints->packed_text(2), "30");
+    EXPECT_EQ(ints->packed_position(2), query.find("30"));
+
+    auto& strs = std::get<arena_ptr<ListValue>>(field->arguments[1]->value);
+    EXPECT_EQ(strs->packed_kind, ASTNodeType::STRING_VALUE);
+    EXPECT_EQ(strs->packed_text(1), "\"y\"");
+
+    auto& enums = std::get<arena_ptr<ListValue>>(field->arguments[2]->value);
+    EXPECT_EQ(enums->packed_kind, ASTNodeType::ENUM_VALUE);
+    std::vector<std::string_view> names;
+    enums->for_each([&](const Value& v) { names.push_back(std::get<EnumValue>(v).value); });
+    EXPECT_EQ(names, (std::vector<std::string_view>{"RED", "GREEN"}));
+
+    auto& floats = std::get<arena_ptr<ListValue>>(field->arguments[3]->value);
+    EXPECT_EQ(floats->packed_kind, ASTNodeType::FLOAT_VALUE);
+}
+
+TEST_F(ParserTest, MixedAndNestedListsUseArenaArrays) {
+    Parser parser = makeParser(R"({ a(x: [1, "two", [3, 4], {k: [5, null]}, $v]) })");
+    auto doc = parser.parse_document();
+    ASSERT_NE(doc, nullptr);
+    EXPECT_FALSE(parser.has_errors());
+
+    auto& op = std::get<arena_ptr<OperationDefinition>>(doc->definitions[0]);
+    auto& field = std::get<arena_ptr<Field>>(op->selection_set->selections[0]);
+    auto& list = std::get<arena_ptr<ListValue>>(field->arguments[0]->value);
+    ASSERT_FALSE(list->is_packed());
+    ASSERT_EQ(list->size(), 5u);
+
+    EXPECT_EQ(std::get<IntValue>(list->values[0]).value, "1");
+    EXPECT_EQ(std::get<StringValue>(list->values[1]).value, "\"two\"");
+    EXPECT_TRUE(std::get<arena_ptr<ListValue>>(list->values[2])->is_packed());
+
+    auto& object = std::get<arena_ptr<ObjectValue>>(list->values[3]);
+    ASSERT_EQ(object->fields.size(), 1u);
+    EXPECT_EQ(object->fields[0].name, "k");
+    auto& inner = std::get<arena_ptr<ListValue>>(object->fields[0].value);
+    EXPECT_FALSE(inner->is_packed());
+    EXPECT_EQ(inner->size(), 2u);
+    EXPECT_TRUE(std::holds_alternative<NullValue>(inner->values[1]));
+
+    EXPECT_EQ(std::get<arena_ptr<Variable>>(list->values[4])->name, "v");
+}
+
+TEST_F(ParserTest, LexerCursorMatchesTokenizer) {
+    std::string query = "query Q($n: Int = -3) { a(s: \"x\"\n, f: -1.5e3) { ...F } }";
+    Tokenizer tokenizer;
+    auto& toks = tokenizer.tokenize(query.data(), query.size(), token_arena);
+
+    LexerCursor cursor(query.data(), query.size());
+    size_t count = 0;
+    for (; cursor.has(count); count++) {
+        ASSERT_LT(count, toks.size());
+        EXPECT_EQ(cursor.at(count).type, toks[count].type);
+        EXPECT_EQ(cursor.at(count).value, toks[count].value);
+        EXPECT_EQ(cursor.at(count).position, toks[count].position);
+    }
+    EXPECT_EQ(count, toks.size());
+
+    // Negative numbers are single tokens; a newline after a closed string is not an error
+    size_t numbers = 0;
+    for (const Token& tok : toks) {
+        EXPECT_NE(tok.type, TokenType::UNKNOWN);
+        EXPECT_NE(tok.value, "-");
+        numbers += tok.type == TokenType::NUMBER;
+    }
+    EXPECT_EQ(numbers, 2u);
+}
+
+TEST_F(ParserTest, FusedModeBuildsSameDocument) {
+    source = R"(query Q($id: ID! = "a") @live { u: user(id: $id, xs: [1, 2, "3"], o: {k: [A, B]}) { name ... on Admin { level } ...F } }
+fragment F on User { email })";
+
+    LexerCursor cursor(source.data(), source.size());
+    Parser fused(cursor, ast_arena);
+    auto doc = fused.parse_document();
+    ASSERT_NE(doc, nullptr);
+    EXPECT_FALSE(fused.has_errors());
+    ASSERT_EQ(doc->definitions.size(), 2u);
+
+    auto& op = std::get<arena_ptr<OperationDefinition>>(doc->definitions[0]);
+    EXPECT_EQ(op->name, "Q");
+    ASSERT_EQ(op->variable_definitions.size(), 1u);
+    EXPECT_EQ(std::get<StringValue>(*op->variable_definitions[0]->default_value).value, "\"a\"");
+
+    auto& user = std::get<arena_ptr<Field>>(op->selection_set->selections[0]);
+    EXPECT_EQ(user->alias, "u");
+    ASSERT_EQ(user->arguments.size(), 3u);
+    auto& xs = std::get<arena_ptr<ListValue>>(user->arguments[1]->value);
+    EXPECT_FALSE(xs->is_packed());
+    EXPECT_EQ(std::get<IntValue>(xs->values[1]).value, "2");
+    auto& o = std::get<arena_ptr<ObjectValue>>(user->arguments[2]->value);
+    EXPECT_TRUE(std::get<arena_ptr<ListValue>>(o->fields[0].value)->is_packed());
+    EXPECT_EQ(user->selection_set->selections.size(), 3u);
+
+    auto& frag = std::get<arena_ptr<FragmentDefinition>>(doc->definitions[1]);
+    EXPECT_EQ(frag->type_condition, "User");
+
+    // Node for node what the materialized token vector parses to
+    Tokenizer tokenizer;
+    Parser materialized(tokenizer.tokenize(source.data(), source.size(), token_arena), ast_arena);
+    auto expected = materialized.parse_document();
+    ASSERT_NE(expected, nullptr);
+    EXPECT_EQ(outline_tree(*doc), outline_tree(*expected));
+
+    // Limits apply as tokens are pulled
+    ParserOptions options;
+    options.max_tokens = 5;
+    LexerCursor limited(source.data(), source.size());
+    Parser capped(limited, ast_arena, options);
+    EXPECT_EQ(capped.parse_document(), nullptr);
+    EXPECT_EQ(capped.limit_exceeded(), ParserLimit::TOKENS);
+}
+
+TEST_F(ParserTest, InlineFragmentsWithoutTypeCondition) {
+    Parser parser = makeParser("{ user { ... @include(if: $a) { id } ... { name } ... on User { role } } }");
+    auto doc = parser.parse_document();
+    ASSERT_NE(doc, nullptr);
+    EXPECT_FALSE(parser.has_errors());
+    const auto& op = std::get<arena_ptr<OperationDefinition>>(doc->definitions[0]);
+    const auto& user = std::get<arena_ptr<Field>>(op->selection_set->selections[0]);
+    ASSERT_EQ(user->selection_set->selections.size(), 3u);
+    const auto& guarded = std::get<arena_ptr<InlineFragment>>(user->selection_set->selections[0]);
+    EXPECT_TRUE(guarded->type_condition.empty());
+    EXPECT_EQ(guarded->directives.size(), 1u);
+
+    // Malformed input that consumes no tokens at the top level still terminates
+    Parser broken = makeParser("{ @x(a: 1) { b } }");
+    broken.parse_document();
+    EXPECT_TRUE(broken.has_errors());
+}
@@ -0,0 +1,852 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ast/ast_arena.h"
+#include "cache/query_cache.h"
+#include "lexer/interner.h"
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "runtime/async.h"
+#include "runtime/executor.h"
+#include "runtime/query_plan.h"
+#include "runtime/response_writer.h"
+#include "schema/schema.h"
+
+namespace {
+
+const char* TEST_SDL = R"(
+interface Node { id: ID! }
+type User implements Node { id: ID! name: String friends: [User!] role: Role }
+type Post implements Node { id: ID! title: String }
+union SearchResult = User | Post
+enum Role { ADMIN MEMBER }
+input Filter { term: String! limit: Int = 10 }
+
+type Query {
+  user(id: ID!): User
+  users(first: Int = 2): [User!]!
+  search: [SearchResult]
+  node(id: ID!): Node
+  echo(filter: Filter, tags: [String], text: String = "none"): String
+  broken: User!
+}
+
+type Mutation { a: String b: String c: String }
+)";
+
+struct UserData {
+    int id;
+    const char* name;
+    std::vector<int> friends;
+    bool admin;
+};
+
+struct PostData {
+    int id;
+    const char* title;
+};
+
+// Stand-in for a storage engine answering on its own thread. Requests are
+// held until `expected` are in flight, so a test can check that an
+// execution had that many outstanding at once.
+class SlowStore {
+public:
+    SlowStore() : expected_(1), stopping_(false), max_in_flight_(0) {
+        thread_ = std::thread([this] { run(); });
+    }
+    ~SlowStore() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        changed_.notify_one();
+        thread_.join();
+    }
+
+    void fetch(const char* value, const char** out, Wakeup wakeup) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            requests_.push_back(Request{value, out, wakeup});
+            max_in_flight_ = std::max(max_in_flight_, requests_.size());
+        }
+        changed_.notify_one();
+    }
+    void expect(size_t count) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        expected_ = count;
+        max_in_flight_ = 0;
+    }
+    size_t max_in_flight() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return max_in_flight_;
+    }
+
+private:
+    struct Request {
+        const char* value;
+        const char** out;
+        Wakeup wakeup;
+    };
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stopping_) {
+            changed_.wait(lock, [this] { return stopping_ || requests_.size() >= expected_; });
+            for (Request& request : requests_) {
+                *request.out = request.value;
+                request.wakeup();
+            }
+            requests_.clear();
+        }
+    }
+
+    size_t expected_;
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    std::vector<Request> requests_;
+    bool stopping_;
+    size_t max_in_flight_;
+    std::thread thread_;
+};
+
+// Compact JSON rendering of a response, for assertions
+std::string render(const ResponseValue& value) {
+    switch (value.kind) {
+        case ResponseKind::NULL_VALUE: return "null";
+        case ResponseKind::BOOLEAN: return value.boolean ? "true" : "false";
+        case ResponseKind::INT: return std::to_string(value.integer);
+        case ResponseKind::FLOAT: return std::to_string(value.number);
+        case ResponseKind::STRING:
+        case ResponseKind::ENUM: return "\"" + std::string(value.text()) + "\"";
+        case ResponseKind::LIST: {
+            std::string out = "[";
+            for (uint32_t i = 0; i < value.size; i++) out += (i ? "," : "") + render(value.items[i]);
+            return out + "]";
+        }
+        case ResponseKind::OBJECT: {
+            std::string out = "{";
+            for (uint32_t i = 0; i < value.size; i++) {
+                out += (i ? ",\"" : "\"") + std::string(value.fields[i].name) + "\":" + render(value.fields[i].value);
+            }
+            return out + "}";
+        }
+    }
+    return "";
+}
+
+class ExecutorTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        schema_ = Schema::from_sdl(TEST_SDL);
+        ASSERT_NE(schema_, nullptr);
+        users_ = {{1, "Ada", {2, 3}, true}, {2, "Brian", {1}, false}, {3, "Cleo", {}, false}};
+        posts_ = {{10, "Hello"}};
+        resolvers_.reset(new ResolverRegistry(*schema_));
+        ResolverRegistry& r = *resolvers_;
+
+        r.add("Query", "user", [this](const FieldContext& ctx) {
+            return Resolved::object(find_user(std::stoi(std::string(ctx.argument(0).text()))));
+        });
+        r.add("Query", "users", [this](const FieldContext& ctx) {
+            uint32_t count = static_cast<uint32_t>(std::min<int64_t>(ctx.argument(0).integer, users_.size()));
+            Resolved* items = ctx.allocate<Resolved>(count);
+            for (uint32_t i = 0; i < count; i++) items[i] = Resolved::object(&users_[i]);
+            return Resolved::list(items, count);
+        });
+        r.add("Query", "search", [this](const FieldContext& ctx) {
+            Resolved* items = ctx.allocate<Resolved>(2);
+            items[0] = Resolved::object(&users_[0], ctx.schema->type_index("User"));
+            items[1] = Resolved::object(&posts_[0], ctx.schema->type_index("Post"));
+            return Resolved::list(items, 2);
+        });
+        r.add("Query", "node", [this](const FieldContext& ctx) {
+            int id = std::stoi(std::string(ctx.argument(0).text()));
+            if (id == posts_[0].id) return Resolved::object(&posts_[0]);
+            return Resolved::object(find_user(id));
+        });
+        r.add_type_resolver("Node", [this](const void* source, const Schema& schema) {
+            return source == &posts_[0] ? schema.type_index("Post") : schema.type_index("User");
+        });
+        r.add("Query", "echo", [](const FieldContext& ctx) {
+            std::string text = "text=" + std::string(ctx.argument("text")->text());
+            const ResponseValue& filter = ctx.argument(0);
+            if (!filter.is_null()) {
+                text += " term=" + std::string(filter.find("term")->text()) +
+                        " limit=" + std::to_string(filter.find("limit")->integer);
+            }
+            const ResponseValue& tags = ctx.argument(1);
+            for (uint32_t i = 0; i < tags.size && tags.kind == ResponseKind::LIST; i++) {
+                text += " tag=" + std::string(tags.items[i].text());
+            }
+            return Resolved::scalar(ResponseValue::of_string(ctx.copy(text)));
+        });
+        r.add("Query", "broken", [](const FieldContext&) { return Resolved::null(); });
+
+        r.add("User", "id", [](const FieldContext& ctx) {
+            return Resolved::scalar(ResponseValue::of_int(static_cast<const UserData*>(ctx.source)->id));
+        });
+        r.add("User", "name", [](const FieldContext& ctx) {
+            const UserData* user = static_cast<const UserData*>(ctx.source);
+            if (user->id == 2) throw std::runtime_error("Name is private");
+            return Resolved::scalar(ResponseValue::of_string(user->name));
+        });
+        r.add("User", "friends", [this](const FieldContext& ctx) {
+            const UserData* user = static_cast<const UserData*>(ctx.source);
+            Resolved* items = ctx.allocate<Resolved>(user->friends.size());
+            for (size_t i = 0; i < user->friends.size(); i++) items[i] = Resolved::object(find_user(user->friends[i]));
+            return Resolved::list(items, static_cast<uint32_t>(user->friends.size()));
+        });
+        r.add("User", "role", [](const FieldContext& ctx) {
+            bool admin = static_cast<const UserData*>(ctx.source)->admin;
+            return Resolved::scalar(ResponseValue::of_enum(admin ? "ADMIN" : "MEMBER"));
+        });
+        r.add("Post", "id", [](const FieldContext& ctx) {
+            return Resolved::scalar(ResponseValue::of_int(static_cast<const PostData*>(ctx.source)->id));
+        });
+        r.add("Post", "title", [](const FieldContext& ctx) {
+            return Resolved::scalar(ResponseValue::of_string(static_cast<const PostData*>(ctx.source)->title));
+        });
+    }
+
+    const UserData* find_user(int id) const {
+        for (const UserData& user : users_) {
+            if (user.id == id) return &user;
+        }
+        return nullptr;
+    }
+
+    // Parses with symbols layered over the schema and executes; returns rendered data
+    std::string run(const char* query, const ResponseValue* variables = nullptr, std::string_view operation = {},
+                    std::string_view variables_json = {}) {
+        Interner symbols(&schema_->names());
+        LexerCursor cursor(query, std::strlen(query), &symbols);
+        ASTArena document_arena;
+        Parser parser(cursor, document_arena);
+        auto document = parser.parse_document();
+        EXPECT_FALSE(parser.has_errors()) << query;
+
+        ExecutionRequest request;
+        request.variables = variables;
+        request.variables_json = variables_json;
+        request.operation_name = operation;
+        Executor executor(*schema_, *resolvers_);
+        result_ = executor.execute(*document, arena_, request);
+        return result_.has_data ? render(result_.data) : "<no data>";
+    }
+
+    // Same, through a QueryPlan compiled from the document
+    std::string run_plan(const char* query, const ResponseValue* variables = nullptr, std::string_view operation = {}) {
+        Interner symbols(&schema_->names());
+        LexerCursor cursor(query, std::strlen(query), &symbols);
+        ASTArena document_arena;
+        Parser parser(cursor, document_arena);
+        auto document = parser.parse_document();
+        Executor executor(*schema_, *resolvers_);
+        auto plan = QueryPlan::compile(*resolvers_, executor.coercer(), *document);
+        EXPECT_NE(plan, nullptr) << query;
+        if (!plan) return "<no plan>";
+
+        ExecutionRequest request;
+        request.variables = variables;
+        request.operation_name = operation;
+        result_ = executor.execute(*plan, arena_, request);
+        return result_.has_data ? render(result_.data) : "<no data>";
+    }
+
+    std::unique_ptr<Schema> schema_;
+    std::unique_ptr<ResolverRegistry> resolvers_;
+    std::vector<UserData> users_;
+    std::vector<PostData> posts_;
+    ASTArena arena_;
+    ExecutionResult result_;
+};
+
+}  // namespace
+
+TEST_F(ExecutorTest, ResolvesSelectionsFragmentsAndAbstractTypes) {
+    EXPECT_EQ(run(R"(
+        query {
+          me: user(id: 1) { ...Basics friends { name } }
+          user(id: 1) { role friends @skip(if: true) { id } }
+          search { __typename ... on User { name } ... on Post { title } }
+          node(id: 10) { id ... on Post { title } }
+        }
+        fragment Basics on User { id name }
+    )"), "{\"me\":{\"id\":\"1\",\"name\":\"Ada\",\"friends\":[{\"name\":null},{\"name\":\"Cleo\"}]},"
+         "\"user\":{\"role\":\"ADMIN\"},"
+         "\"search\":[{\"__typename\":\"User\",\"name\":\"Ada\"},{\"__typename\":\"Post\",\"title\":\"Hello\"}],"
+         "\"node\":{\"id\":\"10\",\"title\":\"Hello\"}}");
+
+    // The resolver that threw nulls its field and is reported with its path
+    ASSERT_EQ(result_.errors.size(), 1u);
+    EXPECT_EQ(result_.errors[0].message, "Name is private");
+    ASSERT_EQ(result_.errors[0].path.size(), 4u);
+    EXPECT_EQ(result_.errors[0].path[0].key, "me");
+    EXPECT_EQ(result_.errors[0].path[2].index, 0u);
+    EXPECT_EQ(result_.errors[0].path[3].key, "name");
+
+    // Fields with the same response key merge their sub-selections
+    EXPECT_EQ(run("{ user(id: 3) { id } user(id: 3) { name } }"), "{\"user\":{\"id\":\"3\",\"name\":\"Cleo\"}}");
+}
+
+TEST_F(ExecutorTest, CoercesArgumentsAndVariables) {
+    EXPECT_EQ(run(R"({ echo(filter: {term: "a\"bé"}, tags: "solo") })"),
+              "{\"echo\":\"text=none term=a\"b\xc3\xa9 limit=10 tag=solo\"}");
+    EXPECT_EQ(run("{ users { id } }"), "{\"users\":[{\"id\":\"1\"},{\"id\":\"2\"}]}");
+
+    // Raw variables: an Int for an ID, a list for a list, an absent nullable variable
+    ResponseField fields[2];
+    ResponseValue tags[2] = {ResponseValue::of_string("x"), ResponseValue::of_string("y")};
+    fields[0] = ResponseField{"id", ResponseValue::of_int(3)};
+    fields[1] = ResponseField{"tags", ResponseValue::of_list(tags, 2)};
+    ResponseValue variables = ResponseValue::of_object(fields, 2);
+    EXPECT_EQ(run(R"(
+        query Q($id: ID!, $tags: [String], $first: Int, $hide: Boolean = false) {
+          user(id: $id) { name @include(if: $hide) id }
+          echo(tags: $tags)
+          users(first: $first) { id }
+        }
+    )", &variables), "{\"user\":{\"id\":\"3\"},\"echo\":\"text=none tag=x tag=y\","
+                     "\"users\":[{\"id\":\"1\"},{\"id\":\"2\"}]}");
+
+    // A missing required variable is a request error: no data at all
+    EXPECT_EQ(run("query Q($id: ID!) { user(id: $id) { id } }"), "<no data>");
+    ASSERT_EQ(result_.errors.size(), 1u);
+    EXPECT_EQ(result_.errors[0].message, "Variable \"$id\" of required type \"ID!\" was not provided.");
+
+    EXPECT_EQ(run("query A { users { id } } query B { broken { id } }"), "<no data>");
+    EXPECT_EQ(run("query A { user(id: 2) { id } } query B { broken { id } }", nullptr, "A"),
+              "{\"user\":{\"id\":\"2\"}}");
+}
+
+TEST_F(ExecutorTest, CoercesVariablesStraightFromJson) {
+    const char* query = R"(
+        query Q($id: ID!, $filter: Filter, $tags: [String], $first: Int, $hide: Boolean = false) {
+          user(id: $id) { name @include(if: $hide) id }
+          echo(filter: $filter, tags: $tags)
+          users(first: $first) { id }
+        }
+    )";
+    // Same coercions as raw values: an Int for an ID, a single value for a
+    // list, input object defaults, 1.0 for an Int, unknown variables ignored
+    EXPECT_EQ(run(query, nullptr, {},
+                  R"({ "id": 3, "filter": {"term": "a\"b\u00e9"}, "tags": "x",
+                       "first": 1.0, "other": [1, {"a": null}] })"),
+              "{\"user\":{\"id\":\"3\"},\"echo\":\"text=none term=a\"b\xc3\xa9 limit=10 tag=x\","
+              "\"users\":[{\"id\":\"1\"}]}");
+    EXPECT_TRUE(result_.errors.empty());
+
+    // Strings without escapes are views into the JSON text
+    Interner symbols(&schema_->names());
+    LexerCursor cursor(query, std::strlen(query), &symbols);
+    ASTArena document_arena;
+    Parser parser(cursor, document_arena);
+    auto document = parser.parse_document();
+    const auto& operation = *std::get<arena_ptr<OperationDefinition>>(document->definitions[0]);
+    std::string json = R"({"id": "1", "tags": ["p", "q\n"]})";
+    ResponseValue variables;
+    std::string error;
+    Executor executor(*schema_, *resolvers_);
+    ASSERT_TRUE(executor.coercer().coerce_variables(operation, json, arena_, variables, error)) << error;
+    EXPECT_EQ(variables.find("id")->string, json.data() + 8);
+    EXPECT_EQ(variables.find("tags")->items[1].text(), "q\n");
+    EXPECT_EQ(variables.find("hide")->boolean, false);
+
+    struct Case {
+        const char* json;
+        const char* error;
+    };
+    const Case cases[] = {
+        {"{}", "Variable \"$id\" of required type \"ID!\" was not provided."},
+        {R"({"id": null})", "Variable \"$id\" of non-null type \"ID!\" must not be null."},
+        {R"({"id": 1, "first": 2147483648})", "Variable \"$first\" got invalid value: Expected value of type \"Int\"."},
+        {R"({"id": 1, "filter": {"limit": 1}})",
+         "Variable \"$filter\" got invalid value: Field \"Filter.term\" of required type \"String!\" was not provided."},
+        {R"({"id": 1, "filter": {"term": "t", "size": 1}})",
+         "Variable \"$filter\" got invalid value: Field \"size\" is not defined by type \"Filter\"."},
+        {R"({"id": 1, "tags": [1]})", "Variable \"$tags\" got invalid value: Expected value of type \"String\"."},
+        {R"({"id": "1",)", "Variables are not valid JSON: Expected string at offset 11."},
+        {R"({"id": "1"} [])", "Variables are not valid JSON: unexpected text at offset 12."},
+    };
+    for (const Case& c : cases) {
+        EXPECT_EQ(run(query, nullptr, {}, c.json), "<no data>") << c.json;
+        ASSERT_EQ(result_.errors.size(), 1u) << c.json;
+        EXPECT_EQ(result_.errors[0].message, c.error);
+    }
+}
+
+TEST_F(ExecutorTest, PropagatesNullsToNearestNullableParent) {
+    // A non-null root field failing nulls the whole data
+    EXPECT_EQ(run("{ user(id: 1) { id } broken { id } }"), "null");
+    ASSERT_EQ(result_.errors.size(), 1u);
+    EXPECT_EQ(result_.errors[0].message, "Cannot return null for non-nullable field \"Query.broken\".");
+
+    // A missing user is just null; an unregistered resolver is an error on its field
+    ResolverRegistry empty(*schema_);
+    Executor executor(*schema_, empty);
+    const char* query = "{ search { __typename } }";
+    Interner symbols(&schema_->names());
+    LexerCursor cursor(query, std::strlen(query), &symbols);
+    ASTArena document_arena;
+    Parser parser(cursor, document_arena);
+    auto document = parser.parse_document();
+    ExecutionResult result = executor.execute(*document, arena_);
+    EXPECT_EQ(render(result.data), "{\"search\":null}");
+    ASSERT_EQ(result.errors.size(), 1u);
+    EXPECT_EQ(result.errors[0].message, "No resolver for field \"Query.search\".");
+
+    EXPECT_EQ(run("{ user(id: 99) { id } }"), "{\"user\":null}");
+    EXPECT_TRUE(result_.errors.empty());
+}
+
+TEST_F(ExecutorTest, CompiledPlansMatchInterpreter) {
+    ResponseField fields[3];
+    fields[0] = ResponseField{"id", ResponseValue::of_int(1)};
+    fields[1] = ResponseField{"show", ResponseValue::of_bool(false)};
+    fields[2] = ResponseField{"term", ResponseValue::of_string("t")};
+    ResponseValue variables = ResponseValue::of_object(fields, 3);
+
+    const char* queries[] = {
+        R"(
+        query {
+          me: user(id: 1) { ...Basics friends { name } }
+          user(id: 1) { role friends @skip(if: true) { id } }
+          search { __typename ... on User { name ...Basics } ... on Post { title } }
+          node(id: 10) { id ... on Post { title } }
+        }
+        fragment Basics on User { id name }
+        )",
+        "{ user(id: 3) { id } user(id: 3) { name } }",
+        R"({ echo(filter: {term: "a"}, tags: "solo") users { id } })",
+        // Variable conditions: a field is included when any of its occurrences is
+        R"(
+        query Q($id: ID!, $show: Boolean, $missing: Boolean, $term: String!) {
+          user(id: $id) {
+            id
+            name @include(if: $show)
+            ... @include(if: $show) { role }
+            ... @skip(if: $show) { role friends @include(if: $missing) { id } }
+          }
+          echo(filter: {term: $term, limit: 3}, text: "x")
+        }
+        )",
+        "{ user(id: 1) { id } broken { id } }",
+        "query A { users { id } } query B { broken { id } }",
+    };
+    for (const char* query : queries) {
+        std::string interpreted = run(query, &variables);
+        std::vector<ExecutionError> errors = result_.errors;
+        EXPECT_EQ(run_plan(query, &variables), interpreted) << query;
+        ASSERT_EQ(result_.errors.size(), errors.size()) << query;
+        for (size_t i = 0; i < errors.size(); i++) {
+            EXPECT_EQ(result_.errors[i].message, errors[i].message);
+            EXPECT_EQ(result_.errors[i].path.size(), errors[i].path.size());
+        }
+    }
+    EXPECT_EQ(run_plan("query A { users { id } } query B { broken { id } }", nullptr, "A"),
+              "{\"users\":[{\"id\":\"1\"},{\"id\":\"2\"}]}");
+
+    // Nested fragment spreads that would expand past the limit fail to compile
+    std::string error;
+    const char* wide = "{ users { ...A ...A } } fragment A on User { friends { ...B ...B } } "
+                       "fragment B on User { friends { id name } }";
+    Interner symbols(&schema_->names());
+    LexerCursor cursor(wide, std::strlen(wide), &symbols);
+    ASTArena document_arena;
+    Parser parser(cursor, document_arena);
+    auto document = parser.parse_document();
+    Executor executor(*schema_, *resolvers_);
+    EXPECT_NE(QueryPlan::compile(*resolvers_, executor.coercer(), *document), nullptr);
+    EXPECT_EQ(QueryPlan::compile(*resolvers_, executor.coercer(), *document, &error, 3), nullptr);
+    EXPECT_EQ(error, "Query plan exceeds 3 fields.");
+}
+
+TEST_F(ExecutorTest, CachedEntriesKeepTheirPlanPerSchemaGeneration) {
+    QueryCache cache;
+    QueryCache::Handle entry = cache.put("query Q($n: Int) { users(first: $n) { id name } }");
+    ASSERT_TRUE(entry);
+
+    ResponseField field{"n", ResponseValue::of_int(3)};
+    ResponseValue variables = ResponseValue::of_object(&field, 1);
+    ExecutionRequest request;
+    request.variables = &variables;
+    Executor executor(*schema_, *resolvers_);
+    ExecutionResult first = executor.execute(*entry, arena_, request);
+    EXPECT_EQ(render(first.data),
+              "{\"users\":[{\"id\":\"1\",\"name\":\"Ada\"},{\"id\":\"2\",\"name\":null},"
+              "{\"id\":\"3\",\"name\":\"Cleo\"}]}");
+    std::shared_ptr<const QueryPlan> plan = std::atomic_load(&entry->plan);
+    ASSERT_NE(plan, nullptr);
+    EXPECT_EQ(plan->generation(), schema_->generation());
+
+    // Reused while the schema is unchanged; recompiled for a new one
+    executor.execute(*entry, arena_, request);
+    EXPECT_EQ(std::atomic_load(&entry->plan), plan);
+
+    auto swapped = Schema::from_sdl(TEST_SDL);
+    ResolverRegistry resolvers(*swapped);
+    resolvers.set_default([](const FieldContext&) { return Resolved::null(); });
+    Executor swapped_executor(*swapped, resolvers);
+    ExecutionResult second = swapped_executor.execute(*entry, arena_, request);
+    EXPECT_EQ(render(second.data), "null");  // users is non-null
+    EXPECT_EQ(std::atomic_load(&entry->plan)->generation(), swapped->generation());
+}
+
+TEST_F(ExecutorTest, CachedEntriesKeepTheirPlanPerResolverRegistry) {
+    QueryCache cache;
+    QueryCache::Handle entry = cache.put("{ users(first: 2) { id } }");
+    ASSERT_TRUE(entry);
+    Executor executor(*schema_, *resolvers_);
+    executor.execute(*entry, arena_);
+    std::shared_ptr<const QueryPlan> cheap = std::atomic_load(&entry->plan);
+    ASSERT_NE(cheap, nullptr);
+    EXPECT_EQ(cheap->resolver_version(), resolvers_->version());
+    EXPECT_FALSE(cheap->block(cheap->operation("")->block).expensive);
+
+    // Same schema, but users is EXPENSIVE here: the plan's marks must follow
+    ResolverRegistry expensive(*schema_);
+    Resolver users = *resolvers_->find(schema_->query_type(), *schema_->field(schema_->query_type(), "users"));
+    expensive.add("Query", "users", users, ResolverCost::EXPENSIVE);
+    Executor expensive_executor(*schema_, expensive);
+    expensive_executor.execute(*entry, arena_);
+    std::shared_ptr<const QueryPlan> marked = std::atomic_load(&entry->plan);
+    EXPECT_NE(marked, cheap);
+    EXPECT_EQ(marked->resolver_version(), expensive.version());
+    EXPECT_TRUE(marked->block(marked->operation("")->block).expensive);
+
+    // Re-registering a resolver renews the version, so the plan is rebuilt too
+    expensive.add("Query", "users", users, ResolverCost::CHEAP);
+    expensive_executor.execute(*entry, arena_);
+    std::shared_ptr<const QueryPlan> renewed = std::atomic_load(&entry->plan);
+    EXPECT_EQ(renewed->resolver_version(), expensive.version());
+    EXPECT_FALSE(renewed->block(renewed->operation("")->block).expensive);
+}
+
+TEST_F(ExecutorTest, ParallelPlansMatchSequentialExecution) {
+    // Re-registered as EXPENSIVE so their fields and lists become tasks
+    for (const char* field : {"user", "users", "search"}) {
+        Resolver resolver = *resolvers_->find(schema_->query_type(), *schema_->field(schema_->query_type(), field));
+        resolvers_->add("Query", field, resolver, ResolverCost::EXPENSIVE);
+    }
+    uint32_t user = schema_->type_index("User");
+    for (const char* field : {"name", "friends"}) {
+        Resolver resolver = *resolvers_->find(user, *schema_->field(user, field));
+        resolvers_->add("User", field, resolver, ResolverCost::EXPENSIVE);
+    }
+
+    Scheduler scheduler(4);
+    WorkerArenas arenas(scheduler);
+    const char* queries[] = {
+        "{ users(first: 3) { id name friends { id name friends { name } } } user(id: 1) { name role } }",
+        "{ search { __typename ... on User { name friends { name } } ... on Post { title } } }",
+        "{ user(id: 2) { id } broken { id } }",
+    };
+    for (const char* query : queries) {
+        std::string sequential = run(query);
+        std::multiset<std::string> expected;
+        for (const ExecutionError& error : result_.errors) expected.insert(error.message);
+
+        Interner symbols(&schema_->names());
+        LexerCursor cursor(query, std::strlen(query), &symbols);
+        ASTArena document_arena;
+        Parser parser(cursor, document_arena);
+        auto document = parser.parse_document();
+        Executor executor(*schema_, *resolvers_);
+        auto plan = QueryPlan::compile(*resolvers_, executor.coercer(), *document);
+        ASSERT_NE(plan, nullptr);
+        for (int repeat = 0; repeat < 20; repeat++) {
+            arenas.reset();
+            ExecutionResult result = executor.execute(*plan, arenas, scheduler);
+            EXPECT_EQ(render(result.data), sequential) << query;
+            std::multiset<std::string> errors;
+            for (const ExecutionError& error : result.errors) errors.insert(error.message);
+            // Siblings of a failed non-null field may still run, adding nothing but their own errors
+            for (const std::string& message : expected) EXPECT_EQ(errors.count(message), expected.count(message));
+        }
+    }
+}
+
+TEST_F(ExecutorTest, BatchLoadersCoalesceKeysPerLevel) {
+    // Users are fetched by id in batches of at most 2; Cleo's only friend doesn't exist
+    users_[2].friends = {99};
+    size_t calls = 0;
+    size_t keys = 0;
+    uint32_t by_id = resolvers_->add_loader([this, &calls, &keys](const BatchCall& call) {
+        calls++;
+        keys += call.count;
+        for (uint32_t i = 0; i < call.count; i++) {
+            call.results[i] = Resolved::object(find_user(static_cast<int>(call.keys[i].integer)));
+        }
+    }, 2);
+    resolvers_->add("Query", "user", [by_id](const FieldContext& ctx) {
+        return ctx.load(by_id, ResponseValue::of_int(std::stoi(std::string(ctx.argument(0).text()))));
+    });
+    resolvers_->add("User", "friends", [by_id](const FieldContext& ctx) {
+        const UserData* user = static_cast<const UserData*>(ctx.source);
+        Resolved* items = ctx.allocate<Resolved>(user->friends.size());
+        for (size_t i = 0; i < user->friends.size(); i++) items[i] = ctx.load(by_id, ResponseValue::of_int(user->friends[i]));
+        return Resolved::list(items, static_cast<uint32_t>(user->friends.size()));
+    });
+
+    const char* query = "{ users(first: 3) { id friends { id friends { id } } } a: user(id: 2) { id } b: user(id: 1) { id } }";
+    std::string interpreted = run(query);
+    EXPECT_EQ(interpreted,
+              "{\"users\":[{\"id\":\"1\",\"friends\":[{\"id\":\"2\",\"friends\":[{\"id\":\"1\"}]},"
+              "{\"id\":\"3\",\"friends\":null}]},"
+              "{\"id\":\"2\",\"friends\":[{\"id\":\"1\",\"friends\":[{\"id\":\"2\"},{\"id\":\"3\"}]}]},"
+              "{\"id\":\"3\",\"friends\":null}],"
+              "\"a\":{\"id\":\"2\"},\"b\":{\"id\":\"1\"}}");
+    std::vector<ExecutionError> errors = result_.errors;
+    ASSERT_EQ(errors.size(), 2u);
+    EXPECT_EQ(errors[0].message, "Cannot return null for non-nullable field \"User.friends\".");
+    // The interpreter dispatches when it reaches a pending key; the cache still dedups
+    EXPECT_EQ(keys, 4u);
+    EXPECT_EQ(calls, 3u);
+
+    // Plans defer: users 2, 3, 1 and 99 are all keys of the first tick, in two batches
+    calls = 0;
+    keys = 0;
+    EXPECT_EQ(run_plan(query), interpreted);
+    EXPECT_EQ(keys, 4u);
+    EXPECT_EQ(calls, 2u);
+    ASSERT_EQ(result_.errors.size(), errors.size());
+    for (size_t i = 0; i < errors.size(); i++) {
+        EXPECT_EQ(result_.errors[i].message, errors[i].message);
+        EXPECT_EQ(result_.errors[i].path.size(), errors[i].path.size());
+    }
+
+    // A non-null deferred value nulls up to the nearest nullable parent
+    EXPECT_EQ(run_plan("{ user(id: 3) { friends { id } } }"), "{\"user\":{\"friends\":null}}");
+    EXPECT_EQ(run_plan("{ user(id: 99) { id } }"), "{\"user\":null}");
+}
+
+TEST_F(ExecutorTest, ParallelRunsBatchLoadsPerTask) {
+    size_t calls = 0;
+    uint32_t by_id = resolvers_->add_loader([this, &calls](const BatchCall& call) {
+        calls++;
+        for (uint32_t i = 0; i < call.count; i++) {
+            call.results[i] = Resolved::object(find_user(static_cast<int>(call.keys[i].integer)));
+        }
+    });
+    resolvers_->add("User", "friends", [by_id](const FieldContext& ctx) {
+        const UserData* user = static_cast<const UserData*>(ctx.source);
+        Resolved* items = ctx.allocate<Resolved>(user->friends.size());
+        for (size_t i = 0; i < user->friends.size(); i++) items[i] = ctx.load(by_id, ResponseValue::of_int(user->friends[i]));
+        return Resolved::list(items, static_cast<uint32_t>(user->friends.size()));
+    });
+    // An EXPENSIVE field under every user makes the list's items tasks
+    resolvers_->add("Query", "users", *resolvers_->find(schema_->query_type(), *schema_->field(schema_->query_type(), "users")),
+                    ResolverCost::EXPENSIVE);
+    uint32_t user = schema_->type_index("User");
+    resolvers_->add("User", "role", *resolvers_->find(user, *schema_->field(user, "role")), ResolverCost::EXPENSIVE);
+
+    const char* query = "{ users(first: 3) { role friends { id friends { id } } } }";
+    std::string sequential = run_plan(query);
+    EXPECT_EQ(calls, 1u);
+
+    Interner symbols(&schema_->names());
+    LexerCursor cursor(query, std::strlen(query), &symbols);
+    ASTArena document_arena;
+    Parser parser(cursor, document_arena);
+    auto document = parser.parse_document();
+    Executor executor(*schema_, *resolvers_);
+    auto plan = QueryPlan::compile(*resolvers_, executor.coercer(), *document);
+    ASSERT_NE(plan, nullptr);
+    Scheduler scheduler(2);
+    WorkerArenas arenas(scheduler);
+    for (int repeat = 0; repeat < 20; repeat++) {
+        // Users 1 and 2 are one worker's share, whose friends (2, 3 and 1) are
+        // all keys of its first tick; Cleo has none. The friends' friends are cached.
+        calls = 0;
+        arenas.reset();
+        EXPECT_EQ(render(executor.execute(*plan, arenas, scheduler).data), sequential);
+        EXPECT_EQ(calls, 1u);
+    }
+}
+
+TEST_F(ExecutorTest, MutationRootFieldsRunSeriallyInOrder) {
+    // a and b are EXPENSIVE, so a query would run them as parallel tasks
+    std::mutex mutex;
+    std::string log;
+    int running = 0;
+    int max_running = 0;
+    auto field = [&](const char* name) {
+        return [&, name](const FieldContext&) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                log += name;
+                max_running = std::max(max_running, ++running);
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            std::lock_guard<std::mutex> lock(mutex);
+            running--;
+            return Resolved::scalar(ResponseValue::of_string(name));
+        };
+    };
+    resolvers_->add("Mutation", "a", field("a"), ResolverCost::EXPENSIVE);
+    resolvers_->add("Mutation", "b", field("b"), ResolverCost::EXPENSIVE);
+    resolvers_->add("Mutation", "c", field("c"));
+
+    const char* query = "mutation { b c a b2: b }";
+    const std::string expected = "{\"b\":\"b\",\"c\":\"c\",\"a\":\"a\",\"b2\":\"b\"}";
+    EXPECT_EQ(run(query), expected);
+    EXPECT_EQ(log, "bcab");
+    log.clear();
+    EXPECT_EQ(run_plan(query), expected);
+    EXPECT_EQ(log, "bcab");
+
+    Interner symbols(&schema_->names());
+    LexerCursor cursor(query, std::strlen(query), &symbols);
+    ASTArena document_arena;
+    Parser parser(cursor, document_arena);
+    auto document = parser.parse_document();
+    Executor executor(*schema_, *resolvers_);
+    auto plan = QueryPlan::compile(*resolvers_, executor.coercer(), *document);
+    ASSERT_NE(plan, nullptr);
+    Scheduler scheduler(4);
+    WorkerArenas arenas(scheduler);
+    for (int repeat = 0; repeat < 5; repeat++) {
+        log.clear();
+        arenas.reset();
+        EXPECT_EQ(render(executor.execute(*plan, arenas, scheduler).data), expected);
+        EXPECT_EQ(log, "bcab");
+        EXPECT_EQ(max_running, 1);
+    }
+}
+
+TEST_F(ExecutorTest, DeferredMutationFieldsFinishBeforeTheNextStarts) {
+    std::string log;
+    uint32_t commit = resolvers_->add_loader([&log](const BatchCall& call) {
+        for (uint32_t i = 0; i < call.count; i++) {
+            log += std::string(call.keys[i].text()) + "-commit ";
+            call.results[i] = Resolved::scalar(call.keys[i]);
+        }
+    });
+    resolvers_->add("Mutation", "a", [commit](const FieldContext& ctx) {
+        return ctx.load(commit, ResponseValue::of_string("a"));
+    });
+    resolvers_->add("Mutation", "b", [&log](const FieldContext&) {
+        log += "b-run ";
+        return Resolved::scalar(ResponseValue::of_string("b"));
+    });
+
+    const char* query = "mutation { a b }";
+    EXPECT_EQ(run(query), "{\"a\":\"a\",\"b\":\"b\"}");
+    EXPECT_EQ(log, "a-commit b-run ");
+    log.clear();
+    EXPECT_EQ(run_plan(query), "{\"a\":\"a\",\"b\":\"b\"}");
+    EXPECT_EQ(log, "a-commit b-run ");
+
+    // Queries still defer root fields to batch them
+    log.clear();
+    resolvers_->add("Query", "echo", [commit](const FieldContext& ctx) {
+        return ctx.load(commit, ResponseValue::of_string("echo"));
+    });
+    resolvers_->add("Query", "broken", [&log](const FieldContext&) {
+        log += "broken-run ";
+        return Resolved::null();
+    });
+    run_plan("{ echo broken { id } }");
+    EXPECT_EQ(log, "broken-run echo-commit ");
+}
+
+TEST_F(ExecutorTest, AsyncResolversSuspendAndResumeFieldCompletion) {
+    std::string query = "{ users(first: 3) { id name friends { name } } user(id: 3) { name } }";
+    std::string sync = run(query.c_str());
+    std::vector<ExecutionError> errors = result_.errors;
+
+    // User.name from the store; Brian's throws after resuming, as the sync one does
+    SlowStore store;
+    resolvers_->add_async("User", "name", [&store](const FieldContext& ctx) -> AsyncResolved {
+        const UserData* user = static_cast<const UserData*>(ctx.source);
+        const char* name = nullptr;
+        co_await suspend([&](Wakeup wakeup) { store.fetch(user->name, &name, wakeup); });
+        if (user->id == 2) throw std::runtime_error("Name is private");
+        co_return Resolved::scalar(ResponseValue::of_string(ctx.copy(name)));
+    });
+    // Finishing without suspending completes like a plain resolver
+    resolvers_->add_async("User", "role", [](const FieldContext& ctx) -> AsyncResolved {
+        co_return Resolved::scalar(ResponseValue::of_enum(static_cast<const UserData*>(ctx.source)->admin ? "ADMIN"
+                                                                                                          : "MEMBER"));
+    });
+    EXPECT_EQ(run("{ user(id: 1) { role } }"), "{\"user\":{\"role\":\"ADMIN\"}}");
+
+    // The interpreter waits for each name in turn
+    EXPECT_EQ(run(query.c_str()), sync);
+    EXPECT_EQ(store.max_in_flight(), 1u);
+
+    // A plan keeps executing while names are fetched: all seven are in flight together
+    store.expect(7);
+    size_t before = arena_.bytes_allocated();
+    EXPECT_EQ(run_plan(query.c_str()), sync);
+    EXPECT_EQ(store.max_in_flight(), 7u);
+    EXPECT_GT(arena_.bytes_allocated(), before);
+    ASSERT_EQ(result_.errors.size(), errors.size());
+    for (size_t i = 0; i < errors.size(); i++) {
+        EXPECT_EQ(result_.errors[i].message, errors[i].message);
+        EXPECT_EQ(result_.errors[i].path.size(), errors[i].path.size());
+    }
+
+    // Non-null async fields propagate their nulls once they finish
+    resolvers_->add_async("Query", "broken", [&store](const FieldContext&) -> AsyncResolved {
+        const char* ignored = nullptr;
+        co_await suspend([&](Wakeup wakeup) { store.fetch("x", &ignored, wakeup); });
+        co_return Resolved::null();
+    });
+    store.expect(2);
+    EXPECT_EQ(run_plan("{ user(id: 1) { name } broken { id } }"), "null");
+    store.expect(1);
+    EXPECT_EQ(run("{ user(id: 1) { name } broken { id } }"), "null");
+
+    // Under a Scheduler, each worker resumes the coroutines its tasks started
+    resolvers_->add("Query", "users", *resolvers_->find(schema_->query_type(), *schema_->field(schema_->query_type(), "users")),
+                    ResolverCost::EXPENSIVE);
+    Interner symbols(&schema_->names());
+    LexerCursor cursor(query.data(), query.size(), &symbols);
+    ASTArena document_arena;
+    Parser parser(cursor, document_arena);
+    auto document = parser.parse_document();
+    Executor executor(*schema_, *resolvers_);
+    auto plan = QueryPlan::compile(*resolvers_, executor.coercer(), *document);
+    ASSERT_NE(plan, nullptr);
+    Scheduler scheduler(2);
+    WorkerArenas arenas(scheduler);
+    EXPECT_EQ(render(executor.execute(*plan, arenas, scheduler).data), sync);
+}
+
+TEST_F(ExecutorTest, PlanKeysSerializeLikeInterpretedResponses) {
+    const char* query = "{ me: user(id: 1) { id name friends { name role } } users { id } "
+                        "echo(filter: {term: \"a\\\"b\"}) }";
+    run(query);
+    std::string interpreted = response_to_json(result_);
+
+    Interner symbols(&schema_->names());
+    LexerCursor cursor(query, std::strlen(query), &symbols);
+    ASTArena document_arena;
+    Parser parser(cursor, document_arena);
+    auto document = parser.parse_document();
+    Executor executor(*schema_, *resolvers_);
+    auto plan = QueryPlan::compile(*resolvers_, executor.coercer(), *document);
+    ASSERT_NE(plan, nullptr);
+    ExecutionResult result = executor.execute(*plan, arena_, ExecutionRequest());
+
+    // Keys come from the plan's quoted fragments, but the bytes are the same
+    const ResponseField& me = result.data.fields[0];
+    ASSERT_NE(me.plan_field, nullptr);
+    EXPECT_EQ(plan->key_fragment(*me.plan_field), "\"me\":");
+    EXPECT_EQ(me.name, "me");
+    EXPECT_EQ(response_to_json(result, plan.get()), interpreted);
+    EXPECT_EQ(interpreted.rfind("{\"errors\":[{\"message\":\"Name is private\",\"path\":[\"me\",\"friends\",0,\"name\"]}],"
+                                "\"data\":{\"me\":{\"id\":\"1\",\"name\":\"Ada\",",
+                                0),
+              0u);
+    EXPECT_NE(interpreted.find("\"echo\":\"text=none term=a\\\"b limit=10\""), std::string::npos);
+}
@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+#include "runtime/response_writer.h"
+
+namespace {
+
+// {"list":[1,-2.5,true,null],"text":<text>}
+struct Sample {
+    ResponseValue items[4];
+    ResponseField fields[2];
+    ExecutionResult result;
+
+    explicit Sample(std::string_view text) {
+        items[0] = ResponseValue::of_int(1);
+        items[1] = ResponseValue::of_float(-2.5);
+        items[2] = ResponseValue::of_bool(true);
+        items[3] = ResponseValue();
+        fields[0] = ResponseField{"list", ResponseValue::of_list(items, 4)};
+        fields[1] = ResponseField{"text", ResponseValue::of_string(text)};
+        result.data = ResponseValue::of_object(fields, 2);
+        result.has_data = true;
+    }
+};
+
+std::string write_value(const ResponseValue& value) {
+    char buffer[256];
+    ResponseWriter writer({buffer, sizeof(buffer)});
+    EXPECT_TRUE(writer.write(value));
+    return std::string(buffer, writer.bytes_written());
+}
+
+}  // namespace
+
+TEST(ResponseWriterTest, EscapesStrings) {
+    EXPECT_EQ(write_value(ResponseValue::of_string("a\"b\\c\n\t\x01\x1f" "\xc3\xa9")),
+              "\"a\\\"b\\\\c\\n\\t\\u0001\\u001f\xc3\xa9\"");
+    // Runs crossing the 16 and 32 byte strides of the scanners
+    std::string text(70, 'x');
+    text[40] = '"';
+    EXPECT_EQ(write_value(ResponseValue::of_string(text)),
+              "\"" + std::string(40, 'x') + "\\\"" + std::string(29, 'x') + "\"");
+}
+
+TEST(ResponseWriterTest, FormatsNumbersAndNonFiniteFloats) {
+    EXPECT_EQ(write_value(ResponseValue::of_int(std::numeric_limits<int64_t>::min())), "-9223372036854775808");
+    EXPECT_EQ(write_value(ResponseValue::of_float(0.1)), "0.1");
+    EXPECT_EQ(write_value(ResponseValue::of_float(1e300)), "1e+300");
+    EXPECT_EQ(write_value(ResponseValue::of_float(std::nan(""))), "null");
+    EXPECT_EQ(write_value(ResponseValue::of_float(-std::numeric_limits<double>::infinity())), "null");
+}
+
+TEST(ResponseWriterTest, StreamsThroughSmallBuffersAndIovecs) {
+    Sample sample("quote\" and more text to cross the 16 and 32 byte strides");
+    ExecutionError error;
+    error.message = "Name is private";
+    error.path = {PathSegment{"list", 0}, PathSegment{{}, 2}};
+    sample.result.errors.push_back(error);
+    const std::string expected =
+        "{\"errors\":[{\"message\":\"Name is private\",\"path\":[\"list\",2]}],"
+        "\"data\":{\"list\":[1,-2.5,true,null],"
+        "\"text\":\"quote\\\" and more text to cross the 16 and 32 byte strides\"}}";
+    EXPECT_EQ(response_to_json(sample.result), expected);
+
+    // Every buffer size yields the same bytes, numbers split included
+    for (size_t size = 1; size <= 40; size++) {
+        std::vector<char> buffer(size);
+        std::string out;
+        ResponseWriter writer({buffer.data(), size}, [&](const char* data, size_t count) {
+            out.append(data, count);
+            return JsonBuffer{buffer.data(), size};
+        });
+        EXPECT_TRUE(writer.write(sample.result));
+        EXPECT_TRUE(writer.finish());
+        EXPECT_EQ(out, expected) << size;
+        EXPECT_EQ(writer.bytes_written(), expected.size());
+    }
+
+    char space[3][64];
+    struct iovec iov[3] = {{space[0], 64}, {space[1], 64}, {space[2], 64}};
+    ASSERT_EQ(write_response(sample.result, iov, 3), 3u);
+    std::string gathered;
+    for (const struct iovec& part : iov) gathered.append(static_cast<char*>(part.iov_base), part.iov_len);
+    EXPECT_EQ(gathered, expected);
+
+    struct iovec small[2] = {{space[0], 64}, {space[1], 64}};
+    EXPECT_EQ(write_response(sample.result, small, 2), 0u);
+
+    // Without flush, a full buffer fails the writer
+    char tiny[8];
+    ResponseWriter writer({tiny, sizeof(tiny)});
+    EXPECT_FALSE(writer.write(sample.result));
+    EXPECT_FALSE(writer.finish());
+}
@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include "runtime/scheduler.h"
+
+namespace {
+
+// Fork-join Fibonacci: every call spawns its first half and runs the second inline
+struct FibTask {
+    Task task;
+    Scheduler* scheduler;
+    int n;
+    uint64_t result;
+};
+
+void run_fib(Task* task);
+
+uint64_t fib(Scheduler& scheduler, int n) {
+    if (n < 2) return n;
+    FibTask left{{&run_fib, nullptr}, &scheduler, n - 1, 0};
+    TaskGroup group;
+    scheduler.spawn(group, &left.task);
+    uint64_t right = fib(scheduler, n - 2);
+    scheduler.wait(group);
+    return left.result + right;
+}
+
+void run_fib(Task* task) {
+    FibTask& fib_task = *reinterpret_cast<FibTask*>(task);
+    fib_task.result = fib(*fib_task.scheduler, fib_task.n);
+}
+
+struct CountTask {
+    Task task;
+    std::atomic<size_t>* count;
+    std::atomic<size_t>* workers;
+    Scheduler* scheduler;
+};
+
+void run_count(Task* task) {
+    CountTask& count = *reinterpret_cast<CountTask*>(task);
+    count.count->fetch_add(1);
+    if (count.scheduler->worker_index() < count.scheduler->worker_count()) count.workers->fetch_add(1);
+}
+
+}  // namespace
+
+TEST(SchedulerTest, NestedForkJoinFromInsideAndOutsideThePool) {
+    Scheduler scheduler(4);
+    EXPECT_EQ(scheduler.worker_count(), 4u);
+    EXPECT_EQ(scheduler.worker_index(), 4u);  // The test thread isn't a worker
+
+    // Started from outside, then every level spawns and helps from inside
+    FibTask root{{&run_fib, nullptr}, &scheduler, 20, 0};
+    TaskGroup group;
+    scheduler.spawn(group, &root.task);
+    scheduler.wait(group);
+    EXPECT_EQ(root.result, 6765u);
+
+    // Several external threads at once
+    std::vector<std::thread> threads;
+    std::vector<FibTask> tasks(4, FibTask{{&run_fib, nullptr}, &scheduler, 16, 0});
+    for (FibTask& task : tasks) {
+        threads.emplace_back([&scheduler, &task] {
+            TaskGroup own;
+            scheduler.spawn(own, &task.task);
+            scheduler.wait(own);
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+    for (const FibTask& task : tasks) EXPECT_EQ(task.result, 987u);
+}
+
+TEST(SchedulerTest, FullDequeRunsTasksInline) {
+    Scheduler scheduler(2);
+    std::atomic<size_t> count{0};
+    std::atomic<size_t> workers{0};
+    size_t total = Scheduler::DEQUE_CAPACITY * 2;
+    std::vector<CountTask> tasks(total, CountTask{{&run_count, nullptr}, &count, &workers, &scheduler});
+
+    // One worker spawns far more than its deque holds
+    struct SpawnAll {
+        Task task;
+        std::vector<CountTask>* tasks;
+        Scheduler* scheduler;
+    } spawner{{[](Task* task) {
+                   auto& self = *reinterpret_cast<SpawnAll*>(task);
+                   TaskGroup group;
+                   for (CountTask& count : *self.tasks) self.scheduler->spawn(group, &count.task);
+                   self.scheduler->wait(group);
+               },
+               nullptr},
+              &tasks, &scheduler};
+    TaskGroup group;
+    scheduler.spawn(group, &spawner.task);
+    scheduler.wait(group);
+    EXPECT_EQ(count.load(), total);
+    EXPECT_EQ(workers.load(), total);
+}
@@ -0,0 +1,220 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include "schema/schema.h"
+
+namespace {
+
+const char* TEST_SDL = R"(
+"""The root"""
+schema { query: Root mutation: Mutations }
+
+scalar DateTime @specifiedBy(url: "https://example.com/datetime")
+
+interface Node { id: ID! }
+interface Named implements Node & Entity { id: ID! name: String }
+interface Entity { id: ID! }
+
+type User implements Node & Named & Entity @key(fields: "id") {
+  id: ID!
+  "Display name"
+  name: String
+  friends(first: Int = 10, after: String, filter: UserFilter = {role: ADMIN, tags: ["a", "b"]}): [User!]!
+  matrix: [[Float!]]
+  oldField: Int @deprecated(reason: "use name")
+}
+
+type Bot implements Node { id: ID! }
+
+union SearchResult = | User | Bot
+
+enum Role { ADMIN USER @deprecated GUEST }
+
+input UserFilter {
+  role: Role = USER
+  tags: [String!]
+}
+
+type Root {
+  node(id: ID!): Node
+  search(term: String!): [SearchResult]
+  type: String
+}
+
+type Mutations { noop: Boolean }
+
+extend type Root { me: User }
+
+directive @key(fields: String!) repeatable on OBJECT | INTERFACE
+)";
+
+std::unique_ptr<Schema> load_test_schema() {
+    std::vector<std::string> errors;
+    auto schema = Schema::from_sdl(TEST_SDL, &errors);
+    for (const std::string& error : errors) ADD_FAILURE() << error;
+    return schema;
+}
+
+}  // namespace
+
+TEST(SchemaTest, BuildsFromSdl) {
+    auto schema = load_test_schema();
+    ASSERT_NE(schema, nullptr);
+
+    uint32_t root = schema->type_index("Root");
+    ASSERT_NE(root, Schema::NONE);
+    EXPECT_EQ(schema->query_type(), root);
+    EXPECT_EQ(schema->mutation_type(), schema->type_index("Mutations"));
+    EXPECT_EQ(schema->subscription_type(), Schema::NONE);
+    EXPECT_EQ(schema->type_index("String"), Schema::BUILTIN_STRING);
+
+    // Extension fields, and keywords as field names
+    EXPECT_NE(schema->field(root, "me"), nullptr);
+    EXPECT_NE(schema->field(root, "type"), nullptr);
+    EXPECT_EQ(schema->field(root, "missing"), nullptr);
+
+    uint32_t user = schema->type_index("User");
+    ASSERT_EQ(schema->type(user).kind, TypeKind::OBJECT);
+    EXPECT_EQ(schema->fields(user).size(), 5u);
+
+    const FieldDef* friends = schema->field(user, "friends");
+    ASSERT_NE(friends, nullptr);
+    EXPECT_EQ(friends->type.type, user);
+    EXPECT_EQ(friends->type.list_depth, 1);
+    EXPECT_TRUE(friends->type.is_non_null());
+    EXPECT_TRUE(friends->type.item().is_non_null());
+    ASSERT_EQ(schema->arguments(*friends).size(), 3u);
+
+    const InputValueDef* first = schema->argument(*friends, schema->name_id("first"));
+    ASSERT_NE(first, nullptr);
+    EXPECT_EQ(first->type.type, Schema::BUILTIN_INT);
+    EXPECT_EQ(first->default_value, "10");
+    const InputValueDef* filter = schema->argument(*friends, schema->name_id("filter"));
+    ASSERT_NE(filter, nullptr);
+    EXPECT_EQ(filter->default_value, "{role: ADMIN, tags: [\"a\", \"b\"]}");
+    EXPECT_FALSE(schema->argument(*friends, schema->name_id("after"))->has_default());
+
+    const FieldDef* matrix = schema->field(user, "matrix");
+    ASSERT_NE(matrix, nullptr);
+    EXPECT_EQ(matrix->type.list_depth, 2);
+    EXPECT_EQ(matrix->type.non_null, 0b100);
+    EXPECT_TRUE(schema->field(user, "oldField")->deprecated);
+    EXPECT_EQ(schema->interfaces(user).size(), 3u);
+
+    uint32_t role = schema->type_index("Role");
+    EXPECT_EQ(schema->enum_values(role).size(), 3u);
+    EXPECT_TRUE(schema->enum_value(role, schema->name_id("USER"))->deprecated);
+    EXPECT_EQ(schema->enum_value(role, schema->name_id("OTHER")), nullptr);
+
+    uint32_t input = schema->type_index("UserFilter");
+    EXPECT_EQ(schema->input_field(input, schema->name_id("role"))->default_value, "USER");
+
+    const DirectiveDef* key = schema->find_directive("key");
+    ASSERT_NE(key, nullptr);
+    EXPECT_TRUE(key->repeatable);
+    EXPECT_TRUE(key->allows(DirectiveLocation::OBJECT));
+    EXPECT_FALSE(key->allows(DirectiveLocation::FIELD));
+    EXPECT_NE(schema->find_directive("skip"), nullptr);
+}
+
+TEST(SchemaTest, PossibleTypes) {
+    auto schema = load_test_schema();
+    ASSERT_NE(schema, nullptr);
+
+    uint32_t node = schema->type_index("Node");
+    uint32_t named = schema->type_index("Named");
+    uint32_t search = schema->type_index("SearchResult");
+    uint32_t user = schema->type_index("User");
+    uint32_t bot = schema->type_index("Bot");
+
+    EXPECT_EQ(schema->possible_types(node).size(), 2u);
+    EXPECT_TRUE(schema->is_possible_type(node, user));
+    EXPECT_TRUE(schema->is_possible_type(node, bot));
+    EXPECT_TRUE(schema->is_possible_type(named, user));
+    EXPECT_FALSE(schema->is_possible_type(named, bot));
+    EXPECT_TRUE(schema->is_possible_type(search, bot));
+    EXPECT_FALSE(schema->is_possible_type(search, node));
+}
+
+TEST(SchemaTest, ReportsErrors) {
+    std::vector<std::string> errors;
+    EXPECT_EQ(Schema::from_sdl("type Query { a: Missing }", &errors), nullptr);
+    ASSERT_EQ(errors.size(), 1u);
+    EXPECT_NE(errors[0].find("Missing"), std::string::npos);
+
+    EXPECT_EQ(Schema::from_sdl("type Query { a: Int a: String }", &errors), nullptr);
+    EXPECT_EQ(Schema::from_sdl("type Query { a: Int } type Query { b: Int }", &errors), nullptr);
+    EXPECT_EQ(Schema::from_sdl("input In { a: Int } type Query { a: In }", &errors), nullptr);
+    EXPECT_EQ(Schema::from_sdl("type Query { a: Int", &errors), nullptr);
+    EXPECT_EQ(Schema::from_sdl("type Foo { a: Int }", &errors), nullptr);  // No query root
+}
+
+TEST(SchemaTest, BuildsFromIntrospection) {
+    const char* json = R"({"data": {"__schema": {
+      "queryType": {"name": "Query"}, "mutationType": null, "subscriptionType": null,
+      "types": [
+        {"kind": "OBJECT", "name": "Query", "fields": [
+          {"name": "pets", "args": [{"name": "limit", "type": {"kind": "SCALAR", "name": "Int", "ofType": null}, "defaultValue": "5"}],
+           "type": {"kind": "NON_NULL", "name": null, "ofType": {"kind": "LIST", "name": null, "ofType": {"kind": "INTERFACE", "name": "Pet", "ofType": null}}},
+           "isDeprecated": false, "deprecationReason": null}],
+         "inputFields": null, "interfaces": [], "enumValues": null, "possibleTypes": null},
+        {"kind": "INTERFACE", "name": "Pet", "fields": [
+          {"name": "name", "args": [], "type": {"kind": "SCALAR", "name": "String", "ofType": null}, "isDeprecated": false}],
+         "possibleTypes": [{"kind": "OBJECT", "name": "Dog"}]},
+        {"name": "Dog", "kind": "OBJECT", "interfaces": [{"kind": "INTERFACE", "name": "Pet", "ofType": null}], "fields": [
+          {"name": "name", "args": [], "type": {"kind": "SCALAR", "name": "String", "ofType": null}, "isDeprecated": false},
+          {"name": "barks", "args": [], "type": {"kind": "SCALAR", "name": "Boolean", "ofType": null}, "isDeprecated": true}]},
+        {"kind": "SCALAR", "name": "String"},
+        {"kind": "OBJECT", "name": "__Schema", "fields": []}
+      ],
+      "directives": [{"name": "cached", "locations": ["FIELD", "QUERY"], "args": [], "isRepeatable": false}]
+    }}})";
+
+    std::vector<std::string> errors;
+    auto schema = Schema::from_introspection(json, &errors);
+    ASSERT_NE(schema, nullptr) << (errors.empty() ? "" : errors[0]);
+
+    uint32_t query = schema->query_type();
+    ASSERT_NE(query, Schema::NONE);
+    const FieldDef* pets = schema->field(query, "pets");
+    ASSERT_NE(pets, nullptr);
+    EXPECT_EQ(pets->type.type, schema->type_index("Pet"));
+    EXPECT_EQ(pets->type.list_depth, 1);
+    EXPECT_EQ(pets->type.non_null, 0b01);
+    EXPECT_EQ(schema->arguments(*pets)[0].default_value, "5");
+
+    uint32_t dog = schema->type_index("Dog");
+    EXPECT_TRUE(schema->is_possible_type(schema->type_index("Pet"), dog));
+    EXPECT_TRUE(schema->field(dog, "barks")->deprecated);
+    EXPECT_EQ(schema->type_index("__Schema"), Schema::NONE);
+    EXPECT_TRUE(schema->find_directive("cached")->allows(DirectiveLocation::QUERY));
+}
+
+TEST(SchemaTest, WideSchemaLookups) {
+    // 5,000 types of 20 fields each, all cross-referencing
+    const size_t type_count = 5000;
+    std::string sdl = "type Query { root: T0 }\n";
+    for (size_t t = 0; t < type_count; t++) {
+        sdl += "type T" + std::to_string(t) + " {";
+        for (size_t f = 0; f < 20; f++) {
+            sdl += " f" + std::to_string(f) + ": T" + std::to_string((t + f) % type_count);
+        }
+        sdl += " }\n";
+    }
+
+    std::vector<std::string> errors;
+    auto schema = Schema::from_sdl(sdl, &errors);
+    ASSERT_NE(schema, nullptr) << (errors.empty() ? "" : errors[0]);
+    EXPECT_EQ(schema->type_count(), type_count + 6);
+
+    for (size_t t = 0; t < type_count; t += 97) {
+        uint32_t type = schema->type_index("T" + std::to_string(t));
+        ASSERT_NE(type, Schema::NONE);
+        for (size_t f = 0; f < 20; f++) {
+            const FieldDef* field = schema->field(type, "f" + std::to_string(f));
+            ASSERT_NE(field, nullptr);
+            EXPECT_EQ(schema->type_name(field->type.type), "T" + std::to_string((t + f) % type_count));
+        }
+        EXPECT_EQ(schema->field(type, "f20"), nullptr);
+    }
+}
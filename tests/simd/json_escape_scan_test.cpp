@@ -0,0 +1,26 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include "simd/json_escape_scan.h"
+
+TEST(JsonEscapeScanTest, ScannersAgreeAcrossVectorWidths) {
+    using namespace json_escape_detail;
+    EXPECT_EQ(find_json_escape("", 0), 0u);
+    EXPECT_EQ(find_json_escape("plain \xc3\xa9", 8), 8u);
+    EXPECT_EQ(find_json_escape("a\x7f\x1f", 3), 2u);
+
+    // Each scanner agrees with the scalar one wherever the first escape falls
+    std::mt19937 random(7);
+    const char alphabet[] = "abcXYZ019 \xc3\xa9~\x7f\x80\xff";
+    for (int round = 0; round < 2000; round++) {
+        std::string text(random() % 80, 'a');
+        for (char& c : text) c = alphabet[random() % (sizeof(alphabet) - 1)];
+        if (!text.empty() && random() % 4) text[random() % text.size()] = "\"\\\n\x1f"[random() % 4];
+        size_t expected = find_scalar(text.data(), text.size());
+        EXPECT_EQ(find_json_escape(text.data(), text.size()), expected) << text;
+        EXPECT_EQ(find_sse2(text.data(), text.size()), expected) << text;
+        if (avx2_supported()) {
+            EXPECT_EQ(find_avx2(text.data(), text.size()), expected) << text;
+        }
+    }
+}
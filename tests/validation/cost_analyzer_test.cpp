@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <string>
+#include "ast/ast_arena.h"
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "schema/schema.h"
+#include "validation/cost_analyzer.h"
+
+namespace {
+
+arena_ptr<Document> parse(const char* query, ASTArena& arena, const ParserOptions& options = ParserOptions()) {
+    LexerCursor cursor(query, std::strlen(query), nullptr);
+    Parser parser(cursor, arena, options);
+    return parser.parse_document();
+}
+
+}  // namespace
+
+TEST(CostAnalyzerTest, WeightsAndListMultipliers) {
+    auto schema = Schema::from_sdl(R"(
+        type User { name: String friends(first: Int): [User] avatar: String }
+        type Query { users(limit: Int): [User] avatar: String }
+    )");
+    ASSERT_NE(schema, nullptr);
+
+    CostOptions options;
+    options.schema = schema.get();
+    options.field_costs["User.avatar"] = 5;   // Only on User
+    options.field_costs["friends"] = 2;
+    CostAnalyzer analyzer(options);
+
+    ASTArena arena;
+    auto document = parse(R"(query Q($n: Int) {
+        avatar
+        users(limit: 3) { name avatar friends(first: $n) { name } }
+    })", arena);
+    ASSERT_NE(document, nullptr);
+    // avatar 1 + users 1 + 3 * (name 1 + avatar 5 + friends 2 + 10 * name 1)
+    EXPECT_EQ(analyzer.analyze(*document), 2u + 3u * (1 + 5 + 2 + 10));
+    EXPECT_FALSE(analyzer.exceeded());
+}
+
+TEST(CostAnalyzerTest, FragmentsCostedOnceInAnyOrder) {
+    CostAnalyzer analyzer;
+    ASTArena arena;
+    // Spreads before definitions, nested fragments, an inline fragment
+    auto document = parse(R"(
+        { a(first: 4) { ...F } b { ...F ...G } }
+        fragment F on T { x y ...G }
+        fragment G on T { z ... on T { w } }
+    )", arena);
+    ASSERT_NE(document, nullptr);
+    // G = 2, F = 2 + G = 4; a: 1 + 4 * F, b: 1 + F + G
+    EXPECT_EQ(analyzer.analyze(*document), (1 + 4 * 4u) + (1 + 4 + 2u));
+
+    // Doubling fragments: saturates instead of expanding or wrapping
+    std::string query = "{ ...F64 } fragment F0 on T { x(first: 1000000) { y } }";
+    for (int i = 1; i <= 64; i++) {
+        std::string previous = "...F" + std::to_string(i - 1);
+        query += " fragment F" + std::to_string(i) + " on T { a(first: 1000) { " + previous + " } }";
+    }
+    ASTArena big_arena;
+    auto big = parse(query.c_str(), big_arena);
+    ASSERT_NE(big, nullptr);
+    EXPECT_EQ(analyzer.analyze(*big), UINT64_MAX);
+}
+
+TEST(CostAnalyzerTest, StreamingAbortsParseOverBudget) {
+    CostOptions options;
+    options.max_cost = 100;
+    CostAnalyzer analyzer(options);
+    ParserOptions parser_options;
+    parser_options.listener = &analyzer;
+
+    ASTArena arena;
+    EXPECT_NE(parse("{ items(first: 10) { a b } }", arena, parser_options), nullptr);
+    EXPECT_EQ(analyzer.cost(), 21u);
+
+    // Rejected inside items (1 + 50 + 50), before the 10000 fields after it are built
+    analyzer.reset();
+    std::string query = "{ items(first: 50) { a b c d } rest { ";
+    for (int i = 0; i < 10000; i++) query += "f" + std::to_string(i) + " ";
+    query += "} }";
+    LexerCursor cursor(query.data(), query.size(), nullptr);
+    ASTArena big_arena;
+    Parser parser(cursor, big_arena, parser_options);
+    EXPECT_EQ(parser.parse_document(), nullptr);
+    ASSERT_TRUE(parser.limit_exceeded().has_value());
+    EXPECT_EQ(*parser.limit_exceeded(), ParserLimit::COST);
+    EXPECT_TRUE(analyzer.exceeded());
+    EXPECT_EQ(analyzer.cost(), 101u);
+    EXPECT_LT(big_arena.bytes_allocated(), 16u * 1024);
+}
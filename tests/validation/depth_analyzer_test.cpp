@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <string>
+#include "ast/ast_arena.h"
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "validation/depth_analyzer.h"
+
+namespace {
+
+arena_ptr<Document> parse(const std::string& query, ASTArena& arena) {
+    LexerCursor cursor(query.data(), query.size(), nullptr);
+    Parser parser(cursor, arena);
+    auto document = parser.parse_document();
+    EXPECT_FALSE(parser.has_errors());
+    return document;
+}
+
+}  // namespace
+
+TEST(DepthAnalyzerTest, ExpandsFragmentsWithoutMaterializing) {
+    ASTArena arena;
+    // Spreads before their definitions; inline fragments merge into their parent set
+    const std::string source = R"(
+        query Q { a { b { ...F } } c ... on T { d ...G } }
+        fragment F on T { x { y } ...G }
+        fragment G on T { z w }
+    )";
+    auto document = parse(source, arena);
+    ASSERT_NE(document, nullptr);
+
+    DepthAnalyzer analyzer;
+    DepthReport report = analyzer.analyze(*document);
+    EXPECT_TRUE(report.cycles.empty());
+    // a > b > x > y
+    EXPECT_EQ(report.max_depth, 4u);
+    // Q: a b c d + F (x y + G) + G, G = z w
+    EXPECT_EQ(report.field_count, 4u + (2 + 2) + 2);
+    // Root set: a c d + G's z w
+    EXPECT_EQ(report.max_breadth, 5u);
+
+    // Each fragment spreads the previous one twice: 2^60 fields, computed in O(n)
+    std::string query = "{ ...F60 } fragment F0 on T { leaf }";
+    for (int i = 1; i <= 60; i++) {
+        std::string previous = "...F" + std::to_string(i - 1);
+        query += " fragment F" + std::to_string(i) + " on T { n { " + previous + " } " + previous + " }";
+    }
+    ASTArena big_arena;
+    auto big = parse(query, big_arena);
+    report = analyzer.analyze(*big);
+    EXPECT_EQ(report.max_depth, 61u);
+    EXPECT_EQ(report.field_count, (1ull << 61) - 1);
+}
+
+TEST(DepthAnalyzerTest, FindsCycles) {
+    ASTArena arena;
+    const std::string source = R"(
+        query Ok { safe }
+        query Bad { ...A }
+        fragment A on T { x ...B }
+        fragment B on T { y { ...C } }
+        fragment C on T { ...A }
+        fragment Self on T { ...Self }
+        fragment Fine on T { ...Undefined }
+    )";
+    auto document = parse(source, arena);
+    ASSERT_NE(document, nullptr);
+
+    DepthAnalyzer analyzer;
+    DepthReport report = analyzer.analyze(*document);
+    ASSERT_EQ(report.cycles.size(), 2u);
+    for (auto& cycle : report.cycles) std::sort(cycle.begin(), cycle.end());
+    std::sort(report.cycles.begin(), report.cycles.end());
+    EXPECT_EQ(report.cycles[0], (std::vector<std::string_view>{"A", "B", "C"}));
+    EXPECT_EQ(report.cycles[1], (std::vector<std::string_view>{"Self"}));
+    EXPECT_EQ(report.max_depth, DepthReport::UNBOUNDED_DEPTH);
+
+    // An operation that doesn't reach the cycle keeps finite figures
+    report = analyzer.analyze(*document, "Ok");
+    EXPECT_EQ(report.max_depth, 1u);
+    EXPECT_EQ(report.field_count, 1u);
+}
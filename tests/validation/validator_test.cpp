@@ -0,0 +1,209 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "ast/ast_arena.h"
+#include "cache/query_cache.h"
+#include "lexer/interner.h"
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "schema/schema.h"
+#include "validation/validator.h"
+
+namespace {
+
+const char* TEST_SDL = R"(
+interface Pet { name: String }
+type Dog implements Pet { name: String barks: Boolean nickname: String }
+type Cat implements Pet { name: String meows: Boolean }
+union CatOrDog = Cat | Dog
+enum Color { RED GREEN }
+input Filter { color: Color! limit: Int = 10 }
+
+type Query {
+  pet(id: ID!): Pet
+  dog: Dog
+  pets(filter: Filter, first: Int = 5): [Pet]
+  any: CatOrDog
+  paint(color: Color): Boolean
+}
+type Subscription { newPet: Pet  newDog: Dog }
+)";
+
+class ValidatorTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        schema_ = Schema::from_sdl(TEST_SDL);
+        ASSERT_NE(schema_, nullptr);
+    }
+
+    // Messages for a query, lexed with symbols layered over the schema
+    std::vector<std::string> validate(const char* query) {
+        Interner symbols(&schema_->names());
+        LexerCursor cursor(query, std::strlen(query), &symbols);
+        ASTArena arena;
+        Parser parser(cursor, arena);
+        auto document = parser.parse_document();
+        EXPECT_FALSE(parser.has_errors()) << query;
+
+        Validator validator(*schema_);
+        validator.validate(*document);
+        std::vector<std::string> messages;
+        for (const ValidationError& error : validator.errors()) messages.push_back(error.message);
+        return messages;
+    }
+
+    static bool contains(const std::vector<std::string>& messages, const std::string& text) {
+        for (const std::string& message : messages) {
+            if (message.find(text) != std::string::npos) return true;
+        }
+        return false;
+    }
+
+    std::unique_ptr<Schema> schema_;
+};
+
+}  // namespace
+
+TEST_F(ValidatorTest, AcceptsValidDocument) {
+    auto errors = validate(R"(
+        query Q($id: ID!, $color: Color = RED, $limit: Int) {
+          pet(id: $id) { name ... on Dog { barks } ...CatFields }
+          pets(filter: {color: $color, limit: $limit}) { __typename name }
+          any { ... on Pet { name } }
+          paint(color: GREEN) @skip(if: false)
+        }
+        fragment CatFields on Cat { meows }
+    )");
+    for (const std::string& error : errors) ADD_FAILURE() << error;
+}
+
+TEST_F(ValidatorTest, FieldsArgumentsAndValues) {
+    auto errors = validate(R"({
+        dog { name meows }
+        pet { name }
+        pets(first: 1, first: 2, filter: {limit: 3}, size: 1)
+        paint(color: BLUE) { x }
+        dog @unknown { name }
+    })");
+    EXPECT_TRUE(contains(errors, "Cannot query field \"meows\" on type \"Dog\"."));
+    EXPECT_TRUE(contains(errors, "argument \"id\" of type \"ID!\" is required"));
+    EXPECT_TRUE(contains(errors, "There can be only one argument named \"first\"."));
+    EXPECT_TRUE(contains(errors, "Unknown argument \"size\""));
+    EXPECT_TRUE(contains(errors, "Field \"Filter.color\" of required type \"Color!\" was not provided."));
+    EXPECT_TRUE(contains(errors, "Field \"pets\" of type \"[Pet]\" must have a selection of subfields."));
+    EXPECT_TRUE(contains(errors, "Expected value of type \"Color\"."));
+    EXPECT_TRUE(contains(errors, "Field \"paint\" must not have a selection"));
+    EXPECT_TRUE(contains(errors, "Unknown directive \"@unknown\"."));
+}
+
+TEST_F(ValidatorTest, Fragments) {
+    auto errors = validate(R"(
+        { dog { ...A ...Missing ... on Cat { meows } } any { ...OnScalar } }
+        fragment A on Dog { ...B }
+        fragment B on Dog { ...A }
+        fragment Unused on Pet { name }
+        fragment OnScalar on Color { x }
+    )");
+    EXPECT_TRUE(contains(errors, "Unknown fragment \"Missing\"."));
+    EXPECT_TRUE(contains(errors, "Cannot spread fragment \"A\" within itself."));
+    EXPECT_TRUE(contains(errors, "Fragment \"Unused\" is never used."));
+    EXPECT_TRUE(contains(errors, "cannot condition on non composite type \"Color\""));
+    EXPECT_TRUE(contains(errors, "objects of type \"Dog\" can never be of type \"Cat\""));
+    EXPECT_FALSE(contains(errors, "Fragment \"A\" is never used."));
+}
+
+TEST_F(ValidatorTest, Variables) {
+    auto errors = validate(R"(
+        query Q($id: ID, $unused: Int, $color: Color, $first: Int, $x: Dog) {
+          pet(id: $id) { name }
+          pets(first: $first, filter: {color: $color}) { ...F }
+        }
+        fragment F on Pet { ... on Dog { nickname } name @include(if: $missing) }
+    )");
+    EXPECT_TRUE(contains(errors, "Variable \"$id\" of type \"ID\" used in position expecting type \"ID!\"."));
+    EXPECT_TRUE(contains(errors, "Variable \"$color\" of type \"Color\" used in position expecting type \"Color!\"."));
+    EXPECT_TRUE(contains(errors, "Variable \"$unused\" is never used by operation \"Q\"."));
+    EXPECT_TRUE(contains(errors, "Variable \"$missing\" is not defined by operation \"Q\"."));
+    EXPECT_TRUE(contains(errors, "Variable \"$x\" cannot be non-input type \"Dog\"."));
+    // A nullable variable may feed an argument that has a default
+    EXPECT_FALSE(contains(errors, "$first"));
+}
+
+TEST_F(ValidatorTest, OperationsAndSubscriptions) {
+    auto errors = validate(R"(
+        { dog { name } }
+        query A { dog { name } }
+        query A { dog { name } }
+        subscription S { newPet { name } newDog { name } }
+        mutation M { x }
+    )");
+    EXPECT_TRUE(contains(errors, "This anonymous operation must be the only defined operation."));
+    EXPECT_TRUE(contains(errors, "There can be only one operation named \"A\"."));
+    EXPECT_TRUE(contains(errors, "Subscription \"S\" must select only one top level field."));
+    EXPECT_TRUE(contains(errors, "Schema is not configured to execute mutation operation."));
+}
+
+TEST_F(ValidatorTest, OverlappingFields) {
+    auto errors = validate(R"({
+        dog { name: nickname name }
+        pet(id: 1) { ... on Dog { barks } ... on Cat { barks: meows } }
+        any { ... on Dog { v: barks } ... on Cat { v: name } }
+        d1: dog { name } d1: dog { barks: name }
+        p: paint(color: RED) p: paint(color: GREEN)
+    })");
+    EXPECT_TRUE(contains(errors, "Fields \"name\" conflict because \"nickname\" and \"name\" are different fields."));
+    EXPECT_TRUE(contains(errors, "Fields \"v\" conflict because they return conflicting types \"Boolean\" and \"String\"."));
+    EXPECT_TRUE(contains(errors, "Fields \"p\" conflict because they have differing arguments."));
+    // Distinct object parents may reuse a response name for different fields
+    EXPECT_FALSE(contains(errors, "Fields \"barks\""));
+    // Sub-selections merge when they don't conflict
+    EXPECT_FALSE(contains(errors, "Fields \"d1\""));
+}
+
+TEST_F(ValidatorTest, OverlapCheckStaysLinearOnRepeatedFragments) {
+    // Each fragment spreads the previous one three times: expanding spreads
+    // naively reaches F0's field 3^40 times
+    std::string query = "{ dog { name: nickname ...F40 } } fragment F0 on Dog { name }";
+    for (int i = 1; i <= 40; i++) {
+        std::string previous = "F" + std::to_string(i - 1);
+        query += " fragment F" + std::to_string(i) + " on Dog { ..." + previous + " ..." + previous +
+                 " ... on Dog { ..." + previous + " } }";
+    }
+
+    auto errors = validate(query.c_str());
+    EXPECT_TRUE(contains(errors, "Fields \"name\" conflict because \"nickname\" and \"name\" are different fields."));
+}
+
+TEST_F(ValidatorTest, CachesPassesPerSchemaGeneration) {
+    QueryCache cache;
+    QueryCache::Handle entry = cache.put("{ dog { name barks } }");
+    ASSERT_TRUE(entry);
+
+    Validator validator(*schema_);
+    EXPECT_FALSE(entry->validated_for(schema_->generation()));
+    EXPECT_TRUE(validator.validate(*entry));
+    EXPECT_TRUE(entry->validated_for(schema_->generation()));
+    EXPECT_TRUE(validator.validate(*entry));
+
+    // Hot-swapping the schema invalidates the stamp; failures aren't recorded
+    auto swapped = Schema::from_sdl("type Dog { name: String } type Query { dog: Dog }");
+    ASSERT_NE(swapped, nullptr);
+    EXPECT_NE(swapped->generation(), schema_->generation());
+    EXPECT_FALSE(entry->validated_for(swapped->generation()));
+    Validator swapped_validator(*swapped);
+    EXPECT_FALSE(swapped_validator.validate(*entry));
+    EXPECT_TRUE(contains({swapped_validator.errors()[0].message}, "Cannot query field \"barks\""));
+    EXPECT_TRUE(entry->validated_for(schema_->generation()));
+
+    // Warm entries restored from a snapshot are validated from their text
+    std::string path = ::testing::TempDir() + "validator_cache_snapshot.bin";
+    ASSERT_EQ(cache.save_snapshot(path), 1u);
+    QueryCache restored;
+    ASSERT_EQ(restored.load_snapshot(path), 1u);
+    QueryCache::Handle warm = restored.get("{ dog { name barks } }");
+    ASSERT_TRUE(warm);
+    ASSERT_TRUE(warm->is_warm());
+    EXPECT_TRUE(validator.validate(*warm));
+    EXPECT_TRUE(warm->validated_for(schema_->generation()));
+}